@@ -0,0 +1,571 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#include <scene_rdl2/common/fb_util/ispc/MergeUtil_ispc_stubs.h>
+
+#include "MergeUtil.h"
+
+namespace scene_rdl2 {
+namespace fb_util {
+
+//
+// We have 2 different versions of all MergeUtil public APIs. They are C++ and ISPC.
+// The following directives define which implementation we use.
+// Both versions are verified and compared by unitTest (tests/lib/common/fb_util/TestMergeUtil.{h,cc}).
+// See TestMergeUtil.cc for more detail.
+//
+#define MERGETILE_ACCUMULATE_ISPC
+#define MERGETILE_CLOSESTFILTER_ISPC
+#define MERGETILE_COPY_ISPC
+
+namespace {
+
+template <typename F>
+void
+operatorOnActivePixOfTile(uint64_t srcTileMask, F operatePixFunc)
+{
+    for (unsigned y = 0; y < 8; ++y) {
+        unsigned pixId = (y << 3); // y * 8
+        uint64_t currTileMask = srcTileMask >> pixId;
+        if (!currTileMask) break; // early exit : rest of them are all empty
+
+        uint64_t currTileScanlineMask = currTileMask & static_cast<uint64_t>(0xff); // get one scanline mask
+        for (unsigned x = 0; x < 8; ++x) {
+            if (!currTileScanlineMask) break; // early exit for scanline
+            if (currTileScanlineMask & static_cast<uint64_t>(0x1)) {
+                operatePixFunc(pixId);
+            }
+            ++pixId;
+            currTileScanlineMask >>= 1;
+        }
+    }
+}
+
+template <unsigned N>
+void
+accumulateTileNumSample_SISD(float* dstV, uint32_t* dstN, const uint64_t srcTileMask,
+                             const float* srcV, const uint32_t* srcN)
+{
+    operatorOnActivePixOfTile(srcTileMask, [&](unsigned pixId) {
+            float* currDstV = dstV + pixId * N;
+            const float* currSrcV = srcV + pixId * N;
+            const uint32_t currDstN = dstN[pixId];
+            const uint32_t currSrcN = srcN[pixId];
+
+            const uint32_t totalN = currDstN + currSrcN;
+            if (totalN > 0) {
+                for (unsigned i = 0; i < N; ++i) {
+                    currDstV[i] =
+                        (currDstV[i] * static_cast<float>(currDstN) +
+                         currSrcV[i] * static_cast<float>(currSrcN)) /
+                        static_cast<float>(totalN);
+                }
+            } else {
+                // just in case
+                for (unsigned i = 0; i < N; ++i) currDstV[i] = 0.0f;
+            }
+            dstN[pixId] = totalN;
+        });
+}
+
+template <unsigned N>
+void
+accumulateTileClosestFilter_SISD(float* dstV, uint32_t* dstN, const uint64_t srcTileMask,
+                                 const float* srcV, const uint32_t* srcN)
+{
+    constexpr unsigned depthId = N - 1; // depth value is last component
+
+    operatorOnActivePixOfTile(srcTileMask, [&](unsigned pixId) {
+            float* currDstV = dstV + pixId * N;
+            const float* currSrcV = srcV + pixId * N;
+            const uint32_t currDstN = dstN[pixId];
+
+            const uint32_t totalN = currDstN + srcN[pixId];
+            if (totalN > 0) {
+                if (currDstN == 0 || currSrcV[depthId] < currDstV[depthId]) {
+                    // replace dst if src's closestFilter depth is closer
+                    for (unsigned i = 0; i < N; ++i) currDstV[i] = currSrcV[i];
+                }
+                dstN[pixId] = totalN;
+            }
+        });
+}
+
+template <unsigned N>
+void
+copyTileNumSample_SISD(float* dstV, uint32_t* dstN, const uint64_t srcTileMask,
+                       const float* srcV, const uint32_t* srcN)
+{
+    operatorOnActivePixOfTile(srcTileMask, [&](unsigned pixId) {
+            for (unsigned i = 0; i < N; ++i) dstV[pixId * N + i] = srcV[pixId * N + i];
+            dstN[pixId] = srcN[pixId];
+        });
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+//
+// accumulate
+//
+// static function
+void
+MergeUtil::accumulateTileFloatNumSample(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+#ifdef MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloatNumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloatNumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_ACCUMULATE_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloatNumSample_SISD(float* dstV,
+                                             uint32_t* dstN,
+                                             const uint64_t srcTileMask,
+                                             const float* srcV,
+                                             const uint32_t* srcN)
+{
+    accumulateTileNumSample_SISD<1>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloatNumSample_SIMD(float* dstV,
+                                             uint32_t* dstN,
+                                             const uint64_t srcTileMask,
+                                             const float* srcV,
+                                             const uint32_t* srcN)
+{
+    ispc::accumulateTileFloatNumSample(dstV,
+                                       dstN,
+                                       srcTileMask,
+                                       const_cast<float*>(srcV),
+                                       const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat2NumSample(float* dstV,
+                                         uint32_t* dstN,
+                                         const uint64_t srcTileMask,
+                                         const float* srcV,
+                                         const uint32_t* srcN)
+{
+#ifdef MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat2NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat2NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_ACCUMULATE_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat2NumSample_SISD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    accumulateTileNumSample_SISD<2>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat2NumSample_SIMD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat2NumSample(dstV,
+                                        dstN,
+                                        srcTileMask,
+                                        const_cast<float*>(srcV),
+                                        const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3NumSample(float* dstV,
+                                         uint32_t* dstN,
+                                         const uint64_t srcTileMask,
+                                         const float* srcV,
+                                         const uint32_t* srcN)
+{
+#ifdef MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat3NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat3NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_ACCUMULATE_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3NumSample_SISD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    accumulateTileNumSample_SISD<3>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3NumSample_SIMD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat3NumSample(dstV,
+                                        dstN,
+                                        srcTileMask,
+                                        const_cast<float*>(srcV),
+                                        const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4NumSample(float* dstV,
+                                         uint32_t* dstN,
+                                         const uint64_t srcTileMask,
+                                         const float* srcV,
+                                         const uint32_t* srcN)
+{
+#ifdef MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat4NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_ACCUMULATE_ISPC
+    accumulateTileFloat4NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_ACCUMULATE_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4NumSample_SISD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    accumulateTileNumSample_SISD<4>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4NumSample_SIMD(float* dstV,
+                                              uint32_t* dstN,
+                                              const uint64_t srcTileMask,
+                                              const float* srcV,
+                                              const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat4NumSample(dstV,
+                                        dstN,
+                                        srcTileMask,
+                                        const_cast<float*>(srcV),
+                                        const_cast<uint32_t*>(srcN));
+}
+
+//------------------------------------------------------------------------------
+//
+// accumulate with closestFilter
+//
+// static function
+void
+MergeUtil::accumulateTileFloat2ClosestFilter(float* dstV,
+                                             uint32_t* dstN,
+                                             const uint64_t srcTileMask,
+                                             const float* srcV,
+                                             const uint32_t* srcN)
+{
+#ifdef MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat2ClosestFilter_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat2ClosestFilter_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_CLOSESTFILTER_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat2ClosestFilter_SISD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    accumulateTileClosestFilter_SISD<2>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat2ClosestFilter_SIMD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat2ClosestFilter(dstV,
+                                            dstN,
+                                            srcTileMask,
+                                            const_cast<float*>(srcV),
+                                            const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3ClosestFilter(float* dstV,
+                                             uint32_t* dstN,
+                                             const uint64_t srcTileMask,
+                                             const float* srcV,
+                                             const uint32_t* srcN)
+{
+#ifdef MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat3ClosestFilter_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat3ClosestFilter_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_CLOSESTFILTER_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3ClosestFilter_SISD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    accumulateTileClosestFilter_SISD<3>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat3ClosestFilter_SIMD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat3ClosestFilter(dstV,
+                                            dstN,
+                                            srcTileMask,
+                                            const_cast<float*>(srcV),
+                                            const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4ClosestFilter(float* dstV,
+                                             uint32_t* dstN,
+                                             const uint64_t srcTileMask,
+                                             const float* srcV,
+                                             const uint32_t* srcN)
+{
+#ifdef MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat4ClosestFilter_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_CLOSESTFILTER_ISPC
+    accumulateTileFloat4ClosestFilter_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_CLOSESTFILTER_ISPC
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4ClosestFilter_SISD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    accumulateTileClosestFilter_SISD<4>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::accumulateTileFloat4ClosestFilter_SIMD(float* dstV,
+                                                  uint32_t* dstN,
+                                                  const uint64_t srcTileMask,
+                                                  const float* srcV,
+                                                  const uint32_t* srcN)
+{
+    ispc::accumulateTileFloat4ClosestFilter(dstV,
+                                            dstN,
+                                            srcTileMask,
+                                            const_cast<float*>(srcV),
+                                            const_cast<uint32_t*>(srcN));
+}
+
+//------------------------------------------------------------------------------
+//
+// copy
+//
+// static function
+void
+MergeUtil::copyTileFloatNumSample(float* dstV,
+                                  uint32_t* dstN,
+                                  const uint64_t srcTileMask,
+                                  const float* srcV,
+                                  const uint32_t* srcN)
+{
+#ifdef MERGETILE_COPY_ISPC
+    copyTileFloatNumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_COPY_ISPC
+    copyTileFloatNumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_COPY_ISPC
+}
+
+// static function
+void
+MergeUtil::copyTileFloatNumSample_SISD(float* dstV,
+                                       uint32_t* dstN,
+                                       const uint64_t srcTileMask,
+                                       const float* srcV,
+                                       const uint32_t* srcN)
+{
+    copyTileNumSample_SISD<1>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::copyTileFloatNumSample_SIMD(float* dstV,
+                                       uint32_t* dstN,
+                                       const uint64_t srcTileMask,
+                                       const float* srcV,
+                                       const uint32_t* srcN)
+{
+    ispc::copyTileFloatNumSample(dstV,
+                                 dstN,
+                                 srcTileMask,
+                                 const_cast<float*>(srcV),
+                                 const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::copyTileFloat2NumSample(float* dstV,
+                                   uint32_t* dstN,
+                                   const uint64_t srcTileMask,
+                                   const float* srcV,
+                                   const uint32_t* srcN)
+{
+#ifdef MERGETILE_COPY_ISPC
+    copyTileFloat2NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_COPY_ISPC
+    copyTileFloat2NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_COPY_ISPC
+}
+
+// static function
+void
+MergeUtil::copyTileFloat2NumSample_SISD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    copyTileNumSample_SISD<2>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::copyTileFloat2NumSample_SIMD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    ispc::copyTileFloat2NumSample(dstV,
+                                  dstN,
+                                  srcTileMask,
+                                  const_cast<float*>(srcV),
+                                  const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::copyTileFloat3NumSample(float* dstV,
+                                   uint32_t* dstN,
+                                   const uint64_t srcTileMask,
+                                   const float* srcV,
+                                   const uint32_t* srcN)
+{
+#ifdef MERGETILE_COPY_ISPC
+    copyTileFloat3NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_COPY_ISPC
+    copyTileFloat3NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_COPY_ISPC
+}
+
+// static function
+void
+MergeUtil::copyTileFloat3NumSample_SISD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    copyTileNumSample_SISD<3>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::copyTileFloat3NumSample_SIMD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    ispc::copyTileFloat3NumSample(dstV,
+                                  dstN,
+                                  srcTileMask,
+                                  const_cast<float*>(srcV),
+                                  const_cast<uint32_t*>(srcN));
+}
+
+// static function
+void
+MergeUtil::copyTileFloat4NumSample(float* dstV,
+                                   uint32_t* dstN,
+                                   const uint64_t srcTileMask,
+                                   const float* srcV,
+                                   const uint32_t* srcN)
+{
+#ifdef MERGETILE_COPY_ISPC
+    copyTileFloat4NumSample_SIMD(dstV, dstN, srcTileMask, srcV, srcN);
+#else // else MERGETILE_COPY_ISPC
+    copyTileFloat4NumSample_SISD(dstV, dstN, srcTileMask, srcV, srcN);
+#endif // end else MERGETILE_COPY_ISPC
+}
+
+// static function
+void
+MergeUtil::copyTileFloat4NumSample_SISD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    copyTileNumSample_SISD<4>(dstV, dstN, srcTileMask, srcV, srcN);
+}
+
+// static function
+void
+MergeUtil::copyTileFloat4NumSample_SIMD(float* dstV,
+                                        uint32_t* dstN,
+                                        const uint64_t srcTileMask,
+                                        const float* srcV,
+                                        const uint32_t* srcN)
+{
+    ispc::copyTileFloat4NumSample(dstV,
+                                  dstN,
+                                  srcTileMask,
+                                  const_cast<float*>(srcV),
+                                  const_cast<uint32_t*>(srcN));
+}
+
+} // namespace fb_util
+} // namespace scene_rdl2
@@ -0,0 +1,221 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+//
+// -- Merge functions for tiled image buffers --
+//
+// Per-tile accumulate and copy functions used by the merge computation (grid_util::Fb). Each function
+// operates on one 8x8 tile and only updates the pixels which are active in srcTileMask.
+//
+// Every function has a C++ version (_SISD) and an ISPC version (_SIMD). The ISPC version is compiled
+// for all of GLOBAL_ISPC_INSTRUCTION_SETS and ISPC picks the best one for the running CPU at runtime
+// (i.e. AVX2 or AVX512 on x86, NEON on ARM). The function without suffix calls the version selected
+// at the top of MergeUtil.cc.
+//
+
+#include <stdint.h>             // uint32_t
+
+namespace scene_rdl2 {
+namespace fb_util {
+
+class MergeUtil
+{
+public:
+    //------------------------------
+    //
+    // accumulate
+    //
+    // Numerically weighted average of the values by numSample. dst numSample becomes the total of
+    // both numSamples. Used for beauty, heatMap and AOVs.
+    static void accumulateTileFloatNumSample(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                             const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+    static void accumulateTileFloatNumSample_SISD(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                                  uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                                  const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                                  const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                                  const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+    static void accumulateTileFloatNumSample_SIMD(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                                  uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                                  const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                                  const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                                  const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+
+    static void accumulateTileFloat2NumSample(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                              uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                              const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                              const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                              const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void accumulateTileFloat2NumSample_SISD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                                   const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void accumulateTileFloat2NumSample_SIMD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                                   const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+
+    static void accumulateTileFloat3NumSample(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                              uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                              const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                              const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                              const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void accumulateTileFloat3NumSample_SISD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                                   const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void accumulateTileFloat3NumSample_SIMD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                                   const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+
+    static void accumulateTileFloat4NumSample(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                              uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                              const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                              const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                              const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void accumulateTileFloat4NumSample_SISD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                                   const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void accumulateTileFloat4NumSample_SIMD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                   uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                                   const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                                   const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                   const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+
+    //------------------------------
+    //
+    // accumulate with closestFilter
+    //
+    // The last component is the depth and the closer (smaller depth) value wins. dst numSample
+    // becomes the total of both numSamples.
+    static void accumulateTileFloat2ClosestFilter(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                                  uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                                  const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                                  const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                                  const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void accumulateTileFloat2ClosestFilter_SISD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                                       const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void accumulateTileFloat2ClosestFilter_SIMD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                                       const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+
+    static void accumulateTileFloat3ClosestFilter(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                  uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                                  const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                                  const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                  const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void accumulateTileFloat3ClosestFilter_SISD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                                       const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void accumulateTileFloat3ClosestFilter_SIMD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                                       const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+
+    static void accumulateTileFloat4ClosestFilter(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                  uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                                  const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                                  const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                  const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void accumulateTileFloat4ClosestFilter_SISD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                                       const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void accumulateTileFloat4ClosestFilter_SIMD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                       uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                                       const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                                       const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                                       const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+
+    //------------------------------
+    //
+    // copy
+    //
+    // Copies the values and numSamples of the active pixels.
+    static void copyTileFloatNumSample(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                       uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                       const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                       const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                       const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+    static void copyTileFloatNumSample_SISD(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                            uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                            const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                            const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                            const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+    static void copyTileFloatNumSample_SIMD(float *dstV,                // float  buffer (x) =  4byte * 8 * 8
+                                            uint32_t *dstN,             // numSample     (n) =  4byte * 8 * 8
+                                            const uint64_t srcTileMask, // src tileMask  (m) =  8byte (64bit)
+                                            const float *srcV,          // float  buffer (x) =  4byte * 8 * 8
+                                            const uint32_t *srcN);      // numSample     (n) =  4byte * 8 * 8
+
+    static void copyTileFloat2NumSample(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                        uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                        const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                        const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                        const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void copyTileFloat2NumSample_SISD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                             const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+    static void copyTileFloat2NumSample_SIMD(float *dstV,                // float2 buffer (x,y) =  8byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)   =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)   =  8byte (64bit)
+                                             const float *srcV,          // float2 buffer (x,y) =  8byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)   =  4byte * 8 * 8
+
+    static void copyTileFloat3NumSample(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                        uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                        const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                        const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                        const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void copyTileFloat3NumSample_SISD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                             const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+    static void copyTileFloat3NumSample_SIMD(float *dstV,                // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)     =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)     =  8byte (64bit)
+                                             const float *srcV,          // float3 buffer (x,y,z) = 12byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)     =  4byte * 8 * 8
+
+    static void copyTileFloat4NumSample(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                        uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                        const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                        const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                        const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void copyTileFloat4NumSample_SISD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                             const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+    static void copyTileFloat4NumSample_SIMD(float *dstV,                // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                             uint32_t *dstN,             // numSample     (n)       =  4byte * 8 * 8
+                                             const uint64_t srcTileMask, // src tileMask  (m)       =  8byte (64bit)
+                                             const float *srcV,          // float4 buffer (x,y,z,w) = 16byte * 8 * 8
+                                             const uint32_t *srcN);      // numSample     (n)       =  4byte * 8 * 8
+}; // MergeUtil
+
+} // namespace fb_util
+} // namespace scene_rdl2
@@ -0,0 +1,320 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "ContentHash.h"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif // end __AVX2__
+
+namespace {
+
+constexpr uint64_t PRIME32_1 = 0x9E3779B1ULL;
+constexpr uint64_t PRIME32_2 = 0x85EBCA77ULL;
+constexpr uint64_t PRIME32_3 = 0xC2B2AE3DULL;
+constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+//
+// The secret is 32 pseudo random 64bit words which are generated by splitmix64 at compile time.
+// Word offsets of each usage :
+//   stripe accumulation : 0 ~ 22 (stripe N inside the block uses N ~ N+7)
+//   block scramble      : 24 ~ 31
+//   last stripe         : 13 ~ 20
+//   final merge         : 11 ~ 18 (low 64bit), 21 ~ 28 (high 64bit)
+//   short input         : 0 ~ 7 (low 64bit), 16 ~ 23 (high 64bit)
+//
+constexpr size_t SECRET_WORDS = 32;
+constexpr size_t SCRAMBLE_OFFSET = 24;
+constexpr size_t LAST_STRIPE_OFFSET = 13;
+constexpr size_t MERGE_LO_OFFSET = 11;
+constexpr size_t MERGE_HI_OFFSET = 21;
+constexpr size_t SHORT_HI_OFFSET = 16;
+
+struct Secret {
+    uint64_t mWord[SECRET_WORDS];
+};
+
+constexpr Secret
+genSecret()
+{
+    Secret secret {};
+    uint64_t x = 0x5CE4E5B9A0D1C3F7ULL;
+    for (size_t i = 0; i < SECRET_WORDS; ++i) {
+        x += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        secret.mWord[i] = z ^ (z >> 31);
+    }
+    return secret;
+}
+
+constexpr Secret gSecret = genSecret();
+
+inline uint64_t
+readU64(const unsigned char *ptr)
+{
+    uint64_t v;
+    std::memcpy(&v, ptr, sizeof(v)); // little endian host is assumed (x86_64 and aarch64)
+    return v;
+}
+
+inline void
+writeU64(const uint64_t v, unsigned char *ptr)
+{
+    std::memcpy(ptr, &v, sizeof(v));
+}
+
+inline uint64_t
+mulFold64(const uint64_t a, const uint64_t b)
+{
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t
+avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t
+mergeAcc(const uint64_t acc[8], const uint64_t *key, const uint64_t start)
+{
+    uint64_t result = start;
+    for (size_t i = 0; i < 4; ++i) {
+        result += mulFold64(acc[i * 2] ^ key[i * 2], acc[i * 2 + 1] ^ key[i * 2 + 1]);
+    }
+    return avalanche(result);
+}
+
+#if defined(__AVX2__)
+
+inline void
+accumulateStripe(uint64_t *acc, const unsigned char *in, const uint64_t *key)
+{
+    __m256i *xAcc = reinterpret_cast<__m256i *>(acc);
+    for (size_t i = 0; i < 2; ++i) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in) + i);
+        const __m256i dataKey = _mm256_xor_si256(data, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key) + i));
+        const __m256i dataKeyHi = _mm256_shuffle_epi32(dataKey, _MM_SHUFFLE(0, 3, 0, 1));
+        const __m256i product = _mm256_mul_epu32(dataKey, dataKeyHi); // lo32 * hi32
+        const __m256i dataSwap = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2)); // swap 64bit lanes
+        xAcc[i] = _mm256_add_epi64(xAcc[i], _mm256_add_epi64(product, dataSwap));
+    }
+}
+
+inline void
+scrambleAcc(uint64_t *acc, const uint64_t *key)
+{
+    __m256i *xAcc = reinterpret_cast<__m256i *>(acc);
+    const __m256i prime = _mm256_set1_epi32(static_cast<int>(PRIME32_1));
+    for (size_t i = 0; i < 2; ++i) {
+        __m256i a = _mm256_xor_si256(xAcc[i], _mm256_srli_epi64(xAcc[i], 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(key) + i));
+        const __m256i productLo = _mm256_mul_epu32(a, prime);
+        const __m256i productHi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        xAcc[i] = _mm256_add_epi64(productLo, _mm256_slli_epi64(productHi, 32));
+    }
+}
+
+#else // else __AVX2__
+
+inline void
+accumulateStripe(uint64_t *acc, const unsigned char *in, const uint64_t *key)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        const uint64_t data = readU64(in + i * 8);
+        const uint64_t dataKey = data ^ key[i];
+        acc[i ^ 1] += data;
+        acc[i] += (dataKey & 0xFFFFFFFFULL) * (dataKey >> 32);
+    }
+}
+
+inline void
+scrambleAcc(uint64_t *acc, const uint64_t *key)
+{
+    for (size_t i = 0; i < 8; ++i) {
+        uint64_t a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * PRIME32_1;
+    }
+}
+
+#endif // end !__AVX2__
+
+} // namespace
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+// static function
+FastHash::Hash
+FastHash::hash(const void *inAddr, const size_t inSize)
+{
+    const unsigned char *in = static_cast<const unsigned char *>(inAddr);
+    uint64_t lo, hi;
+    if (inSize < STRIPE_SIZE) {
+        hashShort(in, inSize, lo, hi);
+    } else {
+        hashLong(in, inSize, lo, hi);
+    }
+
+    Hash hash;
+    writeU64(lo, hash.data());
+    writeU64(hi, hash.data() + 8);
+    return hash;
+}
+
+// static function
+std::string
+FastHash::show(const Hash &hash)
+{
+    std::ostringstream ostr;
+    for (size_t i = 0; i < HASH_SIZE; ++i) {
+        if (i > 0 && (i % 4) == 0) ostr << '-';
+        ostr << std::setw(2) << std::hex << std::setfill('0') << (int)hash[i] << std::dec;
+    }
+    return ostr.str();
+}
+
+// static function
+void
+FastHash::hashShort(const unsigned char *in, const size_t size, uint64_t &lo, uint64_t &hi)
+//
+// size should be less than STRIPE_SIZE. The input is zero padded to a single stripe and
+// the size is mixed into the start value in order to distinguish the padding from the data.
+//
+{
+    unsigned char stripe[STRIPE_SIZE] = {0};
+    if (size) std::memcpy(stripe, in, size);
+
+    const uint64_t *key = gSecret.mWord;
+    lo = PRIME64_3 + size * PRIME64_1;
+    hi = PRIME64_4 - size * PRIME64_2;
+    for (size_t i = 0; i < 4; ++i) {
+        const uint64_t a = readU64(stripe + i * 16);
+        const uint64_t b = readU64(stripe + i * 16 + 8);
+        lo += mulFold64(a ^ key[i * 2], b ^ key[i * 2 + 1]);
+        hi += mulFold64(a ^ key[SHORT_HI_OFFSET + i * 2], b ^ key[SHORT_HI_OFFSET + i * 2 + 1]);
+    }
+    lo = avalanche(lo);
+    hi = avalanche(hi);
+}
+
+// static function
+void
+FastHash::hashLong(const unsigned char *in, const size_t size, uint64_t &lo, uint64_t &hi)
+//
+// size should be equal or bigger than STRIPE_SIZE.
+//
+{
+    alignas(32) uint64_t acc[8] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3,
+                                   PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+    const uint64_t *key = gSecret.mWord;
+
+    // The last stripe is always processed independently. This is why we use (size - 1) here.
+    const size_t totalBlocks = (size - 1) / BLOCK_SIZE;
+    for (size_t blockId = 0; blockId < totalBlocks; ++blockId) {
+        const unsigned char *block = in + blockId * BLOCK_SIZE;
+        for (size_t stripeId = 0; stripeId < STRIPE_PER_BLOCK; ++stripeId) {
+            accumulateStripe(acc, block + stripeId * STRIPE_SIZE, key + stripeId);
+        }
+        scrambleAcc(acc, key + SCRAMBLE_OFFSET);
+    }
+
+    const unsigned char *block = in + totalBlocks * BLOCK_SIZE;
+    const size_t totalStripes = ((size - 1) - totalBlocks * BLOCK_SIZE) / STRIPE_SIZE;
+    for (size_t stripeId = 0; stripeId < totalStripes; ++stripeId) {
+        accumulateStripe(acc, block + stripeId * STRIPE_SIZE, key + stripeId);
+    }
+    accumulateStripe(acc, in + size - STRIPE_SIZE, key + LAST_STRIPE_OFFSET); // might overlap
+
+    lo = mergeAcc(acc, key + MERGE_LO_OFFSET, size * PRIME64_1);
+    hi = mergeAcc(acc, key + MERGE_HI_OFFSET, ~(size * PRIME64_2));
+}
+
+//-----------------------------------------------------------------------------------------
+
+// static function
+void
+ContentHash::calc(const Mode mode, const void *addr, const size_t size, unsigned char *slot)
+{
+    switch (mode) {
+    case Mode::FAST128 : {
+        const FastHash::Hash hash = FastHash::hash(addr, size);
+        std::memcpy(slot, hash.data(), FastHash::HASH_SIZE);
+        std::memcpy(slot + FastHash::HASH_SIZE, SLOT_TAG, sizeof(SLOT_TAG));
+        slot[SLOT_SIZE - 1] = static_cast<unsigned char>(Mode::FAST128);
+    } break;
+    default : {
+        const Sha1Util::Hash hash = Sha1Util::hash(addr, size);
+        std::memcpy(slot, hash.data(), SLOT_SIZE);
+    } break;
+    }
+}
+
+// static function
+ContentHash::Mode
+ContentHash::getMode(const unsigned char *slot)
+{
+    if (std::memcmp(slot + FastHash::HASH_SIZE, SLOT_TAG, sizeof(SLOT_TAG)) == 0 &&
+        slot[SLOT_SIZE - 1] == static_cast<unsigned char>(Mode::FAST128)) {
+        return Mode::FAST128;
+    }
+    return Mode::SHA1;
+}
+
+// static function
+bool
+ContentHash::verify(const unsigned char *slot, const void *addr, const size_t size)
+{
+    if (getMode(slot) == Mode::FAST128) {
+        const FastHash::Hash hash = FastHash::hash(addr, size);
+        if (std::memcmp(slot, hash.data(), FastHash::HASH_SIZE) == 0) return true;
+        // This might be a SHA1 hash which happens to end with the FAST128 tag.
+    }
+    const Sha1Util::Hash hash = Sha1Util::hash(addr, size);
+    return std::memcmp(slot, hash.data(), SLOT_SIZE) == 0;
+}
+
+// static function
+std::string
+ContentHash::showMode(const Mode mode)
+{
+    switch (mode) {
+    case Mode::SHA1 : return "SHA1";
+    case Mode::FAST128 : return "FAST128";
+    default : return "?";
+    }
+}
+
+// static function
+std::string
+ContentHash::show(const unsigned char *slot)
+{
+    const Mode mode = getMode(slot);
+    const unsigned size = (mode == Mode::FAST128) ? FastHash::HASH_SIZE : SLOT_SIZE;
+
+    std::ostringstream ostr;
+    ostr << showMode(mode) << ' ';
+    for (unsigned i = 0; i < size; ++i) {
+        if (i > 0 && (i % 4) == 0) ostr << '-';
+        ostr << std::setw(2) << std::hex << std::setfill('0') << (int)slot[i] << std::dec;
+    }
+    return ostr.str();
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
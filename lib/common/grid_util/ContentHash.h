@@ -0,0 +1,92 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include "Sha1Util.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class FastHash
+//
+// This class generates a non-cryptographic 128bit hash of specifying data. The algorithm is
+// XXH3-style : the input is consumed by 64 byte stripes and each stripe is mixed into 8 independent
+// 64bit accumulators by 32x32->64 multiplications. Accumulators are scrambled at every 1024 byte
+// block boundary and finally folded down to 128bit. The stripe loop is written by AVX2 intrinsics
+// when they are available and falls back to the same logic by scalar code. Both produce an
+// identical hash.
+//
+// This hash is designed to detect accidental data mismatch (like image synchronization feedback)
+// very fast, it is not secure against intentional collision attacks. Use Sha1Util for that purpose.
+//
+{
+public:
+    static constexpr unsigned HASH_SIZE = 16;
+    using Hash = std::array<unsigned char, HASH_SIZE>;
+
+    static Hash hash(const void *inAddr, const size_t inSize);
+    static Hash hash(const std::string &in) { return hash(in.data(), in.size()); }
+
+    static std::string show(const Hash &hash);
+
+protected:
+    static constexpr size_t STRIPE_SIZE = 64;                     // byte
+    static constexpr size_t STRIPE_PER_BLOCK = 16;
+    static constexpr size_t BLOCK_SIZE = STRIPE_SIZE * STRIPE_PER_BLOCK; // byte
+
+    static void hashShort(const unsigned char *in, const size_t size, uint64_t &lo, uint64_t &hi);
+    static void hashLong(const unsigned char *in, const size_t size, uint64_t &lo, uint64_t &hi);
+};
+
+class ContentHash
+//
+// This class selects the hash algorithm which is used for the content verification of the PackTiles
+// message and PixelBufferSha1Hash. The result is always stored in the same 20 byte slot (the size of
+// the SHA1 hash) so that the message layout does not depend on the hash mode.
+//
+//   SHA1    : slot = SHA1 hash (20 byte)
+//   FAST128 : slot = FastHash (16 byte) + SLOT_TAG (3 byte) + mode (1 byte)
+//
+// The receiver picks up the hash mode from the slot itself by getMode(), so both sides agree on the
+// algorithm without any extra negotiation. A SHA1 hash might end with the same 4 bytes as the FAST128
+// tag by accident (1/2^32). verify() takes care of this situation by falling back to the SHA1 test.
+//
+{
+public:
+    static constexpr unsigned SLOT_SIZE = Sha1Util::HASH_SIZE;
+    using Slot = Sha1Util::Hash;
+
+    enum class Mode : unsigned char {
+        SHA1 = 0,   // SHA1 by OpenSSL (default)
+        FAST128 = 1 // FastHash
+    };
+
+    // Computes the hash of data by mode and stores the result into slot (SLOT_SIZE byte).
+    static void calc(const Mode mode, const void *addr, const size_t size, unsigned char *slot);
+    static Slot calc(const Mode mode, const void *addr, const size_t size)
+    {
+        Slot slot;
+        calc(mode, addr, size, slot.data());
+        return slot;
+    }
+
+    // Returns the hash mode which was used for creating the slot.
+    static Mode getMode(const unsigned char *slot);
+
+    // Returns true if the slot is the hash of the data.
+    static bool verify(const unsigned char *slot, const void *addr, const size_t size);
+
+    static std::string showMode(const Mode mode);
+    static std::string show(const unsigned char *slot);
+
+protected:
+    static constexpr unsigned char SLOT_TAG[3] = {'F', 'H', 'T'};
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,346 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "EntropyCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+// static function
+void
+EntropyCodec::encode(const void *src, const size_t srcSize, std::string &out)
+{
+    const unsigned stride = selectStride(src, srcSize);
+    if (!stride) {
+        encodeRawMode(src, srcSize, out);
+        return;
+    }
+
+    const size_t outStart = out.size();
+    out.push_back(static_cast<char>(Mode::DELTA_RANS));
+    enqVLSize(srcSize, out);
+    out.push_back(static_cast<char>(stride));
+
+    const unsigned char *in = static_cast<const unsigned char *>(src);
+    const size_t planeSizeMax = (srcSize + stride - 1) / stride;
+    std::vector<unsigned char> residual(planeSizeMax);
+    std::vector<unsigned char> ransBuff(planeSizeMax * 2 + 16); // worst case is 12bit per symbol
+
+    for (unsigned plane = 0; plane < stride; ++plane) {
+        //
+        // prediction : the same byte of the previous pixel record
+        //
+        uint32_t hist[256] = {0};
+        size_t planeSize = 0;
+        for (size_t i = plane; i < srcSize; i += stride) {
+            const unsigned char pred = (i >= stride) ? in[i - stride] : 0x0;
+            const unsigned char r = static_cast<unsigned char>(in[i] - pred);
+            residual[planeSize++] = r;
+            hist[r]++;
+        }
+
+        uint32_t freq[256];
+        normalizeFreq(hist, planeSize, freq);
+        enqFreqTable(freq, out);
+
+        EncSymbol encSymbol[256];
+        for (unsigned s = 0, cum = 0; s < 256; cum += freq[s], ++s) {
+            setupEncSymbol(cum, freq[s], encSymbol[s]);
+        }
+
+        //
+        // rANS encode : symbols are encoded in reverse order and decoded in forward order
+        //
+        unsigned char *const buffEnd = ransBuff.data() + ransBuff.size();
+        unsigned char *ptr = buffEnd;
+        uint32_t x = RANS_L;
+        for (size_t k = planeSize; k > 0; --k) {
+            const EncSymbol &sym = encSymbol[residual[k - 1]];
+            while (x >= sym.mXMax) {
+                *--ptr = static_cast<unsigned char>(x & 0xff);
+                x >>= 8;
+            }
+            // x = (x / freq) * PROB_SCALE + (x % freq) + cum without division
+            const uint32_t q =
+                static_cast<uint32_t>((static_cast<uint64_t>(x) * sym.mRcpFreq) >> 32) >> sym.mRcpShift;
+            x += sym.mBias + q * sym.mCmplFreq;
+        }
+        for (int shift = 24; shift >= 0; shift -= 8) { // flush the final state by little endian
+            *--ptr = static_cast<unsigned char>((x >> shift) & 0xff);
+        }
+
+        const size_t ransSize = static_cast<size_t>(buffEnd - ptr);
+        enqVLSize(ransSize, out);
+        out.append(reinterpret_cast<const char *>(ptr), ransSize);
+    }
+
+    if (out.size() - outStart > srcSize) {
+        // prediction + entropy coding does not work for this data
+        out.resize(outStart);
+        encodeRawMode(src, srcSize, out);
+    }
+}
+
+// static function
+bool
+EntropyCodec::decode(const void *src, const size_t srcSize, const size_t maxDecodeSize,
+                     std::string &out)
+{
+    const unsigned char *ptr = static_cast<const unsigned char *>(src);
+    const unsigned char *end = ptr + srcSize;
+
+    out.clear();
+    if (ptr == end) return false;
+    const Mode mode = static_cast<Mode>(*ptr++);
+    if (mode == Mode::RAW) {
+        const size_t size = static_cast<size_t>(end - ptr);
+        if (size > maxDecodeSize) return false;
+        out.assign(reinterpret_cast<const char *>(ptr), size);
+        return true;
+    }
+    if (mode != Mode::DELTA_RANS) return false; // unknown mode
+
+    size_t origSize = 0;
+    if (!deqVLSize(ptr, end, origSize) || origSize > maxDecodeSize || ptr == end) return false;
+    const unsigned stride = *ptr++;
+    if (stride == 0 || stride > STRIDE_MAX || origSize < stride) return false;
+
+    out.resize(origSize);
+    unsigned char *dst = reinterpret_cast<unsigned char *>(&out[0]);
+
+    std::vector<unsigned char> cum2sym(PROB_SCALE);
+    for (unsigned plane = 0; plane < stride; ++plane) {
+        uint32_t freq[256], cum[256];
+        if (!deqFreqTable(ptr, end, freq)) return false;
+        cum[0] = 0;
+        for (unsigned s = 1; s < 256; ++s) cum[s] = cum[s - 1] + freq[s - 1];
+        for (unsigned s = 0; s < 256; ++s) {
+            std::fill(cum2sym.begin() + cum[s], cum2sym.begin() + cum[s] + freq[s],
+                      static_cast<unsigned char>(s));
+        }
+
+        size_t ransSize = 0;
+        if (!deqVLSize(ptr, end, ransSize) || ransSize < 4 ||
+            ransSize > static_cast<size_t>(end - ptr)) {
+            return false;
+        }
+        const unsigned char *ransPtr = ptr;
+        const unsigned char *ransEnd = ptr + ransSize;
+        ptr = ransEnd;
+
+        uint32_t x = 0; // initial state is stored by little endian
+        for (int shift = 0; shift < 32; shift += 8) x |= static_cast<uint32_t>(*ransPtr++) << shift;
+
+        for (size_t i = plane; i < origSize; i += stride) {
+            const uint32_t slot = x & (PROB_SCALE - 1);
+            const unsigned char s = cum2sym[slot];
+            x = freq[s] * (x >> PROB_BITS) + slot - cum[s];
+            while (x < RANS_L) {
+                if (ransPtr == ransEnd) return false; // broken data
+                x = (x << 8) | *ransPtr++;
+            }
+            const unsigned char pred = (i >= stride) ? dst[i - stride] : 0x0;
+            dst[i] = static_cast<unsigned char>(s + pred);
+        }
+        if (ransPtr != ransEnd || x != RANS_L) return false; // broken data
+    }
+    return ptr == end;
+}
+
+// static function
+std::string
+EntropyCodec::showMode(const Mode mode)
+{
+    switch (mode) {
+    case Mode::RAW : return "RAW";
+    case Mode::DELTA_RANS : return "DELTA_RANS";
+    default : return "?";
+    }
+}
+
+// static function
+unsigned
+EntropyCodec::selectStride(const void *src, const size_t srcSize)
+//
+// Returns the stride which has the lowest estimated encoded size. The estimation is done by the
+// order-0 entropy of the residual of each plane on a sample of the data. Returns 0 if RAW mode is
+// estimated to be smaller than any stride.
+//
+{
+    constexpr size_t SAMPLE_SIZE = 64 * 1024;
+    constexpr size_t MIN_SIZE = 256; // RAW mode is used for the data which is smaller than this
+    if (srcSize < MIN_SIZE) return 0;
+
+    const unsigned char *in = static_cast<const unsigned char *>(src);
+    const size_t sampleSize = std::min(srcSize, SAMPLE_SIZE);
+
+    auto calcBits = [](const uint32_t hist[256], const size_t total) -> double {
+        double bits = 0.0;
+        unsigned symbolTotal = 0;
+        for (unsigned s = 0; s < 256; ++s) {
+            if (!hist[s]) continue;
+            bits -= static_cast<double>(hist[s]) * std::log2(static_cast<double>(hist[s]) / total);
+            symbolTotal++;
+        }
+        return bits + (32 + symbolTotal * 2) * 8; // + frequency table
+    };
+
+    unsigned bestStride = 0;
+    double bestBits = static_cast<double>(sampleSize) * 8.0; // RAW mode
+    std::vector<uint32_t> hist(STRIDE_MAX * 256);
+    for (unsigned stride = 1; stride <= STRIDE_MAX; ++stride) {
+        std::fill(hist.begin(), hist.begin() + stride * 256, 0);
+        unsigned plane = 0;
+        for (size_t i = 0; i < sampleSize; ++i) {
+            const unsigned char pred = (i >= stride) ? in[i - stride] : 0x0;
+            hist[plane * 256 + static_cast<unsigned char>(in[i] - pred)]++;
+            if (++plane == stride) plane = 0;
+        }
+
+        double bits = 0.0;
+        for (plane = 0; plane < stride; ++plane) {
+            const size_t planeSize = (sampleSize - plane + stride - 1) / stride;
+            bits += calcBits(&hist[plane * 256], planeSize);
+        }
+        if (bits < bestBits) {
+            bestBits = bits;
+            bestStride = stride;
+        }
+    }
+    return bestStride;
+}
+
+// static function
+void
+EntropyCodec::normalizeFreq(const uint32_t hist[256], const size_t total, uint32_t freq[256])
+//
+// Scales the histogram to the frequency table which sums up to PROB_SCALE. Every symbol which
+// appears in the histogram keeps a non-zero frequency.
+//
+{
+    uint32_t sum = 0;
+    for (unsigned s = 0; s < 256; ++s) {
+        if (hist[s]) {
+            const uint64_t f = static_cast<uint64_t>(hist[s]) * PROB_SCALE / total;
+            freq[s] = std::max(static_cast<uint32_t>(f), 1U);
+        } else {
+            freq[s] = 0;
+        }
+        sum += freq[s];
+    }
+
+    auto maxSymbol = [&]() {
+        return static_cast<unsigned>(std::max_element(freq, freq + 256) - freq);
+    };
+    while (sum > PROB_SCALE) {
+        // Only happens when many rare symbols are rounded up to 1.
+        const unsigned s = maxSymbol();
+        const uint32_t delta = std::min(sum - PROB_SCALE, freq[s] - 1);
+        freq[s] -= delta;
+        sum -= delta;
+    }
+    if (sum < PROB_SCALE) {
+        freq[maxSymbol()] += PROB_SCALE - sum;
+    }
+}
+
+// static function
+void
+EntropyCodec::setupEncSymbol(const uint32_t cum, const uint32_t freq, EncSymbol &sym)
+//
+// Division free rANS encoding by the reciprocal of the frequency. This is the same idea as
+// "rANS in practice" by Fabian Giesen.
+//
+{
+    sym.mXMax = ((RANS_L >> PROB_BITS) << 8) * freq;
+    sym.mCmplFreq = PROB_SCALE - freq;
+    if (freq < 2) {
+        // freq = 1 : x / freq = x and x % freq = 0. Works with rcpFreq = 2^32-1 and this bias.
+        sym.mRcpFreq = ~0U;
+        sym.mRcpShift = 0;
+        sym.mBias = cum + PROB_SCALE - 1;
+    } else {
+        uint32_t shift = 0;
+        while (freq > (1U << shift)) shift++;
+        sym.mRcpFreq = static_cast<uint32_t>(((static_cast<uint64_t>(1) << (shift + 31)) + freq - 1) / freq);
+        sym.mRcpShift = shift - 1;
+        sym.mBias = cum;
+    }
+}
+
+// static function
+void
+EntropyCodec::enqFreqTable(const uint32_t freq[256], std::string &out)
+//
+// symbol presence bitmask (32byte) + frequency of each present symbol
+//
+{
+    unsigned char mask[32] = {0};
+    for (unsigned s = 0; s < 256; ++s) {
+        if (freq[s]) mask[s >> 3] |= static_cast<unsigned char>(1 << (s & 0x7));
+    }
+    out.append(reinterpret_cast<const char *>(mask), sizeof(mask));
+    for (unsigned s = 0; s < 256; ++s) {
+        if (freq[s]) enqVLSize(freq[s] - 1, out);
+    }
+}
+
+// static function
+bool
+EntropyCodec::deqFreqTable(const unsigned char *&ptr, const unsigned char *end, uint32_t freq[256])
+{
+    if (end - ptr < 32) return false;
+    const unsigned char *mask = ptr;
+    ptr += 32;
+
+    uint32_t sum = 0;
+    for (unsigned s = 0; s < 256; ++s) {
+        freq[s] = 0;
+        if (mask[s >> 3] & (1 << (s & 0x7))) {
+            size_t f = 0;
+            if (!deqVLSize(ptr, end, f) || f >= PROB_SCALE) return false;
+            freq[s] = static_cast<uint32_t>(f) + 1;
+            sum += freq[s];
+        }
+    }
+    return sum == PROB_SCALE;
+}
+
+// static function
+void
+EntropyCodec::enqVLSize(size_t v, std::string &out)
+{
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// static function
+bool
+EntropyCodec::deqVLSize(const unsigned char *&ptr, const unsigned char *end, size_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (ptr == end) return false;
+        const unsigned char c = *ptr++;
+        v |= static_cast<size_t>(c & 0x7f) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+// static function
+void
+EntropyCodec::encodeRawMode(const void *src, const size_t srcSize, std::string &out)
+{
+    out.push_back(static_cast<char>(Mode::RAW));
+    out.append(static_cast<const char *>(src), srcSize);
+}
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,88 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+//
+// -- EntropyCodec : lossless prediction + entropy coding logic for the PackTiles pixel data --
+//
+// EntropyCodec class is used by pack-tile codec version4. This class compresses the byte stream of a
+// single tile pixel block chunk. This logic does not know the meaning of the data and only assumes
+// the byte stream consists of (mostly) fixed size pixel records, like RGBA float + numSample.
+//
+// The encoder works in 2 steps.
+//
+//  1) Prediction : Each byte is predicted by the byte located one stride before, and the difference
+//     (mod 256) is used as the residual. The stride is supposed to be the size of a single pixel
+//     record, so each byte is predicted by the same byte of the previous pixel (i.e. the spatial
+//     neighbour inside the tile). The encoder tries all stride candidates on a sample of the data and
+//     picks the one which has the lowest estimated entropy. The picked stride is stored in the header.
+//
+//  2) Entropy coding : The residuals are split into stride planes (plane = byte position inside the
+//     pixel record) and each plane is encoded by a static order-0 rANS coder with its own frequency
+//     table. For example, exponent bytes of float values are mostly the same as the previous pixel
+//     and are compressed very well, on the other hand, the low mantissa bytes are almost random and
+//     cost close to 8 bits.
+//
+// Decoding reconstructs the exact same byte stream, so this codec is lossless regardless of the
+// PackTiles precision mode. If the encoded data is not smaller than the input, the input is stored
+// as is (RAW mode).
+//
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+
+class EntropyCodec
+{
+public:
+    static constexpr unsigned STRIDE_MAX = 24; // maximum pixel record size (byte) of the prediction
+
+    enum class Mode : unsigned char {
+        RAW = 0,       // stored as is
+        DELTA_RANS = 1 // stride delta prediction + rANS
+    };
+
+    // Encodes srcSize bytes of src and appends the result to out.
+    static void encode(const void *src, const size_t srcSize, std::string &out);
+
+    // Decodes the data which is created by encode() and stores the original byte stream to out.
+    // Returns false if the data is broken or the decoded size is bigger than maxDecodeSize.
+    static bool decode(const void *src, const size_t srcSize, const size_t maxDecodeSize,
+                       std::string &out);
+
+    static std::string showMode(const Mode mode);
+
+    // debug purpose function : returns the stride which encode() picks for the data.
+    static unsigned selectStride(const void *src, const size_t srcSize);
+
+protected:
+    static constexpr unsigned PROB_BITS = 12; // rANS probability precision
+    static constexpr uint32_t PROB_SCALE = 1 << PROB_BITS;
+    static constexpr uint32_t RANS_L = 1 << 23; // lower bound of the rANS state
+
+    // rANS encoder side symbol information
+    struct EncSymbol {
+        uint32_t mXMax;     // renormalization threshold
+        uint32_t mRcpFreq;  // fixed point reciprocal of freq
+        uint32_t mRcpShift; // reciprocal shift
+        uint32_t mBias;
+        uint32_t mCmplFreq; // PROB_SCALE - freq
+    };
+
+    static void normalizeFreq(const uint32_t hist[256], const size_t total, uint32_t freq[256]);
+    static void setupEncSymbol(const uint32_t cum, const uint32_t freq, EncSymbol &sym);
+
+    static void enqFreqTable(const uint32_t freq[256], std::string &out);
+    static bool deqFreqTable(const unsigned char *&ptr, const unsigned char *end, uint32_t freq[256]);
+
+    static void enqVLSize(size_t v, std::string &out);
+    static bool deqVLSize(const unsigned char *&ptr, const unsigned char *end, size_t &v);
+
+    static void encodeRawMode(const void *src, const size_t srcSize, std::string &out);
+};
+
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -4,8 +4,13 @@
 //
 //
 #include "Fb.h"
+#include <scene_rdl2/common/fb_util/MergeUtil.h>
 #include <scene_rdl2/render/logging/logging.h>
 
+#include <algorithm>      // remove_if()
+#include <unordered_map>
+#include <vector>
+
 namespace scene_rdl2 {
 namespace grid_util {
 
@@ -144,109 +149,164 @@ Fb::accumulateAllFbs(const int numMachines,
                      const std::vector<char>& received,
                      const std::vector<grid_util::Fb>& srcFbs)
 //
-// Test function for tile base MT task distribution. Still work in progress.
+// Merges all received source Fbs into this Fb in a single pass over the tiles.
 // This function is used on progmcrt_merge computation
 //
+// Buffer memory is set up only once for all sources, and all the dst/src FbAov pairs are
+// resolved before the merge starts. Then the tile space is split into disjoint tile ranges
+// and each thread folds every received source into its own tiles. Threads never write the
+// same tile, so the merge loop itself needs no locks and does no getAov() lookups.
+//
 {
-    auto bufferSetupFunc = [&](unsigned bufferId, const Fb& src) {
-        switch (bufferId) {
-        case 0 : {
-            if (src.getPixelInfoStatus()) setupPixelInfo(nullptr, src.getPixelInfoName());
-        } break;
-        case 1 : {
-            if (src.getHeatMapStatus()) setupHeatMap(nullptr, src.getHeatMapName());
-        } break;
-        case 2 : {
-            if (src.getWeightBufferStatus()) setupWeightBuffer(nullptr, src.getWeightBufferName());
-        } break;
-        case 3 : {
-            if (src.getRenderBufferOddStatus()) setupRenderBufferOdd(nullptr);
-        } break;
-        case 4 : {
-            if (src.getRenderOutputStatus()) {
-                operatorOnAllActiveAov
-                    (src,
-                     [&](const FbAovShPtr& srcFbAov, FbAovShPtr& dstFbAov) {
-                        if (srcFbAov->getReferenceType() == FbReferenceType::UNDEF) {
-                            // Non-Reference type buffer
-                            // We have to update fbAov information and accumulate data based on
-                            // activeTile information
-
-                            // We always need to process numSampleData on merge computation
-                            constexpr bool storeNumSampleData = true;
-
-                            // need to setup default value before call setup()
-                            dstFbAov->setDefaultValue(srcFbAov->getDefaultValue());
-                            dstFbAov->setup(nullptr,
-                                            srcFbAov->getFormat(),
-                                            srcFbAov->getWidth(),
-                                            srcFbAov->getHeight(), // setup memory and clean if needed
-                                            storeNumSampleData);
-
-                            // setup closestFilter condition
-                            dstFbAov->setClosestFilterStatus(srcFbAov->getClosestFilterStatus());
-
-                        } else {
-                            // Reference type buffer
-                            // Just setup fbAov w/ referenceType information.
-                            // We don't have any actual data for reference buffer type inside fbAov.
-                            dstFbAov->setup(srcFbAov->getReferenceType());
-                        }
-                    });
-            }
-        } break;
+    std::vector<const Fb*> srcs;
+    for (int machineId = 0; machineId < numMachines; ++machineId) {
+        if (received[machineId]) srcs.push_back(&srcFbs[machineId]);
+    }
+    if (srcs.empty()) return;
+
+    //
+    // setup all buffer memory first. Each buffer is set up once using the first source which has
+    // it active (not for every machineId and not for every tile).
+    //
+    auto findFirstSrc = [&](bool (Fb::*statusFunc)() const) -> const Fb* {
+        for (const Fb* src : srcs) {
+            if ((src->*statusFunc)()) return src;
         }
+        return nullptr;
     };
+    const Fb* pixelInfoSrc = findFirstSrc(&Fb::getPixelInfoStatus);
+    const Fb* heatMapSrc = findFirstSrc(&Fb::getHeatMapStatus);
+    const Fb* weightBufferSrc = findFirstSrc(&Fb::getWeightBufferStatus);
+    const Fb* renderBufferOddSrc = findFirstSrc(&Fb::getRenderBufferOddStatus);
+
+    // All the active AOV names over all the sources, each with the sources which have it active.
+    struct AovMerge {
+        FbAovShPtr mDstFbAov;
+        std::vector<FbAovShPtr> mSrcFbAovs;
+    };
+    std::vector<AovMerge> aovMergeArray;
+    std::unordered_map<std::string, size_t> aovMergeIdMap;
+    for (const Fb* src : srcs) {
+        if (!src->getRenderOutputStatus()) continue;
+        for (const auto& itr : src->mRenderOutput) {
+            const FbAovShPtr& srcFbAov = itr.second;
+            if (!srcFbAov->getStatus()) continue; // skip non active aov
+            auto result = aovMergeIdMap.emplace(srcFbAov->getAovName(), aovMergeArray.size());
+            if (result.second) aovMergeArray.emplace_back();
+            aovMergeArray[result.first->second].mSrcFbAovs.push_back(srcFbAov);
+        }
+    }
+    for (const auto& itr : aovMergeIdMap) {
+        // getAov() locks, so all the dst entries are created here, before the parallel section.
+        aovMergeArray[itr.second].mDstFbAov = getAov(itr.first);
+    }
 
-    // setup all buffer memory first. This should be done for every machineId once
-    // (not for every tile of each machineId).
-    for (int machineId = 0; machineId < numMachines; ++machineId) {
-        if (!received[machineId]) continue;        
-        const Fb& src = srcFbs[machineId];
+    auto setupAov = [&](AovMerge& aovMerge) {
+        const FbAovShPtr& srcFbAov = aovMerge.mSrcFbAovs.front();
+        FbAovShPtr& dstFbAov = aovMerge.mDstFbAov;
+        if (srcFbAov->getReferenceType() == FbReferenceType::UNDEF) {
+            // Non-Reference type buffer
+            // We have to update fbAov information and accumulate data based on
+            // activeTile information
+
+            // We always need to process numSampleData on merge computation
+            constexpr bool storeNumSampleData = true;
+
+            // need to setup default value before call setup()
+            dstFbAov->setDefaultValue(srcFbAov->getDefaultValue());
+            dstFbAov->setup(nullptr,
+                            srcFbAov->getFormat(),
+                            srcFbAov->getWidth(),
+                            srcFbAov->getHeight(), // setup memory and clean if needed
+                            storeNumSampleData);
+
+            // setup closestFilter condition
+            dstFbAov->setClosestFilterStatus(srcFbAov->getClosestFilterStatus());
+        } else {
+            // Reference type buffer
+            // Just setup fbAov w/ referenceType information.
+            // We don't have any actual data for reference buffer type inside fbAov.
+            dstFbAov->setup(srcFbAov->getReferenceType());
+        }
+    };
 
-#       ifdef SINGLE_THREAD
-        for (unsigned int bufferId = 0; bufferId < 5; ++bufferId) {
-            bufferSetupFunc(bufferId, src);
+    auto bufferSetupFunc = [&](size_t bufferId) {
+        switch (bufferId) {
+        case 0 : if (pixelInfoSrc) setupPixelInfo(nullptr, pixelInfoSrc->getPixelInfoName()); break;
+        case 1 : if (heatMapSrc) setupHeatMap(nullptr, heatMapSrc->getHeatMapName()); break;
+        case 2 : if (weightBufferSrc) setupWeightBuffer(nullptr, weightBufferSrc->getWeightBufferName()); break;
+        case 3 : if (renderBufferOddSrc) setupRenderBufferOdd(nullptr); break;
+        default : setupAov(aovMergeArray[bufferId - 4]); break;
         }
-#       else // else SINGLE_THREAD
-        // probably we should try to parallel run for machineId loop as well. : TODO
-        tbb::parallel_for(0, 5, [&](unsigned bufferId) { bufferSetupFunc(bufferId, src); });
-#       endif // end !SINGLE_THREAD        
+    };
+    const size_t totalBuffers = 4 + aovMergeArray.size();
+#   ifdef SINGLE_THREAD
+    for (size_t bufferId = 0; bufferId < totalBuffers; ++bufferId) {
+        bufferSetupFunc(bufferId);
     }
-
+#   else // else SINGLE_THREAD
+    tbb::parallel_for(size_t(0), totalBuffers, bufferSetupFunc);
+#   endif // end !SINGLE_THREAD
+    if (!aovMergeArray.empty()) mRenderOutputStatus = true;
+
+    // Reference type AOVs have no data to merge.
+    aovMergeArray.erase(std::remove_if(aovMergeArray.begin(), aovMergeArray.end(),
+                                       [](const AovMerge& aovMerge) {
+                                           return (aovMerge.mSrcFbAovs.front()->getReferenceType() !=
+                                                   FbReferenceType::UNDEF);
+                                       }),
+                        aovMergeArray.end());
+
+    //
     // merge all buffers
+    //
+    // operatorOnPartialTiles() hands each thread a disjoint tile range. For each tile we merge
+    // one buffer from all the sources before moving on to the next buffer, so that the dst tile
+    // stays in cache while the sources are folded into it.
+    //
     operatorOnPartialTiles(nullptr, [&](int tileId) {
-            for (int machineId = 0; machineId < numMachines; ++machineId) {
-                if (!received[machineId]) continue;
-
-                const Fb& src = srcFbs[machineId];
-
-                accumulateRenderBufferOneTile(src, tileId);
-                if (src.getPixelInfoStatus()) accumulatePixelInfoOneTile(src, tileId);
-                if (src.getHeatMapStatus()) accumulatePixelInfoOneTile(src, tileId);
-                if (src.getWeightBufferStatus()) accumulateWeightBufferOneTile(src, tileId);
-                if (src.getRenderBufferOddStatus()) accumulateRenderBufferOddOneTile(src, tileId);
-                if (src.getRenderOutputStatus()) {
-                    operatorOnAllActiveAov(src, [&](const FbAovShPtr& srcFbAov, FbAovShPtr& dstFbAov) {
-                            if (srcFbAov->getReferenceType() != FbReferenceType::UNDEF) return;
-
-                            switch (srcFbAov->getFormat()) {
-                            case VariablePixelBuffer::FLOAT :
-                                accumulateFloat1AovOneTile(dstFbAov, srcFbAov, tileId);
-                                break;
-                            case VariablePixelBuffer::FLOAT2 :
-                                accumulateFloat2AovOneTile(dstFbAov, srcFbAov, tileId);
-                                break;
-                            case VariablePixelBuffer::FLOAT3 :
-                                accumulateFloat3AovOneTile(dstFbAov, srcFbAov, tileId);
-                                break;
-                            case VariablePixelBuffer::FLOAT4 :
-                                accumulateFloat4AovOneTile(dstFbAov, srcFbAov, tileId);
-                                break;
-                            default :
-                                break;
-                            }
-                        });
+            for (const Fb* src : srcs) {
+                accumulateRenderBufferOneTile(*src, tileId);
+            }
+            if (pixelInfoSrc) {
+                for (const Fb* src : srcs) {
+                    if (src->getPixelInfoStatus()) accumulatePixelInfoOneTile(*src, tileId);
+                }
+            }
+            if (heatMapSrc) {
+                for (const Fb* src : srcs) {
+                    if (src->getHeatMapStatus()) accumulateHeatMapOneTile(*src, tileId);
+                }
+            }
+            if (weightBufferSrc) {
+                for (const Fb* src : srcs) {
+                    if (src->getWeightBufferStatus()) accumulateWeightBufferOneTile(*src, tileId);
+                }
+            }
+            if (renderBufferOddSrc) {
+                for (const Fb* src : srcs) {
+                    if (src->getRenderBufferOddStatus()) accumulateRenderBufferOddOneTile(*src, tileId);
+                }
+            }
+            for (AovMerge& aovMerge : aovMergeArray) {
+                FbAovShPtr& dstFbAov = aovMerge.mDstFbAov;
+                for (const FbAovShPtr& srcFbAov : aovMerge.mSrcFbAovs) {
+                    switch (srcFbAov->getFormat()) {
+                    case VariablePixelBuffer::FLOAT :
+                        accumulateFloat1AovOneTile(dstFbAov, srcFbAov, tileId);
+                        break;
+                    case VariablePixelBuffer::FLOAT2 :
+                        accumulateFloat2AovOneTile(dstFbAov, srcFbAov, tileId);
+                        break;
+                    case VariablePixelBuffer::FLOAT3 :
+                        accumulateFloat3AovOneTile(dstFbAov, srcFbAov, tileId);
+                        break;
+                    case VariablePixelBuffer::FLOAT4 :
+                        accumulateFloat4AovOneTile(dstFbAov, srcFbAov, tileId);
+                        break;
+                    default :
+                        break;
+                    }
                 }
             }
         });
@@ -261,28 +321,30 @@ Fb::accumulateTile(T* dstFirstValOfTile,
                    uint64_t srcMask,
                    const T* srcFirstValOfTile,
                    const unsigned int* srcFirstNumSampleTotalOfTile) const
+//
+// T is float, Vec2f, Vec3f or Vec4f (RenderColor). The actual operation is done by the
+// fb_util::MergeUtil SIMD tile function for the number of float components of T.
+//
 {
-    operatorOnActivePixOfTile(srcMask, [&](unsigned pixId) {
-            T& currDstVal = dstFirstValOfTile[pixId];
-            unsigned int& currDstNumSampleTotal = dstFirstNumSampleTotalOfTile[pixId];
-            const T& currSrcVal = srcFirstValOfTile[pixId];
-            const unsigned int& currSrcNumSampleTotal = srcFirstNumSampleTotalOfTile[pixId];
-
-            unsigned int totalSample = currDstNumSampleTotal + currSrcNumSampleTotal;
-            T ave;
-            if (totalSample > 0) {
-                ave =
-                    (currDstVal * static_cast<float>(currDstNumSampleTotal) +
-                     currSrcVal * static_cast<float>(currSrcNumSampleTotal)) /
-                    static_cast<float>(totalSample);
-            } else {
-                // just in case
-                std::memset(reinterpret_cast<void *>(&ave), 0x0, sizeof(T));
-            }
-
-            currDstVal = ave;
-            currDstNumSampleTotal = totalSample;
-        });
+    constexpr size_t numComponents = sizeof(T) / sizeof(float);
+    static_assert(numComponents >= 1 && numComponents <= 4 && sizeof(T) == numComponents * sizeof(float),
+                  "accumulateTile() only supports 1 to 4 float components");
+
+    float* dstV = reinterpret_cast<float*>(dstFirstValOfTile);
+    const float* srcV = reinterpret_cast<const float*>(srcFirstValOfTile);
+    if constexpr (numComponents == 1) {
+        fb_util::MergeUtil::accumulateTileFloatNumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                         srcV, srcFirstNumSampleTotalOfTile);
+    } else if constexpr (numComponents == 2) {
+        fb_util::MergeUtil::accumulateTileFloat2NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                          srcV, srcFirstNumSampleTotalOfTile);
+    } else if constexpr (numComponents == 3) {
+        fb_util::MergeUtil::accumulateTileFloat3NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                          srcV, srcFirstNumSampleTotalOfTile);
+    } else {
+        fb_util::MergeUtil::accumulateTileFloat4NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                          srcV, srcFirstNumSampleTotalOfTile);
+    }
 }
 
 template <typename T>
@@ -294,29 +356,24 @@ Fb::accumulateTileClosestFilter(T* dstFirstValOfTile,
                                 const unsigned int* srcFirstNumSampleTotalOfTile) const
 //
 // special accumulateTile function for the case of using closestFilter
+// T is Vec2f, Vec3f or Vec4f and the last component is the depth.
 //
 {
-    unsigned int depthId = T::N - 1; // depth value is last component
-    
-    operatorOnActivePixOfTile(srcMask, [&](unsigned pixId) { // operatePixFunc
-            T& currDstVal = dstFirstValOfTile[pixId];
-            unsigned int& currDstNumSampleTotal = dstFirstNumSampleTotalOfTile[pixId];
-            const T& currSrcVal = srcFirstValOfTile[pixId];
-            const unsigned int& currSrcNumSampleTotal = srcFirstNumSampleTotalOfTile[pixId];
-
-            unsigned int totalSample = currDstNumSampleTotal + currSrcNumSampleTotal;
-            if (totalSample > 0) {
-                if (currDstNumSampleTotal == 0) {
-                    currDstVal = currSrcVal;
-                } else {
-                    if (currSrcVal[depthId] < currDstVal[depthId]) {
-                        // replace currDstVal if currSrcVal's closestFilter depth is closer
-                        currDstVal = currSrcVal;
-                    }
-                }
-                currDstNumSampleTotal = totalSample;
-            }
-        });
+    static_assert(T::N >= 2 && T::N <= 4 && sizeof(T) == T::N * sizeof(float),
+                  "accumulateTileClosestFilter() only supports 2 to 4 float components");
+
+    float* dstV = reinterpret_cast<float*>(dstFirstValOfTile);
+    const float* srcV = reinterpret_cast<const float*>(srcFirstValOfTile);
+    if constexpr (T::N == 2) {
+        fb_util::MergeUtil::accumulateTileFloat2ClosestFilter(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                              srcV, srcFirstNumSampleTotalOfTile);
+    } else if constexpr (T::N == 3) {
+        fb_util::MergeUtil::accumulateTileFloat3ClosestFilter(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                              srcV, srcFirstNumSampleTotalOfTile);
+    } else {
+        fb_util::MergeUtil::accumulateTileFloat4ClosestFilter(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                              srcV, srcFirstNumSampleTotalOfTile);
+    }
 }
 
 //---------------------------------------------------------------------------------------------------------------
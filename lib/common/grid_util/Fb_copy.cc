@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "Fb.h"
+#include <scene_rdl2/common/fb_util/MergeUtil.h>
 
 namespace scene_rdl2 {
 namespace grid_util {
@@ -185,16 +186,30 @@ void Fb::copyTile(T* dstFirstValOfTile,
                   uint64_t srcMask,
                   const T* srcFirstValOfTile,
                   const unsigned int* srcFirstNumSampleTotalOfTile) const
+//
+// T is float, Vec2f, Vec3f or Vec4f (RenderColor). The actual operation is done by the
+// fb_util::MergeUtil SIMD tile function for the number of float components of T.
+//
 {
-    operatorOnActivePixOfTile(srcMask, [&](unsigned pixId) {
-            T& currDstVal = dstFirstValOfTile[pixId];
-            unsigned int& currDstNumSampleTotal = dstFirstNumSampleTotalOfTile[pixId];
-            const T& currSrcVal = srcFirstValOfTile[pixId];
-            const unsigned int& currSrcNumSampleTotal = srcFirstNumSampleTotalOfTile[pixId];
-
-            currDstVal = currSrcVal;
-            currDstNumSampleTotal = currSrcNumSampleTotal;
-        });
+    constexpr size_t numComponents = sizeof(T) / sizeof(float);
+    static_assert(numComponents >= 1 && numComponents <= 4 && sizeof(T) == numComponents * sizeof(float),
+                  "copyTile() only supports 1 to 4 float components");
+
+    float* dstV = reinterpret_cast<float*>(dstFirstValOfTile);
+    const float* srcV = reinterpret_cast<const float*>(srcFirstValOfTile);
+    if constexpr (numComponents == 1) {
+        fb_util::MergeUtil::copyTileFloatNumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                   srcV, srcFirstNumSampleTotalOfTile);
+    } else if constexpr (numComponents == 2) {
+        fb_util::MergeUtil::copyTileFloat2NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                    srcV, srcFirstNumSampleTotalOfTile);
+    } else if constexpr (numComponents == 3) {
+        fb_util::MergeUtil::copyTileFloat3NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                    srcV, srcFirstNumSampleTotalOfTile);
+    } else {
+        fb_util::MergeUtil::copyTileFloat4NumSample(dstV, dstFirstNumSampleTotalOfTile, srcMask,
+                                                    srcV, srcFirstNumSampleTotalOfTile);
+    }
 }
 
 void Fb::copyRenderBufferOneTile(const Fb& src, const int tileId)
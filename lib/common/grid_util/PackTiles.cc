@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "PackTiles.h"
+#include "ContentHash.h"
+#include "EntropyCodec.h"
 #include "PackActiveTiles.h"
 
 #include <scene_rdl2/common/fb_util/ActivePixels.h>
@@ -17,8 +19,9 @@
 #include <scene_rdl2/scene/rdl2/ValueContainerDeq.h>
 #include <scene_rdl2/scene/rdl2/ValueContainerEnq.h>
 
+#include <algorithm>
 #include <iomanip>
-#include <openssl/sha.h>
+#include <vector>
 
 //
 // DEBUG_MODE directive activates debug message.
@@ -67,6 +70,18 @@
 // use sRGB conversion if LOWPRECISION_8BIT_GAMMA22 is commented out.
 #define LOWPRECISION_8BIT_GAMMA22 // lowprecision float to 8bit with gamma 2.2 conversion
 
+// VER3 and VER4 encode/decode the tile pixel block chunks by multi-thread.
+// This single thread mode is used debugging and performance comparison reason mainly.
+// ShmFootmark debug messages only support single thread, so DEBUG_SHMFOOTMARK_MODE needs single thread.
+//#define SINGLE_THREAD
+#if defined(DEBUG_MODE) && defined(DEBUG_SHMFOOTMARK_MODE)
+#define SINGLE_THREAD
+#endif // end DEBUG_MODE && DEBUG_SHMFOOTMARK_MODE
+
+#ifndef SINGLE_THREAD
+#include <tbb/parallel_for.h>
+#endif // end !SINGLE_THREAD
+
 namespace scene_rdl2 {
 namespace grid_util {
 
@@ -106,6 +121,7 @@ public:
     static constexpr unsigned HASH_SIZE = 20; // SHA1 hash size : byte
 
     using EnqFormatVer = PackTiles::EnqFormatVer;
+    using HashMode = PackTiles::HashMode;
     using PrecisionMode = PackTiles::PrecisionMode;
     using DataType = PackTiles::DataType;
 
@@ -125,7 +141,8 @@ public:
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool noNumSampleMode,
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // for McrtMergeComputation
     // RGBA : float * 4
@@ -138,7 +155,8 @@ public:
            const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // for McrtMergeComputation : for feedback logic between merge and mcrt computation
     // RGBA + numSample : float * 4 + u_int
@@ -152,7 +170,8 @@ public:
            const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // RGBA + numSample : float * 4 + u_int
     template <bool renderBufferOdd>
@@ -195,7 +214,8 @@ public:
                     const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                     const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                     const bool withSha1Hash = false,
-                    const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                    const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                    const HashMode hashMode = HashMode::SHA1);
 
     static bool
     decodePixelInfo(const void* addr,                         // in
@@ -222,7 +242,8 @@ public:
                   std::string &output,
                   const bool noNumSampleMode,
                   const bool withSha1Hash = false,
-                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                  const HashMode hashMode = HashMode::SHA1);
 
     // Sec : float * 1
     // no precision related argument because heatMap always uses H16
@@ -231,7 +252,8 @@ public:
                   const FloatBuffer &heatMapSecBufferTiled, // normalize sec
                   std::string &output,
                   const bool withSha1Hash = false,
-                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                  const HashMode hashMode = HashMode::SHA1);
 
     // Sec + numSample : float * 1 + u_int
     // no precision related argument because heatMap always uses H16
@@ -270,7 +292,8 @@ public:
                        const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                        const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                        const bool withSha1Hash = false,
-                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                       const HashMode hashMode = HashMode::SHA1);
 
     static bool
     decodeWeightBuffer(const void* addr,               // in
@@ -306,7 +329,8 @@ public:
                        const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                        const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                        const bool withSha1Hash = false,
-                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                       const HashMode hashMode = HashMode::SHA1);
     // for mcrt_dataio::MergeFbSender (progmcrtmerge)
     // VariableValue(float1|float2|float3|float4)
     static size_t
@@ -319,7 +343,8 @@ public:
                             const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                             const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                             const bool withSha1Hash = false,
-                            const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                            const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                            const HashMode hashMode = HashMode::SHA1);
 
     // VariableValue(float1|float2|float3|float4) + numSample : float * (1|2|3) + u_int
     // or
@@ -342,7 +367,8 @@ public:
     encodeRenderOutputReference(const FbReferenceType &referenceType,
                                 std::string &output,
                                 const bool withSha1Hash = false,
-                                const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                                const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                                const HashMode hashMode = HashMode::SHA1);
     static bool
     decodeRenderOutputReference(const void *addr,      // in
                                 const size_t dataSize, // in
@@ -399,6 +425,140 @@ public:
 private:
     using Vec4f = math::Vec4<float>;
 
+    //------------------------------
+    //
+    // VER3/VER4 tile pixel block chunks
+    //
+    // VER3 splits the tile pixel block into chunks of contiguous tileId range. Each chunk is enqueued
+    // as an independent ValueContainer data, so chunks are encoded and decoded by multi-thread.
+    // Chunk table (tileId end and data size of each chunk) is located right after the tile mask block
+    // and all chunk data follows the table.
+    // VER4 uses the same layout but each chunk data is compressed by EntropyCodec. The chunk table
+    // keeps the compressed size.
+    //
+    static constexpr size_t CHUNK_PIXEL_SIZE_MAX = 64; // upper bound of the single pixel data size (byte)
+    static constexpr unsigned CHUNK_ACTIVE_TILE_MIN = 256; // minimum active tiles of one chunk
+    static constexpr unsigned CHUNK_MAX = 64; // maximum chunk total
+
+    // A contiguous tileId range [tileIdStart, tileIdEnd) of ActivePixels.
+    // This is the unit of tile pixel block encode/decode.
+    class ActiveTileRange
+    {
+    public:
+        explicit ActiveTileRange(const ActivePixels &activePixels)
+            : mActivePixels(activePixels)
+            , mTileIdStart(0)
+            , mTileIdEnd(activePixels.getNumTiles())
+        {}
+        ActiveTileRange(const ActivePixels &activePixels,
+                        const unsigned tileIdStart,
+                        const unsigned tileIdEnd)
+            : mActivePixels(activePixels)
+            , mTileIdStart(tileIdStart)
+            , mTileIdEnd(tileIdEnd)
+        {}
+
+        uint64_t getTileMask(const unsigned tileId) const { return mActivePixels.getTileMask(tileId); }
+        unsigned getTileIdStart() const { return mTileIdStart; }
+        unsigned getTileIdEnd() const { return mTileIdEnd; }
+
+    private:
+        const ActivePixels &mActivePixels;
+        const unsigned mTileIdStart;
+        const unsigned mTileIdEnd;
+    };
+
+    // Dequeue side of the tile pixel block. decodeMain() sets this up right after the tile mask block
+    // and passes it to deqTilePixelBlockFunc. VER1/VER2 data has a single tile pixel block which is
+    // decoded by the caller thread. VER3/VER4 data is decoded chunk by chunk by multi-thread.
+    class TilePixelBlockDeq
+    {
+    public:
+        TilePixelBlockDeq(VContainerDeq &vContainerDeq, const ActivePixels &activePixels)
+            : mVContainerDeq(vContainerDeq)
+            , mActivePixels(activePixels)
+        {}
+
+        // VER3/VER4 only. VER4 chunk data is decompressed here by multi-thread.
+        // return false if the chunk table or chunk data is broken.
+        bool deqChunkTable(const bool entropyCoded);
+
+        // chunkFunc(VContainerDeq &vContainerDeq, const ActiveTileRange &activeTiles) is called once
+        // for each chunk. chunkFunc might be called by multi-thread for VER3/VER4 data.
+        template <typename F>
+        void crawlChunks(F chunkFunc) const {
+            if (mChunkVContainerDeq.empty()) {
+                chunkFunc(mVContainerDeq, ActiveTileRange(mActivePixels));
+                return;
+            }
+
+            auto deqChunk = [&](const size_t chunkId) {
+                // shallow copy and each chunk keeps own current dequeue position
+                VContainerDeq vContainerDeq = mChunkVContainerDeq[chunkId];
+                const unsigned tileIdStart = (chunkId == 0) ? 0 : mChunkTileIdEnd[chunkId - 1];
+                chunkFunc(vContainerDeq, ActiveTileRange(mActivePixels, tileIdStart, mChunkTileIdEnd[chunkId]));
+            };
+#           ifdef SINGLE_THREAD
+            for (size_t chunkId = 0; chunkId < mChunkVContainerDeq.size(); ++chunkId) {
+                deqChunk(chunkId);
+            }
+#           else // else SINGLE_THREAD
+            tbb::parallel_for(size_t(0), mChunkVContainerDeq.size(), deqChunk);
+#           endif // end !SINGLE_THREAD
+        }
+
+    private:
+        VContainerDeq &mVContainerDeq;
+        const ActivePixels &mActivePixels;
+
+        std::vector<unsigned> mChunkTileIdEnd; // empty for VER1/VER2
+        std::vector<VContainerDeq> mChunkVContainerDeq;
+        std::vector<std::string> mChunkData; // VER4 decompressed chunk data
+    };
+
+    static void calcTilePixelBlockChunk(const ActivePixels &activePixels,
+                                        std::vector<unsigned> &chunkTileIdEnd);
+
+    template <typename F>
+    static void enqTilePixelBlockChunk(const EnqFormatVer enqFormatVer,
+                                       const ActivePixels &activePixels,
+                                       VContainerEnq &vContainerEnq,
+                                       F enqTilePixelBlockFunc) {
+        std::vector<unsigned> chunkTileIdEnd;
+        calcTilePixelBlockChunk(activePixels, chunkTileIdEnd);
+
+        std::vector<std::string> chunkData(chunkTileIdEnd.size());
+        auto enqChunk = [&](const size_t chunkId) {
+            const unsigned tileIdStart = (chunkId == 0) ? 0 : chunkTileIdEnd[chunkId - 1];
+            VContainerEnq chunkVContainerEnq(&chunkData[chunkId]);
+            enqTilePixelBlockFunc(chunkVContainerEnq,
+                                  ActiveTileRange(activePixels, tileIdStart, chunkTileIdEnd[chunkId]));
+            chunkVContainerEnq.finalize();
+
+            if (enqFormatVer == EnqFormatVer::VER4) {
+                std::string compressed;
+                EntropyCodec::encode(chunkData[chunkId].data(), chunkData[chunkId].size(), compressed);
+                chunkData[chunkId].swap(compressed);
+            }
+        };
+#       ifdef SINGLE_THREAD
+        for (size_t chunkId = 0; chunkId < chunkData.size(); ++chunkId) {
+            enqChunk(chunkId);
+        }
+#       else // else SINGLE_THREAD
+        tbb::parallel_for(size_t(0), chunkData.size(), enqChunk);
+#       endif // end !SINGLE_THREAD
+
+        vContainerEnq.enqVLUInt(static_cast<unsigned>(chunkData.size()));
+        for (size_t chunkId = 0; chunkId < chunkData.size(); ++chunkId) {
+            vContainerEnq.enqVLUInt(chunkTileIdEnd[chunkId]);
+            vContainerEnq.enqVLSizeT(chunkData[chunkId].size());
+        }
+        for (const std::string &data : chunkData) {
+            vContainerEnq.enqByteData(data.data(), data.size());
+        }
+    }
+
     //------------------------------
 
     finline static void
@@ -717,6 +877,7 @@ private:
                              const ActivePixels &activePixels,
                              std::string &output,
                              const bool withSha1Hash,
+                             const HashMode hashMode,
                              F enqTilePixelBlockFunc) {
         //------------------------------
         //
@@ -748,7 +909,11 @@ private:
         sizeInfoPtr = sizeInfo.data();
 #       endif // end DEBUG_MSG_SIZEDUMP
         if (enqTileMaskBlock(enqFormatVer, activePixels, vContainerEnq, sizeInfoPtr)) {
-            enqTilePixelBlockFunc(vContainerEnq);
+            if (enqFormatVer == EnqFormatVer::VER3 || enqFormatVer == EnqFormatVer::VER4) {
+                enqTilePixelBlockChunk(enqFormatVer, activePixels, vContainerEnq, enqTilePixelBlockFunc);
+            } else {
+                enqTilePixelBlockFunc(vContainerEnq, ActiveTileRange(activePixels));
+            }
         }
     
         size_t dataSize = vContainerEnq.finalize(); // data size
@@ -786,7 +951,7 @@ private:
             unsigned char *dstPtr =
                 reinterpret_cast<unsigned char *>((uintptr_t)(output.data()) +
                                                   static_cast<uintptr_t>(hashOffset));
-            SHA1(srcPtr, srcSize, dstPtr);
+            ContentHash::calc(hashMode, srcPtr, srcSize, dstPtr);
         }
 
         return dataSize + HASH_SIZE;
@@ -881,13 +1046,25 @@ private:
                 return true;       // decode tileMaskBlock returns no-data condition
             }
 
+            TilePixelBlockDeq tilePixelBlockDeq(vContainerDeq, activePixels);
+            if (formatVersion >= static_cast<unsigned>(EnqFormatVer::VER3)) {
+                const bool entropyCoded = (formatVersion == static_cast<unsigned>(EnqFormatVer::VER4));
+                if (!tilePixelBlockDeq.deqChunkTable(entropyCoded)) {
+                    activeDecodeAction = false;
+#                   ifdef DEBUG_FOOTMARK_DECODEMAIN
+                    debugFootmarkPop();
+#                   endif // end DEBUG_FOOTMARK_DECODEMAIN
+                    return false; // broken chunk table
+                }
+            }
+
 #           ifdef DEBUG_FOOTMARK_DECODEMAIN
             debugFootmark([]() { return ">> PackTiles.cc decodeMain() before deqTilePixelBlockFunc()"; });
             debugFootmarkPush();
 #           endif // end DEBUG_FOOTMARK_DECODEMAIN
             if (!deqTilePixelBlockFunc(currDataType, defaultValue, precisionMode, closestFilterStatus,
                                        coarsePassPrecision, finePassPrecision,
-                                       vContainerDeq)) {
+                                       tilePixelBlockDeq)) {
                 activeDecodeAction = false;
 #               ifdef DEBUG_FOOTMARK_DECODEMAIN
                 debugFootmarkPop();
@@ -915,7 +1092,7 @@ private:
     static void enqTilePixelBlockValSample(VContainerEnq &vContainerEnq,
                                            const PrecisionMode precisionMode,
                                            const bool doNormalizeMode,
-                                           const ActivePixels &activePixels,
+                                           const ActiveTileRange &activeTiles,
                                            const B &bufferTiled,
                                            const FloatBuffer &weightBufferTiled,
                                            UC8 funcLowPrecision,
@@ -927,7 +1104,7 @@ private:
             //
             // 8bit precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -940,7 +1117,7 @@ private:
             //
             // 16bit half float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -953,7 +1130,7 @@ private:
             //
             // 32bit full float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -974,7 +1151,7 @@ private:
     static void enqTilePixelBlockVal(VContainerEnq &vContainerEnq,
                                      const PrecisionMode precisionMode,
                                      const bool doNormalizeMode,
-                                     const ActivePixels &activePixels,
+                                     const ActiveTileRange &activeTiles,
                                      const B &bufferTiled,
                                      const FloatBuffer &weightBufferTiled,
                                      UC8 funcLowPrecision,
@@ -986,7 +1163,7 @@ private:
             //
             // 8bit precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -999,7 +1176,7 @@ private:
             //
             // 16bit half float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -1012,7 +1189,7 @@ private:
             //
             // 32bit full float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   const float *__restrict srcWeight =
@@ -1029,7 +1206,7 @@ private:
     template <typename B, typename UC8, typename H16, typename F32>
     static void enqTilePixelBlockValSampleNormalizedSrc(VContainerEnq &vContainerEnq,
                                                         const PrecisionMode precisionMode,
-                                                        const ActivePixels& activePixels,
+                                                        const ActiveTileRange& activeTiles,
                                                         const B& bufferTiled,
                                                         const NumSampleBuffer& numSampleBufferTiled,
                                                         UC8 funcLowPrecision,
@@ -1041,7 +1218,7 @@ private:
             //
             // 8bit precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto* __restrict src = bufferTiled.getData() + pixelOffset;
                                   const unsigned int* __restrict srcNumSample =
@@ -1054,7 +1231,7 @@ private:
             //
             // 16bit half float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto* __restrict src = bufferTiled.getData() + pixelOffset;
                                   const unsigned int* __restrict srcNumSample =
@@ -1067,7 +1244,7 @@ private:
             //
             // 32bit full float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto* __restrict src = bufferTiled.getData() + pixelOffset;
                                   const unsigned int* __restrict srcNumSample =
@@ -1084,7 +1261,7 @@ private:
     template <typename B, typename UC8, typename H16, typename F32>
     static void enqTilePixelBlockValNormalizedSrc(VContainerEnq &vContainerEnq,
                                                   const PrecisionMode precisionMode,
-                                                  const ActivePixels &activePixels,
+                                                  const ActiveTileRange &activeTiles,
                                                   const B &bufferTiled,
                                                   UC8 funcLowPrecision,
                                                   H16 funcHalfPrecision,
@@ -1095,7 +1272,7 @@ private:
             //
             // 8bit precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   enqTileValNormalizedSrc(mask, src, vContainerEnq, funcLowPrecision);
@@ -1105,7 +1282,7 @@ private:
             //
             // 16bit half float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   enqTileValNormalizedSrc(mask, src, vContainerEnq, funcHalfPrecision);
@@ -1115,7 +1292,7 @@ private:
             //
             // 32bit full float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) {
                                   const auto *__restrict src = bufferTiled.getData() + pixelOffset;
                                   enqTileValNormalizedSrc(mask, src, vContainerEnq, funcFullPrecision);
@@ -1129,7 +1306,7 @@ private:
     template <typename B, typename UC8, typename H16, typename F32>
     static void deqTilePixelBlockValSample(VContainerDeq& vContainerDeq,
                                            const PrecisionMode precisionMode,
-                                           const ActivePixels& activePixels,
+                                           const ActiveTileRange& activeTiles,
                                            B& normalizedBufferTiled,
                                            NumSampleBuffer& numSampleBufferTiled,
                                            bool storeNumSampleData,
@@ -1159,7 +1336,7 @@ private:
             debugFootmarkPush();
 #           endif // end DEBUG_FOOTMARK_DEQTILEPIXELBLOCKVALSAMPLE
             {
-                activeTileCrawler(activePixels,
+                activeTileCrawler(activeTiles,
                                   [&](uint64_t mask, unsigned pixelOffset) { // func
                                       auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                       unsigned int *__restrict dstNumSample =
@@ -1188,7 +1365,7 @@ private:
             debugFootmarkPush();
 #           endif // end DEBUG_FOOTMARK_DEQTILEPIXELBLOCKVALSAMPLE
             {
-                activeTileCrawler(activePixels,
+                activeTileCrawler(activeTiles,
                                   [&](uint64_t mask, unsigned pixelOffset) { // func
                                       auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                       unsigned int *__restrict dstNumSample =
@@ -1217,7 +1394,7 @@ private:
             debugFootmarkPush();
 #           endif // end DEBUG_FOOTMARK_DEQTILEPIXELBLOCKVALSAMPLE
             {
-                activeTileCrawler(activePixels,
+                activeTileCrawler(activeTiles,
                                   [&](uint64_t mask, unsigned pixelOffset) { // func
                                       auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                       unsigned int *__restrict dstNumSample =
@@ -1247,7 +1424,7 @@ private:
     template <typename B, typename UC8, typename H16, typename F32>
     static void deqTilePixelBlockVal(VContainerDeq &vContainerDeq,
                                      const PrecisionMode precisionMode,
-                                     const ActivePixels &activePixels,
+                                     const ActiveTileRange &activeTiles,
                                      B &normalizedBufferTiled,
                                      UC8 funcLowPrecision,
                                      H16 funcHalfPrecision,
@@ -1258,7 +1435,7 @@ private:
             //
             // 8bit precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                   deqTileVal(vContainerDeq, mask, dst, funcLowPrecision);
@@ -1268,7 +1445,7 @@ private:
             //
             // 16bit half float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                   deqTileVal(vContainerDeq, mask, dst, funcHalfPrecision);
@@ -1278,7 +1455,7 @@ private:
             //
             // 32bit full float precision
             //
-            activeTileCrawler(activePixels,
+            activeTileCrawler(activeTiles,
                               [&](uint64_t mask, unsigned pixelOffset) { // func
                                   auto *__restrict dst = normalizedBufferTiled.getData() + pixelOffset;
                                   deqTileVal(vContainerDeq, mask, dst, funcFullPrecision);
@@ -1290,10 +1467,10 @@ private:
     }
 
     template <typename F>
-    static void activeTileCrawler(const ActivePixels &activePixels, F tileFunc) {
+    static void activeTileCrawler(const ActiveTileRange &activeTiles, F tileFunc) {
         uint64_t mask = 0x0;
-        for (unsigned tileId = 0; tileId < activePixels.getNumTiles(); ++tileId) {
-            if ((mask = activePixels.getTileMask(tileId)) != 0x0) {
+        for (unsigned tileId = activeTiles.getTileIdStart(); tileId < activeTiles.getTileIdEnd(); ++tileId) {
+            if ((mask = activeTiles.getTileMask(tileId)) != 0x0) {
                 unsigned pixelOffset = tileId << 6;
                 tileFunc(mask, pixelOffset);
             }
@@ -1617,7 +1794,8 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
                       const FinePassPrecision finePassPrecision,
                       const bool noNumSampleMode,
                       const bool withSha1Hash,
-                      const EnqFormatVer enqFormatVer)
+                      const EnqFormatVer enqFormatVer,
+                      const HashMode hashMode)
 //
 // for McrtComputation : RenderBuffer (beauty/alpha), RenderBufferOdd (beautyAux/alphaAux)
 //
@@ -1641,17 +1819,18 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
 //
 {
     DataType dataType = DataType::UNDEF;
-    std::function<void (VContainerEnq &)> enqTilePixelBlockFunc;
+    std::function<void (VContainerEnq &, const ActiveTileRange &)> enqTilePixelBlockFunc;
     if (noNumSampleMode) {
         dataType = ((renderBufferOdd) ?
                     DataType::BEAUTYODD :
                     DataType::BEAUTY);
-        enqTilePixelBlockFunc = [&](VContainerEnq &vContainerEnq) {
+        enqTilePixelBlockFunc = [&](VContainerEnq &vContainerEnq,
+                                    const ActiveTileRange &activeTiles) {
             enqTilePixelBlockVal
             (vContainerEnq,
              precisionMode,
              true, // doNormalizeMode
-             activePixels,
+             activeTiles,
              renderBufferTiled,
              weightBufferTiled,
              [&](const RenderColor &v) { // lowPrecision
@@ -1668,12 +1847,13 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
         dataType = ((renderBufferOdd) ?
                     DataType::BEAUTYODD_WITH_NUMSAMPLE :
                     DataType::BEAUTY_WITH_NUMSAMPLE);
-        enqTilePixelBlockFunc = [&](VContainerEnq &vContainerEnq) {
+        enqTilePixelBlockFunc = [&](VContainerEnq &vContainerEnq,
+                                    const ActiveTileRange &activeTiles) {
             enqTilePixelBlockValSample
             (vContainerEnq,
              precisionMode,
              true, // doNormalizeMode
-             activePixels,
+             activeTiles,
              renderBufferTiled,
              weightBufferTiled,
              [&](const RenderColor &v, unsigned int numSample) { // lowPrecision
@@ -1701,6 +1881,7 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
+                      hashMode,
                       enqTilePixelBlockFunc);
 }
 
@@ -1714,7 +1895,8 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
                       const CoarsePassPrecision coarsePassPrecision,
                       const FinePassPrecision finePassPrecision,
                       const bool withSha1Hash,
-                      const EnqFormatVer enqFormatVer)
+                      const EnqFormatVer enqFormatVer,
+                      const HashMode hashMode)
 //
 // for McrtMergeComputation : RenderBuffer (beauty/alpha), RenderBufferOdd (beautyAux/alphaAux)
 //
@@ -1736,11 +1918,13 @@ PackTilesImpl::encode(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                           enqTilePixelBlockValNormalizedSrc
                           (vContainerEnq,
                            precisionMode,
-                           activePixels,
+                           activeTiles,
                            renderBufferTiled,
                            [&](const RenderColor &v) { // lowPrecision
                               enqLowPrecisionVec4f(vContainerEnq, v);
@@ -1765,7 +1949,8 @@ PackTilesImpl::encode(const ActivePixels& activePixels,
                       const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                       const FinePassPrecision finePassPrecision, // minimum fine pass precision
                       const bool withSha1Hash,
-                      const EnqFormatVer enqFormatVer)
+                      const EnqFormatVer enqFormatVer,
+                      const HashMode hashMode)
 //
 // for McrtMergeComputation : RenderBuffer (beauty/alpha), RenderBufferOdd (beautyAux/alphaAux)
 //
@@ -1789,11 +1974,13 @@ PackTilesImpl::encode(const ActivePixels& activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                           enqTilePixelBlockValSampleNormalizedSrc
                           (vContainerEnq,
                            precisionMode,
-                           activePixels,
+                           activeTiles,
                            renderBufferTiled,
                            numSampleBufferTiled,
                            [&](const RenderColor &v, unsigned int numSample) { // lowPrecision
@@ -1859,7 +2046,7 @@ PackTilesImpl::decode(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision currCoarsePassPrecision,
                        FinePassPrecision currFinePassPrecision,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_A
                        debugFootmark([]() {
@@ -1910,25 +2097,28 @@ PackTilesImpl::decode(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_A
 
-                           deqTilePixelBlockValSample
-                               (vContainerDeq,
-                                precisionMode,
-                                activePixels,
-                                normalizedRenderBufferTiled,
-                                numSampleBufferTiled,
-                                storeNumSampleData,
-                                [&](RenderColor& v, unsigned int& numSample) { // lowPrecision
-                                   v = deqLowPrecisionVec4f(vContainerDeq);
-                                   numSample = vContainerDeq.deqVLUInt();
-                                },
-                                [&](RenderColor& v, unsigned int& numSample) { // halfPrecision
-                                    v = deqHalfPrecisionVec4f(vContainerDeq);
-                                    numSample = vContainerDeq.deqVLUInt();
-                                },
-                                [&](RenderColor& v, unsigned int& numSample) { // fullPrecision
-                                    v = vContainerDeq.deqVec4f();
-                                    numSample = vContainerDeq.deqVLUInt();
-                                });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   deqTilePixelBlockValSample
+                                       (vContainerDeq,
+                                        precisionMode,
+                                        activeTiles,
+                                        normalizedRenderBufferTiled,
+                                        numSampleBufferTiled,
+                                        storeNumSampleData,
+                                        [&](RenderColor& v, unsigned int& numSample) { // lowPrecision
+                                           v = deqLowPrecisionVec4f(vContainerDeq);
+                                           numSample = vContainerDeq.deqVLUInt();
+                                        },
+                                        [&](RenderColor& v, unsigned int& numSample) { // halfPrecision
+                                            v = deqHalfPrecisionVec4f(vContainerDeq);
+                                            numSample = vContainerDeq.deqVLUInt();
+                                        },
+                                        [&](RenderColor& v, unsigned int& numSample) { // fullPrecision
+                                            v = vContainerDeq.deqVec4f();
+                                            numSample = vContainerDeq.deqVLUInt();
+                                        });
+                               });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_A
                        debugFootmarkPop();
@@ -1989,7 +2179,7 @@ PackTilesImpl::decode(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision currCoarsePassPrecision,
                        FinePassPrecision currFinePassPrecision,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_B
                        debugFootmark([]() {
@@ -2026,19 +2216,22 @@ PackTilesImpl::decode(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_B
 
-                           deqTilePixelBlockVal(vContainerDeq,
-                                                precisionMode,
-                                                activePixels,
-                                                normalizedRenderBufferTiled,
-                                                [&](RenderColor& v) { // lowPrecision
-                                                    v = deqLowPrecisionVec4f(vContainerDeq);
-                                                },
-                                                [&](RenderColor& v) { // halfPrecision
-                                                    v = deqHalfPrecisionVec4f(vContainerDeq);
-                                                },
-                                                [&](RenderColor& v) { // fullPrecision
-                                                    v = vContainerDeq.deqVec4f();
-                                                });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   deqTilePixelBlockVal(vContainerDeq,
+                                                        precisionMode,
+                                                        activeTiles,
+                                                        normalizedRenderBufferTiled,
+                                                        [&](RenderColor& v) { // lowPrecision
+                                                            v = deqLowPrecisionVec4f(vContainerDeq);
+                                                        },
+                                                        [&](RenderColor& v) { // halfPrecision
+                                                            v = deqHalfPrecisionVec4f(vContainerDeq);
+                                                        },
+                                                        [&](RenderColor& v) { // fullPrecision
+                                                            v = vContainerDeq.deqVec4f();
+                                                        });
+                               });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_B
                        debugFootmarkPop();
@@ -2113,11 +2306,11 @@ PackTilesImpl::deqHeaderBlock(VContainerDeq &vContainerDeq,
                               FinePassPrecision &finePassPrecision) // minimum fine pass precision
 {
     formatVersion = vContainerDeq.deqVLUInt();
-    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER2)) {
-        return false; // This code only understand up to VER2.
+    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER4)) {
+        return false; // This code only understand up to VER4.
     }
 
-    // formatVersion : VER1, VER2
+    // formatVersion : VER1, VER2, VER3, VER4
 
     dataType = static_cast<DataType>(vContainerDeq.deqVLUInt());
     referenceType = static_cast<FbReferenceType>(vContainerDeq.deqVLUInt());
@@ -2144,11 +2337,11 @@ PackTilesImpl::deqHeaderBlock(VContainerDeq &vContainerDeq,
     unsigned int formatVersion, ui;
 
     vContainerDeq.deqVLUInt(formatVersion);
-    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER2)) {
-        return false; // This code only understand up to VER2.
+    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER4)) {
+        return false; // This code only understand up to VER4.
     }
 
-    // formatVersion : VER1, VER2
+    // formatVersion : VER1, VER2, VER3, VER4
     
     vContainerDeq.deqVLUInt(ui);
     dataType = static_cast<DataType>(ui);
@@ -2170,11 +2363,11 @@ PackTilesImpl::deqHeaderBlock(VContainerDeq &vContainerDeq,
     unsigned int formatVersion, ui;
 
     vContainerDeq.deqVLUInt(formatVersion);
-    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER2)) {
-        return false; // This code only understand up to VER2.
+    if (formatVersion > static_cast<unsigned>(EnqFormatVer::VER4)) {
+        return false; // This code only understand up to VER4.
     }
 
-    // formatVersion : VER1, VER2
+    // formatVersion : VER1, VER2, VER3, VER4
 
     vContainerDeq.deqVLUInt(ui);
     dataType = static_cast<DataType>(ui);
@@ -2193,7 +2386,7 @@ PackTilesImpl::enqTileMaskBlock(const EnqFormatVer enqFormatVer,
     if (enqFormatVer == EnqFormatVer::VER1) {
         enqTileMaskBlockVer1(activePixels, vContainerEnq);
     } else {
-        // This code only understand up to VER2.
+        // VER2, VER3 and VER4 use the same tile mask block.
         result = enqTileMaskBlockVer2(activePixels, vContainerEnq, sizeInfo);
     }
     return result;
@@ -2209,12 +2402,117 @@ PackTilesImpl::deqTileMaskBlock(VContainerDeq &vContainerDeq,
     if (formatVersion == static_cast<unsigned>(EnqFormatVer::VER1)) {
         deqTileMaskBlockVer1(vContainerDeq, activeTileTotal, activePixels);
     } else {
-        // This code only understand up to VER2.
+        // VER2, VER3 and VER4 use the same tile mask block.
         result = deqTileMaskBlockVer2(vContainerDeq, activeTileTotal, activePixels);
     }
     return result;
 }
 
+// static function
+void
+PackTilesImpl::calcTilePixelBlockChunk(const ActivePixels &activePixels,
+                                       std::vector<unsigned> &chunkTileIdEnd)
+//
+// Splits all tiles into contiguous tileId ranges which have almost the same number of active tiles
+// and returns the tileId end of each range. The last range always ends at the total tile count.
+//
+{
+    const unsigned numTiles = activePixels.getNumTiles();
+    const unsigned activeTileTotal = activePixels.getActiveTileTotal();
+    const unsigned chunkTotal =
+        std::max(1U, std::min(CHUNK_MAX, activeTileTotal / CHUNK_ACTIVE_TILE_MIN));
+
+    chunkTileIdEnd.clear();
+    chunkTileIdEnd.reserve(chunkTotal);
+    unsigned activeTileCount = 0;
+    for (unsigned tileId = 0; tileId < numTiles && chunkTileIdEnd.size() + 1 < chunkTotal; ++tileId) {
+        if (!activePixels.getTileMask(tileId)) continue;
+        ++activeTileCount;
+        const uint64_t chunkId = chunkTileIdEnd.size();
+        if (activeTileCount == (chunkId + 1) * activeTileTotal / chunkTotal) {
+            chunkTileIdEnd.push_back(tileId + 1);
+        }
+    }
+    chunkTileIdEnd.push_back(numTiles);
+}
+
+bool
+PackTilesImpl::TilePixelBlockDeq::deqChunkTable(const bool entropyCoded)
+{
+    const unsigned numTiles = mActivePixels.getNumTiles();
+    const unsigned chunkTotal = mVContainerDeq.deqVLUInt();
+    if (chunkTotal == 0 || chunkTotal > numTiles) {
+        return false;
+    }
+
+    mChunkTileIdEnd.resize(chunkTotal);
+    std::vector<size_t> chunkDataSize(chunkTotal);
+    size_t chunkDataSizeTotal = 0;
+    for (unsigned chunkId = 0; chunkId < chunkTotal; ++chunkId) {
+        mChunkTileIdEnd[chunkId] = mVContainerDeq.deqVLUInt();
+        chunkDataSize[chunkId] = mVContainerDeq.deqVLSizeT();
+        chunkDataSizeTotal += chunkDataSize[chunkId];
+
+        const unsigned tileIdStart = (chunkId == 0) ? 0 : mChunkTileIdEnd[chunkId - 1];
+        if (mChunkTileIdEnd[chunkId] < tileIdStart || mChunkTileIdEnd[chunkId] > numTiles) {
+            return false;
+        }
+    }
+    if (mChunkTileIdEnd.back() != numTiles || chunkDataSizeTotal > mVContainerDeq.getRestSize()) {
+        return false;
+    }
+
+    std::vector<const void *> chunkDataAddr(chunkTotal);
+    try {
+        for (unsigned chunkId = 0; chunkId < chunkTotal; ++chunkId) {
+            chunkDataAddr[chunkId] = mVContainerDeq.skipByteData(chunkDataSize[chunkId]);
+        }
+    }
+    catch (...) {
+        return false; // chunk data size mismatch
+    }
+
+    if (entropyCoded) {
+        // VER4 : decompress all chunks and decode from the decompressed data
+        mChunkData.resize(chunkTotal);
+        std::vector<char> chunkResult(chunkTotal, 0);
+        auto decompressChunk = [&](const size_t chunkId) {
+            const unsigned tileIdStart = (chunkId == 0) ? 0 : mChunkTileIdEnd[chunkId - 1];
+            const size_t maxDecodeSize =
+                (mChunkTileIdEnd[chunkId] - tileIdStart) * 64 * CHUNK_PIXEL_SIZE_MAX + sizeof(size_t);
+            chunkResult[chunkId] = EntropyCodec::decode(chunkDataAddr[chunkId],
+                                                        chunkDataSize[chunkId],
+                                                        maxDecodeSize,
+                                                        mChunkData[chunkId]);
+        };
+#       ifdef SINGLE_THREAD
+        for (size_t chunkId = 0; chunkId < chunkTotal; ++chunkId) {
+            decompressChunk(chunkId);
+        }
+#       else // else SINGLE_THREAD
+        tbb::parallel_for(size_t(0), static_cast<size_t>(chunkTotal), decompressChunk);
+#       endif // end !SINGLE_THREAD
+        if (std::find(chunkResult.begin(), chunkResult.end(), 0) != chunkResult.end()) {
+            return false; // broken chunk data
+        }
+        for (unsigned chunkId = 0; chunkId < chunkTotal; ++chunkId) {
+            chunkDataAddr[chunkId] = mChunkData[chunkId].data();
+            chunkDataSize[chunkId] = mChunkData[chunkId].size();
+        }
+    }
+
+    mChunkVContainerDeq.reserve(chunkTotal);
+    try {
+        for (unsigned chunkId = 0; chunkId < chunkTotal; ++chunkId) {
+            mChunkVContainerDeq.emplace_back(chunkDataAddr[chunkId], chunkDataSize[chunkId]);
+        }
+    }
+    catch (...) {
+        return false; // chunk data size mismatch
+    }
+    return true;
+}
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 //
@@ -2230,7 +2528,8 @@ PackTilesImpl::encodePixelInfo(const ActivePixels &activePixels,
                                const CoarsePassPrecision coarsePassPrecision,
                                const FinePassPrecision finePassPrecision,
                                const bool withSha1Hash,
-                               const EnqFormatVer enqFormatVer)
+                               const EnqFormatVer enqFormatVer,
+                               const HashMode hashMode)
 //
 // Creates PixelInfo (Depth) : float * 1
 //
@@ -2256,8 +2555,10 @@ PackTilesImpl::encodePixelInfo(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
-                          activeTileCrawler(activePixels,
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
+                          activeTileCrawler(activeTiles,
                                             [&](uint64_t mask, unsigned pixelOffset) { // func
                                                 const auto *__restrict src =
                                                     pixelInfoBufferTiled.getData() + pixelOffset;
@@ -2308,7 +2609,7 @@ PackTilesImpl::decodePixelInfo(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision currCoarsePassPrecision,
                        FinePassPrecision currFinePassPrecision,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_PIXELINFO
                        debugFootmark([]() {
@@ -2341,15 +2642,18 @@ PackTilesImpl::decodePixelInfo(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_PIXELINFO
 
-                           activeTileCrawler
-                               (activePixels,
-                                [&](uint64_t mask, unsigned pixelOffset) { // func
-                                   PixelInfo *__restrict dst =
-                                       pixelInfoBufferTiled.getData() + pixelOffset;
-                                   deqTileVal(vContainerDeq, mask, reinterpret_cast<float *>(dst),
-                                              [&](float& v) { // deqfunc
-                                                  vContainerDeq.deqFloat(v);
-                                              });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   activeTileCrawler
+                                       (activeTiles,
+                                        [&](uint64_t mask, unsigned pixelOffset) { // func
+                                           PixelInfo *__restrict dst =
+                                               pixelInfoBufferTiled.getData() + pixelOffset;
+                                           deqTileVal(vContainerDeq, mask, reinterpret_cast<float *>(dst),
+                                                      [&](float& v) { // deqfunc
+                                                          vContainerDeq.deqFloat(v);
+                                                      });
+                                       });
                                });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_PIXELINFO
@@ -2381,7 +2685,8 @@ PackTilesImpl::encodeHeatMap(const ActivePixels &activePixels,
                              std::string &output,
                              const bool noNumSampleMode,
                              const bool withSha1Hash,
-                             const EnqFormatVer enqFormatVer)
+                             const EnqFormatVer enqFormatVer,
+                             const HashMode hashMode)
 //
 // Creates Sec(normalized) + numSample : float * 1 + unsigned int : when noNumSampleMode = false
 // Creates Sec(normalized)             : float * 1                : when noNumSampleMode = true
@@ -2415,9 +2720,11 @@ PackTilesImpl::encodeHeatMap(const ActivePixels &activePixels,
                        activePixels,
                        output,
                        withSha1Hash,
-                       [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                       hashMode,
+                       [&](VContainerEnq &vContainerEnq,
+                           const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                            activeTileCrawler
-                           (activePixels,
+                           (activeTiles,
                             [&](uint64_t mask, unsigned pixelOffset) { // func
                                const float *__restrict src =
                                heatMapSecBufferTiled.getData() + pixelOffset;
@@ -2443,9 +2750,11 @@ PackTilesImpl::encodeHeatMap(const ActivePixels &activePixels,
                        activePixels,
                        output,
                        withSha1Hash,
-                       [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                       hashMode,
+                       [&](VContainerEnq &vContainerEnq,
+                           const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                            activeTileCrawler
-                           (activePixels,
+                           (activeTiles,
                             [&](uint64_t mask, unsigned pixelOffset) { // func
                                const float *__restrict src =
                                heatMapSecBufferTiled.getData() + pixelOffset;
@@ -2470,7 +2779,8 @@ PackTilesImpl::encodeHeatMap(const ActivePixels &activePixels,
                              const FloatBuffer &heatMapSecBufferTiled, // normalized sec
                              std::string &output,
                              const bool withSha1Hash,
-                             const EnqFormatVer enqFormatVer)
+                             const EnqFormatVer enqFormatVer,
+                             const HashMode hashMode)
 //
 // Creates Sec : float * 1
 //
@@ -2490,9 +2800,11 @@ PackTilesImpl::encodeHeatMap(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                           activeTileCrawler
-                              (activePixels,
+                              (activeTiles,
                                [&](uint64_t mask, unsigned pixelOffset) { // func
                                   const float *__restrict src =
                                       heatMapSecBufferTiled.getData() + pixelOffset;
@@ -2547,7 +2859,7 @@ PackTilesImpl::decodeHeatMap(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision /*currCoarsePassPrecision*/,
                        FinePassPrecision /*currFinePassPrecision */,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_HEATMAP_A
                        debugFootmark([]() {
@@ -2584,20 +2896,23 @@ PackTilesImpl::decodeHeatMap(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_HEATMAP_A
 
-                           activeTileCrawler
-                               (activePixels,
-                                [&](uint64_t mask, unsigned pixelOffset) { // func
-                                   float *__restrict dstSec =
-                                       normalizedHeatMapSecBufferTiled.getData() + pixelOffset;
-                                   unsigned int *__restrict dstNumSample =
-                                       (storeNumSampleData) ?
-                                       (heatMapNumSampleBufferTiled.getData() + pixelOffset) :
-                                       nullptr;
-                                   deqTileValSample(vContainerDeq, mask, dstSec, dstNumSample,
-                                                    [&](float& v, unsigned int& numSample) { // deqfunc
-                                                        vContainerDeq.deqFloat(v);
-                                                        vContainerDeq.deqVLUInt(numSample);
-                                                    });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   activeTileCrawler
+                                       (activeTiles,
+                                        [&](uint64_t mask, unsigned pixelOffset) { // func
+                                           float *__restrict dstSec =
+                                               normalizedHeatMapSecBufferTiled.getData() + pixelOffset;
+                                           unsigned int *__restrict dstNumSample =
+                                               (storeNumSampleData) ?
+                                               (heatMapNumSampleBufferTiled.getData() + pixelOffset) :
+                                               nullptr;
+                                           deqTileValSample(vContainerDeq, mask, dstSec, dstNumSample,
+                                                            [&](float& v, unsigned int& numSample) { // deqfunc
+                                                                vContainerDeq.deqFloat(v);
+                                                                vContainerDeq.deqVLUInt(numSample);
+                                                            });
+                                       });
                                });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_HEATMAP_A
@@ -2655,7 +2970,7 @@ PackTilesImpl::decodeHeatMap(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision /*currCoarsePassPrecision*/,
                        FinePassPrecision /*currFinePassPrecision */,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_HEATMAP_B
                        debugFootmark([]() {
@@ -2686,15 +3001,18 @@ PackTilesImpl::decodeHeatMap(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_HEATMAP_B
 
-                           activeTileCrawler
-                               (activePixels,
-                                [&](uint64_t mask, unsigned pixelOffset) {
-                                   float *__restrict dstSec =
-                                       normalizedHeatMapSecBufferTiled.getData() + pixelOffset;
-                                   deqTileVal(vContainerDeq, mask, dstSec,
-                                              [&](float& v) { // deqfunc
-                                                  vContainerDeq.deqFloat(v);
-                                              });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   activeTileCrawler
+                                       (activeTiles,
+                                        [&](uint64_t mask, unsigned pixelOffset) {
+                                           float *__restrict dstSec =
+                                               normalizedHeatMapSecBufferTiled.getData() + pixelOffset;
+                                           deqTileVal(vContainerDeq, mask, dstSec,
+                                                      [&](float& v) { // deqfunc
+                                                          vContainerDeq.deqFloat(v);
+                                                      });
+                                       });
                                });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_HEATMAP_B
@@ -2727,7 +3045,8 @@ PackTilesImpl::encodeWeightBuffer(const ActivePixels &activePixels,
                                   const CoarsePassPrecision coarsePassPrecision,
                                   const FinePassPrecision finePassPrecision,
                                   const bool withSha1Hash,
-                                  const EnqFormatVer enqFormatVer)
+                                  const EnqFormatVer enqFormatVer,
+                                  const HashMode hashMode)
 //
 // Creates Weight : float * 1
 //
@@ -2753,11 +3072,13 @@ PackTilesImpl::encodeWeightBuffer(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                           enqTilePixelBlockValNormalizedSrc
                               (vContainerEnq,
                                precisionMode,
-                               activePixels,
+                               activeTiles,
                                weightBufferTiled,
                                [&](const float &v) { // lowPrecision
                                   enqLowPrecisionFloat(vContainerEnq, v);
@@ -2808,7 +3129,7 @@ PackTilesImpl::decodeWeightBuffer(const void* addr,
                        bool /*closestFilterStatus*/,
                        CoarsePassPrecision currCoarsePassPrecision,
                        FinePassPrecision currFinePassPrecision,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_WEIGHT
                        debugFootmark([]() {
@@ -2840,19 +3161,22 @@ PackTilesImpl::decodeWeightBuffer(const void* addr,
                                });
 #                          endif // end DEBUG_FOOTMARK_DECODE_WEIGHT
 
-                           deqTilePixelBlockVal(vContainerDeq,
-                                                precisionMode,
-                                                activePixels,
-                                                weightBufferTiled,
-                                                [&](float& v) { // lowPrecision
-                                                    v = deqLowPrecisionFloat(vContainerDeq);
-                                                },
-                                                [&](float& v) { // halfPrecision
-                                                    v = deqHalfPrecisionFloat(vContainerDeq);
-                                                },
-                                                [&](float& v) { // fullPrecision
-                                                    v = vContainerDeq.deqFloat();
-                                                });
+                           tilePixelBlockDeq.crawlChunks
+                               ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+                                   deqTilePixelBlockVal(vContainerDeq,
+                                                        precisionMode,
+                                                        activeTiles,
+                                                        weightBufferTiled,
+                                                        [&](float& v) { // lowPrecision
+                                                            v = deqLowPrecisionFloat(vContainerDeq);
+                                                        },
+                                                        [&](float& v) { // halfPrecision
+                                                            v = deqHalfPrecisionFloat(vContainerDeq);
+                                                        },
+                                                        [&](float& v) { // fullPrecision
+                                                            v = vContainerDeq.deqFloat();
+                                                        });
+                               });
                        }
 #                      ifdef DEBUG_FOOTMARK_DECODE_WEIGHT
                        debugFootmarkPop();
@@ -2890,7 +3214,8 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                   const CoarsePassPrecision coarsePassPrecision,
                                   const FinePassPrecision finePassPrecision,
                                   const bool withSha1Hash,
-                                  const EnqFormatVer enqFormatVer)
+                                  const EnqFormatVer enqFormatVer,
+                                  const HashMode hashMode)
 //
 // for moonray::engine_tool::McrtFbSender (moonray)
 //
@@ -2966,14 +3291,16 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                        activePixels,
                        output,
                        withSha1Hash,
-                       [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                       hashMode,
+                       [&](VContainerEnq &vContainerEnq,
+                           const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                            switch (renderOutputBufferTiled.getFormat()) {
                            case fb_util::VariablePixelBuffer::FLOAT : {
                                enqTilePixelBlockVal
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloatBuffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const float &v) { // lowPrecision
@@ -2991,7 +3318,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloat2Buffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const math::Vec2f &v) { // lowPrecision
@@ -3009,7 +3336,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloat3Buffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const math::Vec3f &v) { // lowPrecision
@@ -3035,7 +3362,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v) { // lowPrecision
@@ -3055,7 +3382,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v) { // lowPrecision
@@ -3075,7 +3402,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v) { // lowPrecision
@@ -3136,14 +3463,16 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                        activePixels,
                        output,
                        withSha1Hash,
-                       [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                       hashMode,
+                       [&](VContainerEnq &vContainerEnq,
+                           const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                            switch (renderOutputBufferTiled.getFormat()) {
                            case fb_util::VariablePixelBuffer::FLOAT : {
                                enqTilePixelBlockValSample
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloatBuffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const float &v, unsigned int numSample) { // lowPrecision
@@ -3164,7 +3493,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloat2Buffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const math::Vec2f &v, unsigned int numSample) { // lowPrecision
@@ -3185,7 +3514,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                (vContainerEnq,
                                 precisionMode,
                                 doNormalizeMode,
-                                activePixels,
+                                activeTiles,
                                 renderOutputBufferTiled.getFloat3Buffer(),
                                 renderOutputWeightBufferTiled,
                                 [&](const math::Vec3f &v, unsigned int numSample) { // lowPrecision
@@ -3214,7 +3543,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v, unsigned int numSample) {
@@ -3240,7 +3569,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v, unsigned int numSample) {
@@ -3266,7 +3595,7 @@ PackTilesImpl::encodeRenderOutput(const ActivePixels &activePixels,
                                            (vContainerEnq,
                                             precisionMode,
                                             doNormalizeMode,
-                                            activePixels,
+                                            activeTiles,
                                             renderOutputBufferTiled.getFloat4Buffer(),
                                             renderOutputWeightBufferTiled,
                                             [&](const math::Vec4f &v, unsigned int numSample) {
@@ -3309,7 +3638,8 @@ PackTilesImpl::encodeRenderOutputMerge(const ActivePixels &activePixels,
                                        const CoarsePassPrecision coarsePassPrecision,
                                        const FinePassPrecision finePassPrecision,
                                        const bool withSha1Hash,
-                                       const EnqFormatVer enqFormatVer)
+                                       const EnqFormatVer enqFormatVer,
+                                       const HashMode hashMode)
 //
 // Creates VariableValue(float1|float2|float3|float4) : float * (1|2|3|4)
 //    
@@ -3346,13 +3676,15 @@ PackTilesImpl::encodeRenderOutputMerge(const ActivePixels &activePixels,
                       activePixels,
                       output,
                       withSha1Hash,
-                      [&](VContainerEnq &vContainerEnq) { // enqTilePixelBlockFunc
+                      hashMode,
+                      [&](VContainerEnq &vContainerEnq,
+                          const ActiveTileRange &activeTiles) { // enqTilePixelBlockFunc
                           switch (renderOutputBufferTiled.getFormat()) {
                           case fb_util::VariablePixelBuffer::FLOAT :
                               enqTilePixelBlockValNormalizedSrc
                                   (vContainerEnq,
                                    precisionMode,
-                                   activePixels,
+                                   activeTiles,
                                    renderOutputBufferTiled.getFloatBuffer(),
                                    [&](const float &v) { // lowPrecision
                                       enqLowPrecisionFloat(vContainerEnq, v);
@@ -3368,7 +3700,7 @@ PackTilesImpl::encodeRenderOutputMerge(const ActivePixels &activePixels,
                               enqTilePixelBlockValNormalizedSrc
                                   (vContainerEnq,
                                    precisionMode,
-                                   activePixels,
+                                   activeTiles,
                                    renderOutputBufferTiled.getFloat2Buffer(),
                                    [&](const math::Vec2f &v) { // lowPrecision
                                       enqLowPrecisionVec2f(vContainerEnq, v);
@@ -3384,7 +3716,7 @@ PackTilesImpl::encodeRenderOutputMerge(const ActivePixels &activePixels,
                               enqTilePixelBlockValNormalizedSrc
                                   (vContainerEnq,
                                    precisionMode,
-                                   activePixels,
+                                   activeTiles,
                                    renderOutputBufferTiled.getFloat3Buffer(),
                                    [&](const math::Vec3f &v) { // lowPrecision
                                       enqLowPrecisionVec3f(vContainerEnq, v);
@@ -3400,7 +3732,7 @@ PackTilesImpl::encodeRenderOutputMerge(const ActivePixels &activePixels,
                               enqTilePixelBlockValNormalizedSrc
                                   (vContainerEnq,
                                    precisionMode,
-                                   activePixels,
+                                   activeTiles,
                                    renderOutputBufferTiled.getFloat4Buffer(),
                                    [&](const math::Vec4f &v) { // lowPrecision
                                       enqLowPrecisionVec4f(vContainerEnq, v);
@@ -3479,7 +3811,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                        bool closestFilterStatus,
                        CoarsePassPrecision currCoarsePassPrecision,
                        FinePassPrecision currFinePassPrecision,
-                       VContainerDeq& vContainerDeq) -> bool { // deqTilePixelBlockFunc
+                       const TilePixelBlockDeq& tilePixelBlockDeq) -> bool { // deqTilePixelBlockFunc
 
 #                      ifdef DEBUG_FOOTMARK_DECODE_RENDEROUTPUT
                        debugFootmark([]() {
@@ -3572,7 +3904,8 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                });
                            debugFootmarkPush();
 #                          endif // end DEBUG_FOOTMARK_DECODE_RENDEROUTPUT
-                           {
+                           tilePixelBlockDeq.crawlChunks([&](VContainerDeq& vContainerDeq,
+                                                             const ActiveTileRange& activeTiles) {
                                switch (fbAov->getBufferTiled().getFormat()) {
                                case fb_util::VariablePixelBuffer::FLOAT : {
                                    if (withNumSample) {
@@ -3596,7 +3929,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockValSample
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloatBuffer(),
                                             fbAov->getNumSampleBufferTiled(),
                                             storeNumSampleData,
@@ -3624,7 +3957,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockVal
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloatBuffer(),
                                             [&](float& v) { // lowPrecision
                                                v = deqLowPrecisionFloat(vContainerDeq);
@@ -3657,7 +3990,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockValSample
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat2Buffer(),
                                             fbAov->getNumSampleBufferTiled(),
                                             storeNumSampleData,
@@ -3685,7 +4018,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockVal
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat2Buffer(),
                                             [&](math::Vec2f& v) { // lowPrecision
                                                v = deqLowPrecisionVec2f(vContainerDeq);
@@ -3727,7 +4060,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockValSample
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat3Buffer(),
                                             fbAov->getNumSampleBufferTiled(),
                                             storeNumSampleData,
@@ -3755,7 +4088,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockVal
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat3Buffer(),
                                             [&](math::Vec3f& v) { // lowPrecision
                                                v = deqLowPrecisionVec3f(vContainerDeq);
@@ -3788,7 +4121,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockValSample
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat4Buffer(),
                                             fbAov->getNumSampleBufferTiled(),
                                             storeNumSampleData,
@@ -3816,7 +4149,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
                                        deqTilePixelBlockVal
                                            (vContainerDeq,
                                             precisionMode,
-                                            activePixels,
+                                            activeTiles,
                                             fbAov->getBufferTiled().getFloat4Buffer(),
                                             [&](math::Vec4f& v) { // lowPrecision
                                                v = deqLowPrecisionVec4f(vContainerDeq);
@@ -3845,7 +4178,7 @@ PackTilesImpl::decodeRenderOutput(const void* addr,
 #                                  endif // end DEBUG_FOOTMARK_DECODE_RENDEROUTPUT
                                    break;
                                } // end of switch
-                           }
+                           });
 #                          ifdef DEBUG_FOOTMARK_DECODE_RENDEROUTPUT
                            debugFootmarkPop();
                            debugFootmark([]() {
@@ -3880,7 +4213,8 @@ size_t
 PackTilesImpl::encodeRenderOutputReference(const FbReferenceType &referenceType,
                                            std::string &output,
                                            const bool withSha1Hash,
-                                           const EnqFormatVer enqFormatVer)
+                                           const EnqFormatVer enqFormatVer,
+                                           const HashMode hashMode)
 {
     //------------------------------
     //
@@ -3925,7 +4259,7 @@ PackTilesImpl::encodeRenderOutputReference(const FbReferenceType &referenceType,
         unsigned srcSize = dataSize;
         unsigned char *dstPtr = reinterpret_cast<unsigned char *>((uintptr_t)(output.data()) +
                                                                   static_cast<uintptr_t>(hashOffset));
-        SHA1(srcPtr, srcSize, dstPtr);
+        ContentHash::calc(hashMode, srcPtr, srcSize, dstPtr);
     }
 
     return dataSize + HASH_SIZE;
@@ -4061,6 +4395,15 @@ PackTilesImpl::show(const std::string &hd, const void *addr, const size_t dataSi
 
     deqTileMaskBlock(vContainerDeq, formatVersion, activeTileTotal, activePixels);
 
+    TilePixelBlockDeq tilePixelBlockDeq(vContainerDeq, activePixels);
+    if (formatVersion >= static_cast<unsigned>(EnqFormatVer::VER3)) {
+        const bool entropyCoded = (formatVersion == static_cast<unsigned>(EnqFormatVer::VER4));
+        if (!tilePixelBlockDeq.deqChunkTable(entropyCoded)) {
+            ostr << hd << "PackTiles::show() : deqChunkTable() failed";
+            return ostr.str();
+        }
+    }
+
     {
         unsigned alignedWidth = activePixels.getAlignedWidth();
         unsigned alignedHeight = activePixels.getAlignedHeight();
@@ -4071,24 +4414,27 @@ PackTilesImpl::show(const std::string &hd, const void *addr, const size_t dataSi
         numSampleBufferTiled.clear();
     }
 
-    deqTilePixelBlockValSample(vContainerDeq,
-                               precisionMode,
-                               activePixels,
-                               normalizedRenderBufferTiled,
-                               numSampleBufferTiled,
-                               true, // storeNumSampleData
-                               [&](RenderColor &v, unsigned int &numSample) { // lowPrecision
-                                   v = deqLowPrecisionVec4f(vContainerDeq);
-                                   vContainerDeq.deqVLUInt(numSample);
-                               },
-                               [&](RenderColor &v, unsigned int &numSample) { // halfPrecision
-                                   v = deqHalfPrecisionVec4f(vContainerDeq);
-                                   vContainerDeq.deqVLUInt(numSample);
-                               },
-                               [&](RenderColor &v, unsigned int &numSample) { // fullPrecision
-                                   v = vContainerDeq.deqVec4f();
-                                   numSample = vContainerDeq.deqVLUInt();
-                               });
+    tilePixelBlockDeq.crawlChunks
+        ([&](VContainerDeq& vContainerDeq, const ActiveTileRange& activeTiles) {
+            deqTilePixelBlockValSample(vContainerDeq,
+                                       precisionMode,
+                                       activeTiles,
+                                       normalizedRenderBufferTiled,
+                                       numSampleBufferTiled,
+                                       true, // storeNumSampleData
+                                       [&](RenderColor &v, unsigned int &numSample) { // lowPrecision
+                                           v = deqLowPrecisionVec4f(vContainerDeq);
+                                           vContainerDeq.deqVLUInt(numSample);
+                                       },
+                                       [&](RenderColor &v, unsigned int &numSample) { // halfPrecision
+                                           v = deqHalfPrecisionVec4f(vContainerDeq);
+                                           vContainerDeq.deqVLUInt(numSample);
+                                       },
+                                       [&](RenderColor &v, unsigned int &numSample) { // fullPrecision
+                                           v = vContainerDeq.deqVec4f();
+                                           numSample = vContainerDeq.deqVLUInt();
+                                       });
+        });
 
     //------------------------------
     //
@@ -4238,7 +4584,7 @@ PackTilesImpl::showHash(const std::string &hd, const unsigned char sha1HashDiges
 {
     std::ostringstream ostr;
 
-    ostr << hd << "hash: ";
+    ostr << hd << "hash(" << ContentHash::showMode(ContentHash::getMode(sha1HashDigest)) << "): ";
     for (unsigned i = 0; i < HASH_SIZE; ++i) {
         ostr << std::hex << std::setw(2) << std::setfill('0')
              << static_cast<unsigned>(sha1HashDigest[i]) << ' ';
@@ -4338,13 +4684,9 @@ PackTilesImpl::verifyDecodeHash(const void *addr, const size_t dataSize)
                                                 static_cast<uintptr_t>(HASH_SIZE));
     unsigned srcSize = static_cast<unsigned>(dataSize) - HASH_SIZE;
 
-    unsigned char reCompHash[HASH_SIZE];
-    SHA1(srcPtr, srcSize, reCompHash);
-
-    for (unsigned i = 0; i < HASH_SIZE; ++i) {
-        if (dataHash[i] != reCompHash[i]) return false;
-    }
-    return true;
+    // The hash mode is picked up from dataHash itself, so this works regardless of the sender's
+    // hash mode setting.
+    return ContentHash::verify(dataHash, srcPtr, srcSize);
 }
 
 // static function
@@ -5037,20 +5379,21 @@ PackTiles::encode(const bool renderBufferOdd,
                   const FinePassPrecision finePassPrecision,
                   const bool noNumSampleMode,
                   const bool withSha1Hash,
-                  const EnqFormatVer enqFormatVer)
+                  const EnqFormatVer enqFormatVer,
+                  const HashMode hashMode)
 {
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, weightBufferTiled,
                                            output,
                                            precisionMode, coarsePassPrecision, finePassPrecision,
                                            noNumSampleMode, withSha1Hash,
-                                           enqFormatVer);
+                                           enqFormatVer, hashMode);
     } else {
         return PackTilesImpl::encode<false>(activePixels, renderBufferTiled, weightBufferTiled,
                                             output,
                                             precisionMode, coarsePassPrecision, finePassPrecision,
                                             noNumSampleMode, withSha1Hash,
-                                            enqFormatVer);
+                                            enqFormatVer, hashMode);
     }
 }
                   
@@ -5066,16 +5409,17 @@ PackTiles::encode(const bool renderBufferOdd,
                   const CoarsePassPrecision coarsePassPrecision,
                   const FinePassPrecision finePassPrecision,
                   const bool withSha1Hash,
-                  const EnqFormatVer enqFormatVer)
+                  const EnqFormatVer enqFormatVer,
+                  const HashMode hashMode)
 {
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, output,
                                            precisionMode, coarsePassPrecision, finePassPrecision,
-                                           withSha1Hash, enqFormatVer);
+                                           withSha1Hash, enqFormatVer, hashMode);
     } else {
         return PackTilesImpl::encode<false>(activePixels, renderBufferTiled, output,
                                             precisionMode, coarsePassPrecision, finePassPrecision,
-                                            withSha1Hash, enqFormatVer);
+                                            withSha1Hash, enqFormatVer, hashMode);
     }
 }
                   
@@ -5092,18 +5436,19 @@ PackTiles::encode(const bool renderBufferOdd,
                   const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                   const FinePassPrecision finePassPrecision, // minimum fine pass precision
                   const bool withSha1Hash,
-                  const EnqFormatVer enqFormatVer)
+                  const EnqFormatVer enqFormatVer,
+                  const HashMode hashMode)
 {
     if (renderBufferOdd) {
         return PackTilesImpl::encode<true>(activePixels, renderBufferTiled, numSampleBufferTiled,
                                            output,
                                            precisionMode, coarsePassPrecision, finePassPrecision,
-                                           withSha1Hash, enqFormatVer);
+                                           withSha1Hash, enqFormatVer, hashMode);
     } else {
         return PackTilesImpl::encode<false>(activePixels, renderBufferTiled, numSampleBufferTiled,
                                             output,
                                             precisionMode, coarsePassPrecision, finePassPrecision,
-                                            withSha1Hash, enqFormatVer);
+                                            withSha1Hash, enqFormatVer, hashMode);
     }
 }
 
@@ -5191,14 +5536,15 @@ PackTiles::encodePixelInfo(const ActivePixels &activePixels,
                            const CoarsePassPrecision coarsePassPrecision,
                            const FinePassPrecision finePassPrecision,
                            const bool withSha1Hash,
-                           const EnqFormatVer enqFormatVer)
+                           const EnqFormatVer enqFormatVer,
+                           const HashMode hashMode)
 {
     return PackTilesImpl::encodePixelInfo(activePixels, pixelInfoBufferTiled,
                                           output,
                                           precisionMode,
                                           coarsePassPrecision,
                                           finePassPrecision,
-                                          withSha1Hash, enqFormatVer);
+                                          withSha1Hash, enqFormatVer, hashMode);
 }
 
 // static function
@@ -5235,11 +5581,12 @@ PackTiles::encodeHeatMap(const ActivePixels &activePixels,
                          std::string &output,
                          const bool noNumSampleMode,
                          const bool withSha1Hash,
-                         const EnqFormatVer enqFormatVer)
+                         const EnqFormatVer enqFormatVer,
+                         const HashMode hashMode)
 {
     return PackTilesImpl::encodeHeatMap(activePixels, heatMapSecBufferTiled, heatMapWeightBufferTiled,
                                         output,
-                                        noNumSampleMode, withSha1Hash, enqFormatVer);
+                                        noNumSampleMode, withSha1Hash, enqFormatVer, hashMode);
 }
 
 // Sec : float * 1
@@ -5249,11 +5596,12 @@ PackTiles::encodeHeatMap(const ActivePixels &activePixels,
                          const FloatBuffer &heatMapSecBufferTiled, // normalize sec
                          std::string &output,
                          const bool withSha1Hash,
-                         const EnqFormatVer enqFormatVer)
+                         const EnqFormatVer enqFormatVer,
+                         const HashMode hashMode)
 {
     return PackTilesImpl::encodeHeatMap(activePixels, heatMapSecBufferTiled,
                                         output,
-                                        withSha1Hash, enqFormatVer);
+                                        withSha1Hash, enqFormatVer, hashMode);
 }
 
 // Sec + numSample : float * 1 + u_int
@@ -5307,7 +5655,8 @@ PackTiles::encodeWeightBuffer(const ActivePixels &activePixels,
                               const CoarsePassPrecision coarsePassPrecision,
                               const FinePassPrecision finePassPrecision,
                               const bool withSha1Hash,
-                              const EnqFormatVer enqFormatVer)
+                              const EnqFormatVer enqFormatVer,
+                              const HashMode hashMode)
 {
     return PackTilesImpl::encodeWeightBuffer(activePixels,
                                              weightBufferTiled,
@@ -5316,7 +5665,7 @@ PackTiles::encodeWeightBuffer(const ActivePixels &activePixels,
                                              coarsePassPrecision,
                                              finePassPrecision,
                                              withSha1Hash,
-                                             enqFormatVer);
+                                             enqFormatVer, hashMode);
 }
 
 // static function
@@ -5362,7 +5711,8 @@ PackTiles::encodeRenderOutput(const ActivePixels &activePixels,
                               const CoarsePassPrecision coarsePassPrecision,
                               const FinePassPrecision finePassPrecision,
                               const bool withSha1Hash,
-                              const EnqFormatVer enqFormatVer)
+                              const EnqFormatVer enqFormatVer,
+                              const HashMode hashMode)
 // closestFilterAovOriginalNumChan is only used when closestFilterStatus is true
 {
     return PackTilesImpl::encodeRenderOutput(activePixels,
@@ -5378,7 +5728,7 @@ PackTiles::encodeRenderOutput(const ActivePixels &activePixels,
                                              coarsePassPrecision,
                                              finePassPrecision,
                                              withSha1Hash,
-                                             enqFormatVer);
+                                             enqFormatVer, hashMode);
 }
     
 // for mcrt_dataio::MergeFbSender (progmcrtmerge)
@@ -5394,7 +5744,8 @@ PackTiles::encodeRenderOutputMerge(const ActivePixels &activePixels,
                                    const CoarsePassPrecision coarsePassPrecision,
                                    const FinePassPrecision finePassPrecision,
                                    const bool withSha1Hash,
-                                   const EnqFormatVer enqFormatVer)
+                                   const EnqFormatVer enqFormatVer,
+                                   const HashMode hashMode)
 {
     return PackTilesImpl::encodeRenderOutputMerge(activePixels,
                                                   renderOutputBufferTiled,
@@ -5405,7 +5756,7 @@ PackTiles::encodeRenderOutputMerge(const ActivePixels &activePixels,
                                                   coarsePassPrecision,
                                                   finePassPrecision,
                                                   withSha1Hash,
-                                                  enqFormatVer);
+                                                  enqFormatVer, hashMode);
 }
 
 // VariableValue(float1|float2|float3|float4) + numSample : float * (1|2|3|4) + u_int
@@ -5440,9 +5791,11 @@ size_t
 PackTiles::encodeRenderOutputReference(const FbReferenceType &referenceType,
                                        std::string &output,
                                        const bool withSha1Hash,
-                                       const EnqFormatVer enqFormatVer)
+                                       const EnqFormatVer enqFormatVer,
+                                       const HashMode hashMode)
 {
-    return PackTilesImpl::encodeRenderOutputReference(referenceType, output, withSha1Hash, enqFormatVer);
+    return PackTilesImpl::encodeRenderOutputReference(referenceType, output, withSha1Hash, enqFormatVer,
+                                                      hashMode);
 }
     
 // static function
@@ -5597,6 +5950,13 @@ PackTiles::decodeActivePixels(VContainerDeq& vContainerDeq, ActivePixels& active
     return PackTilesImpl::decodeActivePixels(vContainerDeq, activePixels);
 }
 
+// static function
+PackTiles::HashMode
+PackTiles::decodeHashMode(const unsigned char sha1HashDigest[HASH_SIZE])
+{
+    return ContentHash::getMode(sha1HashDigest);
+}
+
 // static function
 void
 PackTiles::debugMode(bool flag)
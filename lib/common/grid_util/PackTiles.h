@@ -24,6 +24,7 @@
 // 250ms to 37ms.
 //
 
+#include "ContentHash.h"
 #include "Fb.h"
 #include "FbReferenceType.h"
 #include "PackTilesPassPrecision.h"
@@ -59,14 +60,27 @@ public:
     using VContainerDeq = rdl2::ValueContainerDeq;
     using VContainerEnq = rdl2::ValueContainerEnq;
 
-    static constexpr unsigned HASH_SIZE = 20; // SHA1 hash size : byte
+    // Hash algorithm for the encode*() with withSha1Hash = true, selected by the hashMode argument of each
+    // call. Default is HashMode::SHA1. HashMode::FAST128 is more than 10x faster than SHA1 for a large
+    // image. The mode is recorded inside the hash slot of the PackTile data, so the receiver does not need
+    // to know it in advance : decodeHashMode() tells it from the sha1HashDigest of the decode*() functions
+    // and verifyDecodeHash() supports all modes.
+    using HashMode = ContentHash::Mode;
+
+    static constexpr unsigned HASH_SIZE = ContentHash::SLOT_SIZE; // hash slot size (= SHA1 hash size) : byte
 
     // PackTile format version for encoding(i.e. enqueue) operation.
-    // We can encode (i.e. enqueue) both of VER1 and VER2 based on argument of enqFormatVer of
+    // We can encode (i.e. enqueue) VER1, VER2, VER3 and VER4 based on argument of enqFormatVer of
     // encode*() Current default is VER2.
+    // VER3 and VER4 data can not be decoded by the code which only understands up to VER2. Use VER3 or
+    // VER4 only when all the receivers are updated.
+    // VER4 is lossless on top of the precision mode and trades encode/decode CPU time for a smaller
+    // data size. This is useful for a bandwidth bound network like a remote interactive session.
     enum class EnqFormatVer : unsigned int {
         VER1 = 1, // original naive tileId/pixelMask output version
-        VER2 = 2  // optimized tileId/pixelMask output by PackActiveTiles
+        VER2 = 2, // optimized tileId/pixelMask output by PackActiveTiles
+        VER3 = 3, // VER2 + tile pixel block is split into chunks which are encoded/decoded by multi-thread
+        VER4 = 4  // VER3 + each chunk is compressed by prediction + entropy coding (EntropyCodec)
     };
 
     enum class PrecisionMode : char {
@@ -122,7 +136,8 @@ public:
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool noNumSampleMode,
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // for McrtMergeComputation
     // RGBA : float * 4
@@ -135,7 +150,8 @@ public:
            const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // for McrtMergeComputation : for feedback logic between merge and mcrt computation
     // RGBA + numSample : float * 4 + u_int
@@ -149,7 +165,8 @@ public:
            const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
            const FinePassPrecision finePassPrecision,     // minimum fine pass precision
            const bool withSha1Hash = false,
-           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+           const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+           const HashMode hashMode = HashMode::SHA1);
 
     // RGBA + numSample : float * 4 + u_int
     static bool
@@ -192,7 +209,8 @@ public:
                     const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                     const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                     const bool withSha1Hash = false,
-                    const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                    const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                    const HashMode hashMode = HashMode::SHA1);
 
     static bool
     decodePixelInfo(const void* addr,                         // in
@@ -219,7 +237,8 @@ public:
                   std::string &output,
                   const bool noNumSampleMode,
                   const bool withSha1Hash = false,
-                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                  const HashMode hashMode = HashMode::SHA1);
 
     // Sec : float * 1
     // no precision related argument because heatMap always uses H16
@@ -228,7 +247,8 @@ public:
                   const FloatBuffer &heatMapSecBufferTiled, // normalize sec
                   std::string &output,
                   const bool withSha1Hash = false,
-                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                  const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                  const HashMode hashMode = HashMode::SHA1);
 
     // Sec + numSample : float * 1 + u_int
     // no precision related argument because heatMap always uses H16
@@ -267,7 +287,8 @@ public:
                        const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                        const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                        const bool withSha1Hash = false,
-                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                       const HashMode hashMode = HashMode::SHA1);
 
     static bool
     decodeWeightBuffer(const void* addr,               // in
@@ -303,7 +324,8 @@ public:
                        const CoarsePassPrecision coarsePassPrecision,  // minimum coarse pass precision
                        const FinePassPrecision finePassPrecision,      // minimum fine pass precision
                        const bool withSha1Hash = false,
-                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                       const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                       const HashMode hashMode = HashMode::SHA1);
     // for mcrt_dataio::MergeFbSender (progmcrtmerge)
     // VariableValue(float1|float2|float3|float4)
     static size_t
@@ -316,7 +338,8 @@ public:
                             const CoarsePassPrecision coarsePassPrecision, // minimum coarse pass precision
                             const FinePassPrecision finePassPrecision,     // minimum fine pass precision
                             const bool withSha1Hash = false,
-                            const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                            const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                            const HashMode hashMode = HashMode::SHA1);
 
     // VariableValue(float1|float2|float3|float4) + numSample : float * (1|2|3|4) + u_int
     // or
@@ -339,7 +362,8 @@ public:
     encodeRenderOutputReference(const FbReferenceType &referenceType,
                                 std::string &output,
                                 const bool withSha1Hash = false,
-                                const EnqFormatVer enqFormatVer = EnqFormatVer::VER2);
+                                const EnqFormatVer enqFormatVer = EnqFormatVer::VER2,
+                                const HashMode hashMode = HashMode::SHA1);
     static bool
     decodeRenderOutputReference(const void *addr, const size_t dataSize, // input
                                 FbAovShPtr &fbAov, // output
@@ -393,6 +417,9 @@ public:
     static void encodeActivePixels(const ActivePixels &activePixels, VContainerEnq &vContainerEnq);
     static void decodeActivePixels(VContainerDeq &vContainerDeq, ActivePixels &activePixels);
 
+    // Returns the hash mode which the encode*() used for the sha1HashDigest of the decode*() functions.
+    static HashMode decodeHashMode(const unsigned char sha1HashDigest[HASH_SIZE]);
+
     static void debugMode(bool flag);
 }; // PackTiles
 
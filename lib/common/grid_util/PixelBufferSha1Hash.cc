@@ -22,6 +22,22 @@ allTilesAreActive(const PixelBufferSha1Hash::PartialMergeTilesTbl& tbl)
     return true;
 }
 
+template <typename T>
+void
+getSingleRegion(const int startTileId,
+                const int endTileId,
+                PixelBuffer<T>& buffer,
+                uintptr_t& dataStartAddr,
+                size_t& dataSize)
+{
+    size_t singlePixDataSize = sizeof(T); // byte
+    size_t singleTileDataSize = singlePixDataSize * 64; // byte : tile is 8x8 pixels
+
+    const uintptr_t tileStartAddr = reinterpret_cast<uintptr_t>(buffer.getData());
+    dataStartAddr = tileStartAddr + static_cast<uintptr_t>(startTileId * singleTileDataSize);
+    dataSize = static_cast<size_t>(endTileId - startTileId + 1) * singleTileDataSize;
+}
+
 template <typename T>
 bool
 updateSha1HashSingleRegion(const int startTileId,
@@ -29,12 +45,9 @@ updateSha1HashSingleRegion(const int startTileId,
                            PixelBuffer<T>& buffer,
                            Sha1Gen& sha1)
 {
-    size_t singlePixDataSize = sizeof(T); // byte
-    size_t singleTileDataSize = singlePixDataSize * 64; // byte : tile is 8x8 pixels
-
-    const uintptr_t tileStartAddr = reinterpret_cast<uintptr_t>(buffer.getData());
-    const uintptr_t dataStartAddr = tileStartAddr + static_cast<uintptr_t>(startTileId * singleTileDataSize);
-    const size_t dataSize = static_cast<size_t>(endTileId - startTileId + 1) * singleTileDataSize;
+    uintptr_t dataStartAddr;
+    size_t dataSize;
+    getSingleRegion(startTileId, endTileId, buffer, dataStartAddr, dataSize);
 
     /* useful debug message
     std::ostringstream ostr;
@@ -50,6 +63,19 @@ updateSha1HashSingleRegion(const int startTileId,
     return sha1.updateByteData(reinterpret_cast<const void*>(dataStartAddr), dataSize);
 }
 
+template <typename T>
+PixelBufferSha1Hash::Hash
+calcContentHashSingleRegion(const ContentHash::Mode mode,
+                            const int startTileId,
+                            const int endTileId,
+                            PixelBuffer<T>& buffer)
+{
+    uintptr_t dataStartAddr;
+    size_t dataSize;
+    getSingleRegion(startTileId, endTileId, buffer, dataStartAddr, dataSize);
+    return ContentHash::calc(mode, reinterpret_cast<const void*>(dataStartAddr), dataSize);
+}
+
 template <typename T>
 unsigned
 getTotalTileX(const PixelBuffer<T>& buffer)
@@ -185,7 +211,8 @@ PixelBufferSha1Hash::calcHashForVerify(unsigned tileStartId, unsigned tileEndId,
                 if (tileStartId <= tileId && tileId <= tileEndId) {
                     size_t offset = tileId * tileDataSize;
                     uintptr_t currAddr = dataStartAddr + static_cast<uintptr_t>(offset);
-                    if (!sha1.updateByteData(reinterpret_cast<const void*>(currAddr), tileDataSize)) {
+                    if (mHashMode == ContentHash::Mode::SHA1 &&
+                        !sha1.updateByteData(reinterpret_cast<const void*>(currAddr), tileDataSize)) {
                         std::cerr << ERR_HEADER << " sha1.updateByteData() failed.";
                         return false;
                     }
@@ -250,7 +277,15 @@ PixelBufferSha1Hash::calcHashForVerify(unsigned tileStartId, unsigned tileEndId,
 
         if (totalActiveTile == 0) return false;
 
-        outHash = sha1.finalize();
+        if (mHashMode == ContentHash::Mode::SHA1) {
+            outHash = sha1.finalize();
+        } else {
+            // Non SHA1 hash is computed by a single call. This only makes sense for continuous active memory
+            // which is the same as the verifyResult condition.
+            outHash = ContentHash::calc(mHashMode,
+                                        reinterpret_cast<const void*>(activeTileStartAddr),
+                                        static_cast<size_t>(activeTileEndAddr - activeTileStartAddr));
+        }
     }
     catch (std::string error) {
         std::cerr << ERR_HEADER << " failed. error:" << error;
@@ -308,7 +343,7 @@ PixelBufferSha1Hash::show() const
             ostr << '\n'
                  << "mPrimaryStartTileId:" << mPrimaryStartTileId << '\n'
                  << "mPrimaryEndTileId:" << mPrimaryEndTileId << '\n'
-                 << "mPrimaryHash:" << Sha1Util::show(mPrimaryHash);
+                 << "mPrimaryHash:" << ContentHash::show(mPrimaryHash.data());
         }
         return ostr.str();
     };
@@ -319,7 +354,7 @@ PixelBufferSha1Hash::show() const
             ostr << '\n'
                  << "mSecondaryStartTileId:" << mSecondaryStartTileId << '\n'
                  << "mSecondaryEndTileId:" << mSecondaryEndTileId << '\n'
-                 << "mSecondaryHash:" << Sha1Util::show(mSecondaryHash);
+                 << "mSecondaryHash:" << ContentHash::show(mSecondaryHash.data());
         }
         return ostr.str();
     };
@@ -391,6 +426,12 @@ PixelBufferSha1Hash::processSingleRegion(const PartialMergeTilesTbl* partialMerg
     }
 
     if (endTileId > 0) {
+        if (mHashMode != ContentHash::Mode::SHA1) {
+            savePrimaryHash(startTileId, endTileId,
+                            calcContentHashSingleRegion(mHashMode, startTileId, endTileId, buffer));
+            return;
+        }
+
         try {
             Sha1Gen sha1;
             if (!sha1.init()) {
@@ -461,6 +502,13 @@ PixelBufferSha1Hash::processDualRegion(const PartialMergeTilesTbl* partialMergeT
             if (isEndRegion(tileId)) {
                 endTileId = tileId;
 
+                if (mHashMode != ContentHash::Mode::SHA1) {
+                    const Hash hash = calcContentHashSingleRegion(mHashMode, startTileId, endTileId, buffer);
+                    if (stageId == 0) savePrimaryHash(startTileId, endTileId, hash);
+                    else saveSecondaryHash(startTileId, endTileId, hash);
+                    continue;
+                }
+
                 // calculate SHA1 hash for this tileId span from startTileId to endTileId.
                 if (!updateSha1HashSingleRegion(startTileId, endTileId, buffer, sha1)) {
                     std::cerr << ERR_HEADER << " updateSha1HashSingleRegion() failed";
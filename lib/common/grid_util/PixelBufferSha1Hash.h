@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "ContentHash.h"
 #include "Sha1Util.h"
 
 #include <scene_rdl2/common/fb_util/PixelBuffer.h>
@@ -34,6 +35,10 @@ class PixelBufferSha1Hash
 //      For example 0 ~ tileIdA, tileIdB ~ totalTileSize - 1, tileIdB - tileIdA > 1
 //          11100000000001111 <- has exactly two active tile regions, and the start and end are both active
 //
+// The hash algorithm is SHA1 by default. setHashMode() switches it to the other ContentHash mode
+// (like FAST128) for a large buffer. The result is still stored in the same Hash (20 byte) and
+// ContentHash::getMode() tells which algorithm was used.
+//
 {
 public:
     using Hash = Sha1Gen::Hash;
@@ -41,6 +46,9 @@ public:
 
     PixelBufferSha1Hash() = default;
 
+    void setHashMode(const ContentHash::Mode mode) { mHashMode = mode; }
+    ContentHash::Mode getHashMode() const { return mHashMode; }
+
     // This API computes and initializes all membersof this class.
     // a nullptr value for partialMergeTilesTbl indicates that all tiles are active.
     // returns true : Some hasing was done (primary only or both primary and secondary)
@@ -113,10 +121,28 @@ private:
         mSecondaryActive = true;
     }
 
+    void savePrimaryHash(const size_t startTileId, const size_t endTileId, const Hash& hash)
+    {
+        mPrimaryStartTileId = startTileId;
+        mPrimaryEndTileId = endTileId;
+        mPrimaryHash = hash;
+        mPrimaryActive = true;
+    }
+
+    void saveSecondaryHash(const size_t startTileId, const size_t endTileId, const Hash& hash)
+    {
+        mSecondaryStartTileId = startTileId;
+        mSecondaryEndTileId = endTileId;
+        mSecondaryHash = hash;
+        mSecondaryActive = true;
+    }
+
     bool isEmpty() const { return !mPrimaryActive; } // We only test primary information
 
     //------------------------------
 
+    ContentHash::Mode mHashMode {ContentHash::Mode::SHA1};
+
     bool mPrimaryActive {false};
     size_t mPrimaryStartTileId {0};
     size_t mPrimaryEndTileId {0};
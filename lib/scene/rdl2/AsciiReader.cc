@@ -32,13 +32,20 @@
 #include <scene_rdl2/render/logging/logging.h>
 
 #include <lua.hpp>
+#include <tbb/parallel_for.h>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <istream>
 #include <ostream>
 #include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 
 /**
@@ -185,7 +192,8 @@ const char* AsciiReader::UNDEF_VALUE_METATABLE = "rdl2_Undef";
 AsciiReader::AsciiReader(SceneContext& context) :
     mContext(context),
     mLua(luaL_newstate()),
-    mWarningsAsErrors(false)
+    mWarningsAsErrors(false),
+    mObjectLocks(nullptr)
 {
     if (!mLua) {
         throw except::RuntimeError("Could not initialize Lua interpreter.");
@@ -242,6 +250,8 @@ AsciiReader::AsciiReader(SceneContext& context) :
 
 AsciiReader::~AsciiReader()
 {
+    releaseStripes();
+
     if (mLua) {
         lua_close(mLua);
     }
@@ -279,12 +289,134 @@ AsciiReader::fromString(const std::string& code, const std::string& chunkName)
     // chunk for nice error messages.)
     if (luaL_loadbuffer(mLua, code.c_str(), code.size(), chunkName.c_str()) ||
             lua_pcall(mLua, 0, LUA_MULTRET, 0)) {
+        // Don't keep the other readers of a fromFiles() call waiting on
+        // objects whose update the error unwound past.
+        releaseStripes();
+
         std::string errorMessage("RDLA Error: ");
         errorMessage.append(lua_tostring(mLua, -1));
         throw except::RuntimeError(errorMessage);
     }
 }
 
+struct AsciiReader::ObjectLocks
+{
+    static constexpr std::size_t sStripeCount = 256;
+
+    std::array<std::mutex, sStripeCount> mMutexes;
+
+    // Set when any reader fails.
+    std::atomic<bool> mCancelled{false};
+};
+
+constexpr std::size_t AsciiReader::ObjectLocks::sStripeCount;
+
+void
+AsciiReader::fromFiles(SceneContext& context, const std::vector<std::string>& filenames,
+                       bool warningsAsErrors)
+{
+    ObjectLocks locks;
+    std::vector<std::exception_ptr> errors(filenames.size());
+    std::atomic<std::size_t> firstError(filenames.size());
+
+    tbb::parallel_for(std::size_t(0), filenames.size(), [&](std::size_t i) {
+        if (locks.mCancelled) {
+            return;
+        }
+        try {
+            AsciiReader reader(context);
+            reader.mObjectLocks = &locks;
+            reader.mStripeDepths.assign(ObjectLocks::sStripeCount, 0);
+            reader.setWarningsAsErrors(warningsAsErrors);
+            reader.fromFile(filenames[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+            // Only the first failure is the real problem, the rest may just
+            // be readers which gave up because of it.
+            if (!locks.mCancelled.exchange(true)) {
+                firstError = i;
+            }
+        }
+    });
+
+    if (firstError < filenames.size()) {
+        std::rethrow_exception(errors[firstError]);
+    }
+}
+
+bool
+AsciiReader::lockStripe(std::size_t stripe)
+{
+    // Already held by this reader, for this or another object in the stripe.
+    if (mStripeDepths[stripe]++ > 0) {
+        return true;
+    }
+
+    std::mutex& mutex = mObjectLocks->mMutexes[stripe];
+    while (!mutex.try_lock()) {
+        if (mObjectLocks->mCancelled) {
+            mStripeDepths[stripe] = 0;
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void
+AsciiReader::unlockStripe(std::size_t stripe)
+{
+    MNRY_ASSERT(mStripeDepths[stripe] > 0);
+    if (--mStripeDepths[stripe] == 0) {
+        mObjectLocks->mMutexes[stripe].unlock();
+    }
+}
+
+void
+AsciiReader::releaseStripes()
+{
+    for (std::size_t stripe = 0; stripe < mStripeDepths.size(); ++stripe) {
+        if (mStripeDepths[stripe] > 0) {
+            mStripeDepths[stripe] = 0;
+            mObjectLocks->mMutexes[stripe].unlock();
+        }
+    }
+}
+
+template <typename F>
+bool
+AsciiReader::updateObject(SceneObject* so, F update)
+{
+    // Unlocks on the way out, including when update() throws.
+    struct StripeGuard
+    {
+        AsciiReader* mReader;
+        std::size_t mStripe;
+        ~StripeGuard() { if (mReader) mReader->unlockStripe(mStripe); }
+    } stripeGuard{nullptr, 0};
+
+    if (mObjectLocks) {
+        // SceneObjects are much bigger than 64 bytes, so drop the low bits.
+        const std::uintptr_t bits = reinterpret_cast<std::uintptr_t>(so) >> 6;
+        const std::size_t stripe = bits % ObjectLocks::sStripeCount;
+        if (!lockStripe(stripe)) {
+            return false;
+        }
+        stripeGuard.mReader = this;
+        stripeGuard.mStripe = stripe;
+    }
+
+    SceneObject::UpdateGuard guard(so);
+    update();
+    return true;
+}
+
+int
+AsciiReader::raiseLoadCancelled()
+{
+    return luaL_error(mLua, "RDLA load cancelled, another file failed to load.");
+}
+
 void
 AsciiReader::storeInstancePtr()
 {
@@ -1756,6 +1888,49 @@ AsciiReader::setAttribute(SceneObject* so, const Attribute* attr, int valueIndex
     }
 }
 
+bool
+AsciiReader::trySetAttribute(SceneObject* so, const std::string& attrName,
+                             int valueIndex, std::vector<std::string>& problems)
+{
+    try {
+        // Fetch the attribute and set the value.
+        const Attribute* attr = so->getSceneClass().getAttribute(attrName);
+        setAttribute(so, attr, valueIndex);
+        return true;
+    } catch (except::KeyError& e) {
+        // No attribute with that name.
+        problems.push_back(e.what());
+    } catch (except::TypeError& e) {
+        // Type mismatch.
+        problems.push_back(e.what());
+    } catch (except::ValueError& e) {
+        // Inappropriate value (i.e. tried to bind to a non-bindable attribute)
+        problems.push_back(e.what());
+    }
+    return !mWarningsAsErrors;
+}
+
+void
+AsciiReader::reportAttributeProblems(const SceneObject* so,
+                                     const std::vector<std::string>& problems)
+{
+    if (problems.empty()) {
+        return;
+    }
+
+    if (mWarningsAsErrors) {
+        const char* msg = lua_pushstring(mLua, problems.front().c_str());
+        luaL_argerror(mLua, 2, msg); // Never returns.
+    }
+
+    luaL_where(mLua, 1);
+    for (const std::string& problem : problems) {
+        Logger::warn(util::buildString(lua_tostring(mLua, -1),
+                                       so->getName(), ": ", problem));
+    }
+    lua_pop(mLua, 1);
+}
+
 template <typename SetT, typename ElemT>
 int
 AsciiReader::commonCall(const char* setTypeName, const char* elemTypeName)
@@ -1802,9 +1977,12 @@ AsciiReader::commonCall(const char* setTypeName, const char* elemTypeName)
     }
 
     // Actually set the contents of the set.
-    SceneObject::UpdateGuard guard(set);
-    for (auto iter = elems.begin(); iter != elems.end(); ++iter) {
-        set->add(*iter);
+    if (!updateObject(set, [&]() {
+            for (auto iter = elems.begin(); iter != elems.end(); ++iter) {
+                set->add(*iter);
+            }
+        })) {
+        return raiseLoadCancelled();
     }
 
     // Return the object itself (allows for chaining).
@@ -2115,47 +2293,13 @@ RDL2_LUA_DEFINE(sceneObjectNewIndex)
     }
     std::string attrName(luaL_checkstring(mLua, 2));
 
-    // Begin the attribute update.
-    SceneObject::UpdateGuard guard(so);
-
-    try {
-        // Fetch the attribute and set the value.
-        const Attribute* attr = so->getSceneClass().getAttribute(attrName);
-        setAttribute(so, attr, 3);
-    } catch (except::KeyError& e) {
-        // No attribute with that name.
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(lua_tostring(mLua, -1),
-                         so->getName(), ": ", e.what());
-            lua_pop(mLua, 1);
-        }
-    } catch (except::TypeError& e) {
-        // Type mismatch.
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                           so->getName(), ": ", e.what()));
-            lua_pop(mLua, 1);
-        }
-    } catch (except::ValueError& e) {
-        // Inappropriate value (i.e. tried to bind to a non-bindable attribute)
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                           so->getName(), ": ", e.what()));
-            lua_pop(mLua, 1);
-        }
+    // Set the attribute. Lua errors must not be raised while the object is
+    // locked, so problems are only reported once the update is done.
+    std::vector<std::string> problems;
+    if (!updateObject(so, [&]() { trySetAttribute(so, attrName, 3, problems); })) {
+        return raiseLoadCancelled();
     }
+    reportAttributeProblems(so, problems);
 
     return 0;
 }
@@ -2211,57 +2355,30 @@ RDL2_LUA_DEFINE(sceneObjectCall)
         }
     }
 
-    // Begin the attribute update.
-    SceneObject::UpdateGuard guard(so);
-
-    // Grab the value for each attribute and set it.
+    // Push the value of each attribute before locking the object, since
+    // fetching them may run Lua code (and so raise Lua errors).
+    const int numValues = static_cast<int>(attrNames.size());
+    luaL_checkstack(mLua, numValues, "too many attributes in mass set");
+    const int firstValue = lua_gettop(mLua) + 1;
     for (auto& attrName : attrNames) {
-        //const std::string& attrName = *iter;
-
-        // Push the attribute's value onto the stack.
         lua_getfield(mLua, 2, attrName.c_str());
-        LuaPopGuard popGuard(mLua, 1);
+    }
 
-        try {
-            // Fetch the attribute and set the value.
-            const Attribute* attr = so->getSceneClass().getAttribute(attrName);
-            setAttribute(so, attr, -1);
-        } catch (except::KeyError& e) {
-            // No attribute with that name.
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(lua_tostring(mLua, -1),
-                             so->getName(), ": ", e.what());
-                lua_pop(mLua, 1);
-            }
-        } catch (except::TypeError& e) {
-            // Type mismatch.
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                               so->getName(), ": ", e.what()));
-                lua_pop(mLua, 1);
-            }
-        } catch (except::ValueError& e) {
-            // Inappropriate value (i.e. tried to bind to a non-bindable
-            // attribute)
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                               so->getName(), ": ", e.what()));
-                lua_pop(mLua, 1);
+    // Set each attribute from its value. Lua errors must not be raised while
+    // the object is locked, so problems are only reported once the update is
+    // done.
+    std::vector<std::string> problems;
+    if (!updateObject(so, [&]() {
+            for (int i = 0; i < numValues; ++i) {
+                if (!trySetAttribute(so, attrNames[i], firstValue + i, problems)) {
+                    break;
+                }
             }
-        }
+        })) {
+        return raiseLoadCancelled();
     }
+    lua_pop(mLua, numValues);
+    reportAttributeProblems(so, problems);
 
     // Return the object itself (allows for chaining).
     lua_pushvalue(mLua, 1);
@@ -2597,47 +2714,13 @@ RDL2_LUA_DEFINE(shadowReceiverSetNewIndex)
     }
     std::string attrName(luaL_checkstring(mLua, 2));
 
-    // Begin the attribute update.
-    SceneObject::UpdateGuard guard(so);
-
-    try {
-        // Fetch the attribute and set the value.
-        const Attribute* attr = so->getSceneClass().getAttribute(attrName);
-        setAttribute(so, attr, 3);
-    } catch (except::KeyError& e) {
-        // No attribute with that name.
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(lua_tostring(mLua, -1),
-                         so->getName(), ": ", e.what());
-            lua_pop(mLua, 1);
-        }
-    } catch (except::TypeError& e) {
-        // Type mismatch.
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                           so->getName(), ": ", e.what()));
-            lua_pop(mLua, 1);
-        }
-    } catch (except::ValueError& e) {
-        // Inappropriate value (i.e. tried to bind to a non-bindable attribute)
-        if (mWarningsAsErrors) {
-            const char* msg = lua_pushstring(mLua, e.what());
-            return luaL_argerror(mLua, 2, msg);
-        } else {
-            luaL_where(mLua, 1);
-            Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                           so->getName(), ": ", e.what()));
-            lua_pop(mLua, 1);
-        }
+    // Set the attribute. Lua errors must not be raised while the object is
+    // locked, so problems are only reported once the update is done.
+    std::vector<std::string> problems;
+    if (!updateObject(so, [&]() { trySetAttribute(so, attrName, 3, problems); })) {
+        return raiseLoadCancelled();
     }
+    reportAttributeProblems(so, problems);
 
     return 0;
 }
@@ -2684,57 +2767,30 @@ RDL2_LUA_DEFINE(shadowReceiverSetCall)
         }
     }
 
-    // Begin the attribute update.
-    SceneObject::UpdateGuard guard(so);
-
-    // Grab the value for each attribute and set it.
+    // Push the value of each attribute before locking the object, since
+    // fetching them may run Lua code (and so raise Lua errors).
+    const int numValues = static_cast<int>(attrNames.size());
+    luaL_checkstack(mLua, numValues, "too many attributes in mass set");
+    const int firstValue = lua_gettop(mLua) + 1;
     for (auto& attrName : attrNames) {
-        //const std::string& attrName = *iter;
-
-        // Push the attribute's value onto the stack.
         lua_getfield(mLua, 2, attrName.c_str());
-        LuaPopGuard popGuard(mLua, 1);
+    }
 
-        try {
-            // Fetch the attribute and set the value.
-            const Attribute* attr = so->getSceneClass().getAttribute(attrName);
-            setAttribute(so, attr, -1);
-        } catch (except::KeyError& e) {
-            // No attribute with that name.
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(lua_tostring(mLua, -1),
-                             so->getName(), ": ", e.what());
-                lua_pop(mLua, 1);
-            }
-        } catch (except::TypeError& e) {
-            // Type mismatch.
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                               so->getName(), ": ", e.what()));
-                lua_pop(mLua, 1);
-            }
-        } catch (except::ValueError& e) {
-            // Inappropriate value (i.e. tried to bind to a non-bindable
-            // attribute)
-            if (mWarningsAsErrors) {
-                const char* msg = lua_pushstring(mLua, e.what());
-                return luaL_argerror(mLua, 2, msg);
-            } else {
-                luaL_where(mLua, 1);
-                Logger::warn(util::buildString(lua_tostring(mLua, -1),
-                                               so->getName(), ": ", e.what()));
-                lua_pop(mLua, 1);
+    // Set each attribute from its value. Lua errors must not be raised while
+    // the object is locked, so problems are only reported once the update is
+    // done.
+    std::vector<std::string> problems;
+    if (!updateObject(so, [&]() {
+            for (int i = 0; i < numValues; ++i) {
+                if (!trySetAttribute(so, attrNames[i], firstValue + i, problems)) {
+                    break;
+                }
             }
-        }
+        })) {
+        return raiseLoadCancelled();
     }
+    lua_pop(mLua, numValues);
+    reportAttributeProblems(so, problems);
 
     // Return the object itself (allows for chaining).
     lua_pushvalue(mLua, 1);
@@ -2839,11 +2895,14 @@ RDL2_LUA_DEFINE(traceSetCall)
     }
 
     // Actually set the contents of the TraceSet.
-    SceneObject::UpdateGuard guard(traceSet);
-    for (std::size_t i = 0; i < geoms.size(); ++i) {
-        for (auto&& part : parts[i]) {
-            traceSet->assign(geoms[i], part);
-        }
+    if (!updateObject(traceSet, [&]() {
+            for (std::size_t i = 0; i < geoms.size(); ++i) {
+                for (auto&& part : parts[i]) {
+                    traceSet->assign(geoms[i], part);
+                }
+            }
+        })) {
+        return raiseLoadCancelled();
     }
 
     // Return the object itself (allows for chaining).
@@ -3051,11 +3110,14 @@ RDL2_LUA_DEFINE(layerCall)
     }
 
     // Actually set the contents of the layer.
-    SceneObject::UpdateGuard guard(layer);
-    for (std::size_t i = 0; i < geoms.size(); ++i) {
-        for (auto&& part : parts[i]) {
-            layer->assign(geoms[i], part, layerAssignments[i]);
-        }
+    if (!updateObject(layer, [&]() {
+            for (std::size_t i = 0; i < geoms.size(); ++i) {
+                for (auto&& part : parts[i]) {
+                    layer->assign(geoms[i], part, layerAssignments[i]);
+                }
+            }
+        })) {
+        return raiseLoadCancelled();
     }
 
     // Return the object itself (allows for chaining).
@@ -3194,8 +3256,9 @@ RDL2_LUA_DEFINE(metadataCall)
     }
 
     // Actually set the contents of the metadata.
-    SceneObject::UpdateGuard guard(metadata);
-    metadata->setAttributes(names, types, values);
+    if (!updateObject(metadata, [&]() { metadata->setAttributes(names, types, values); })) {
+        return raiseLoadCancelled();
+    }
 
     // Return the object itself (allows for chaining).
     lua_pushvalue(mLua, 1);
@@ -46,6 +46,8 @@ namespace rdl2 {
  *      the AsciiReader processes the file serially, this is only a problem
  *      if you are mucking about with SceneObjects in another thread while the
  *      AsciiReader is working.
+ *  - fromFiles() runs several AsciiReaders at once. It serializes their
+ *      updates to any one SceneObject, but nothing else.
  */
 class AsciiReader
 {
@@ -92,6 +94,29 @@ public:
      */
     void fromString(const std::string& code, const std::string& chunkName = "@rdla");
 
+    /**
+     * Reads a set of RDL ASCII files into the given SceneContext in
+     * parallel. Each file is evaluated by its own AsciiReader, with its own
+     * Lua state, on a TBB worker thread.
+     *
+     * The files must be independent: each file may create and reference
+     * objects from any other file (names are resolved through the
+     * SceneContext, so bindings across files just work), but no two files
+     * should set the same attribute, as the order in which files are applied
+     * is undefined. Updates to a single SceneObject from different files are
+     * serialized, so they are safe, just not ordered. Lua globals are not
+     * shared between files.
+     *
+     * If any file fails to load, the remaining files are abandoned and the
+     * error of the first file to fail is rethrown once all threads are done.
+     *
+     * @param   context             The SceneContext where updates will be made.
+     * @param   filenames           The paths to the RDL ASCII files.
+     * @param   warningsAsErrors    See setWarningsAsErrors().
+     */
+    static void fromFiles(SceneContext& context, const std::vector<std::string>& filenames,
+                          bool warningsAsErrors = false);
+
     /**
      * When enabled, questionable actions which may be mistakes (such as trying 
      * to set an attribute which doesn't exist) will cause an error rather than
@@ -115,6 +140,31 @@ private:
     // invokes C++ static functions).
     static AsciiReader* loadInstancePtr(lua_State* state);
 
+    // Striped locks shared by the AsciiReaders of one fromFiles() call.
+    struct ObjectLocks;
+
+    // Runs update() on the given SceneObject inside an UpdateGuard, holding
+    // the object's striped lock against the other readers of a fromFiles()
+    // call. Stand alone readers don't lock. The stripes are re-entrant per
+    // reader (and so per thread), so update() may touch another object which
+    // shares the stripe. update() must not raise Lua errors, since those
+    // longjmp past the unlock; collect problems and raise them once this has
+    // returned. Returns false without calling update() if another reader
+    // failed while we were waiting for the lock.
+    template <typename F> bool updateObject(SceneObject* so, F update);
+
+    // Stripe bookkeeping for updateObject(). lockStripe() returns false if
+    // the load was cancelled while waiting.
+    bool lockStripe(std::size_t stripe);
+    void unlockStripe(std::size_t stripe);
+
+    // Releases every stripe this reader still holds. Only does anything if a
+    // Lua error unwound past updateObject().
+    void releaseStripes();
+
+    // Raises the Lua error for a load cancelled by another reader.
+    int raiseLoadCancelled();
+
     // The linker guarantees the address of this constant will be unique
     // through the whole program, so we can use its address as a key into the
     // Lua registry that is guaranteed to not collide with anything else.
@@ -343,6 +393,20 @@ private:
     // the appropriate calls to setBinding() and setValue().
     void setAttribute(SceneObject* so, const Attribute* attr, int valueIndex);
 
+    // Looks up the Attribute attrName and sets it on SceneObject so with
+    // setAttribute(). Key, type and value errors don't raise, they are
+    // appended to problems instead so this can run under updateObject().
+    // Returns false if the caller should stop setting attributes, which is
+    // on the first problem when warnings are errors.
+    bool trySetAttribute(SceneObject* so, const std::string& attrName,
+                         int valueIndex, std::vector<std::string>& problems);
+
+    // Reports the problems collected by trySetAttribute(). If warnings are
+    // errors the first one is raised as a Lua error on argument 2, otherwise
+    // they are all logged as warnings.
+    void reportAttributeProblems(const SceneObject* so,
+                                 const std::vector<std::string>& problems);
+
     // Common function call operator for set types which use the bare table
     // function call syntax to set the members of a set. The parameters are
     // string names of these types for use in error messages.
@@ -532,6 +596,12 @@ private:
 
     lua_State* mLua;
     bool mWarningsAsErrors;
+
+    // Set only for readers run by fromFiles().
+    ObjectLocks* mObjectLocks;
+
+    // How many times this reader holds each stripe of mObjectLocks.
+    std::vector<unsigned> mStripeDepths;
 };
 
 void
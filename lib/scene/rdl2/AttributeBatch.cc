@@ -0,0 +1,94 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "AttributeBatch.h"
+
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+constexpr std::size_t AttributeBatch::sNumAttributeTypes;
+
+AttributeBatch::AttributeBatch()
+{
+}
+
+AttributeBatch::~AttributeBatch()
+{
+}
+
+void
+AttributeBatch::apply(bool parallel)
+{
+    if (mChanges.empty()) {
+        return;
+    }
+
+    // Group the changes by object. The sort is stable so that changes to the
+    // same object keep the order they were queued in.
+    std::stable_sort(mChanges.begin(), mChanges.end(),
+        [](const Change& a, const Change& b) {
+            return a.mObject < b.mObject;
+        });
+
+    // Each group runs from groupStarts[i] up to groupStarts[i + 1].
+    std::vector<std::size_t> groupStarts;
+    for (std::size_t i = 0; i < mChanges.size(); ++i) {
+        if (i == 0 || mChanges[i].mObject != mChanges[i - 1].mObject) {
+            groupStarts.push_back(i);
+        }
+    }
+    groupStarts.push_back(mChanges.size());
+
+    const Change* changes = mChanges.data();
+    auto applyGroupAt = [&](std::size_t group) {
+        applyGroup(changes + groupStarts[group], changes + groupStarts[group + 1]);
+    };
+
+    // Empty the batch whether or not applying it succeeds.
+    struct ClearOnExit
+    {
+        AttributeBatch& mBatch;
+        ~ClearOnExit() { mBatch.clear(); }
+    } clearOnExit{*this};
+
+    const std::size_t groupCount = groupStarts.size() - 1;
+    if (parallel) {
+        tbb::parallel_for(std::size_t(0), groupCount, applyGroupAt);
+    } else {
+        for (std::size_t group = 0; group < groupCount; ++group) {
+            applyGroupAt(group);
+        }
+    }
+}
+
+void
+AttributeBatch::applyGroup(const Change* begin, const Change* end)
+{
+    SceneObject* obj = begin->mObject;
+    SceneObject::UpdateGuard guard(obj);
+    for (const Change* change = begin; change != end; ++change) {
+        change->mList->apply(obj, change->mSlot);
+    }
+}
+
+void
+AttributeBatch::clear()
+{
+    for (std::unique_ptr<ValueListBase>& list : mValueLists) {
+        if (list) {
+            list->clear();
+        }
+    }
+    mChanges.clear();
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,290 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include "AttributeKey.h"
+#include "SceneObject.h"
+#include "Types.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * An AttributeBatch collects attribute changes for many SceneObjects and
+ * applies them in one call. Each change is an (object, AttributeKey, value)
+ * tuple, optionally for a single timestep; whole vectors of objects and
+ * values can be queued at once.
+ *
+ * When the batch is applied the changes are grouped by object, and each
+ * object's changes are made inside a single beginUpdate() / endUpdate()
+ * bracket, so callers don't need to open an UpdateGuard per object. Since
+ * every object is touched by exactly one thread, groups can be applied in
+ * parallel. Changes to the same attribute of the same object are applied in
+ * the order they were queued, so the last one wins.
+ *
+ * Changes go through SceneObject::set(), so the usual bookkeeping (lazy
+ * attributes, the set and update masks, and the SceneContext's dirty list)
+ * happens exactly as if each value had been set individually.
+ *
+ *      AttributeBatch batch;
+ *      batch.set(objects, xformKey, xforms);
+ *      batch.set(light, intensityKey, 2.0f);
+ *      batch.apply(true);
+ *
+ * Thread Safety:
+ *  - Queueing changes is not thread safe.
+ *  - apply() must not run while any of the objects in the batch are between
+ *      beginUpdate() and endUpdate() calls, or are being changed elsewhere.
+ */
+class AttributeBatch
+{
+public:
+    AttributeBatch();
+    ~AttributeBatch();
+
+    /**
+     * Queues a change to an attribute on a SceneObject. If the attribute is
+     * blurrable, all timesteps are set.
+     *
+     * @param   obj     The SceneObject to change.
+     * @param   key     The AttributeKey of the attribute to change.
+     * @param   value   The new value.
+     */
+    template <typename T>
+    void set(SceneObject* obj, AttributeKey<T> key, const T& value);
+
+    /**
+     * Queues a change to an attribute on a SceneObject at a specific
+     * timestep.
+     *
+     * @param   obj         The SceneObject to change.
+     * @param   key         The AttributeKey of the attribute to change.
+     * @param   value       The new value.
+     * @param   timestep    The timestep to set.
+     */
+    template <typename T>
+    void set(SceneObject* obj, AttributeKey<T> key, const T& value,
+             AttributeTimestep timestep);
+
+    /**
+     * Queues changes to the same attribute on many SceneObjects, where
+     * objects[i] gets values[i]. If the attribute is blurrable, all timesteps
+     * are set.
+     *
+     * @param   objects     The SceneObjects to change.
+     * @param   key         The AttributeKey of the attribute to change.
+     * @param   values      The new values, one for each object.
+     * @throw   except::ValueError  If the vectors differ in length.
+     */
+    template <typename T>
+    void set(const SceneObjectVector& objects, AttributeKey<T> key,
+             const std::vector<T>& values);
+
+    /**
+     * Queues changes to the same attribute on many SceneObjects at a
+     * specific timestep, where objects[i] gets values[i].
+     *
+     * @param   objects     The SceneObjects to change.
+     * @param   key         The AttributeKey of the attribute to change.
+     * @param   values      The new values, one for each object.
+     * @param   timestep    The timestep to set.
+     * @throw   except::ValueError  If the vectors differ in length.
+     */
+    template <typename T>
+    void set(const SceneObjectVector& objects, AttributeKey<T> key,
+             const std::vector<T>& values, AttributeTimestep timestep);
+
+    /**
+     * Applies all queued changes and empties the batch. If a change fails
+     * (for example, a SceneObject of the wrong type is assigned to a
+     * SceneObject attribute) the exception is passed on; changes made before
+     * the failure are kept, and every object's update bracket is closed.
+     *
+     * @param   parallel    Apply the changes to different objects in
+     *                      parallel.
+     */
+    void apply(bool parallel = false);
+
+    /// Discards all queued changes.
+    void clear();
+
+    /// Returns the number of queued changes.
+    finline std::size_t size() const;
+
+    /// Returns true if no changes are queued.
+    finline bool empty() const;
+
+private:
+    // Non-copyable.
+    AttributeBatch(const AttributeBatch&);
+    const AttributeBatch& operator=(const AttributeBatch&);
+
+    // The queued keys, values and timesteps of one attribute type. Values are
+    // kept in typed vectors so queueing a change doesn't allocate per change.
+    class ValueListBase
+    {
+    public:
+        virtual ~ValueListBase() {}
+        virtual void apply(SceneObject* obj, uint32_t slot) const = 0;
+        virtual void clear() = 0;
+    };
+
+    template <typename T>
+    class ValueList : public ValueListBase
+    {
+    public:
+        void apply(SceneObject* obj, uint32_t slot) const override;
+        void clear() override;
+
+        std::vector<AttributeKey<T>> mKeys;
+        std::vector<T> mValues;
+        std::vector<AttributeTimestep> mTimesteps;
+    };
+
+    // A single queued change: which object, and where its key and value live.
+    struct Change
+    {
+        SceneObject* mObject;
+        const ValueListBase* mList;
+        uint32_t mSlot;
+    };
+
+    template <typename T>
+    ValueList<T>& getValueList();
+
+    template <typename T>
+    void push(SceneObject* obj, AttributeKey<T> key, const T& value,
+              AttributeTimestep timestep);
+
+    // Applies changes [begin, end), which all belong to the same object.
+    static void applyGroup(const Change* begin, const Change* end);
+
+    static constexpr std::size_t sNumAttributeTypes = TYPE_SCENE_OBJECT_INDEXABLE + 1;
+
+    // Indexed by AttributeType, created on first use.
+    std::array<std::unique_ptr<ValueListBase>, sNumAttributeTypes> mValueLists;
+    std::vector<Change> mChanges;
+};
+
+template <typename T>
+void
+AttributeBatch::ValueList<T>::apply(SceneObject* obj, uint32_t slot) const
+{
+    // NUM_TIMESTEPS marks a change to all timesteps.
+    const T& value = mValues[slot];
+    if (mTimesteps[slot] == NUM_TIMESTEPS) {
+        obj->set(mKeys[slot], value);
+    } else {
+        obj->set(mKeys[slot], value, mTimesteps[slot]);
+    }
+}
+
+template <typename T>
+void
+AttributeBatch::ValueList<T>::clear()
+{
+    mKeys.clear();
+    mValues.clear();
+    mTimesteps.clear();
+}
+
+template <typename T>
+AttributeBatch::ValueList<T>&
+AttributeBatch::getValueList()
+{
+    std::unique_ptr<ValueListBase>& list = mValueLists[attributeType<T>()];
+    if (!list) {
+        list.reset(new ValueList<T>);
+    }
+    return static_cast<ValueList<T>&>(*list);
+}
+
+template <typename T>
+void
+AttributeBatch::push(SceneObject* obj, AttributeKey<T> key, const T& value,
+                     AttributeTimestep timestep)
+{
+    MNRY_ASSERT(obj, "Cannot queue an attribute change on a null SceneObject.");
+    ValueList<T>& list = getValueList<T>();
+    const uint32_t slot = static_cast<uint32_t>(list.mValues.size());
+    list.mKeys.push_back(key);
+    list.mValues.push_back(value);
+    list.mTimesteps.push_back(timestep);
+    mChanges.push_back(Change{obj, &list, slot});
+}
+
+template <typename T>
+void
+AttributeBatch::set(SceneObject* obj, AttributeKey<T> key, const T& value)
+{
+    push(obj, key, value, NUM_TIMESTEPS);
+}
+
+template <typename T>
+void
+AttributeBatch::set(SceneObject* obj, AttributeKey<T> key, const T& value,
+                    AttributeTimestep timestep)
+{
+    MNRY_ASSERT(timestep < NUM_TIMESTEPS, "Invalid attribute timestep.");
+    push(obj, key, value, timestep);
+}
+
+template <typename T>
+void
+AttributeBatch::set(const SceneObjectVector& objects, AttributeKey<T> key,
+                    const std::vector<T>& values)
+{
+    if (objects.size() != values.size()) {
+        throw except::ValueError("AttributeBatch::set() needs exactly one value"
+                " for each SceneObject.");
+    }
+    mChanges.reserve(mChanges.size() + objects.size());
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        push<T>(objects[i], key, values[i], NUM_TIMESTEPS);
+    }
+}
+
+template <typename T>
+void
+AttributeBatch::set(const SceneObjectVector& objects, AttributeKey<T> key,
+                    const std::vector<T>& values, AttributeTimestep timestep)
+{
+    if (objects.size() != values.size()) {
+        throw except::ValueError("AttributeBatch::set() needs exactly one value"
+                " for each SceneObject.");
+    }
+    MNRY_ASSERT(timestep < NUM_TIMESTEPS, "Invalid attribute timestep.");
+    mChanges.reserve(mChanges.size() + objects.size());
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        push<T>(objects[i], key, values[i], timestep);
+    }
+}
+
+std::size_t
+AttributeBatch::size() const
+{
+    return mChanges.size();
+}
+
+bool
+AttributeBatch::empty() const
+{
+    return mChanges.empty();
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,243 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include "AttributeKey.h"
+#include "SceneClass.h"
+#include "SceneObject.h"
+#include "Types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * An AttributeColumn is a contiguous copy of one attribute's value across
+ * every SceneObject of a SceneClass, in a structure-of-arrays layout. Row i
+ * holds the value of the i'th object of the class, in creation order (the
+ * order of SceneClass::getSceneObjects()), so bulk consumers can scan an
+ * attribute with plain (SIMD friendly) loads instead of chasing a pointer
+ * into each object's attribute storage.
+ *
+ * The column is a snapshot that is refreshed explicitly with update(). Each
+ * update() re-reads only the rows whose attribute has changed
+ * (SceneObject::hasChanged()) and appends rows for newly created objects.
+ * The rows it touched are reported as a dirty range, so consumers can limit
+ * their own work to [getDirtyBegin(), getDirtyEnd()).
+ *
+ * Because changes are detected through the update masks, update() must be
+ * called after changes are made and before the masks are cleared by
+ * SceneContext::resetUpdates(), the same window in which DSOs see
+ * hasChanged(). Values of blurrable attributes are read at the timestep the
+ * column was created for.
+ *
+ * Only trivially copyable attribute types (everything except strings,
+ * vectors and SceneObject vectors) can be stored in a column. The storage is
+ * cache line aligned.
+ *
+ * Thread Safety:
+ *  - update() must not run concurrently with creating objects of the class
+ *      or setting the attribute. Reading a column is safe from any number of
+ *      threads while it is not being updated.
+ */
+template <typename T>
+class AttributeColumn
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "AttributeColumn only supports trivially copyable attribute types.");
+
+public:
+    /**
+     * Creates a column for the given attribute of the given SceneClass, and
+     * fills it with the current values of all the objects of that class.
+     *
+     * @param   sceneClass  The SceneClass whose objects make up the rows.
+     * @param   key         An AttributeKey for an attribute of that class.
+     * @param   timestep    The timestep to read blurrable attributes at.
+     */
+    AttributeColumn(const SceneClass& sceneClass, AttributeKey<T> key,
+                    AttributeTimestep timestep = TIMESTEP_BEGIN);
+
+    ~AttributeColumn();
+
+    /**
+     * Brings the column up to date with the objects of the SceneClass,
+     * re-reading changed rows and appending rows for new objects.
+     *
+     * @return  True if any rows were written.
+     */
+    bool update();
+
+    /// Returns a pointer to the first row. Valid until the next update().
+    finline const T* data() const;
+
+    /// Returns the number of rows (objects) in the column.
+    finline std::size_t size() const;
+
+    /// Returns the value in the given row.
+    finline const T& operator[](std::size_t row) const;
+
+    /// Returns the SceneObject a row belongs to.
+    finline const SceneObject* getSceneObject(std::size_t row) const;
+
+    /// Returns the first row written by the last update() (or construction).
+    finline std::size_t getDirtyBegin() const;
+
+    /// Returns one past the last row written by the last update(). Equal to
+    /// getDirtyBegin() if nothing was written.
+    finline std::size_t getDirtyEnd() const;
+
+private:
+    // Non-copyable.
+    AttributeColumn(const AttributeColumn&);
+    const AttributeColumn& operator=(const AttributeColumn&);
+
+    static constexpr std::size_t sAlignment = 64;
+
+    // Grows the storage so it can hold at least the given number of rows.
+    void reserve(std::size_t rows);
+
+    const SceneClass& mSceneClass;
+    const AttributeKey<T> mKey;
+    const AttributeTimestep mTimestep;
+
+    // Aligned storage for the rows. A plain array rather than a std::vector,
+    // so that Bool columns are real bools and not a packed vector<bool>.
+    T* mValues;
+    std::size_t mSize;
+    std::size_t mCapacity;
+
+    std::size_t mDirtyBegin;
+    std::size_t mDirtyEnd;
+};
+
+template <typename T>
+AttributeColumn<T>::AttributeColumn(const SceneClass& sceneClass, AttributeKey<T> key,
+                                    AttributeTimestep timestep) :
+    mSceneClass(sceneClass),
+    mKey(key),
+    mTimestep(timestep),
+    mValues(nullptr),
+    mSize(0),
+    mCapacity(0),
+    mDirtyBegin(0),
+    mDirtyEnd(0)
+{
+    update();
+}
+
+template <typename T>
+AttributeColumn<T>::~AttributeColumn()
+{
+    util::alignedFree(mValues);
+}
+
+template <typename T>
+bool
+AttributeColumn<T>::update()
+{
+    const SceneObjectVector& objects = mSceneClass.getSceneObjects();
+
+    std::size_t dirtyBegin = objects.size();
+    std::size_t dirtyEnd = 0;
+    for (std::size_t row = 0; row < mSize; ++row) {
+        const SceneObject* obj = objects[row];
+        if (obj->hasChanged(mKey)) {
+            mValues[row] = obj->get(mKey, mTimestep);
+            dirtyBegin = std::min(dirtyBegin, row);
+            dirtyEnd = row + 1;
+        }
+    }
+
+    if (objects.size() > mSize) {
+        reserve(objects.size());
+        dirtyBegin = std::min(dirtyBegin, mSize);
+        for (std::size_t row = mSize; row < objects.size(); ++row) {
+            mValues[row] = objects[row]->get(mKey, mTimestep);
+        }
+        mSize = objects.size();
+        dirtyEnd = mSize;
+    }
+
+    if (dirtyBegin < dirtyEnd) {
+        mDirtyBegin = dirtyBegin;
+        mDirtyEnd = dirtyEnd;
+        return true;
+    }
+    mDirtyBegin = mDirtyEnd = 0;
+    return false;
+}
+
+template <typename T>
+void
+AttributeColumn<T>::reserve(std::size_t rows)
+{
+    if (rows <= mCapacity) {
+        return;
+    }
+
+    const std::size_t capacity = std::max(rows, mCapacity * 2);
+    T* values = static_cast<T*>(util::alignedMalloc(capacity * sizeof(T), sAlignment));
+    if (mSize) {
+        std::memcpy(values, mValues, mSize * sizeof(T));
+    }
+    util::alignedFree(mValues);
+    mValues = values;
+    mCapacity = capacity;
+}
+
+template <typename T>
+const T*
+AttributeColumn<T>::data() const
+{
+    return mValues;
+}
+
+template <typename T>
+std::size_t
+AttributeColumn<T>::size() const
+{
+    return mSize;
+}
+
+template <typename T>
+const T&
+AttributeColumn<T>::operator[](std::size_t row) const
+{
+    MNRY_ASSERT(row < mSize);
+    return mValues[row];
+}
+
+template <typename T>
+const SceneObject*
+AttributeColumn<T>::getSceneObject(std::size_t row) const
+{
+    return mSceneClass.getSceneObjects()[row];
+}
+
+template <typename T>
+std::size_t
+AttributeColumn<T>::getDirtyBegin() const
+{
+    return mDirtyBegin;
+}
+
+template <typename T>
+std::size_t
+AttributeColumn<T>::getDirtyEnd() const
+{
+    return mDirtyEnd;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,114 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "AttributeStorageArena.h"
+
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <algorithm>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+constexpr std::size_t AttributeStorageArena::sAlignment;
+constexpr std::size_t AttributeStorageArena::sFirstSlabBlocks;
+constexpr std::size_t AttributeStorageArena::sMaxSlabBlocks;
+
+AttributeStorageArena::ThreadArena::ThreadArena() :
+    mNextSlabBlocks(sFirstSlabBlocks),
+    mCursor(nullptr),
+    mSlabEnd(nullptr),
+    mFreeList(nullptr)
+{
+}
+
+AttributeStorageArena::AttributeStorageArena() :
+    mBlockSize(0),
+    mSharedFreeList(nullptr)
+{
+}
+
+AttributeStorageArena::~AttributeStorageArena()
+{
+    for (ThreadArena& arena : mThreadArenas) {
+        for (void* slab : arena.mSlabs) {
+            util::alignedFree(slab);
+        }
+    }
+}
+
+void*
+AttributeStorageArena::allocate(std::size_t size)
+{
+    std::size_t blockSize = mBlockSize.load(std::memory_order_relaxed);
+    if (blockSize == 0) {
+        // Every block must be able to hold a free list link, and rounding up
+        // to the alignment keeps every block in a slab cache line aligned.
+        const std::size_t minSize = std::max(size, sizeof(void*));
+        blockSize = ((minSize + sAlignment - 1) / sAlignment) * sAlignment;
+        mBlockSize.store(blockSize, std::memory_order_relaxed);
+    }
+    MNRY_ASSERT(size <= blockSize);
+
+    ThreadArena& arena = mThreadArenas.local();
+    if (!arena.mFreeList &&
+        mSharedFreeList.load(std::memory_order_relaxed)) {
+        arena.mFreeList = mSharedFreeList.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (arena.mFreeList) {
+        void* block = arena.mFreeList;
+        arena.mFreeList = *static_cast<void**>(block);
+        return block;
+    }
+
+    if (arena.mCursor == arena.mSlabEnd) {
+        addSlab(arena, blockSize);
+    }
+    void* block = arena.mCursor;
+    arena.mCursor += blockSize;
+    return block;
+}
+
+void
+AttributeStorageArena::deallocate(void* block)
+{
+    if (!block) {
+        return;
+    }
+
+    // The block goes on the shared list, wherever it was allocated, so it is
+    // reused even if the calling thread never allocates again.
+    void*& next = *static_cast<void**>(block);
+    next = mSharedFreeList.load(std::memory_order_relaxed);
+    while (!mSharedFreeList.compare_exchange_weak(next, block,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+    }
+}
+
+std::size_t
+AttributeStorageArena::getSlabCount() const
+{
+    std::size_t count = 0;
+    for (const ThreadArena& arena : mThreadArenas) {
+        count += arena.mSlabs.size();
+    }
+    return count;
+}
+
+void
+AttributeStorageArena::addSlab(ThreadArena& arena, std::size_t blockSize)
+{
+    const std::size_t slabSize = blockSize * arena.mNextSlabBlocks;
+    void* slab = util::alignedMalloc(slabSize, sAlignment);
+    arena.mSlabs.push_back(slab);
+
+    arena.mCursor = static_cast<char*>(slab);
+    arena.mSlabEnd = arena.mCursor + slabSize;
+    arena.mNextSlabBlocks = std::min(arena.mNextSlabBlocks * 2, sMaxSlabBlocks);
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
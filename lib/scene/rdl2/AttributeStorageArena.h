@@ -0,0 +1,118 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <tbb/enumerable_thread_specific.h>
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * An AttributeStorageArena hands out the attribute storage blocks for all
+ * SceneObjects of one SceneClass. Blocks all have the same size, so they are
+ * carved out of large cache line aligned slabs instead of being allocated
+ * one by one. Objects of a class created one after another end up next to
+ * each other in memory, which keeps loops over all geometries, lights, etc.
+ * of a class from jumping around the heap, and tearing a scene down frees a
+ * handful of slabs rather than one block per object.
+ *
+ * Freed blocks go on a free list and are reused by later allocations. Slab
+ * memory is only returned when the arena is destroyed, which happens when
+ * its SceneClass is destroyed after all of the SceneContext's objects.
+ *
+ * Each thread carves blocks out of its own slabs, so objects can be created
+ * from many threads at once (parallel rdla/rdlb loading) without the threads
+ * contending on a lock. Freed blocks are pushed onto a single free list
+ * shared by the whole arena, whichever thread frees them; a thread which runs
+ * out of its own freed blocks takes over everything on the shared list in
+ * one exchange. Blocks freed on a thread which never allocates therefore
+ * still come back to the threads which do.
+ *
+ * Thread Safety:
+ *  - allocate() and deallocate() are safe to call concurrently, as
+ *      SceneContext::createSceneObject() may be called from multiple threads.
+ *      They don't take any locks.
+ *  - getSlabCount() must not run concurrently with allocate().
+ */
+class AttributeStorageArena
+{
+public:
+    AttributeStorageArena();
+    ~AttributeStorageArena();
+
+    AttributeStorageArena(const AttributeStorageArena&) = delete;
+    AttributeStorageArena& operator=(const AttributeStorageArena&) = delete;
+
+    /**
+     * Returns an uninitialized block of at least size bytes, aligned on a
+     * cache line boundary. The block size is fixed by the first call, so
+     * every call must pass the same size.
+     *
+     * @param   size    The attribute storage size of the SceneClass.
+     */
+    void* allocate(std::size_t size);
+
+    /**
+     * Returns a block obtained from allocate() to the arena. Any values in
+     * it must already have been destroyed.
+     */
+    void deallocate(void* block);
+
+    /**
+     * Returns the number of slabs allocated so far.
+     */
+    std::size_t getSlabCount() const;
+
+    // Blocks and slabs are aligned on cache lines.
+    static constexpr std::size_t sAlignment = 64;
+
+private:
+    // The slabs and private free list of one thread.
+    struct ThreadArena
+    {
+        ThreadArena();
+
+        // Number of blocks in the next slab. Slabs start small so classes
+        // with only a few objects (or threads which only create a few)
+        // don't waste memory, and grow geometrically.
+        std::size_t mNextSlabBlocks;
+
+        std::vector<void*> mSlabs;
+
+        // Unused part of the newest slab.
+        char* mCursor;
+        char* mSlabEnd;
+
+        // Singly linked list of freed blocks taken over from mSharedFreeList,
+        // threaded through the blocks themselves. Only this thread pops it.
+        void* mFreeList;
+    };
+
+    // Allocates a new slab for the thread and points its bump cursor at it.
+    void addSlab(ThreadArena& arena, std::size_t blockSize);
+
+    // Size of each block, rounded up to sAlignment. Zero until the first
+    // allocation. Every allocate() computes the same value from the same
+    // size, so racing first calls store the same thing.
+    std::atomic<std::size_t> mBlockSize;
+
+    // Blocks freed by any thread. deallocate() pushes single blocks and
+    // allocate() only ever takes the whole list, so unlike popping single
+    // blocks off a shared stack neither operation is exposed to ABA.
+    std::atomic<void*> mSharedFreeList;
+
+    tbb::enumerable_thread_specific<ThreadArena> mThreadArenas;
+
+    static constexpr std::size_t sFirstSlabBlocks = 16;
+    static constexpr std::size_t sMaxSlabBlocks = 1024;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
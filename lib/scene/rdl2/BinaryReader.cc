@@ -7,10 +7,12 @@
 #include "Attribute.h"
 #include "Displacement.h"
 #include "Geometry.h"
+#include "LazyAttributeTable.h"
 #include "Layer.h"
 #include "LightFilterSet.h"
 #include "LightSet.h"
 #include "Material.h"
+#include "RecordCompression.h"
 #include "SceneClass.h"
 #include "SceneContext.h"
 #include "SceneObject.h"
@@ -25,13 +27,26 @@
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/Strings.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <fstream>
 #include <istream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <stdint.h>
 
+#include <fcntl.h>      // open
+#include <sys/mman.h>   // mmap, munmap, madvise
+#include <sys/stat.h>   // fstat
+#include <unistd.h>     // close
+
 #ifdef __APPLE__
 #include <libkern/OSByteOrder.h>
 #define be64toh(x) OSSwapBigToHostInt64(x)
@@ -44,9 +59,65 @@ using logging::Logger;
 
 namespace rdl2 {
 
+namespace {
+
+// Size of the frame header in front of the manifest: mlen and plen.
+constexpr std::size_t sFrameHeaderSize = 2 * sizeof(uint64_t);
+
+// Owns a read-only memory mapping of a whole file and unmaps it (and closes
+// the file descriptor) when it goes out of scope, including on exceptions
+// thrown while decoding.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if (mAddr) munmap(mAddr, mSize);
+        if (mFd != -1) close(mFd);
+    }
+
+    // Returns false if the file could not be opened or mapped.
+    bool map(const std::string& filename)
+    {
+        mFd = open(filename.c_str(), O_RDONLY);
+        if (mFd == -1) return false;
+
+        struct stat st;
+        if (fstat(mFd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) return false;
+        mSize = static_cast<std::size_t>(st.st_size);
+
+        void* addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+        if (addr == MAP_FAILED) return false;
+        mAddr = addr;
+
+        // Records are decoded front to back, so let the kernel read ahead.
+        madvise(mAddr, mSize, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    const void* getData() const { return mAddr; }
+    std::size_t getSize() const { return mSize; }
+
+private:
+    int mFd {-1};
+    void* mAddr {nullptr};
+    std::size_t mSize {0};
+};
+
+} // namespace
+
+constexpr std::size_t BinaryReader::sLazyAttributeMinSize;
+
 BinaryReader::BinaryReader(SceneContext& context) :
     mContext(context),
-    mWarningsAsErrors(false)
+    mWarningsAsErrors(false),
+    mMemoryMappedFile(true),
+    mParallelDecoding(false),
+    mLazyAttributes(false)
 {
 }
 
@@ -57,6 +128,10 @@ BinaryReader::~BinaryReader()
 void
 BinaryReader::fromFile(const std::string& filename)
 {
+    if (mMemoryMappedFile && fromMappedFile(filename)) {
+        return;
+    }
+
     // Create an input file stream.
     std::ifstream in(filename.c_str(), std::ios::binary);
     if (!in) {
@@ -85,49 +160,205 @@ BinaryReader::fromStream(std::istream& input)
     std::string manifest(manifestLen, '\0');
     input.read(&(manifest[0]), manifestLen);
 
-    // Read the payload.
-    std::string payload(payloadLen, '\0');
-    input.read(&(payload[0]), payloadLen);
+    // Read the payload. It's shared so lazily decoded attributes can keep
+    // it alive without another copy.
+    auto payload = std::make_shared<std::string>(payloadLen, '\0');
+    input.read(&((*payload)[0]), payloadLen);
+
+    fromSlices(Slice(manifest), Slice(*payload),
+               mLazyAttributes ? std::shared_ptr<const void>(payload) : nullptr);
+}
+
+bool
+BinaryReader::fromMappedFile(const std::string& filename)
+{
+    // Shared so lazily decoded attributes can keep the mapping alive.
+    auto file = std::make_shared<MappedFile>();
+    if (!file->map(filename)) {
+        return false;
+    }
+
+    Slice fileBytes(file->getData(), file->getSize());
+    if (fileBytes.getLength() < sFrameHeaderSize) {
+        std::stringstream errMsg;
+        errMsg << "RDL2 binary file '" << filename << "' is too short to"
+            " contain a frame header.";
+        throw except::IoError(errMsg.str());
+    }
+
+    // Read the manifest and payload lengths and convert to native byte order.
+    uint64_t manifestLen;
+    uint64_t payloadLen;
+    Slice(fileBytes, 0, sizeof(uint64_t)).copyTo(&manifestLen, sizeof(uint64_t));
+    Slice(fileBytes, sizeof(uint64_t), sizeof(uint64_t)).copyTo(&payloadLen, sizeof(uint64_t));
+    manifestLen = be64toh(manifestLen);
+    payloadLen = be64toh(payloadLen);
+
+    if (manifestLen > fileBytes.getLength() - sFrameHeaderSize ||
+        payloadLen > fileBytes.getLength() - sFrameHeaderSize - manifestLen) {
+        std::stringstream errMsg;
+        errMsg << "RDL2 binary file '" << filename << "' is truncated (mlen:"
+            << manifestLen << " plen:" << payloadLen << " file size:"
+            << fileBytes.getLength() << ").";
+        throw except::IoError(errMsg.str());
+    }
 
-    fromBytes(manifest, payload);
+    // Decode straight out of the mapping. The mapping stays alive until all
+    // records have been applied to the SceneContext, and after that for as
+    // long as any lazily decoded attribute still refers to it.
+    fromSlices(Slice(fileBytes, sFrameHeaderSize, manifestLen),
+               Slice(fileBytes, sFrameHeaderSize + manifestLen, payloadLen),
+               mLazyAttributes ? std::shared_ptr<const void>(file) : nullptr);
+    return true;
 }
 
 void
 BinaryReader::fromBytes(const std::string& manifest, const std::string& payload)
 {
-    Slice manifestBytes(manifest);
-    Slice payloadBytes(payload);
+    if (mLazyAttributes) {
+        // We don't own the payload, so lazily decoded attributes need a copy
+        // which outlives this call.
+        auto owned = std::make_shared<const std::string>(payload);
+        fromSlices(Slice(manifest), Slice(*owned), owned);
+    } else {
+        fromSlices(Slice(manifest), Slice(payload), nullptr);
+    }
+}
 
+void
+BinaryReader::fromSlices(Slice manifestBytes, Slice payloadBytes,
+                         const std::shared_ptr<const void>& owner)
+{
     // Read the manifest.
     RecordInfoVector records;
     readManifest(manifestBytes, records);
 
+    if (mParallelDecoding && records.size() > 1) {
+        readRecordsParallel(payloadBytes, records, owner);
+    } else {
+        readRecordsSerial(payloadBytes, records, owner);
+    }
+}
+
+void
+BinaryReader::readRecordsSerial(Slice payloadBytes, const RecordInfoVector& records,
+                                const std::shared_ptr<const void>& owner)
+{
     // Loop over records in the manifest and read each out of the payload.
-    // (This could be parallelized fairly easily if it's a bottleneck.)
     for (RecordInfoVector::const_iterator iter = records.begin(); iter != records.end(); ++iter) {
-        switch (iter->mType) {
-        case SCENE_OBJECT :
-            {
-                std::stringstream errMsg;
-                errMsg << "SCENE_OBJECT payload type is nolonger supported";
-                throw except::TypeError(errMsg.str());
-            }
-            break;
+        readRecord(iter->mType, Slice(payloadBytes, iter->mOffset, iter->mSize), owner);
+    }
+}
+
+void
+BinaryReader::readRecord(RecordType type, Slice bytes, const std::shared_ptr<const void>& owner)
+{
+    switch (type) {
+    case SCENE_OBJECT :
+        {
+            std::stringstream errMsg;
+            errMsg << "SCENE_OBJECT payload type is nolonger supported";
+            throw except::TypeError(errMsg.str());
+        }
+        break;
 
-        case SCENE_OBJECT_2 :
-            readSceneObject(Slice(payloadBytes, iter->mOffset, iter->mSize));
-            break;
+    case SCENE_OBJECT_2 :
+        readSceneObject(bytes, owner);
+        break;
+
+    case SCENE_OBJECT_2_COMPRESSED :
+        {
+            // Deferred values point into the decompressed record, not the
+            // payload, so it becomes their owner.
+            auto raw = std::make_shared<std::string>();
+            RecordCompression::decompress(bytes.getData(), bytes.getLength(), *raw);
+            readSceneObject(Slice(*raw), owner ? std::shared_ptr<const void>(raw) : nullptr);
+        }
+        break;
+
+    default:
+        {
+            std::stringstream errMsg;
+            errMsg << "Encountered unknown payload type '" << type <<
+                "' in manifest while parsing RDL2 binary file.";
+            throw except::TypeError(errMsg.str());
+        }
+        break;
+    }
+}
 
-        default:
-            {
-                std::stringstream errMsg;
-                errMsg << "Encountered unknown payload type '" << iter->mType <<
+void
+BinaryReader::readRecordsParallel(Slice payloadBytes, const RecordInfoVector& records,
+                                  const std::shared_ptr<const void>& owner)
+{
+    // Compressed records have to be expanded before even the object name
+    // can be read. Do that up front, in parallel.
+    std::vector<std::shared_ptr<std::string>> decompressed(records.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, records.size()),
+                      [&](const tbb::blocked_range<std::size_t>& range) {
+        for (std::size_t i = range.begin(); i != range.end(); ++i) {
+            if (records[i].mType == SCENE_OBJECT_2_COMPRESSED) {
+                Slice bytes(payloadBytes, records[i].mOffset, records[i].mSize);
+                decompressed[i] = std::make_shared<std::string>();
+                RecordCompression::decompress(bytes.getData(), bytes.getLength(), *decompressed[i]);
+            }
+        }
+    });
+
+    // Serial pass: validate the record types and create the SceneObjects in
+    // manifest order, so object creation order (and therefore the order of
+    // the SceneContext's geometry, camera, etc. lists) does not depend on
+    // thread scheduling. Each dequeuer is left positioned right after the
+    // object name, ready for unpackSceneObject().
+    std::vector<SceneObject*> sceneObjects;
+    std::vector<ValueContainerDeq> dequeuers;
+    sceneObjects.reserve(records.size());
+    dequeuers.reserve(records.size());
+
+    std::unordered_set<const SceneObject*> seen;
+    seen.reserve(records.size());
+
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const RecordInfo& record = records[i];
+        if (record.mType != SCENE_OBJECT_2 && record.mType != SCENE_OBJECT_2_COMPRESSED) {
+            std::stringstream errMsg;
+            if (record.mType == SCENE_OBJECT) {
+                errMsg << "SCENE_OBJECT payload type is nolonger supported";
+            } else {
+                errMsg << "Encountered unknown payload type '" << record.mType <<
                     "' in manifest while parsing RDL2 binary file.";
-                throw except::TypeError(errMsg.str());
             }
-            break;
+            throw except::TypeError(errMsg.str());
+        }
+
+        Slice bytes = (record.mType == SCENE_OBJECT_2_COMPRESSED) ?
+            Slice(*decompressed[i]) : Slice(payloadBytes, record.mOffset, record.mSize);
+        dequeuers.emplace_back(bytes.getData(), bytes.getLength());
+        SceneObject* sceneObject = readSceneObjectHeader(dequeuers.back());
+        if (sceneObject && !seen.insert(sceneObject).second) {
+            // Updates to the same SceneObject must be applied in order and
+            // must not race each other, so give up on parallel decoding.
+            // Objects created so far are simply found again.
+            readRecordsSerial(payloadBytes, records, owner);
+            return;
         }
+        sceneObjects.push_back(sceneObject);
     }
+
+    // Parallel pass: every record touches a distinct SceneObject, and any
+    // referenced objects are created through the thread safe SceneContext.
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, records.size()),
+                      [&](const tbb::blocked_range<std::size_t>& range) {
+        for (std::size_t i = range.begin(); i != range.end(); ++i) {
+            if (sceneObjects[i]) {
+                std::shared_ptr<const void> recordOwner = owner;
+                if (owner && decompressed[i]) {
+                    recordOwner = decompressed[i];
+                }
+                unpackSceneObject(dequeuers[i], *sceneObjects[i], recordOwner);
+            }
+        }
+    });
 }
 
 // static function    
@@ -179,11 +410,23 @@ BinaryReader::readManifest(Slice bytes, RecordInfoVector& info)
 }
 
 void
-BinaryReader::readSceneObject(Slice bytes)
+BinaryReader::readSceneObject(Slice bytes, const std::shared_ptr<const void>& owner)
 {
     const char *ptr = static_cast<const char *>(bytes.getData());
     ValueContainerDeq vContainerDeq(ptr, bytes.getLength());
 
+    SceneObject* sceneObject = readSceneObjectHeader(vContainerDeq);
+    if (!sceneObject) {
+        return;
+    }
+
+    // Unpack the data into the object.
+    unpackSceneObject(vContainerDeq, *sceneObject, owner);
+}
+
+SceneObject*
+BinaryReader::readSceneObjectHeader(ValueContainerDeq& vContainerDeq)
+{
     std::string klassName;
     std::string objName;
     vContainerDeq.deqString(klassName);
@@ -201,11 +444,10 @@ BinaryReader::readSceneObject(Slice bytes)
         } else {
             logging::Logger::warn(msg);
         }
-        return;
+        return nullptr;
     }
 
-    // Unpack the data into the object.
-    unpackSceneObject(vContainerDeq, *sceneObject);
+    return sceneObject;
 }
 
 void
@@ -230,57 +472,71 @@ BinaryReader::unpackLayer(BinaryReaderLayerUnpackStrings &layerStrVectors, Layer
     StringVector &volumeShaderKlassName = layerStrVectors.mVolumeShaderKlassName;
     StringVector &volumeShaderObjName   = layerStrVectors.mVolumeShaderObjName;
 
+    // Most assignments share a handful of materials, light sets, etc., so
+    // remember what each object name resolved to rather than going through
+    // the SceneContext maps for every slot of every assignment.
+    std::unordered_map<std::string, SceneObject*> resolved;
+    auto resolve = [&](const std::string& klassName, const std::string& objName) -> SceneObject* {
+        auto iter = resolved.find(objName);
+        if (iter != resolved.end() && iter->second->getSceneClass().getName() == klassName) {
+            return iter->second;
+        }
+        // Also reports mismatched class names for names we've seen before.
+        SceneObject* obj = mContext.createSceneObject(klassName, objName);
+        resolved[objName] = obj;
+        return obj;
+    };
+
     for (size_t i = 0; i < geomKlassName.size(); ++i) {
         // Unpack the geometry
         SceneObject *geomObj = nullptr;
         if (!geomKlassName[i].empty() && !geomObjName[i].empty()) {
-            geomObj = mContext.createSceneObject(geomKlassName[i], geomObjName[i]);
+            geomObj = resolve(geomKlassName[i], geomObjName[i]);
         }
 
         // Unpack the material, might be null
         SceneObject* materialObj = nullptr;
         if (!materialKlassName.empty() && !materialKlassName[i].empty() && !materialObjName[i].empty()) {
-            materialObj = mContext.createSceneObject(materialKlassName[i], materialObjName[i]);
+            materialObj = resolve(materialKlassName[i], materialObjName[i]);
         }
 
         // Unpack the lightset
         SceneObject* lightSetObj = nullptr;
         if (!lightSetKlassName.empty() && !lightSetKlassName[i].empty() && !lightSetObjName[i].empty()) {
-            lightSetObj = mContext.createSceneObject(lightSetKlassName[i], lightSetObjName[i]);
+            lightSetObj = resolve(lightSetKlassName[i], lightSetObjName[i]);
         }
 
         // Unpack the lightfilterset
         SceneObject* lightFilterSetObj = nullptr;
         if (!lightFilterSetKlassName.empty() && !lightFilterSetKlassName[i].empty() &&
                 !lightFilterSetObjName[i].empty()) {
-            lightFilterSetObj = mContext.createSceneObject(lightFilterSetKlassName[i], lightFilterSetObjName[i]);
+            lightFilterSetObj = resolve(lightFilterSetKlassName[i], lightFilterSetObjName[i]);
         }
 
         // Unpack the shadowset
         SceneObject* shadowSetObj = nullptr;
         if (!shadowSetKlassName.empty() && !shadowSetKlassName[i].empty() &&
                 !shadowSetObjName[i].empty()) {
-            shadowSetObj = mContext.createSceneObject(shadowSetKlassName[i], shadowSetObjName[i]);
+            shadowSetObj = resolve(shadowSetKlassName[i], shadowSetObjName[i]);
         }
 
         // Unpack the shadowreceiverset
         SceneObject* shadowReceiverSetObj = nullptr;
         if (!shadowReceiverSetKlassName.empty() && !shadowReceiverSetKlassName[i].empty()
                                                 && !shadowReceiverSetObjName[i].empty()) {
-            shadowReceiverSetObj = mContext.createSceneObject(shadowReceiverSetKlassName[i],
-                                                              shadowReceiverSetObjName[i]);
+            shadowReceiverSetObj = resolve(shadowReceiverSetKlassName[i], shadowReceiverSetObjName[i]);
         }
 
         // Unpack the displacement, might be null
         SceneObject* displacementObj = nullptr;
         if (!displacementKlassName.empty() && !displacementKlassName[i].empty() && !displacementObjName[i].empty()) {
-            displacementObj = mContext.createSceneObject(displacementKlassName[i], displacementObjName[i]);
+            displacementObj = resolve(displacementKlassName[i], displacementObjName[i]);
         }
 
         // Unpack the volumeShader, might be null
         SceneObject* volumeShaderObj = nullptr;
         if (!volumeShaderKlassName.empty() && !volumeShaderKlassName[i].empty() && !volumeShaderObjName[i].empty()) {
-            volumeShaderObj = mContext.createSceneObject(volumeShaderKlassName[i], volumeShaderObjName[i]);
+            volumeShaderObj = resolve(volumeShaderKlassName[i], volumeShaderObjName[i]);
         }
 
         LayerAssignment layerAssignment;
@@ -297,7 +553,8 @@ BinaryReader::unpackLayer(BinaryReaderLayerUnpackStrings &layerStrVectors, Layer
 }
 
 void
-BinaryReader::unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& sceneObject) const
+BinaryReader::unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& sceneObject,
+                                const std::shared_ptr<const void>& owner) const
 {
     SceneObject::UpdateGuard guard(&sceneObject);
 
@@ -334,7 +591,8 @@ BinaryReader::unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& s
                         (transientEncoding)? sceneClass.mAttributes[attributeId]->getName(): attributeName;
                     unpackLayerValue(vContainerDeq, layerStrVectors, valueType, attrName);
                 } else {
-                    unpackValue(vContainerDeq, sceneObject, valueType, transientEncoding, attributeId, attributeName);
+                    unpackValue(vContainerDeq, sceneObject, valueType, transientEncoding, attributeId, attributeName,
+                                owner);
                 }
             } catch (except::KeyError& e) {
                 // No attribute with that name.
@@ -408,7 +666,7 @@ BinaryReader::unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& s
                 sceneObject.mBindings[index] = targetObject;
                 sceneObject.mBindingSetMask.set(index, true);
                 sceneObject.mBindingUpdateMask.set(index, true);
-                sceneObject.mDirty = true;
+                sceneObject.setDirty();
             }
 
         } catch (except::KeyError& e) {
@@ -437,7 +695,8 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
                            ValueContainerUtil::ValueType valueType,
                            bool transientEncoding,
                            int attributeId,
-                           std::string &attributeName) const
+                           std::string &attributeName,
+                           const std::shared_ptr<const void>& owner) const
 {
     int timestepInt;
     {
@@ -445,10 +704,22 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
         vContainerDeq.deqUChar(uc);
         timestepInt = static_cast<int>(uc);
     }
-    AttributeTimestep timestep = static_cast<AttributeTimestep>(static_cast<int>(timestepInt));
-
     const SceneClass& sceneClass = sceneObject.getSceneClass();
 
+    // A flagged timestep marks a vector written as a sparse delta, followed
+    // by the attribute it is a delta against.
+    DeltaReference reference;
+    if (timestepInt & sVectorDeltaFlag) {
+        timestepInt &= ~sVectorDeltaFlag;
+        reference.mIsDelta = true;
+        if (transientEncoding) {
+            vContainerDeq.deqInt(reference.mId);
+        } else {
+            vContainerDeq.deqString(reference.mName);
+        }
+    }
+    AttributeTimestep timestep = static_cast<AttributeTimestep>(static_cast<int>(timestepInt));
+
     switch (valueType) {
     case ValueContainerUtil::ValueType::BOOL : {
         Bool val; vContainerDeq.deqBool(val);
@@ -540,56 +811,56 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
         sceneObject.set(keyGen<LongVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
     } break;
     case ValueContainerUtil::ValueType::FLOAT_VECTOR : {
-        FloatVector vec; vContainerDeq.deqFloatVector(vec);
-        sceneObject.set(keyGen<FloatVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<FloatVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::DOUBLE_VECTOR : {
-        DoubleVector vec; vContainerDeq.deqDoubleVector(vec);
-        sceneObject.set(keyGen<DoubleVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<DoubleVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                   timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::STRING_VECTOR : {
         StringVector vec; vContainerDeq.deqStringVector(vec);
         sceneObject.set(keyGen<StringVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
     } break;
     case ValueContainerUtil::ValueType::RGB_VECTOR : {
-        RgbVector vec; vContainerDeq.deqRgbVector(vec);
-        sceneObject.set(keyGen<RgbVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<RgbVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::RGBA_VECTOR : {
-        RgbaVector vec; vContainerDeq.deqRgbaVector(vec);
-        sceneObject.set(keyGen<RgbaVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<RgbaVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                 timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC2F_VECTOR : {
-        Vec2fVector vec; vContainerDeq.deqVec2fVector(vec);
-        sceneObject.set(keyGen<Vec2fVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec2fVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC2D_VECTOR : {
-        Vec2dVector vec; vContainerDeq.deqVec2dVector(vec);
-        sceneObject.set(keyGen<Vec2dVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec2dVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC3F_VECTOR : {
-        Vec3fVector vec; vContainerDeq.deqVec3fVector(vec);
-        sceneObject.set(keyGen<Vec3fVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec3fVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC3D_VECTOR : {
-        Vec3dVector vec; vContainerDeq.deqVec3dVector(vec);
-        sceneObject.set(keyGen<Vec3dVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec3dVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC4F_VECTOR : {
-        Vec4fVector vec; vContainerDeq.deqVec4fVector(vec);
-        sceneObject.set(keyGen<Vec4fVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec4fVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::VEC4D_VECTOR : {
-        Vec4dVector vec; vContainerDeq.deqVec4dVector(vec);
-        sceneObject.set(keyGen<Vec4dVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Vec4dVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::MAT4F_VECTOR : {
-        Mat4fVector vec; vContainerDeq.deqMat4fVector(vec);
-        sceneObject.set(keyGen<Mat4fVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Mat4fVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
     case ValueContainerUtil::ValueType::MAT4D_VECTOR : {
-        Mat4dVector vec; vContainerDeq.deqMat4dVector(vec);
-        sceneObject.set(keyGen<Mat4dVector>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        unpackVector<Mat4dVector>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                                  timestep, reference, owner);
     } break;
 
     case ValueContainerUtil::ValueType::SCENE_OBJECT_VECTOR : {
@@ -648,6 +919,114 @@ BinaryReader::unpackValue(ValueContainerDeq &vContainerDeq,
     }
 }
 
+template <typename T>
+void
+BinaryReader::unpackVector(ValueContainerDeq &vContainerDeq,
+                           SceneObject &sceneObject,
+                           bool transientEncoding,
+                           int attributeId,
+                           std::string &attributeName,
+                           AttributeTimestep timestep,
+                           const DeltaReference& reference,
+                           const std::shared_ptr<const void>& owner) const
+{
+    if (reference.mIsDelta) {
+        unpackVectorDelta<T>(vContainerDeq, sceneObject, transientEncoding, attributeId, attributeName,
+                             timestep, reference);
+        return;
+    }
+
+    // The key is only looked up once the value has been dequeued, so an
+    // unknown or mistyped attribute leaves the rest of the record readable.
+    const SceneClass& sceneClass = sceneObject.getSceneClass();
+    if (!owner) {
+        T vec; vContainerDeq.deqVector(vec);
+        sceneObject.set(keyGen<T>(transientEncoding, attributeId, attributeName, sceneClass), vec, timestep);
+        return;
+    }
+
+    size_t size;
+    const void *data = vContainerDeq.skipVector<T>(size);
+    AttributeKey<T> key = keyGen<T>(transientEncoding, attributeId, attributeName, sceneClass);
+    if (size * sizeof(typename T::value_type) >= sLazyAttributeMinSize) {
+        sceneObject.setLazy(key, data, size, timestep, owner);
+    } else {
+        T vec;
+        LazyAttributeTable::decodeVector<T>(&vec, data, size);
+        sceneObject.set(key, vec, timestep);
+    }
+}
+
+template <typename T>
+void
+BinaryReader::unpackVectorDelta(ValueContainerDeq &vContainerDeq,
+                                SceneObject &sceneObject,
+                                bool transientEncoding,
+                                int attributeId,
+                                std::string &attributeName,
+                                AttributeTimestep timestep,
+                                const DeltaReference& reference) const
+{
+    typedef typename T::value_type Element;
+
+    size_t size, count;
+    vContainerDeq.deqVLSizeT(size);
+    vContainerDeq.deqVLSizeT(count);
+
+    // Every element takes at least a one byte gap and its value, so a count
+    // the rest of the record can't hold means the delta was cut off.
+    const size_t restSize = vContainerDeq.getRestSize();
+    if (count > restSize / (1 + sizeof(Element))) {
+        throw except::FormatError(util::buildString("SceneObject '", sceneObject.getName(),
+            "' has a truncated vector delta (", count, " elements in ", restSize, " bytes)."));
+    }
+
+    // Dequeue the whole delta before looking anything up, so the stream
+    // stays in step whatever goes wrong below.
+    std::vector<std::pair<size_t, Element>> elements(count);
+    bool inRange = true;
+    size_t index = 0;
+    for (auto& element : elements) {
+        size_t gap;
+        vContainerDeq.deqVLSizeT(gap);
+        inRange = inRange && gap < size - index;
+        index += gap;
+        element.first = index;
+        vContainerDeq.deq(element.second);
+    }
+    if (!inRange) {
+        throw except::FormatError(util::buildString("SceneObject '", sceneObject.getName(),
+            "' has a vector delta with an element past its length of ", size, "."));
+    }
+
+    const SceneClass& sceneClass = sceneObject.getSceneClass();
+    const Attribute* referenceAttr = nullptr;
+    if (transientEncoding) {
+        if (reference.mId < 0 || static_cast<size_t>(reference.mId) >= sceneClass.mAttributes.size()) {
+            throw except::KeyError(util::buildString("SceneClass '", sceneClass.getName(),
+                "' has no attribute with index ", reference.mId, " to apply a vector delta to."));
+        }
+        referenceAttr = sceneClass.mAttributes[reference.mId];
+    } else {
+        referenceAttr = sceneClass.getAttribute(reference.mName);
+    }
+
+    // Both keys throw except::TypeError if the attribute isn't a T.
+    AttributeKey<T> key = keyGen<T>(transientEncoding, attributeId, attributeName, sceneClass);
+    T vec = sceneObject.get(AttributeKey<T>(*referenceAttr));
+    if (vec.size() != size) {
+        throw except::TypeError(util::buildString("Attribute '",
+            sceneClass.getAttribute(key)->getName(), "' of SceneObject '",
+            sceneObject.getName(), "' is a delta against '", referenceAttr->getName(),
+            "', which has the wrong length."));
+    }
+
+    for (const auto& element : elements) {
+        vec[element.first] = element.second;
+    }
+    sceneObject.set(key, vec, timestep);
+}
+
 void
 BinaryReader::unpackLayerValue(ValueContainerDeq &vContainerDeq,
                                BinaryReaderLayerUnpackStrings &layerStrVectors,
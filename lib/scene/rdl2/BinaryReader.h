@@ -94,12 +94,15 @@ public:
  */
 class BinaryReader
 {
+    friend class BinaryStreamReader;
+
 public:
     enum RecordType
     {
         UNKNOWN = 0,
         SCENE_OBJECT = 1,
-        SCENE_OBJECT_2 = 2
+        SCENE_OBJECT_2 = 2,
+        SCENE_OBJECT_2_COMPRESSED = 3
     };
 
     /**
@@ -119,6 +122,12 @@ public:
      * as a stream of RDL binary. You can use BinaryWriter's toFile() method
      * to write these files.
      *
+     * When memory mapped file reading is enabled (the default), the file is
+     * mapped read-only and the manifest and payload are decoded directly out
+     * of the mapping without being copied into intermediate buffers. If the
+     * file cannot be mapped, this falls back to reading it through an input
+     * stream.
+     *
      * @param   filename    The path to the RDL binary file on the filesystem.
      */
     void fromFile(const std::string& filename);
@@ -153,6 +162,51 @@ public:
      */
     finline void setWarningsAsErrors(bool warningsAsErrors);
 
+    /**
+     * Controls whether fromFile() memory maps the file instead of reading the
+     * manifest and payload into byte strings. Mapping avoids holding a second
+     * copy of the whole file in memory while it is decoded, which matters for
+     * very large RDL binary files. Enabled by default.
+     *
+     * @param   memoryMapped    True to memory map files in fromFile(), false
+     *                          to read them through an input stream.
+     */
+    finline void setMemoryMappedFile(bool memoryMapped);
+
+    /**
+     * Turns on parallel decoding of SceneObject records. The SceneObjects of
+     * all records are created serially in manifest order, then the attribute
+     * values and bindings of each record are unpacked concurrently in the TBB
+     * thread pool. If the same SceneObject appears in more than one record,
+     * the records are decoded serially instead so they are applied in order.
+     *
+     * @param   parallelDecoding    True to enable parallel decoding, false to
+     *                              disable it. (Disabled by default.)
+     */
+    finline void setParallelDecoding(bool parallelDecoding);
+
+    /**
+     * Turns on lazy decoding of large vector attributes. Float, double, Rgb,
+     * Rgba, Vec and Mat vector values of at least sLazyAttributeMinSize bytes
+     * are not copied into attribute storage while reading. The SceneObject
+     * remembers where the value is in the source bytes instead, and decodes
+     * it the first time the attribute is accessed, so objects which are
+     * never looked at cost neither the copy nor the memory.
+     *
+     * The source bytes (the memory mapped file, the payload, or a
+     * decompressed record) are kept alive until every deferred value which
+     * refers to them has been decoded. fromBytes() has to take a copy of the
+     * payload for this, since the caller owns it. Lazy decoding does not apply
+     * to records decoded through BinaryStreamReader.
+     *
+     * @param   lazyAttributes  True to defer decoding of large vector
+     *                          attributes. (Disabled by default.)
+     */
+    finline void setLazyAttributes(bool lazyAttributes);
+
+    // Vector values smaller than this are always decoded right away.
+    static constexpr std::size_t sLazyAttributeMinSize = 4096;
+
     // for debug 
     static std::string showManifest(const std::string& manifest);
 
@@ -170,11 +224,39 @@ private:
     };
     typedef std::vector<RecordInfo> RecordInfoVector;
 
+    // Helper function to memory map a framed RDL binary file and decode it.
+    // Returns false if the file could not be mapped, in which case nothing
+    // has been decoded and the caller should fall back to stream reading.
+    bool fromMappedFile(const std::string& filename);
+
+    // Helper function to decode the records of a manifest and payload which
+    // have already been unframed. If owner is set, it keeps the payload bytes
+    // alive and large vector values may be left in them for lazy decoding.
+    void fromSlices(Slice manifestBytes, Slice payloadBytes,
+                    const std::shared_ptr<const void>& owner);
+
     // Helper function to decode the manifest and compute message offsets.
     void readManifest(Slice bytes, RecordInfoVector& info);
 
     // Helper function for reading SceneObject messages out of the payload.
-    void readSceneObject(Slice bytes);
+    void readSceneObject(Slice bytes, const std::shared_ptr<const void>& owner);
+
+    // Helper function for reading a single record of the given type.
+    void readRecord(RecordType type, Slice bytes, const std::shared_ptr<const void>& owner);
+
+    // Helper function which decodes every record serially, in manifest order.
+    void readRecordsSerial(Slice payloadBytes, const RecordInfoVector& records,
+                           const std::shared_ptr<const void>& owner);
+
+    // Helper function which creates the SceneObjects of all records serially
+    // and then unpacks their payloads in parallel.
+    void readRecordsParallel(Slice payloadBytes, const RecordInfoVector& records,
+                             const std::shared_ptr<const void>& owner);
+
+    // Helper function for creating (or finding) the SceneObject named at the
+    // front of a SceneObject message. Returns nullptr if the object could not
+    // be created and the error was downgraded to a warning.
+    SceneObject* readSceneObjectHeader(ValueContainerDeq& vContainerDeq);
 
     // Helper function for unpacking a Layer object one assignment
     // at a time
@@ -182,13 +264,48 @@ private:
 
     // Helper function for unpacking a SceneObject ValueContainer into an RDL
     // SceneObject.
-    void unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& sceneObject) const;
+    void unpackSceneObject(ValueContainerDeq &vContainerDeq, SceneObject& sceneObject,
+                           const std::shared_ptr<const void>& owner) const;
 
     // Helper function for unpacking a core (non-vector) attribute value into
     // a SceneObject.
     void unpackValue(ValueContainerDeq &vContainerDeq, SceneObject &sceneObject,
                      ValueContainerUtil::ValueType valueType,
-                     bool transientEncoding, int attributeId, std::string &attributeName) const;
+                     bool transientEncoding, int attributeId, std::string &attributeName,
+                     const std::shared_ptr<const void>& owner) const;
+
+    // The attribute a vector written as a sparse delta was encoded against,
+    // as read from the record: its index under transient encoding, its name
+    // otherwise. It is only resolved once the whole delta has been dequeued.
+    struct DeltaReference
+    {
+        bool mIsDelta = false;
+        int mId = -1;
+        std::string mName;
+    };
+
+    // Helper function for unpacking a vector of trivially copyable elements.
+    // Defers large values to the SceneObject when owner is set. If reference
+    // is a delta the value is a sparse delta against that attribute. The
+    // value is dequeued before the attribute is looked up, so it is consumed
+    // even if the lookup throws.
+    template <typename T>
+    void unpackVector(ValueContainerDeq &vContainerDeq, SceneObject &sceneObject,
+                      bool transientEncoding, int attributeId, std::string &attributeName,
+                      AttributeTimestep timestep, const DeltaReference& reference,
+                      const std::shared_ptr<const void>& owner) const;
+
+    // Helper function for unpacking a vector written as the elements which
+    // differ from the reference attribute (see
+    // BinaryWriter::setVectorDeltaEncoding()). The whole delta is dequeued
+    // before anything is looked up. Throws except::KeyError if either
+    // attribute doesn't exist, except::TypeError if the reference has a
+    // different type or length, or except::FormatError if the delta was cut
+    // off or indexes past the end of the vector.
+    template <typename T>
+    void unpackVectorDelta(ValueContainerDeq &vContainerDeq, SceneObject &sceneObject,
+                           bool transientEncoding, int attributeId, std::string &attributeName,
+                           AttributeTimestep timestep, const DeltaReference& reference) const;
     void unpackLayerValue(ValueContainerDeq &vContainerDeq, BinaryReaderLayerUnpackStrings &layerStrVectors,
                           ValueContainerUtil::ValueType valueType, const std::string &attrName) const;
 
@@ -202,6 +319,19 @@ private:
     SceneContext& mContext;
 
     bool mWarningsAsErrors;
+
+    // True if fromFile() should memory map the file.
+    bool mMemoryMappedFile;
+
+    // True if SceneObject records should be unpacked in parallel.
+    bool mParallelDecoding;
+
+    // True if large vector attributes should be decoded on first access.
+    bool mLazyAttributes;
+
+    // Set in the timestep of a value written as a sparse delta. Matches the
+    // BinaryWriter.
+    static constexpr unsigned char sVectorDeltaFlag = 0x80;
 };
 
 void
@@ -210,6 +340,24 @@ BinaryReader::setWarningsAsErrors(bool warningsAsErrors)
     mWarningsAsErrors = warningsAsErrors;
 }
 
+void
+BinaryReader::setMemoryMappedFile(bool memoryMapped)
+{
+    mMemoryMappedFile = memoryMapped;
+}
+
+void
+BinaryReader::setParallelDecoding(bool parallelDecoding)
+{
+    mParallelDecoding = parallelDecoding;
+}
+
+void
+BinaryReader::setLazyAttributes(bool lazyAttributes)
+{
+    mLazyAttributes = lazyAttributes;
+}
+
 } // namespace rdl2
 } // namespace scene_rdl2
 
@@ -0,0 +1,162 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "BinaryStreamReader.h"
+
+#include "Slice.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <stdint.h>
+
+#ifdef __APPLE__
+#include <libkern/OSByteOrder.h>
+#define be64toh(x) OSSwapBigToHostInt64(x)
+#else
+#include <endian.h>
+#endif
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+namespace {
+
+// Size of the frame header in front of the manifest: mlen and plen.
+constexpr std::size_t sFrameHeaderSize = 2 * sizeof(uint64_t);
+
+} // namespace
+
+BinaryStreamReader::BinaryStreamReader(SceneContext& context) :
+    mReader(context),
+    mState(State::HEADER),
+    mManifestLen(0),
+    mPayloadLen(0),
+    mNextRecord(0)
+{
+}
+
+void
+BinaryStreamReader::reset()
+{
+    mState = State::HEADER;
+    mBuffer.clear();
+    mManifestLen = 0;
+    mPayloadLen = 0;
+    mRecords.clear();
+    mNextRecord = 0;
+}
+
+std::size_t
+BinaryStreamReader::push(const void* data, std::size_t length)
+{
+    const char* bytes = static_cast<const char*>(data);
+    std::size_t consumed = 0;
+
+    while (consumed < length && mState != State::COMPLETE) {
+        const char* ptr = bytes + consumed;
+        const std::size_t remaining = length - consumed;
+
+        switch (mState) {
+        case State::HEADER:
+            consumed += fill(ptr, remaining, sFrameHeaderSize);
+            if (mBuffer.size() == sFrameHeaderSize) {
+                decodeHeader();
+            }
+            break;
+
+        case State::MANIFEST:
+            consumed += fill(ptr, remaining, mManifestLen);
+            if (mBuffer.size() == mManifestLen) {
+                decodeManifest();
+            }
+            break;
+
+        case State::PAYLOAD: {
+            const std::size_t recordSize = mRecords[mNextRecord].mSize;
+            if (mBuffer.empty() && remaining >= recordSize) {
+                // The whole record is in the caller's buffer, so decode it in
+                // place instead of copying it.
+                applyRecord(Slice(ptr, recordSize));
+                consumed += recordSize;
+            } else {
+                consumed += fill(ptr, remaining, recordSize);
+                if (mBuffer.size() == recordSize) {
+                    applyRecord(Slice(mBuffer));
+                    mBuffer.clear();
+                }
+            }
+        } break;
+
+        case State::COMPLETE:
+            break;
+        }
+    }
+
+    return consumed;
+}
+
+std::size_t
+BinaryStreamReader::fill(const char* data, std::size_t length, std::size_t needed)
+{
+    const std::size_t amount = std::min(length, needed - mBuffer.size());
+    mBuffer.append(data, amount);
+    return amount;
+}
+
+void
+BinaryStreamReader::decodeHeader()
+{
+    // Convert mlen and plen to native byte order.
+    Slice header(mBuffer);
+    Slice(header, 0, sizeof(uint64_t)).copyTo(&mManifestLen, sizeof(uint64_t));
+    Slice(header, sizeof(uint64_t), sizeof(uint64_t)).copyTo(&mPayloadLen, sizeof(uint64_t));
+    mManifestLen = be64toh(mManifestLen);
+    mPayloadLen = be64toh(mPayloadLen);
+    mBuffer.clear();
+
+    if (mManifestLen == 0) {
+        throw except::FormatError("RDL2 binary frame has an empty manifest.");
+    }
+    mState = State::MANIFEST;
+}
+
+void
+BinaryStreamReader::decodeManifest()
+{
+    mReader.readManifest(Slice(mBuffer), mRecords);
+    mBuffer.clear();
+
+    // The record sizes have to add up to plen, otherwise we'd either stop
+    // early or swallow bytes belonging to whatever follows this frame.
+    uint64_t recordTotal = 0;
+    for (const auto& record : mRecords) {
+        recordTotal += record.mSize;
+    }
+    if (recordTotal != mPayloadLen) {
+        std::stringstream errMsg;
+        errMsg << "RDL2 binary manifest records add up to " << recordTotal <<
+            " bytes, but the frame payload is " << mPayloadLen << " bytes.";
+        throw except::FormatError(errMsg.str());
+    }
+
+    mNextRecord = 0;
+    mState = mRecords.empty() ? State::COMPLETE : State::PAYLOAD;
+}
+
+void
+BinaryStreamReader::applyRecord(Slice bytes)
+{
+    // The bytes don't outlive this call, so nothing is decoded lazily.
+    mReader.readRecord(mRecords[mNextRecord].mType, bytes, nullptr);
+    if (++mNextRecord == mRecords.size()) {
+        mState = State::COMPLETE;
+    }
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,173 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include "BinaryReader.h"
+#include "Types.h"
+
+#include <cstddef>
+#include <string>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * A BinaryStreamReader decodes a single framed RDL binary message (see
+ * BinaryReader for the frame layout) which arrives in arbitrarily sized
+ * pieces, such as reads from a network socket. Bytes are pushed into the
+ * reader as they arrive and every SceneObject record is applied to the
+ * SceneContext as soon as all of its bytes are present, so work on early
+ * objects can start while the rest of a large update is still in flight.
+ *
+ * Only the bytes of the section currently being assembled (the frame header,
+ * the manifest, or one partially received record) are buffered. Records
+ * which arrive whole inside a single push() are decoded straight out of the
+ * caller's buffer without being copied.
+ *
+ * Once a frame is complete, push() stops consuming bytes. Any bytes past the
+ * end of the frame are left to the caller, who can reset() the reader and
+ * push them again to decode the next frame.
+ *
+ * Thread Safety:
+ *  - The same rules as BinaryReader apply. Records are applied in the thread
+ *      which calls push(), and it is not safe to be mucking about with the
+ *      SceneContext in another thread while push() is working.
+ */
+class BinaryStreamReader
+{
+public:
+    /**
+     * Constructs a BinaryStreamReader that will decode RDL binary into the
+     * given SceneContext.
+     *
+     * @param   context     The SceneContext where updates will be made.
+     */
+    explicit BinaryStreamReader(SceneContext& context);
+
+    /**
+     * Feeds the next piece of framed RDL binary into the reader. Every record
+     * completed by these bytes is decoded and applied to the SceneContext
+     * before this returns.
+     *
+     * @param   data    Pointer to the received bytes.
+     * @param   length  Number of received bytes.
+     * @return  The number of bytes consumed. This is less than length only
+     *          when the frame was completed part way through the data.
+     */
+    std::size_t push(const void* data, std::size_t length);
+
+    /**
+     * Convenience wrapper around push() for byte strings.
+     */
+    finline std::size_t push(const std::string& bytes);
+
+    /**
+     * Returns true once the whole frame has been received and applied.
+     */
+    finline bool isComplete() const;
+
+    /**
+     * Returns true once the manifest has been received and decoded, at which
+     * point getRecordCount() is valid.
+     */
+    finline bool hasManifest() const;
+
+    /**
+     * Returns the number of records in the frame's manifest, or zero if the
+     * manifest has not been received yet.
+     */
+    finline std::size_t getRecordCount() const;
+
+    /**
+     * Returns the number of records which have been applied to the
+     * SceneContext so far.
+     */
+    finline std::size_t getRecordsApplied() const;
+
+    /**
+     * Discards any partially received frame and prepares the reader for a
+     * new one. Records which were already applied stay applied.
+     */
+    void reset();
+
+    /**
+     * Same as BinaryReader::setWarningsAsErrors().
+     *
+     * @param   warningsAsErrors    Causes questionable actions to cause an
+     *                              error instead of logging a warning.
+     */
+    finline void setWarningsAsErrors(bool warningsAsErrors);
+
+private:
+    enum class State
+    {
+        HEADER,
+        MANIFEST,
+        PAYLOAD,
+        COMPLETE
+    };
+
+    // Appends up to "needed" bytes (minus what's already buffered) from data
+    // to mBuffer. Returns the number of bytes taken.
+    std::size_t fill(const char* data, std::size_t length, std::size_t needed);
+
+    void decodeHeader();
+    void decodeManifest();
+    void applyRecord(Slice bytes);
+
+    // Does the actual decoding into the SceneContext.
+    BinaryReader mReader;
+
+    State mState;
+
+    // Bytes of the frame section currently being assembled.
+    std::string mBuffer;
+
+    uint64_t mManifestLen;
+    uint64_t mPayloadLen;
+
+    BinaryReader::RecordInfoVector mRecords;
+    std::size_t mNextRecord;
+};
+
+std::size_t
+BinaryStreamReader::push(const std::string& bytes)
+{
+    return push(bytes.data(), bytes.size());
+}
+
+bool
+BinaryStreamReader::isComplete() const
+{
+    return mState == State::COMPLETE;
+}
+
+bool
+BinaryStreamReader::hasManifest() const
+{
+    return mState == State::PAYLOAD || mState == State::COMPLETE;
+}
+
+std::size_t
+BinaryStreamReader::getRecordCount() const
+{
+    return mRecords.size();
+}
+
+std::size_t
+BinaryStreamReader::getRecordsApplied() const
+{
+    return mNextRecord;
+}
+
+void
+BinaryStreamReader::setWarningsAsErrors(bool warningsAsErrors)
+{
+    mReader.setWarningsAsErrors(warningsAsErrors);
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
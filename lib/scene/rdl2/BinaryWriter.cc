@@ -7,6 +7,8 @@
 #include "Attribute.h"
 #include "SceneClass.h"
 #include "SceneContext.h"
+#include "SceneContextSnapshot.h"
+#include "RecordCompression.h"
 #include "SceneObject.h"
 #include "Types.h"
 #include "ValueContainerEnq.h"
@@ -14,11 +16,18 @@
 
 #include <scene_rdl2/common/except/exceptions.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <stdint.h>
 
 #ifdef __APPLE__
@@ -49,11 +58,29 @@ isSkippedInSplitMode(const SceneObject& so)
 
 BinaryWriter::BinaryWriter(const SceneContext& context) :
     mContext(context),
+    mSnapshot(nullptr),
     mTransientEncoding(false),
     mDeltaEncoding(false),
     mSkipDefaults(false),
     mLargeVectorsOnly(false),
-    mMinVectorSize(0)
+    mMinVectorSize(0),
+    mParallelEncoding(false),
+    mCompression(false),
+    mVectorDeltaEncoding(false)
+{
+}
+
+BinaryWriter::BinaryWriter(const SceneContextSnapshot& snapshot) :
+    mContext(snapshot.getSceneContext()),
+    mSnapshot(&snapshot),
+    mTransientEncoding(false),
+    mDeltaEncoding(false),
+    mSkipDefaults(false),
+    mLargeVectorsOnly(false),
+    mMinVectorSize(0),
+    mParallelEncoding(false),
+    mCompression(false),
+    mVectorDeltaEncoding(false)
 {
 }
 
@@ -95,24 +122,97 @@ BinaryWriter::toStream(std::ostream& output) const
 void
 BinaryWriter::toBytes(std::string& manifest, std::string& payload) const
 {
+    std::vector<const SceneObject*> sceneObjects;
+    gatherSceneObjects(sceneObjects);
+
     RecordInfoVector records;
+    records.reserve(sceneObjects.size());
+    if (mParallelEncoding && sceneObjects.size() > 1) {
+        writeSceneObjectsParallel(sceneObjects, records, payload);
+    } else {
+        writeSceneObjectsSerial(sceneObjects, records, payload);
+    }
+
+    // Write the manifest once the payload is finished.
+    writeManifest(records, manifest);
+}
+
+void
+BinaryWriter::gatherSceneObjects(std::vector<const SceneObject*>& sceneObjects) const
+{
+    // A snapshot holds frozen copies of the objects, in SceneContext
+    // iteration order.
+    if (mSnapshot) {
+        for (const SceneObject* sceneObject : mSnapshot->getSceneObjects()) {
+            if (mDeltaEncoding && !sceneObject->mDirty) {
+                continue;
+            }
+            sceneObjects.push_back(sceneObject);
+        }
+        return;
+    }
 
-    // Step over each SceneObject.
-    std::ptrdiff_t offset = 0;
     for (SceneContext::SceneObjectConstIterator iter = mContext.beginSceneObject();
             iter != mContext.endSceneObject(); ++iter) {
         if (mDeltaEncoding && !iter->second->mDirty) {
             // If delta encoding, skip objects that aren't dirty.
             continue;
         }
+        sceneObjects.push_back(iter->second);
+    }
+}
 
-        std::size_t size = writeSceneObject(*(iter->second), payload);
-        records.emplace_back(SCENE_OBJECT_2, offset, size);
+void
+BinaryWriter::writeSceneObjectsSerial(const std::vector<const SceneObject*>& sceneObjects,
+                                      RecordInfoVector& records, std::string& bytes) const
+{
+    std::ptrdiff_t offset = 0;
+    for (const SceneObject* sceneObject : sceneObjects) {
+        RecordType type;
+        std::size_t size = writeRecord(*sceneObject, bytes, type);
+        records.emplace_back(type, offset, size);
         offset += size;
     }
+}
 
-    // Write the manifest once the payload is finished.
-    writeManifest(records, manifest);
+void
+BinaryWriter::writeSceneObjectsParallel(const std::vector<const SceneObject*>& sceneObjects,
+                                        RecordInfoVector& records, std::string& bytes) const
+{
+    // Split the objects into a few more chunks than there are threads, so a
+    // chunk full of heavy geometry does not hold up the whole encode.
+    const std::size_t numObjects = sceneObjects.size();
+    const std::size_t numChunks =
+        std::min(numObjects, static_cast<std::size_t>(tbb::this_task_arena::max_concurrency()) * 4);
+    const std::size_t chunkSize = (numObjects + numChunks - 1) / numChunks;
+
+    std::vector<std::string> chunkBytes(numChunks);
+    std::vector<std::size_t> recordSizes(numObjects);
+    std::vector<RecordType> recordTypes(numObjects);
+
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, numChunks, 1),
+                      [&](const tbb::blocked_range<std::size_t>& range) {
+        for (std::size_t chunk = range.begin(); chunk != range.end(); ++chunk) {
+            const std::size_t begin = chunk * chunkSize;
+            const std::size_t end = std::min(begin + chunkSize, numObjects);
+            for (std::size_t i = begin; i < end; ++i) {
+                recordSizes[i] = writeRecord(*sceneObjects[i], chunkBytes[chunk], recordTypes[i]);
+            }
+        }
+    });
+
+    // Lay the records out back to back, in the same order as a serial encode.
+    std::ptrdiff_t offset = 0;
+    for (std::size_t i = 0; i < numObjects; ++i) {
+        records.emplace_back(recordTypes[i], offset, recordSizes[i]);
+        offset += recordSizes[i];
+    }
+
+    bytes.reserve(bytes.size() + offset);
+    for (std::string& chunk : chunkBytes) {
+        bytes.append(chunk);
+        std::string().swap(chunk); // release the chunk as soon as it's copied
+    }
 }
 
 std::string
@@ -125,8 +225,14 @@ BinaryWriter::show(const std::string &hd, const bool sort) const
 //
 {
     std::vector<std::string> work;
-    for (SceneContext::SceneObjectConstIterator iter = mContext.beginSceneObject(); iter != mContext.endSceneObject(); ++iter) {
-        work.emplace_back(showSceneObject(*(iter->second), hd + "  ", sort));
+    if (mSnapshot) {
+        for (const SceneObject* sceneObject : mSnapshot->getSceneObjects()) {
+            work.emplace_back(showSceneObject(*sceneObject, hd + "  ", sort));
+        }
+    } else {
+        for (SceneContext::SceneObjectConstIterator iter = mContext.beginSceneObject(); iter != mContext.endSceneObject(); ++iter) {
+            work.emplace_back(showSceneObject(*(iter->second), hd + "  ", sort));
+        }
     }
     if (sort) std::sort(work.begin(), work.end());
 
@@ -156,6 +262,25 @@ BinaryWriter::writeManifest(const RecordInfoVector& info, std::string& bytes) co
     vContainerEnq.finalize();
 }
 
+std::size_t
+BinaryWriter::writeRecord(const SceneObject& sceneObject, std::string& bytes, RecordType& type) const
+{
+    const std::size_t start = bytes.size();
+    std::size_t size = writeSceneObject(sceneObject, bytes);
+    type = SCENE_OBJECT_2;
+
+    if (mCompression && size >= RecordCompression::sMinRecordSize) {
+        std::string compressed;
+        if (RecordCompression::compress(bytes.data() + start, size, compressed)) {
+            bytes.resize(start);
+            bytes.append(compressed);
+            size = compressed.size();
+            type = SCENE_OBJECT_2_COMPRESSED;
+        }
+    }
+    return size;
+}
+
 std::size_t
 BinaryWriter::writeSceneObject(const SceneObject& sceneObject, std::string& bytes) const
 {
@@ -173,6 +298,15 @@ BinaryWriter::packSceneObject(const SceneObject& sceneObject, ValueContainerEnq
 {
     const SceneClass& sceneClass = sceneObject.getSceneClass();
 
+    // The index of the last attribute of each type written to this record,
+    // which vectors are delta encoded against. Layers are unpacked by their
+    // own code, which doesn't know about deltas.
+    const bool vectorDeltas = mVectorDeltaEncoding && !sceneObject.isA<Layer>();
+    std::vector<int> lastWritten;
+    if (vectorDeltas) {
+        lastWritten.assign(TYPE_SCENE_OBJECT_INDEXABLE + 1, -1);
+    }
+
     // Step over each attribute.
     for (size_t i = 0; i < sceneClass.mAttributes.size(); ++i) {
         const Attribute* attribute = sceneClass.mAttributes[i];
@@ -215,6 +349,17 @@ BinaryWriter::packSceneObject(const SceneObject& sceneObject, ValueContainerEnq
             vContainerEnq.enqUChar(static_cast<unsigned char>(n));
         }
 
+        // Vectors are never blurrable, so a delta stands in for the single
+        // TIMESTEP_BEGIN value.
+        if (vectorDeltas) {
+            const int reference = lastWritten[attribute->getType()];
+            lastWritten[attribute->getType()] = static_cast<int>(i);
+            if (reference >= 0 &&
+                packVectorDelta(sceneObject, attribute, reference, vContainerEnq)) {
+                continue;
+            }
+        }
+
         // Set the value for each relevant timestep.
         int timestep = TIMESTEP_BEGIN;
         do {
@@ -423,6 +568,85 @@ BinaryWriter::packValue(const SceneObject& sObj, const Attribute* attr, int time
     }
 }
 
+bool
+BinaryWriter::packVectorDelta(const SceneObject& sObj, const Attribute* attr, std::size_t referenceIndex,
+                              ValueContainerEnq &vContainerEnq) const
+{
+    switch (attr->getType()) {
+    case TYPE_FLOAT_VECTOR:
+        return packVectorDelta<FloatVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_DOUBLE_VECTOR:
+        return packVectorDelta<DoubleVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_RGB_VECTOR:
+        return packVectorDelta<RgbVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_RGBA_VECTOR:
+        return packVectorDelta<RgbaVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC2F_VECTOR:
+        return packVectorDelta<Vec2fVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC2D_VECTOR:
+        return packVectorDelta<Vec2dVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC3F_VECTOR:
+        return packVectorDelta<Vec3fVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC3D_VECTOR:
+        return packVectorDelta<Vec3dVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC4F_VECTOR:
+        return packVectorDelta<Vec4fVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_VEC4D_VECTOR:
+        return packVectorDelta<Vec4dVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_MAT4F_VECTOR:
+        return packVectorDelta<Mat4fVector>(sObj, attr, referenceIndex, vContainerEnq);
+    case TYPE_MAT4D_VECTOR:
+        return packVectorDelta<Mat4dVector>(sObj, attr, referenceIndex, vContainerEnq);
+    default:
+        return false;
+    }
+}
+
+template <typename T>
+bool
+BinaryWriter::packVectorDelta(const SceneObject& sObj, const Attribute* attr, std::size_t referenceIndex,
+                              ValueContainerEnq &vContainerEnq) const
+{
+    typedef typename T::value_type Element;
+
+    const Attribute* reference = sObj.getSceneClass().mAttributes[referenceIndex];
+    const T& vec = sObj.get(AttributeKey<T>(*attr));
+    const T& base = sObj.get(AttributeKey<T>(*reference));
+    if (vec.size() < sVectorDeltaMinSize || vec.size() != base.size()) {
+        return false;
+    }
+
+    // Compare bitwise, so NaNs and signed zeros survive the round trip.
+    std::vector<std::size_t> changed;
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        if (std::memcmp(&vec[i], &base[i], sizeof(Element)) != 0) {
+            changed.push_back(i);
+        }
+    }
+
+    // Each changed element costs its value plus its (usually one byte)
+    // distance from the previous one. Only bother if that halves the size.
+    if (changed.size() * (sizeof(Element) + 1) > vec.size() * sizeof(Element) / 2) {
+        return false;
+    }
+
+    vContainerEnq.enqUChar(static_cast<unsigned char>(TIMESTEP_BEGIN | sVectorDeltaFlag));
+    if (mTransientEncoding) {
+        vContainerEnq.enqInt(static_cast<int>(referenceIndex));
+    } else {
+        vContainerEnq.enqString(reference->getName());
+    }
+    vContainerEnq.enqVLSizeT(vec.size());
+    vContainerEnq.enqVLSizeT(changed.size());
+    std::size_t previous = 0;
+    for (std::size_t i : changed) {
+        vContainerEnq.enqVLSizeT(i - previous);
+        vContainerEnq.enq<Element>(vec[i]);
+        previous = i;
+    }
+    return true;
+}
+
 std::string
 BinaryWriter::showSceneObject(const SceneObject &sceneObject, const std::string &hd, const bool sort) const
 {
@@ -18,6 +18,7 @@
 namespace scene_rdl2 {
 namespace rdl2 {
 
+class SceneContextSnapshot;
 class ValueContainerEnq;
 
 /**
@@ -54,6 +55,8 @@ class ValueContainerEnq;
  *  - Since the BinaryWriter reads SceneContext data (in particular,
  *      SceneObjects), it is not safe to be writing to SceneObjects in another
  *      thread while the BinaryWriter is working.
+ *  - A BinaryWriter constructed from a SceneContextSnapshot only reads the
+ *      snapshot, so the live SceneObjects may be written to meanwhile.
  *
  * Scene contexts can be written in "rdlsplit" mode, where non-vectors and small vectors
  * are placed in an rdla file, and large vectors are placed in a parallel rdlb file.
@@ -67,7 +70,8 @@ public:
     {
         UNKNOWN = 0,
         SCENE_OBJECT = 1,       // protbuf version
-        SCENE_OBJECT_2 = 2      // value container version
+        SCENE_OBJECT_2 = 2,     // value container version
+        SCENE_OBJECT_2_COMPRESSED = 3 // value container version, RecordCompression applied
     };
 
     /**
@@ -78,6 +82,18 @@ public:
      */
     BinaryWriter(const SceneContext& context);
 
+    /**
+     * Constructs a BinaryWriter that will encode the SceneObjects of the
+     * given snapshot into RDL binary. Unlike a SceneContext, a snapshot can
+     * be encoded while its live objects are being written to in another
+     * thread. With delta encoding, only the objects which were dirty when the
+     * snapshot was taken are written.
+     *
+     * @param   snapshot    The SceneContextSnapshot you want to encode. It
+     *                      must outlive the BinaryWriter.
+     */
+    BinaryWriter(const SceneContextSnapshot& snapshot);
+
     /**
      * Turns on optimizations for encoding transient data. This results in
      * minor data compression and improvements in decoding speed. However, the
@@ -129,6 +145,51 @@ public:
     finline void setSplitMode(size_t minVectorSize);
     finline void clearSplitMode();
 
+    /**
+     * Turns on parallel encoding of SceneObject records. The SceneObjects to
+     * write are split into contiguous chunks which are serialized
+     * concurrently in the TBB thread pool, each into its own buffer. The
+     * buffers are then concatenated in order, so the output is byte for byte
+     * identical to serial encoding.
+     *
+     * @param   parallelEncoding    True to enable parallel encoding, false to
+     *                              disable it. (Disabled by default.)
+     */
+    finline void setParallelEncoding(bool parallelEncoding);
+
+    /**
+     * Turns on compression of SceneObject records with RecordCompression.
+     * Each record is compressed on its own, so records can still be decoded
+     * individually (in parallel, or incrementally as they arrive). Small
+     * records, and records which don't get any smaller, are stored raw.
+     *
+     * Compressed records can only be read by a BinaryReader which knows the
+     * SCENE_OBJECT_2_COMPRESSED record type.
+     *
+     * @param   compression     True to enable record compression, false to
+     *                          disable it. (Disabled by default.)
+     */
+    finline void setCompression(bool compression);
+
+    /**
+     * Turns on sparse delta encoding of vector attributes. Motion blurred
+     * point data (e.g. the vertex lists of the two motion keys of a
+     * deforming mesh) is declared as pairs of vector attributes of the same
+     * type, and often most of the elements don't move between them. With
+     * this on, a Float, Double, Rgb, Rgba, Vec or Mat vector attribute which
+     * has the same length as the closest preceding attribute of the same type
+     * written in the record is written as only the elements which differ
+     * from it, when that saves at least half the bytes. Elements are compared
+     * bitwise, so the encoding is lossless.
+     *
+     * Sparse deltas can only be read by a BinaryReader which knows about
+     * them.
+     *
+     * @param   vectorDeltaEncoding     True to enable sparse delta encoding
+     *                                  of vectors. (Disabled by default.)
+     */
+    finline void setVectorDeltaEncoding(bool vectorDeltaEncoding);
+
     /**
      * Opens the file with the given filename and attempts to write the RDL
      * binary to it. You can use the BinaryReader's fromFile() method to read
@@ -180,9 +241,23 @@ private:
     };
     typedef std::vector<RecordInfo> RecordInfoVector;
 
+    // Collects the SceneObjects to write, in SceneContext iteration order.
+    void gatherSceneObjects(std::vector<const SceneObject*>& sceneObjects) const;
+
     // Helper function to encode the manifest.
     void writeManifest(const RecordInfoVector& info, std::string& bytes) const;
 
+    // Helper functions for writing the records of the given SceneObjects out
+    // to the payload, either one after another or in parallel chunks.
+    void writeSceneObjectsSerial(const std::vector<const SceneObject*>& sceneObjects,
+                                 RecordInfoVector& records, std::string& bytes) const;
+    void writeSceneObjectsParallel(const std::vector<const SceneObject*>& sceneObjects,
+                                   RecordInfoVector& records, std::string& bytes) const;
+
+    // Helper function for writing a SceneObject record out to the payload,
+    // compressing it if enabled. Returns the record size and type.
+    std::size_t writeRecord(const SceneObject& sceneObject, std::string& bytes, RecordType& type) const;
+
     // Helper function for writing SceneObject messages out to the payload.
     std::size_t writeSceneObject(const SceneObject& sceneObject, std::string& bytes) const;
 
@@ -194,6 +269,16 @@ private:
     // Helper function for packing attribute values.
     void packValue(const SceneObject& sObj, const Attribute* attr, int timeStep, ValueContainerEnq &vContainer) const;
 
+    // Helper functions for packing a vector attribute value as a sparse delta
+    // against the attribute with the given index, written earlier in the same
+    // record. Return false, having packed nothing, if the delta wouldn't save
+    // enough to be worth it.
+    bool packVectorDelta(const SceneObject& sObj, const Attribute* attr, std::size_t referenceIndex,
+                         ValueContainerEnq &vContainer) const;
+    template <typename T>
+    bool packVectorDelta(const SceneObject& sObj, const Attribute* attr, std::size_t referenceIndex,
+                         ValueContainerEnq &vContainer) const;
+
     // for debug show logic
     std::string showSceneObject(const SceneObject &sceneObject, const std::string &hd, const bool sort) const;
     std::string showSceneObjectAttributes(const SceneObject &sceneObject, const std::string &hd, const bool sort) const;
@@ -220,6 +305,10 @@ private:
     // The SceneContext we're encoding data from.
     const SceneContext& mContext;
 
+    // The snapshot we're encoding data from instead of the live SceneContext
+    // objects, if any.
+    const SceneContextSnapshot* mSnapshot;
+
     // True if the encoded data is transient and we can trade size for resiliency.
     bool mTransientEncoding;
 
@@ -232,6 +321,21 @@ private:
     // Enables writing for "split mode", where only large vectors are written
     bool mLargeVectorsOnly;
     size_t mMinVectorSize;
+
+    // True if SceneObject records should be encoded in parallel.
+    bool mParallelEncoding;
+
+    // True if SceneObject records should be compressed.
+    bool mCompression;
+
+    // True if vector attributes may be written as sparse deltas.
+    bool mVectorDeltaEncoding;
+
+    // Vectors shorter than this are always written in full.
+    static constexpr std::size_t sVectorDeltaMinSize = 64;
+
+    // Set in the timestep of a value written as a sparse delta.
+    static constexpr unsigned char sVectorDeltaFlag = 0x80;
 };
 
 void
@@ -265,6 +369,24 @@ BinaryWriter::clearSplitMode()
     mLargeVectorsOnly = false;
 }
 
+void
+BinaryWriter::setParallelEncoding(bool parallelEncoding)
+{
+    mParallelEncoding = parallelEncoding;
+}
+
+void
+BinaryWriter::setCompression(bool compression)
+{
+    mCompression = compression;
+}
+
+void
+BinaryWriter::setVectorDeltaEncoding(bool vectorDeltaEncoding)
+{
+    mVectorDeltaEncoding = vectorDeltaEncoding;
+}
+
 } // namespace rdl2
 } // namespace scene_rdl2
 
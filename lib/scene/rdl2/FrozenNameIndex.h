@@ -0,0 +1,141 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * A FrozenNameIndex is an immutable name to pointer lookup table, built once
+ * from a snapshot of a container and then only read. It exists to take the
+ * tbb::concurrent_hash_map accessor locks off the hot lookup paths of the
+ * SceneContext (binding resolution, reader lookups, etc.) once a scene has
+ * been loaded.
+ *
+ * The table uses open addressing with linear probing and is kept at most
+ * half full. All names are copied into one contiguous character buffer, and
+ * each slot stores the full hash, so probes rarely have to compare strings
+ * and never chase pointers into the objects themselves.
+ *
+ * Thread Safety:
+ *  - insert() must only be called while building the index, from a single
+ *      thread. After that, find() is safe to call concurrently without any
+ *      locking.
+ */
+template <typename T>
+class FrozenNameIndex
+{
+public:
+    /**
+     * Creates an empty index sized for the given number of names.
+     */
+    explicit FrozenNameIndex(std::size_t expectedSize);
+
+    /**
+     * Adds a name to the index. Names must be unique.
+     */
+    void insert(const std::string& name, T* value);
+
+    /**
+     * Returns the value stored for the given name, or nullptr if the name
+     * was not in the snapshot the index was built from.
+     */
+    T* find(const std::string& name) const;
+
+    /**
+     * Returns the number of names in the index.
+     */
+    std::size_t size() const { return mSize; }
+
+private:
+    struct Slot
+    {
+        uint64_t mHash;
+        uint32_t mOffset;
+        uint32_t mLength;
+        T* mValue; // nullptr for empty slots
+    };
+
+    static uint64_t hash(std::string_view name)
+    {
+        return std::hash<std::string_view>()(name);
+    }
+
+    std::vector<Slot> mSlots;
+    std::size_t mMask;
+    std::size_t mSize;
+    std::string mNames;
+};
+
+template <typename T>
+FrozenNameIndex<T>::FrozenNameIndex(std::size_t expectedSize) :
+    mMask(0),
+    mSize(0)
+{
+    std::size_t capacity = 16;
+    while (capacity < expectedSize * 2) {
+        capacity *= 2;
+    }
+    mSlots.assign(capacity, Slot{0, 0, 0, nullptr});
+    mMask = capacity - 1;
+}
+
+template <typename T>
+void
+FrozenNameIndex<T>::insert(const std::string& name, T* value)
+{
+    if ((mSize + 1) * 2 > mSlots.size()) {
+        // Grow and rehash. Only happens if expectedSize was too small.
+        std::vector<Slot> old;
+        old.swap(mSlots);
+        mSlots.assign(old.size() * 2, Slot{0, 0, 0, nullptr});
+        mMask = mSlots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.mValue) {
+                std::size_t i = slot.mHash & mMask;
+                while (mSlots[i].mValue) {
+                    i = (i + 1) & mMask;
+                }
+                mSlots[i] = slot;
+            }
+        }
+    }
+
+    const uint64_t h = hash(name);
+    std::size_t i = h & mMask;
+    while (mSlots[i].mValue) {
+        i = (i + 1) & mMask;
+    }
+    mSlots[i] = Slot{h, static_cast<uint32_t>(mNames.size()), static_cast<uint32_t>(name.size()), value};
+    mNames.append(name);
+    ++mSize;
+}
+
+template <typename T>
+T*
+FrozenNameIndex<T>::find(const std::string& name) const
+{
+    const uint64_t h = hash(name);
+    for (std::size_t i = h & mMask; mSlots[i].mValue; i = (i + 1) & mMask) {
+        const Slot& slot = mSlots[i];
+        if (slot.mHash == h && slot.mLength == name.size() &&
+            std::memcmp(mNames.data() + slot.mOffset, name.data(), name.size()) == 0) {
+            return slot.mValue;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
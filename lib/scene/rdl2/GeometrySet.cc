@@ -76,7 +76,7 @@ GeometrySet::add(Geometry* geometry)
     // the set() method.
     mAttributeUpdateMask.set(sGeometriesKey.mIndex, true);
     mAttributeSetMask.set(sGeometriesKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 }
 
 void
@@ -104,7 +104,7 @@ GeometrySet::remove(Geometry* geometry)
         // through the set() method.
         mAttributeUpdateMask.set(sGeometriesKey.mIndex, true);
         mAttributeSetMask.set(sGeometriesKey.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -137,7 +137,7 @@ GeometrySet::clear()
     // through the set() method.
     mAttributeUpdateMask.set(sGeometriesKey.mIndex, true);
     mAttributeSetMask.set(sGeometriesKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 }
 
 bool
@@ -19,6 +19,7 @@
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/render/util/Strings.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <sstream>
 #include <string>
@@ -36,6 +37,39 @@ isDeformed(const scene_rdl2::rdl2::Geometry *geom)
     return geom->getProcedural() ? geom->deformed() : false;
 }
 
+typedef std::unordered_map<scene_rdl2::rdl2::SceneObject*, uint32_t> ObjectCountMap;
+
+// Counts one more assignment referencing the object (if not null).
+void
+addReference(ObjectCountMap& counts, scene_rdl2::rdl2::SceneObject* object)
+{
+    if (object) {
+        ++counts[object];
+    }
+}
+
+// Counts one less assignment referencing the object (if not null), forgetting
+// the object once nothing references it.
+void
+removeReference(ObjectCountMap& counts, scene_rdl2::rdl2::SceneObject* object)
+{
+    if (object) {
+        auto iter = counts.find(object);
+        MNRY_ASSERT(iter != counts.end());
+        if (--iter->second == 0) {
+            counts.erase(iter);
+        }
+    }
+}
+
+// Returns the object as the given type, or null for a null object.
+template <typename T>
+T*
+objectAs(scene_rdl2::rdl2::SceneObject* object)
+{
+    return object ? object->asA<T>() : nullptr;
+}
+
 }
 
 namespace scene_rdl2 {
@@ -49,12 +83,141 @@ AttributeKey<SceneObjectVector> Layer::sLightFilterSetsKey;
 AttributeKey<SceneObjectVector> Layer::sShadowSetsKey;
 AttributeKey<SceneObjectVector> Layer::sShadowReceiverSetsKey;
 
+const Layer::AssignmentIdVector Layer::AssignmentIndex::sNoIds;
+
+void
+Layer::AssignmentIndex::insert(SceneObject* object, int32_t assignmentId)
+{
+    if (std::size_t(assignmentId) >= mPositions.size()) {
+        mPositions.resize(assignmentId + 1);
+    }
+    if (object) {
+        AssignmentIdVector& ids = mIds[object];
+        mPositions[assignmentId] = static_cast<uint32_t>(ids.size());
+        ids.push_back(assignmentId);
+    }
+}
+
+void
+Layer::AssignmentIndex::reassign(int32_t assignmentId, SceneObject* from, SceneObject* to)
+{
+    if (from) {
+        // Swap the last ID into the removed one's place so removal doesn't
+        // depend on how many assignments share the object.
+        auto iter = mIds.find(from);
+        MNRY_ASSERT(iter != mIds.end());
+        AssignmentIdVector& ids = iter->second;
+        const uint32_t position = mPositions[assignmentId];
+        const int32_t lastId = ids.back();
+        ids[position] = lastId;
+        mPositions[lastId] = position;
+        ids.pop_back();
+        if (ids.empty()) {
+            mIds.erase(iter);
+        }
+    }
+    insert(to, assignmentId);
+}
+
+void
+Layer::AssignmentIndex::clear()
+{
+    mIds.clear();
+    mPositions.clear();
+}
+
+const Layer::AssignmentIdVector&
+Layer::AssignmentIndex::find(const SceneObject* object) const
+{
+    auto iter = mIds.find(const_cast<SceneObject*>(object));
+    return (iter != mIds.end()) ? iter->second : sNoIds;
+}
+
+std::size_t
+Layer::AssignmentTable::Hash::operator()(const LayerAssignment& layerAssignment) const
+{
+    const void* const pointers[] = {
+        layerAssignment.mMaterial,
+        layerAssignment.mLightSet,
+        layerAssignment.mDisplacement,
+        layerAssignment.mVolumeShader,
+        layerAssignment.mLightFilterSet,
+        layerAssignment.mShadowSet,
+        layerAssignment.mShadowReceiverSet
+    };
+    std::size_t h = 0;
+    for (const void* pointer : pointers) {
+        h ^= std::hash<const void*>()(pointer) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+void
+Layer::AssignmentTable::assign(int32_t assignmentId, const LayerAssignment& layerAssignment)
+{
+    // Acquire the new entry before releasing the old one, so an unchanged
+    // LayerAssignment isn't recycled in between.
+    const uint32_t entryId = acquire(layerAssignment);
+    if (std::size_t(assignmentId) == mEntryIds.size()) {
+        mEntryIds.push_back(entryId);
+    } else {
+        MNRY_ASSERT(std::size_t(assignmentId) < mEntryIds.size());
+        release(mEntryIds[assignmentId]);
+        mEntryIds[assignmentId] = entryId;
+    }
+}
+
+void
+Layer::AssignmentTable::clear()
+{
+    mEntryIds.clear();
+    mEntries.clear();
+    mRefCounts.clear();
+    mFreeEntries.clear();
+    mEntryIndex.clear();
+}
+
+uint32_t
+Layer::AssignmentTable::acquire(const LayerAssignment& layerAssignment)
+{
+    auto iter = mEntryIndex.find(layerAssignment);
+    if (iter != mEntryIndex.end()) {
+        ++mRefCounts[iter->second];
+        return iter->second;
+    }
+
+    uint32_t entryId;
+    if (!mFreeEntries.empty()) {
+        entryId = mFreeEntries.back();
+        mFreeEntries.pop_back();
+        mEntries[entryId] = layerAssignment;
+        mRefCounts[entryId] = 1;
+    } else {
+        entryId = static_cast<uint32_t>(mEntries.size());
+        mEntries.push_back(layerAssignment);
+        mRefCounts.push_back(1);
+    }
+    mEntryIndex.emplace(layerAssignment, entryId);
+    return entryId;
+}
+
+void
+Layer::AssignmentTable::release(uint32_t entryId)
+{
+    MNRY_ASSERT(mRefCounts[entryId] > 0);
+    if (--mRefCounts[entryId] == 0) {
+        mEntryIndex.erase(mEntries[entryId]);
+        mFreeEntries.push_back(entryId);
+    }
+}
+
 Layer::Layer(const SceneClass& sceneClass, const std::string& name) :
     Parent(sceneClass, name),
     mLightSetsChanged(false),
     mLightFilterSetsChanged(false),
     mShadowSetsChanged(false),
-    mShadowReceiverSetsChanged(false)
+    mShadowReceiverSetsChanged(false),
+    mIndexedChangeCount(mChangeCount)
 {
     // Add the Layer interface.
     mType |= INTERFACE_LAYER;
@@ -184,7 +347,7 @@ Layer::dirtyAssignments() {
     mAttributeSetMask.set(sVolumeShadersKey.mIndex, true);
     mAttributeSetMask.set(sShadowSetsKey.mIndex, true);
     mAttributeSetMask.set(sShadowReceiverSetsKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 }
 
 int32_t
@@ -221,6 +384,10 @@ Layer::assign(Geometry* geometry, const String& partName, const LayerAssignment&
         throw except::RuntimeError(errMsg.str());
     }
 
+    // Only keep the reverse indices up to date if they already are. Otherwise
+    // they're rebuilt the next time they're needed.
+    const bool indexCurrent = (mIndexedChangeCount.load(std::memory_order_relaxed) == mChangeCount);
+
     // Assign the geometry and part
     // For geometry with a volume shader, we ignore the parts which causes
     // moonray to just use the entire geometry.  Individual parts are generally
@@ -246,30 +413,54 @@ Layer::assign(Geometry* geometry, const String& partName, const LayerAssignment&
         // assignment is for existing geometry / part pair
         bool shouldDirtyAssignments = false;
         if (surfaceShaders[idx] != layerAssignment.mMaterial) {
+            if (indexCurrent) {
+                mSurfaceShaderIndex.reassign(idx, surfaceShaders[idx], layerAssignment.mMaterial);
+            }
             surfaceShaders[idx] = layerAssignment.mMaterial;
             shouldDirtyAssignments = true;
         }
         if (lightSets[idx] != layerAssignment.mLightSet) {
+            if (indexCurrent) {
+                mLightSetIndex.reassign(idx, lightSets[idx], layerAssignment.mLightSet);
+            }
             lightSets[idx] = layerAssignment.mLightSet;
             shouldDirtyAssignments = true;
         }
         if (displacements[idx] != layerAssignment.mDisplacement) {
+            if (indexCurrent) {
+                mDisplacementIndex.reassign(idx, displacements[idx], layerAssignment.mDisplacement);
+            }
             displacements[idx] = layerAssignment.mDisplacement;
             shouldDirtyAssignments = true;
         }
         if (volumeShaders[idx] != layerAssignment.mVolumeShader) {
+            if (indexCurrent) {
+                mVolumeShaderIndex.reassign(idx, volumeShaders[idx], layerAssignment.mVolumeShader);
+            }
             volumeShaders[idx] = layerAssignment.mVolumeShader;
             shouldDirtyAssignments = true;
         }
         if (lightFilterSets[idx] != layerAssignment.mLightFilterSet) {
+            if (indexCurrent) {
+                removeReference(mLightFilterSetCounts, lightFilterSets[idx]);
+                addReference(mLightFilterSetCounts, layerAssignment.mLightFilterSet);
+            }
             lightFilterSets[idx] = layerAssignment.mLightFilterSet;
             shouldDirtyAssignments = true;
         }
         if (shadowSets[idx] != layerAssignment.mShadowSet) {
+            if (indexCurrent) {
+                removeReference(mShadowSetCounts, shadowSets[idx]);
+                addReference(mShadowSetCounts, layerAssignment.mShadowSet);
+            }
             shadowSets[idx] = layerAssignment.mShadowSet;
             shouldDirtyAssignments = true;
         }
         if (shadowReceiverSets[idx] != layerAssignment.mShadowReceiverSet) {
+            if (indexCurrent) {
+                removeReference(mShadowReceiverSetCounts, shadowReceiverSets[idx]);
+                addReference(mShadowReceiverSetCounts, layerAssignment.mShadowReceiverSet);
+            }
             shadowReceiverSets[idx] = layerAssignment.mShadowReceiverSet;
             shouldDirtyAssignments = true;
         }
@@ -277,6 +468,9 @@ Layer::assign(Geometry* geometry, const String& partName, const LayerAssignment&
         // IMPORTANT: Binary reader requires this attributes serialized. It can not call this
         // method if the data is not present
         if (shouldDirtyAssignments) {
+            if (indexCurrent) {
+                mAssignmentTable.assign(idx, layerAssignment);
+            }
             dirtyAssignments();
         }
     } else {
@@ -293,14 +487,115 @@ Layer::assign(Geometry* geometry, const String& partName, const LayerAssignment&
         shadowReceiverSets.push_back(layerAssignment.mShadowReceiverSet);
 
         MNRY_ASSERT(surfaceShaders.size() == idx + 1);
+
+        if (indexCurrent) {
+            indexAssignment(idx);
+        }
+    }
+
+    if (indexCurrent) {
+        mIndexedChangeCount.store(mChangeCount, std::memory_order_release);
     }
 
     return idx;
 }
 
+void
+Layer::indexAssignment(int32_t assignmentId) const
+{
+    const std::size_t i = assignmentId;
+    mGeometryIndex.insert(get(sGeometriesKey)[i], assignmentId);
+    mSurfaceShaderIndex.insert(get(sSurfaceShadersKey)[i], assignmentId);
+    mLightSetIndex.insert(get(sLightSetsKey)[i], assignmentId);
+    mDisplacementIndex.insert(get(sDisplacementsKey)[i], assignmentId);
+    mVolumeShaderIndex.insert(get(sVolumeShadersKey)[i], assignmentId);
+    addReference(mLightFilterSetCounts, get(sLightFilterSetsKey)[i]);
+    addReference(mShadowSetCounts, get(sShadowSetsKey)[i]);
+    addReference(mShadowReceiverSetCounts, get(sShadowReceiverSetsKey)[i]);
+
+    LayerAssignment layerAssignment;
+    layerAssignment.mMaterial = objectAs<Material>(get(sSurfaceShadersKey)[i]);
+    layerAssignment.mLightSet = objectAs<LightSet>(get(sLightSetsKey)[i]);
+    layerAssignment.mDisplacement = objectAs<Displacement>(get(sDisplacementsKey)[i]);
+    layerAssignment.mVolumeShader = objectAs<VolumeShader>(get(sVolumeShadersKey)[i]);
+    layerAssignment.mLightFilterSet = objectAs<LightFilterSet>(get(sLightFilterSetsKey)[i]);
+    layerAssignment.mShadowSet = objectAs<ShadowSet>(get(sShadowSetsKey)[i]);
+    layerAssignment.mShadowReceiverSet = objectAs<ShadowReceiverSet>(get(sShadowReceiverSetsKey)[i]);
+    mAssignmentTable.assign(assignmentId, layerAssignment);
+}
+
+void
+Layer::clearAssignmentIndex() const
+{
+    mGeometryIndex.clear();
+    mSurfaceShaderIndex.clear();
+    mLightSetIndex.clear();
+    mDisplacementIndex.clear();
+    mVolumeShaderIndex.clear();
+    mLightFilterSetCounts.clear();
+    mShadowSetCounts.clear();
+    mShadowReceiverSetCounts.clear();
+    mAssignmentTable.clear();
+}
+
+void
+Layer::syncAssignmentIndex() const
+{
+    if (mIndexedChangeCount.load(std::memory_order_acquire) == mChangeCount) {
+        return;
+    }
+
+    // Several const readers may find the indices out of date at once, only
+    // the first one to get here rebuilds them.
+    std::lock_guard<std::mutex> lock(mIndexMutex);
+    if (mIndexedChangeCount.load(std::memory_order_relaxed) == mChangeCount) {
+        return;
+    }
+
+    clearAssignmentIndex();
+
+    const std::size_t assignmentCount = get(sSurfaceShadersKey).size();
+    for (std::size_t i = 0; i < assignmentCount; ++i) {
+        indexAssignment(static_cast<int32_t>(i));
+    }
+    mIndexedChangeCount.store(mChangeCount, std::memory_order_release);
+}
+
+const Layer::AssignmentIdVector&
+Layer::getAssignmentIds(const Material* material) const
+{
+    syncAssignmentIndex();
+    return mSurfaceShaderIndex.find(material);
+}
+
+const Layer::AssignmentIdVector&
+Layer::getAssignmentIds(const LightSet* lightSet) const
+{
+    syncAssignmentIndex();
+    return mLightSetIndex.find(lightSet);
+}
+
+const Layer::AssignmentIdVector&
+Layer::getAssignmentIds(const Geometry* geometry) const
+{
+    syncAssignmentIndex();
+    return mGeometryIndex.find(geometry);
+}
+
+std::size_t
+Layer::getDistinctAssignmentCount() const
+{
+    syncAssignmentIndex();
+    return mAssignmentTable.getEntryCount();
+}
+
 const Material*
 Layer::lookupMaterial(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mMaterial;
+    }
+
     const auto& surfaceShaders = get(sSurfaceShadersKey);
 
     // Sanity check.
@@ -322,6 +617,10 @@ Layer::lookupMaterial(int32_t assignmentId) const
 const LightSet*
 Layer::lookupLightSet(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mLightSet;
+    }
+
     const auto& lightSets = get(sLightSetsKey);
 
     // Sanity check.
@@ -337,6 +636,10 @@ Layer::lookupLightSet(int32_t assignmentId) const
 const Displacement*
 Layer::lookupDisplacement(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mDisplacement;
+    }
+
     const auto& displacements = get(sDisplacementsKey);
 
     // Sanity check.
@@ -358,6 +661,10 @@ Layer::lookupDisplacement(int32_t assignmentId) const
 const VolumeShader*
 Layer::lookupVolumeShader(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mVolumeShader;
+    }
+
     const auto& volumeShaders = get(sVolumeShadersKey);
 
     // Sanity check.
@@ -379,6 +686,10 @@ Layer::lookupVolumeShader(int32_t assignmentId) const
 const LightFilterSet*
 Layer::lookupLightFilterSet(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mLightFilterSet;
+    }
+
     const auto& lightFilterSets = get(sLightFilterSetsKey);
 
     // Sanity check.
@@ -394,6 +705,10 @@ Layer::lookupLightFilterSet(int32_t assignmentId) const
 const ShadowSet*
 Layer::lookupShadowSet(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mShadowSet;
+    }
+
     const auto& shadowSets = get(sShadowSetsKey);
 
     // Sanity check.
@@ -409,6 +724,10 @@ Layer::lookupShadowSet(int32_t assignmentId) const
 const ShadowReceiverSet*
 Layer::lookupShadowReceiverSet(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return layerAssignment->mShadowReceiverSet;
+    }
+
     const auto& shadowReceiverSets = get(sShadowReceiverSetsKey);
 
     // Sanity check.
@@ -424,6 +743,10 @@ Layer::lookupShadowReceiverSet(int32_t assignmentId) const
 Layer::MaterialLightSetPair
 Layer::lookup(int32_t assignmentId) const
 {
+    if (const LayerAssignment* layerAssignment = findAssignment(assignmentId)) {
+        return MaterialLightSetPair(layerAssignment->mMaterial, layerAssignment->mLightSet);
+    }
+
     const auto& surfaceShaders = get(sSurfaceShadersKey);
     const auto& lightSets = get(sLightSetsKey);
 
@@ -468,16 +791,57 @@ Layer::updatePrepAssignments(UpdateHelper& sceneObjects, int depth, Camera* came
     MNRY_ASSERT(mChangedRootShaders.empty());
     MNRY_ASSERT(mChangedOrDeformedGeometries.empty());
 
-    // Loop through all of the shaders in the scene and check if they are in the update graph. If so, flag so that 
+    syncAssignmentIndex();
+
+    // Loop through all of the shaders in the layer and check if they are in the update graph. If so, flag so that 
     // we can update the primitive attribute tables in renderPrep(). Also flag the associated geometry for reload in
-    // renderPrep(). 
+    // renderPrep(). Each distinct object is visited once, and the reverse indices lead from a changed object to just
+    // the assignments it affects, so the cost doesn't grow with the number of assignments in the layer.
     bool changed = false;    
-    const auto& surfaceShaders = get(sSurfaceShadersKey);
     const auto& geometries = get(sGeometriesKey);
-    const auto& displacements = get(sDisplacementsKey);
-    const auto& volumeShaders = get(sVolumeShadersKey);
-    for (size_t i = 0; i < surfaceShaders.size(); ++i) {
-        Geometry * const geometry = geometries[i]->asA<Geometry>();
+
+    // Flags a geometry for reload. A geometry with several assignments records
+    // the highest assignment ID which flagged it.
+    auto flagGeometry = [this](Geometry* geometry, int32_t assignmentId) {
+        auto result = mChangedOrDeformedGeometries.emplace(geometry, assignmentId);
+        if (!result.second && result.first->second < assignmentId) {
+            result.first->second = assignmentId;
+        }
+    };
+
+    for (const auto& entry : mSurfaceShaderIndex.getMap()) {
+        Material * const material = entry.first->asA<Material>();
+        if (material && material->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
+            mChangedRootShaders.insert(material);
+            // Geometries depend on materials because material request primitive
+            // attributes from the geometry. That means if a material changes
+            // it might request a new primitive attribute from the geometry
+            // and so the geometry would need to be reloaded and retessellated.
+            // At this point we do not know which primitive attributes the material
+            // requests, that occurs during the update calls, so we add this
+            // geometry to the list of changed or deformed geometries just in case.
+            for (int32_t id : entry.second) {
+                flagGeometry(geometries[id]->asA<Geometry>(), id);
+            }
+            changed = true;
+        }
+    }
+    for (const auto& entry : mVolumeShaderIndex.getMap()) {
+        VolumeShader * const volumeShader = entry.first->asA<VolumeShader>();
+        if (volumeShader && volumeShader->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
+            mChangedRootShaders.insert(volumeShader);
+            // Geometries depend on volumeShaders because we bake the maps into the geometry itself
+            for (int32_t id : entry.second) {
+                flagGeometry(geometries[id]->asA<Geometry>(), id);
+            }
+            changed = true;
+        }
+    }
+    for (const auto& entry : mGeometryIndex.getMap()) {
+        Geometry * const geometry = entry.first->asA<Geometry>();
+        if (!geometry) {
+            continue;
+        }
 
         // For IOR tracking purposes -- check if the geometry matches the geometry attached to the camera. If so, flag 
         // it so that (in updatePriorityAssignments) we can check for intersection with the geometry and set the 
@@ -490,74 +854,50 @@ Layer::updatePrepAssignments(UpdateHelper& sceneObjects, int depth, Camera* came
             }
         }
 
-        if (surfaceShaders[i] != nullptr) {
-            Material * const material = surfaceShaders[i]->asA<Material>();
-            if (material && material->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
-                mChangedRootShaders.insert(material);
-                // Geometries depend on materials because material request primitive
-                // attributes from the geometry. That means if a material changes
-                // it might request a new primitive attribute from the geometry
-                // and so the geometry would need to be reloaded and retessellated.
-                // At this point we do not know which primitive attributes the material
-                // requests, that occurs during the update calls, so we add this
-                // geometry to the list of changed or deformed geometries just in case.
-                mChangedOrDeformedGeometries[geometry] = i;
-                changed = true;
-            }
-        }
-        if (volumeShaders[i] != nullptr) {
-            VolumeShader * const volumeShader = volumeShaders[i]->asA<VolumeShader>();
-            if (volumeShader && volumeShader->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
-                mChangedRootShaders.insert(volumeShader);
-                // Geometries depend on volumeShaders because we bake the maps into the geometry itself
-                mChangedOrDeformedGeometries[geometry] = i;
-                changed = true;
-            }
-        }
-        if (geometry) {
-            if (isDeformed(geometry)) {
-                mChangedOrDeformedGeometries[geometry] = i;
-                changed = true;
-            } else if (geometry->updatePrep(sceneObjects, depth + 1)) {
-                // true if the dirtied attributes involve geometry change
-                if (geometry->requiresGeometryUpdate(sceneObjects, depth + 1)) {
-                    mChangedOrDeformedGeometries[geometry] = i;
-                }
-                changed = true;
+        const int32_t lastId = *std::max_element(entry.second.begin(), entry.second.end());
+        if (isDeformed(geometry)) {
+            flagGeometry(geometry, lastId);
+            changed = true;
+        } else if (geometry->updatePrep(sceneObjects, depth + 1)) {
+            // true if the dirtied attributes involve geometry change
+            if (geometry->requiresGeometryUpdate(sceneObjects, depth + 1)) {
+                flagGeometry(geometry, lastId);
             }
+            changed = true;
         }
-        if (displacements[i] != nullptr) {
-            Displacement * const displacement = displacements[i]->asA<Displacement>();
-            if (displacement && displacement->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
-                mChangedRootShaders.insert(displacement);
-                mChangedOrDeformedGeometries[geometry] = i;
+    }
+    for (const auto& entry : mDisplacementIndex.getMap()) {
+        Displacement * const displacement = entry.first->asA<Displacement>();
+        if (displacement && displacement->updatePrep(sceneObjects, depth + 1)) { // true if object is in update graph
+            mChangedRootShaders.insert(displacement);
+            for (int32_t id : entry.second) {
+                Geometry * const geometry = geometries[id]->asA<Geometry>();
+                flagGeometry(geometry, id);
                 // geometry must re-tessellate even though no attrs or bindings have changed
                 geometry->requestUpdate();
-                changed = true;
             }
+            changed = true;
         }
     }
     // Flag LightSets, LightFilterSets, ShadowSets, and ShadowReceiverSets that need to be updated in preFrame()
-    for (SceneObject * const lightSetObj : get(sLightSetsKey)) {
-        if (lightSetObj) {
-            LightSet * lightSet = lightSetObj->asA<LightSet>();
-            if (lightSet->updatePrepLight(sceneObjects, depth  + 1)) {
-                mLightSetsChanged = true;
-                changed = true;
-            }
+    for (const auto& entry : mLightSetIndex.getMap()) {
+        LightSet * lightSet = entry.first->asA<LightSet>();
+        if (lightSet->updatePrepLight(sceneObjects, depth  + 1)) {
+            mLightSetsChanged = true;
+            changed = true;
+        }
 
-            for (SceneObject * const light : lightSet->getLights()) {
-                if (light->hasChanged(Light::sLightFiltersKey)) {
-                    mLightFilterSetsChanged = true;
-                    changed = true;
-                }
+        for (SceneObject * const light : lightSet->getLights()) {
+            if (light->hasChanged(Light::sLightFiltersKey)) {
+                mLightFilterSetsChanged = true;
+                changed = true;
             }
         }
     }
 
     if (!mLightFilterSetsChanged) {
-        for (SceneObject * const lightFilterSet : get(sLightFilterSetsKey)) {
-            if (lightFilterSet && lightFilterSet->asA<LightFilterSet>()->
+        for (const auto& entry : mLightFilterSetCounts) {
+            if (entry.first->asA<LightFilterSet>()->
                 updatePrepLightFilter(sceneObjects, depth  + 1)) {
                 mLightFilterSetsChanged = true;
                 changed = true;
@@ -565,24 +905,20 @@ Layer::updatePrepAssignments(UpdateHelper& sceneObjects, int depth, Camera* came
         }
     }
 
-    for (SceneObject * const shadowSetObj : get(sShadowSetsKey)) {
-        if (shadowSetObj) {
-            ShadowSet * shadowSet = shadowSetObj->asA<ShadowSet>();
-            if (shadowSet->haveLightsChanged()) {
-                mShadowSetsChanged = true;
-                changed = true;
-            }
+    for (const auto& entry : mShadowSetCounts) {
+        ShadowSet * shadowSet = entry.first->asA<ShadowSet>();
+        if (shadowSet->haveLightsChanged()) {
+            mShadowSetsChanged = true;
+            changed = true;
         }
     }
 
-    for (SceneObject * const shadowReceiverSetObj : get(sShadowReceiverSetsKey)) {
-        if (shadowReceiverSetObj) {
-            const scene_rdl2::rdl2::ShadowReceiverSet * shadowReceiverSet =
-                shadowReceiverSetObj->asA<scene_rdl2::rdl2::ShadowReceiverSet>();
-            if (shadowReceiverSet->haveGeometriesChanged()) {
-                mShadowReceiverSetsChanged = true;
-                changed = true;
-            }
+    for (const auto& entry : mShadowReceiverSetCounts) {
+        const scene_rdl2::rdl2::ShadowReceiverSet * shadowReceiverSet =
+            entry.first->asA<scene_rdl2::rdl2::ShadowReceiverSet>();
+        if (shadowReceiverSet->haveGeometriesChanged()) {
+            mShadowReceiverSetsChanged = true;
+            changed = true;
         }
     }
 
@@ -670,50 +1006,42 @@ addRootShaderToSet(RootShader *s, Layer::RootShaderSet &rootShaders)
 void
 Layer::getAllRootShaders(RootShaderSet& rootShaders)
 {
-    for (SceneObject * const object : get(sSurfaceShadersKey)) {
-        if (object) {
-            addRootShaderToSet(object->asA<RootShader>(),rootShaders);
-        }
+    syncAssignmentIndex();
+    for (const auto& entry : mSurfaceShaderIndex.getMap()) {
+        addRootShaderToSet(entry.first->asA<RootShader>(), rootShaders);
     }
-    for (SceneObject * const object : get(sVolumeShadersKey)) {
-        if (object) {
-            addRootShaderToSet(object->asA<RootShader>(),rootShaders);
-        }
+    for (const auto& entry : mVolumeShaderIndex.getMap()) {
+        addRootShaderToSet(entry.first->asA<RootShader>(), rootShaders);
     }
-    for (SceneObject * const object : get(sDisplacementsKey)) {
-        if (object) {
-            addRootShaderToSet(object->asA<RootShader>(),rootShaders);
-        }
+    for (const auto& entry : mDisplacementIndex.getMap()) {
+        addRootShaderToSet(entry.first->asA<RootShader>(), rootShaders);
     }
 }
 
 void
 Layer::getAllMaterials(MaterialSet& materials)
 {
-    for (SceneObject * const object : get(sSurfaceShadersKey)) {
-        if (object) {
-            materials.insert(object->asA<Material>());
-        }
+    syncAssignmentIndex();
+    for (const auto& entry : mSurfaceShaderIndex.getMap()) {
+        materials.insert(entry.first->asA<Material>());
     }
 }
 
 void
 Layer::getAllLightSets(LightSetSet& lightSets) const
 {
-    for (SceneObject * const object : get(sLightSetsKey)) {
-        if (object) {
-            lightSets.insert(object->asA<LightSet>());
-        }
+    syncAssignmentIndex();
+    for (const auto& entry : mLightSetIndex.getMap()) {
+        lightSets.insert(entry.first->asA<LightSet>());
     }
 }
 
 void
 Layer::getAllGeometries(GeometrySet& geometries) const
 {
-    for (SceneObject * const object : get(sGeometriesKey)) {
-        if (object) {
-            geometries.insert(object->asA<Geometry>());
-        }
+    syncAssignmentIndex();
+    for (const auto& entry : mGeometryIndex.getMap()) {
+        geometries.insert(entry.first->asA<Geometry>());
     }
 }
 
@@ -843,7 +1171,10 @@ Layer::clear()
     mAttributeSetMask.set(sLightFilterSetsKey.mIndex, true);
     mAttributeSetMask.set(sShadowSetsKey.mIndex, true);
     mAttributeSetMask.set(sShadowReceiverSetsKey.mIndex, true);
-    mDirty = true;
+    setDirty();
+
+    clearAssignmentIndex();
+    mIndexedChangeCount.store(mChangeCount, std::memory_order_release);
     
     mLightSetsChanged = true;
     mChangedRootShaders.clear();
@@ -13,11 +13,14 @@
 
 #include <scene_rdl2/common/except/exceptions.h>
 
+#include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -39,6 +42,17 @@ struct LayerAssignment {
     LightFilterSet* mLightFilterSet;
     ShadowSet* mShadowSet;
     ShadowReceiverSet* mShadowReceiverSet;
+
+    bool operator==(const LayerAssignment& other) const
+    {
+        return mMaterial == other.mMaterial &&
+               mLightSet == other.mLightSet &&
+               mDisplacement == other.mDisplacement &&
+               mVolumeShader == other.mVolumeShader &&
+               mLightFilterSet == other.mLightFilterSet &&
+               mShadowSet == other.mShadowSet &&
+               mShadowReceiverSet == other.mShadowReceiverSet;
+    }
 };
 
 /**
@@ -80,6 +94,7 @@ public:
     typedef std::unordered_map<Geometry *, RootShaderSet> GeometryToRootShadersMap;
     typedef std::unordered_set<VolumeShader *> VolumeShaderSet;
     typedef std::unordered_set<const LightSet *> LightSetSet;
+    typedef std::vector<int32_t> AssignmentIdVector;
 
     typedef
     FilterIndexIterator<detail::ContainerWrapper<SceneObjectVector>,
@@ -375,6 +390,46 @@ public:
      */
     void getChangedGeometryToRootShaders(GeometryToRootShadersMap& g2s);
 
+    /**
+     * Returns the IDs of all assignments to which the given Material is
+     * assigned, in no particular order. The Layer keeps this reverse index up
+     * to date as assignments are made, so the lookup doesn't scan the Layer.
+     * The returned vector is only valid until the Layer is next changed.
+     *
+     * @param   material    The Material to look up assignments for.
+     * @return  The IDs of the assignments using the Material (possibly none).
+     */
+    const AssignmentIdVector& getAssignmentIds(const Material* material) const;
+
+    /**
+     * Returns the IDs of all assignments to which the given LightSet is
+     * assigned, in no particular order. The returned vector is only valid
+     * until the Layer is next changed.
+     *
+     * @param   lightSet    The LightSet to look up assignments for.
+     * @return  The IDs of the assignments using the LightSet (possibly none).
+     */
+    const AssignmentIdVector& getAssignmentIds(const LightSet* lightSet) const;
+
+    /**
+     * Returns the IDs of all assignments (one per part) made on the given
+     * Geometry, in no particular order. The returned vector is only valid
+     * until the Layer is next changed.
+     *
+     * @param   geometry    The Geometry to look up assignments for.
+     * @return  The IDs of the assignments on the Geometry (possibly none).
+     */
+    const AssignmentIdVector& getAssignmentIds(const Geometry* geometry) const;
+
+    /**
+     * Returns the number of distinct LayerAssignments (combinations of
+     * Material, LightSet, Displacement, etc.) in the Layer. Assignments with
+     * the same combination share one entry in the Layer's lookup table.
+     *
+     * @return  The number of distinct LayerAssignments.
+     */
+    std::size_t getDistinctAssignmentCount() const;
+
     /// Completely empties the Layer so that it doesn't contain anything.
     void clear();
 
@@ -398,9 +453,101 @@ public:
     LightSetIterator end(const LightSet* lightSet) const;
 
 private:
+    /**
+     * Maps each SceneObject in one column of the assignment table (e.g. the
+     * surface shaders) to the IDs of the assignments that reference it, so a
+     * change to one object can be traced to its assignments without scanning
+     * the whole table. Null entries aren't indexed. Moving an assignment from
+     * one object to another is constant time.
+     */
+    class AssignmentIndex
+    {
+    public:
+        typedef std::unordered_map<SceneObject*, AssignmentIdVector> Map;
+
+        void insert(SceneObject* object, int32_t assignmentId);
+        void reassign(int32_t assignmentId, SceneObject* from, SceneObject* to);
+        void clear();
+
+        const AssignmentIdVector& find(const SceneObject* object) const;
+        const Map& getMap() const { return mIds; }
+
+    private:
+        static const AssignmentIdVector sNoIds;
+
+        Map mIds;
+        // Position of each assignment ID within its object's ID vector.
+        std::vector<uint32_t> mPositions;
+    };
+
+    /**
+     * A lookup cache of the assignment table. Each assignment is a 32-bit
+     * index into a table of the distinct LayerAssignments in the Layer, so a
+     * lookup reads 4 bytes from a dense array and then an entry in a small
+     * table which is usually cache resident, instead of one attribute vector
+     * per column and the assigned object itself (to check its type). Entries
+     * no assignment uses any more are recycled.
+     *
+     * The attributes remain the authoritative storage (serialization and
+     * the iterators read them), so the table costs memory on top of them:
+     * about 4 bytes per assignment plus one entry per distinct assignment.
+     */
+    class AssignmentTable
+    {
+    public:
+        /// Sets the LayerAssignment of an assignment, which is either an
+        /// existing one or the next new one.
+        void assign(int32_t assignmentId, const LayerAssignment& layerAssignment);
+        void clear();
+
+        const LayerAssignment& get(int32_t assignmentId) const
+        {
+            return mEntries[mEntryIds[assignmentId]];
+        }
+        std::size_t size() const { return mEntryIds.size(); }
+        std::size_t getEntryCount() const { return mEntryIndex.size(); }
+
+    private:
+        struct Hash
+        {
+            std::size_t operator()(const LayerAssignment& layerAssignment) const;
+        };
+
+        uint32_t acquire(const LayerAssignment& layerAssignment);
+        void release(uint32_t entryId);
+
+        std::vector<uint32_t> mEntryIds;        // one per assignment
+        std::vector<LayerAssignment> mEntries;
+        std::vector<uint32_t> mRefCounts;       // one per entry
+        std::vector<uint32_t> mFreeEntries;
+        std::unordered_map<LayerAssignment, uint32_t, Hash> mEntryIndex;
+    };
+
+    // Number of assignments referencing each object, for the columns where
+    // only the set of distinct objects is needed.
+    typedef std::unordered_map<SceneObject*, uint32_t> ObjectCountMap;
 
     void dirtyAssignments();
 
+    // Rebuilds the reverse indices from the assignment attributes if they
+    // were changed by anything other than assign() or clear(). Safe to call
+    // from several const readers at once: the rebuild is serialized by
+    // mIndexMutex and published through mIndexedChangeCount.
+    void syncAssignmentIndex() const;
+
+    // Empties the reverse indices.
+    void clearAssignmentIndex() const;
+
+    // Records the given assignment (which must be new) in the reverse indices.
+    void indexAssignment(int32_t assignmentId) const;
+
+    // Returns the assignment's entry in the assignment table, or null if the
+    // ID is out of range or the table is out of date, in which case the
+    // attributes have to be read instead. Never rebuilds the table, so that
+    // lookups stay safe to call from many threads. Like the other const
+    // queries it must not run concurrently with changes to the Layer.
+    finline const LayerAssignment* findAssignment(int32_t assignmentId) const;
+
     /// Clears the updated or deformed geometry map and resets the deformed
     /// status of the geometry.
     void resetDeformedGeometries();
@@ -444,10 +591,43 @@ private:
     /// or geometry data deformed.
     GeometryIndexMap mChangedOrDeformedGeometries;
 
+    /// Reverse indices and lookup cache of the assignment table. assign() and
+    /// clear() keep them up to date. Any other change to the Layer's
+    /// attributes (e.g. a direct set()) changes the SceneObject change count,
+    /// and they're rebuilt the next time the indices are used (the lookup
+    /// functions read the attributes until then). They're mutable so that
+    /// they can be rebuilt from const queries, which may run concurrently
+    /// with each other (but not with changes to the Layer).
+    mutable AssignmentIndex mGeometryIndex;
+    mutable AssignmentIndex mSurfaceShaderIndex;
+    mutable AssignmentIndex mLightSetIndex;
+    mutable AssignmentIndex mDisplacementIndex;
+    mutable AssignmentIndex mVolumeShaderIndex;
+    mutable ObjectCountMap mLightFilterSetCounts;
+    mutable ObjectCountMap mShadowSetCounts;
+    mutable ObjectCountMap mShadowReceiverSetCounts;
+    mutable AssignmentTable mAssignmentTable;
+    /// The change count the indices were last brought up to date at. Stored
+    /// with release order once a rebuild is complete, so a reader which sees
+    /// it match the change count with acquire order sees complete indices.
+    mutable std::atomic<uint32_t> mIndexedChangeCount;
+    /// Serializes rebuilds of the indices by const queries.
+    mutable std::mutex mIndexMutex;
+
     /// Classes requiring access for serialization.
     friend class AsciiWriter;
 };
 
+const LayerAssignment*
+Layer::findAssignment(int32_t assignmentId) const
+{
+    if (mIndexedChangeCount.load(std::memory_order_acquire) == mChangeCount && assignmentId >= 0 &&
+            std::size_t(assignmentId) < mAssignmentTable.size()) {
+        return &mAssignmentTable.get(assignmentId);
+    }
+    return nullptr;
+}
+
 template <>
 inline const Layer*
 SceneObject::asA() const
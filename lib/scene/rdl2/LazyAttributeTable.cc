@@ -0,0 +1,77 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "LazyAttributeTable.h"
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+LazyAttributeTable::LazyAttributeTable() :
+    mPending(0)
+{
+}
+
+void
+LazyAttributeTable::add(uint32_t index, void* dst, const void* src, std::size_t count,
+                        DecodeFunc decode, const std::shared_ptr<const void>& owner)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.emplace_back(index, dst, src, count, decode);
+    if (mOwners.empty() || mOwners.back() != owner) {
+        mOwners.push_back(owner);
+    }
+    mPending.fetch_add(1, std::memory_order_release);
+}
+
+void
+LazyAttributeTable::materialize(uint32_t index)
+{
+    if (mPending.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+
+    // Entries are only appended while the object is being updated, which
+    // can't overlap with attribute access, so scanning without the lock is
+    // fine. Only take the lock when there is something left to decode.
+    for (Entry& entry : mEntries) {
+        if (entry.mIndex == index && !entry.mDone.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            decode(entry);
+        }
+    }
+}
+
+void
+LazyAttributeTable::materializeAll()
+{
+    if (mPending.load(std::memory_order_acquire) == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (Entry& entry : mEntries) {
+        decode(entry);
+    }
+}
+
+void
+LazyAttributeTable::decode(Entry& entry)
+{
+    if (entry.mDone.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    entry.mDecode(entry.mDst, entry.mSrc, entry.mCount);
+    entry.mDone.store(true, std::memory_order_release);
+
+    if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Nothing references the source buffers anymore.
+        mOwners.clear();
+        mOwners.shrink_to_fit();
+    }
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
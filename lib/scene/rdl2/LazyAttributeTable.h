@@ -0,0 +1,122 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * A LazyAttributeTable tracks attribute values of a single SceneObject which
+ * have been read from RDL binary but not yet copied into the object's
+ * attribute storage. Each entry points at the raw element bytes of a vector
+ * value inside the buffer it was decoded from (a memory mapped file, a
+ * payload string, or a decompressed record) and knows where in the
+ * attribute storage the value belongs.
+ *
+ * Values are copied into place the first time their attribute is accessed.
+ * The source buffers are kept alive through shared ownership and released
+ * as soon as every entry in the table has been materialized.
+ *
+ * Thread Safety:
+ *  - add() may only be called while the owning SceneObject is being updated.
+ *  - materialize() and materializeAll() are safe to call concurrently, which
+ *      allows const attribute access from multiple render threads.
+ */
+class LazyAttributeTable
+{
+public:
+    // Copies count elements from (possibly unaligned) src into the value at
+    // dst, replacing its contents.
+    typedef void (*DecodeFunc)(void* dst, const void* src, std::size_t count);
+
+    LazyAttributeTable();
+
+    /**
+     * Records a pending value for the attribute with the given index. The
+     * caller must make sure there is no other pending entry for the same
+     * storage location.
+     *
+     * @param   index   Attribute index within the SceneClass.
+     * @param   dst     Address of the value in attribute storage.
+     * @param   src     Address of the encoded element bytes.
+     * @param   count   Number of encoded elements.
+     * @param   decode  Function which copies the elements into dst.
+     * @param   owner   Keeps the bytes at src alive.
+     */
+    void add(uint32_t index, void* dst, const void* src, std::size_t count,
+             DecodeFunc decode, const std::shared_ptr<const void>& owner);
+
+    /**
+     * Copies every pending value of the attribute with the given index into
+     * attribute storage. Does nothing if there are none.
+     */
+    void materialize(uint32_t index);
+
+    /**
+     * Copies every pending value into attribute storage.
+     */
+    void materializeAll();
+
+    /**
+     * Returns the number of values which have not been materialized yet.
+     */
+    std::size_t getPendingCount() const { return mPending.load(std::memory_order_acquire); }
+
+    // DecodeFunc for std::vector based attribute types of trivially copyable
+    // elements.
+    template <typename Vector>
+    static void decodeVector(void* dst, const void* src, std::size_t count)
+    {
+        Vector& vec = *static_cast<Vector*>(dst);
+        vec.resize(count);
+        if (count) {
+            std::memcpy(static_cast<void*>(vec.data()), src, count * sizeof(typename Vector::value_type));
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Entry(uint32_t index, void* dst, const void* src, std::size_t count, DecodeFunc decode) :
+            mIndex(index), mDst(dst), mSrc(src), mCount(count), mDecode(decode), mDone(false) {}
+
+        uint32_t mIndex;
+        void* mDst;
+        const void* mSrc;
+        std::size_t mCount;
+        DecodeFunc mDecode;
+        std::atomic<bool> mDone;
+    };
+
+    // Decodes the entry unless another thread beat us to it. Must be called
+    // with mMutex held.
+    void decode(Entry& entry);
+
+    // A std::deque because entries hold atomics and must never move. The
+    // number of large vector attributes per object is small, so lookups are
+    // linear.
+    std::deque<Entry> mEntries;
+
+    std::atomic<std::size_t> mPending;
+
+    // Serializes decoding.
+    std::mutex mMutex;
+
+    // Buffers referenced by pending entries.
+    std::vector<std::shared_ptr<const void>> mOwners;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -72,7 +72,7 @@ LightFilterSet::add(LightFilter* lightfilter)
     // the set() method.
     mAttributeUpdateMask.set(sLightFiltersKey.mIndex, true);
     mAttributeSetMask.set(sLightFiltersKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 }
 
 void
@@ -102,7 +102,7 @@ LightFilterSet::remove(LightFilter* lightfilter)
         // through the set() method.
         mAttributeUpdateMask.set(sLightFiltersKey.mIndex, true);
         mAttributeSetMask.set(sLightFiltersKey.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -158,7 +158,7 @@ LightFilterSet::clear()
     // through the set() method.
     mAttributeUpdateMask.set(sLightFiltersKey.mIndex, true);
     mAttributeSetMask.set(sLightFiltersKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 }
 
 } // namespace rdl2
@@ -0,0 +1,173 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "RecordCompression.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+
+#include <cstring>
+#include <sstream>
+#include <stdint.h>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+constexpr std::size_t RecordCompression::sMinRecordSize;
+constexpr std::size_t RecordCompression::sWordSize;
+constexpr std::size_t RecordCompression::sMaxLiteralRun;
+constexpr std::size_t RecordCompression::sMinZeroRun;
+constexpr std::size_t RecordCompression::sMaxZeroRun;
+
+bool
+RecordCompression::compress(const void* data, std::size_t size, std::string& out)
+{
+    const unsigned char* src = static_cast<const unsigned char*>(data);
+    const std::size_t numWords = size / sWordSize;
+    const std::size_t planeBytes = numWords * sWordSize;
+
+    // Byte shuffle into planes, leaving any trailing partial word as is.
+    std::string work(size, '\0');
+    unsigned char* shuffled = reinterpret_cast<unsigned char*>(&work[0]);
+    for (std::size_t plane = 0; plane < sWordSize; ++plane) {
+        unsigned char* dst = shuffled + plane * numWords;
+        for (std::size_t i = 0; i < numWords; ++i) {
+            dst[i] = src[i * sWordSize + plane];
+        }
+    }
+    std::memcpy(shuffled + planeBytes, src + planeBytes, size - planeBytes);
+
+    // Delta against the previous byte.
+    unsigned char prev = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        const unsigned char curr = shuffled[i];
+        shuffled[i] = static_cast<unsigned char>(curr - prev);
+        prev = curr;
+    }
+
+    // Zero run-length coding. Give up as soon as it stops paying off.
+    std::string encoded;
+    encoded.reserve(size);
+    const uint64_t rawSize = size;
+    encoded.append(reinterpret_cast<const char*>(&rawSize), sizeof(uint64_t));
+
+    std::size_t literalStart = 0;
+    std::size_t literalLen = 0;
+    auto flushLiterals = [&]() {
+        if (literalLen == 0) return;
+        encoded.push_back(static_cast<char>(literalLen - 1));
+        encoded.append(reinterpret_cast<const char*>(shuffled + literalStart), literalLen);
+        literalLen = 0;
+    };
+
+    std::size_t i = 0;
+    while (i < size) {
+        if (shuffled[i] == 0) {
+            std::size_t run = 1;
+            while (i + run < size && run < sMaxZeroRun && shuffled[i + run] == 0) {
+                ++run;
+            }
+            if (run >= sMinZeroRun) {
+                flushLiterals();
+                encoded.push_back(static_cast<char>(128 + run - sMinZeroRun));
+                i += run;
+                continue;
+            }
+        }
+
+        if (literalLen == 0) {
+            literalStart = i;
+        }
+        if (++literalLen == sMaxLiteralRun) {
+            flushLiterals();
+        }
+        ++i;
+
+        if (encoded.size() >= size) {
+            return false;
+        }
+    }
+    flushLiterals();
+
+    if (encoded.size() >= size) {
+        return false;
+    }
+    out.append(encoded);
+    return true;
+}
+
+void
+RecordCompression::decompress(const void* data, std::size_t size, std::string& out)
+{
+    const unsigned char* src = static_cast<const unsigned char*>(data);
+    if (size < sizeof(uint64_t)) {
+        throw except::FormatError("Compressed RDL2 record is too short to hold its header.");
+    }
+
+    uint64_t rawSize;
+    std::memcpy(&rawSize, src, sizeof(uint64_t));
+
+    // No control byte expands to more than sMaxZeroRun bytes, so a larger
+    // raw size can only come from a corrupt header. Check before allocating.
+    if (rawSize > (size - sizeof(uint64_t)) * sMaxZeroRun) {
+        std::stringstream errMsg;
+        errMsg << "Compressed RDL2 record claims " << rawSize << " bytes, more than its "
+            << (size - sizeof(uint64_t)) << " bytes of data can hold.";
+        throw except::FormatError(errMsg.str());
+    }
+
+    // Undo the run-length coding.
+    std::string work(rawSize, '\0');
+    unsigned char* shuffled = reinterpret_cast<unsigned char*>(&work[0]);
+    std::size_t pos = sizeof(uint64_t);
+    std::size_t decoded = 0;
+    while (pos < size) {
+        const unsigned char control = src[pos++];
+        if (control < 128) {
+            const std::size_t len = control + 1;
+            if (pos + len > size || decoded + len > rawSize) {
+                throw except::FormatError("Compressed RDL2 record has a literal run past its end.");
+            }
+            std::memcpy(shuffled + decoded, src + pos, len);
+            pos += len;
+            decoded += len;
+        } else {
+            const std::size_t len = control - 128 + sMinZeroRun;
+            if (decoded + len > rawSize) {
+                throw except::FormatError("Compressed RDL2 record has a zero run past its end.");
+            }
+            decoded += len; // already zero
+        }
+    }
+    if (decoded != rawSize) {
+        std::stringstream errMsg;
+        errMsg << "Compressed RDL2 record decoded to " << decoded << " bytes, expected "
+            << rawSize << " bytes.";
+        throw except::FormatError(errMsg.str());
+    }
+
+    // Undo the delta.
+    unsigned char prev = 0;
+    for (std::size_t i = 0; i < rawSize; ++i) {
+        prev = static_cast<unsigned char>(shuffled[i] + prev);
+        shuffled[i] = prev;
+    }
+
+    // Undo the byte shuffle.
+    const std::size_t numWords = rawSize / sWordSize;
+    const std::size_t planeBytes = numWords * sWordSize;
+    const std::size_t outStart = out.size();
+    out.resize(outStart + rawSize);
+    unsigned char* dst = reinterpret_cast<unsigned char*>(&out[outStart]);
+    for (std::size_t plane = 0; plane < sWordSize; ++plane) {
+        const unsigned char* planeSrc = shuffled + plane * numWords;
+        for (std::size_t i = 0; i < numWords; ++i) {
+            dst[i * sWordSize + plane] = planeSrc[i];
+        }
+    }
+    std::memcpy(dst + planeBytes, shuffled + planeBytes, rawSize - planeBytes);
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,71 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+/**
+ * Lossless codec for individual RDL binary payload records. Each record is
+ * compressed on its own, so any record can still be located through the
+ * manifest and decoded without touching its neighbours, which keeps parallel
+ * and incremental decoding working on compressed payloads.
+ *
+ * Records are dominated by large float, Vec3f, Mat4f, etc. vectors, so the
+ * codec is tuned for arrays of 4 byte words:
+ *  1. Byte shuffle: the bytes of every 32-bit word are split into four
+ *      planes (all byte 0s, then all byte 1s, ...). Sign/exponent bytes of
+ *      neighbouring floats are then adjacent and mostly equal.
+ *  2. Delta: each byte is replaced by its difference from the previous byte,
+ *      turning those repeated bytes (and slowly changing ones) into zeros
+ *      and small values.
+ *  3. Zero run-length coding: runs of zero bytes are collapsed into a single
+ *      control byte, everything else is stored as literal runs.
+ *
+ * Compressed record layout:
+ *
+ * +------------+------------------------------------------+
+ * |  raw size  |  control byte + run, ... (until the end) |
+ * +------------+------------------------------------------+
+ * |  8 bytes   |  variable                                |
+ * +------------+------------------------------------------+
+ *
+ * A control byte c < 128 is followed by c + 1 literal bytes. A control byte
+ * c >= 128 stands for (c - 128 + sMinZeroRun) zero bytes.
+ */
+class RecordCompression
+{
+public:
+    /**
+     * Compresses size bytes at data and appends the result to out. Returns
+     * false (and leaves out untouched) if compression would not make the
+     * record smaller, in which case the record should be stored raw.
+     */
+    static bool compress(const void* data, std::size_t size, std::string& out);
+
+    /**
+     * Decompresses a record produced by compress() and appends the original
+     * bytes to out.
+     *
+     * @throw   except::FormatError     If the compressed data is corrupt.
+     */
+    static void decompress(const void* data, std::size_t size, std::string& out);
+
+    // Records smaller than this are not worth compressing.
+    static constexpr std::size_t sMinRecordSize = 256;
+
+private:
+    static constexpr std::size_t sWordSize = 4;
+    static constexpr std::size_t sMaxLiteralRun = 128;
+    static constexpr std::size_t sMinZeroRun = 3;
+    static constexpr std::size_t sMaxZeroRun = 128 + sMinZeroRun - 1;
+};
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
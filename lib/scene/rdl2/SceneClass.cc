@@ -7,12 +7,17 @@
 
 #include "Attribute.h"
 #include "ObjectFactory.h"
+#include "SceneClassCache.h"
+#include "SceneContext.h"
 #include "Types.h"
 
 #include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/render/logging/logging.h>
 #include <scene_rdl2/render/util/StrUtil.h>
 
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -30,8 +35,10 @@ SceneClass::SceneClass(SceneContext* context, const std::string& name,
     mName(name),
     mDeclaredInterface(INTERFACE_GENERIC),
     mObjectFactory(std::move(objectFactory)),
+    mDeferredProxy(false),
     mAttributeStorageSize(0),
-    mComplete(false)
+    mComplete(false),
+    mTrivialStorage(false)
 {
 }
 
@@ -108,13 +115,10 @@ SceneClass::computeOffsetAndSize(AttributeFlags flags)
 void*
 SceneClass::createStorage() const
 {
-    // Cache lines on all modern processors are 64 bytes.
-    const std::size_t cacheLineSize = 64;
-
     // Allocate a chunk of memory for the attribute values. We spent the time
-    // laying out attributes nicely with respect to cache lines, so make sure
-    // to allocate this chunk with proper alignment!
-    void* storage = util::alignedMalloc(mAttributeStorageSize, cacheLineSize);
+    // laying out attributes nicely with respect to cache lines, so the arena
+    // hands out chunks aligned on cache line boundaries.
+    void* storage = mStorageArena.allocate(mAttributeStorageSize);
 
     // Initialize each attribute with its default value at every timestep.
     for (AttributeConstIterator iter = mAttributes.begin();
@@ -126,6 +130,34 @@ SceneClass::createStorage() const
     return storage;
 }
 
+void*
+SceneClass::copyStorage(const void* source) const
+{
+    void* storage = mStorageArena.allocate(mAttributeStorageSize);
+
+    // Without strings or vectors the chunk is plain data and can be copied
+    // wholesale.
+    if (mTrivialStorage) {
+        std::memcpy(storage, source, mAttributeStorageSize);
+        return storage;
+    }
+
+    for (AttributeConstIterator iter = mAttributes.begin();
+            iter != mAttributes.end(); ++iter) {
+        const Attribute* attribute = *iter;
+        createValue(storage, attribute);
+
+        int timestep = TIMESTEP_BEGIN;
+        do {
+            copyValue(storage, attribute, const_cast<void*>(source), attribute,
+                      static_cast<AttributeTimestep>(timestep));
+            ++timestep;
+        } while (attribute->isBlurrable() && timestep < NUM_TIMESTEPS);
+    }
+
+    return storage;
+}
+
 void
 SceneClass::createValue(void* storage, const Attribute* attribute) const
 {
@@ -329,15 +361,18 @@ SceneClass::createValue(void* storage, const Attribute* attribute) const
 void
 SceneClass::destroyStorage(void* storage) const
 {
-    // Destroy each attribute value at every timestep.
-    for (AttributeConstIterator iter = mAttributes.begin();
-            iter != mAttributes.end(); ++iter) {
-        const Attribute* attribute = *iter;
-        destroyValue(storage, attribute);
+    // Destroy each attribute value at every timestep, unless there's nothing
+    // to destroy.
+    if (!mTrivialStorage) {
+        for (AttributeConstIterator iter = mAttributes.begin();
+                iter != mAttributes.end(); ++iter) {
+            const Attribute* attribute = *iter;
+            destroyValue(storage, attribute);
+        }
     }
 
-    // Release the memory.
-    util::alignedFree(storage);
+    // Hand the memory back to the arena.
+    mStorageArena.deallocate(storage);
 }
 
 void
@@ -632,9 +667,76 @@ SceneClass::getAttributeGroup(const std::string& groupName) const
 std::string
 SceneClass::getSourcePath() const
 {
+    if (!mDeferredSourcePath.empty()) {
+        return mDeferredSourcePath;
+    }
     return mObjectFactory->getSourcePath();
 }
 
+void
+SceneClass::loadDeferredObjectFactory()
+{
+    // Only search the directory the cached DSO lives in, so we open the same
+    // file the cache entry describes.
+    const std::string directory =
+        std::filesystem::path(mDeferredSourcePath).parent_path().string();
+    std::unique_ptr<ObjectFactory> factory = mDeferredProxy ?
+        ObjectFactory::createProxyFactory(mName, directory) :
+        ObjectFactory::createDsoFactory(mName, directory);
+
+    // The attributes we hand out came from the cache, but the DSO's own
+    // AttributeKeys are only filled in by running its declare(). Declare into
+    // a scratch SceneClass and verify the layout agrees with ours.
+    SceneClass declared(mContext, mName, nullptr);
+    declared.mDeclaredInterface = factory->declare(declared);
+
+    bool matches = declared.mDeclaredInterface == mDeclaredInterface &&
+                   declared.mAttributeStorageSize == mAttributeStorageSize &&
+                   declared.mAttributes.size() == mAttributes.size();
+    for (std::size_t i = 0; matches && i < mAttributes.size(); ++i) {
+        const Attribute* expected = mAttributes[i];
+        const Attribute* actual = declared.mAttributes[i];
+        matches = actual->mName == expected->mName &&
+                  actual->mType == expected->mType &&
+                  actual->mFlags == expected->mFlags &&
+                  actual->mObjectType == expected->mObjectType &&
+                  actual->mOffset == expected->mOffset;
+    }
+    if (!matches) {
+        // The cache entry is stale, e.g. it was written against an older
+        // build of a built-in base class whose declarations changed. No
+        // objects of this class exist yet, so take the DSO's declarations
+        // instead and rewrite the entry so the next load restores them.
+        // Attributes and keys obtained from the cached declarations before
+        // this point are not valid afterwards.
+        logging::Logger::warn("SceneClass '", mName, "' declared by DSO '", mDeferredSourcePath,
+                     "' no longer matches its cached declarations. Re-declaring it.");
+        std::swap(mAttributes, declared.mAttributes);
+        std::swap(mNameMap, declared.mNameMap);
+        std::swap(mGroupNames, declared.mGroupNames);
+        std::swap(mGroupMap, declared.mGroupMap);
+        mAttributeStorageSize = declared.mAttributeStorageSize;
+        mDeclaredInterface = declared.mDeclaredInterface;
+        setComplete();
+
+        const std::string cachePath = mContext ? mContext->getSceneClassCachePath() : std::string();
+        if (!cachePath.empty()) {
+            SceneClassCache cache;
+            cache.load(cachePath);
+            cache.store(mDeferredSourcePath, *this);
+            try {
+                cache.save(cachePath);
+            } catch (const except::IoError& e) {
+                // The cache only saves time on the next load.
+                logging::Logger::warn(e.what());
+            }
+        }
+    }
+
+    mData = declared.mData;
+    mObjectFactory = std::move(factory);
+}
+
 // Explicit instantiations of templated functions for all attribute types.
 template std::pair<uint32_t, std::size_t> SceneClass::computeOffsetAndSize<Bool>(AttributeFlags);
 template std::pair<uint32_t, std::size_t> SceneClass::computeOffsetAndSize<Int>(AttributeFlags);
@@ -8,6 +8,7 @@
 #include <scene_rdl2/common/platform/Platform.h>
 
 #include "Attribute.h"
+#include "AttributeStorageArena.h"
 #include "AttributeKey.h"
 #include "ObjectFactory.h"
 #include "Types.h"
@@ -22,6 +23,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -427,13 +429,25 @@ public:
     finline void declareDataPtr(const std::string &name, const T *data);
 
     /**
-     * Get a named class data ptr
+     * Get a named class data ptr. Class data points into the DSO, so for a
+     * SceneClass restored from a SceneClassCache it is only available once
+     * an object of the class has been created.
      * @param name The name of the data
      * @return a pointer to the function method
      */
     template <typename T>
     finline const T *getDataPtr(const std::string &name) const;
 
+    /**
+     * Returns the SceneObjects of this SceneClass in the order they were
+     * created. Objects are never removed, so an object's position is stable
+     * for the lifetime of the SceneContext (see AttributeColumn).
+     *
+     * Like the other SceneContext registries, this must not be read while
+     * objects of this class are being created.
+     */
+    finline const SceneObjectVector& getSceneObjects() const;
+
     std::string showAllAttributes() const; // returns all attribute info as a string for display purposes
 
     // Metadata Keys
@@ -460,6 +474,17 @@ private:
     // Helper function to destroy a SceneObject of this SceneClass.
     finline void destroyObject(SceneObject* sceneObject);
 
+    // Marks a SceneClass whose declarations were restored from a
+    // SceneClassCache as coming from the given DSO, which will be opened the
+    // first time an object is created.
+    finline void deferObjectFactory(const std::string& dsoFilePath, bool proxyModeEnabled);
+
+    // Opens the deferred DSO, runs its declare() function (which initializes
+    // the DSO's own AttributeKeys and class data) and checks that it still
+    // matches the cached declarations. If it doesn't, the DSO's declarations
+    // replace the cached ones and the cache entry is rewritten.
+    void loadDeferredObjectFactory();
+
     // Helper function to validate attribute name
     static bool validName(const std::string& name);
 
@@ -482,9 +507,13 @@ private:
     // Internal API function to create a storage chunk for storing attributes.
     // It guarantees the proper memory alignment that we worked for in
     // computeOffsetAndSize(). It also initializes all the attribute values
-    // to their default value.
+    // to their default value. Chunks come from the class's storage arena.
     void* createStorage() const;
 
+    // Internal API function to create a storage chunk holding a copy of every
+    // attribute value in the given storage chunk, at every timestep.
+    void* copyStorage(const void* source) const;
+
     // Internal API function to destroy a storage chunk for storing attributes.
     void destroyStorage(void* storage) const;
 
@@ -558,9 +587,17 @@ private:
     SceneObjectInterface mDeclaredInterface;
 
     // The factory for declaring, creating, and destroying objects of this
-    // SceneClass type.
+    // SceneClass type. Null until the first object is created if the class
+    // was restored from a SceneClassCache.
     std::unique_ptr<ObjectFactory> mObjectFactory;
 
+    // The DSO a cached SceneClass will load its ObjectFactory from, and
+    // whether it's a proxy DSO. Empty for classes which were declared
+    // normally. mDeferredLoad guards the one time load.
+    std::string mDeferredSourcePath;
+    bool mDeferredProxy;
+    std::once_flag mDeferredLoad;
+
     // The size (in bytes) required to store all the attribute values.
     std::size_t mAttributeStorageSize;
 
@@ -568,6 +605,14 @@ private:
     // "complete").
     bool mComplete;
 
+    // True if every attribute value is trivially destructible (no strings or
+    // vectors), so destroying a storage chunk doesn't have to visit them.
+    // Computed by setComplete().
+    bool mTrivialStorage;
+
+    // Slab allocator for the storage chunks of this class's SceneObjects.
+    mutable AttributeStorageArena mStorageArena;
+
     // The list of all attributes in the SceneClass.
     AttributeVector mAttributes;
 
@@ -587,10 +632,17 @@ private:
     // Blind data
     DataPtrMap mData;
 
+    // All SceneObjects of this class, in creation order. Appended to by the
+    // SceneContext under its mCreateSceneObjectMutex.
+    SceneObjectVector mSceneObjects;
+
     // SceneContext needs access to the private constructor. It is the only
     // class capable of constructing SceneClasses.
     friend class SceneContext;
 
+    // SceneClassCache records and restores the declarations.
+    friend class SceneClassCache;
+
     // SceneObject needs access for calling private functions that manipulate
     // attribute values. These are internal to the RDL implementation.
     friend class SceneObject;
@@ -734,6 +786,11 @@ SceneClass::createObject(const std::string& name)
         throw except::RuntimeError(errMsg.str());
     }
 
+    // Cached SceneClasses open their DSO on first use.
+    if (!mDeferredSourcePath.empty()) {
+        std::call_once(mDeferredLoad, &SceneClass::loadDeferredObjectFactory, this);
+    }
+
     // Delegate to the ObjectFactory.
     return mObjectFactory->create(*this, name);
 }
@@ -753,10 +810,21 @@ SceneClass::destroyObject(SceneObject* sceneObject)
     mObjectFactory->destroy(sceneObject);
 }
 
+void
+SceneClass::deferObjectFactory(const std::string& dsoFilePath, bool proxyModeEnabled)
+{
+    mDeferredSourcePath = dsoFilePath;
+    mDeferredProxy = proxyModeEnabled;
+}
+
 void
 SceneClass::setComplete()
 {
     mComplete = true;
+    mTrivialStorage = std::all_of(mAttributes.begin(), mAttributes.end(),
+        [](const Attribute* attribute) {
+            return attribute->getType() != TYPE_STRING && attribute->getType() < TYPE_BOOL_VECTOR;
+        });
 }
 
 template <typename T>
@@ -826,6 +894,12 @@ SceneClass::setGroup(const std::string& groupName, AttributeKey<T> attributeKey)
     mGroupMap.insert(std::make_pair(groupIndex, getAttribute(attributeKey)));
 }
 
+const SceneObjectVector&
+SceneClass::getSceneObjects() const
+{
+    return mSceneObjects;
+}
+
 SceneClass::AttributeConstIterator
 SceneClass::beginAttributes() const
 {
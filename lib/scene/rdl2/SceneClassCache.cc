@@ -0,0 +1,401 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "SceneClassCache.h"
+
+#include "Attribute.h"
+#include "SceneClass.h"
+#include "Types.h"
+#include "ValueContainerDeq.h"
+#include "ValueContainerEnq.h"
+
+#include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/render/util/Strings.h>
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+namespace {
+
+// Bump this whenever the encoding below changes. Files with any other
+// version are ignored.
+const unsigned int sFormatVersion = 2;
+
+// Tag type used to dispatch on an AttributeType at runtime.
+template <typename T>
+struct TypeTag
+{
+    typedef T type;
+};
+
+template <typename F>
+void
+visitAttributeType(AttributeType type, F&& visitor)
+{
+    switch (type) {
+    case TYPE_BOOL:                   visitor(TypeTag<Bool>()); break;
+    case TYPE_INT:                    visitor(TypeTag<Int>()); break;
+    case TYPE_LONG:                   visitor(TypeTag<Long>()); break;
+    case TYPE_FLOAT:                  visitor(TypeTag<Float>()); break;
+    case TYPE_DOUBLE:                 visitor(TypeTag<Double>()); break;
+    case TYPE_STRING:                 visitor(TypeTag<String>()); break;
+    case TYPE_RGB:                    visitor(TypeTag<Rgb>()); break;
+    case TYPE_RGBA:                   visitor(TypeTag<Rgba>()); break;
+    case TYPE_VEC2F:                  visitor(TypeTag<Vec2f>()); break;
+    case TYPE_VEC2D:                  visitor(TypeTag<Vec2d>()); break;
+    case TYPE_VEC3F:                  visitor(TypeTag<Vec3f>()); break;
+    case TYPE_VEC3D:                  visitor(TypeTag<Vec3d>()); break;
+    case TYPE_VEC4F:                  visitor(TypeTag<Vec4f>()); break;
+    case TYPE_VEC4D:                  visitor(TypeTag<Vec4d>()); break;
+    case TYPE_MAT4F:                  visitor(TypeTag<Mat4f>()); break;
+    case TYPE_MAT4D:                  visitor(TypeTag<Mat4d>()); break;
+    case TYPE_SCENE_OBJECT:           visitor(TypeTag<SceneObject*>()); break;
+    case TYPE_BOOL_VECTOR:            visitor(TypeTag<BoolVector>()); break;
+    case TYPE_INT_VECTOR:             visitor(TypeTag<IntVector>()); break;
+    case TYPE_LONG_VECTOR:            visitor(TypeTag<LongVector>()); break;
+    case TYPE_FLOAT_VECTOR:           visitor(TypeTag<FloatVector>()); break;
+    case TYPE_DOUBLE_VECTOR:          visitor(TypeTag<DoubleVector>()); break;
+    case TYPE_STRING_VECTOR:          visitor(TypeTag<StringVector>()); break;
+    case TYPE_RGB_VECTOR:             visitor(TypeTag<RgbVector>()); break;
+    case TYPE_RGBA_VECTOR:            visitor(TypeTag<RgbaVector>()); break;
+    case TYPE_VEC2F_VECTOR:           visitor(TypeTag<Vec2fVector>()); break;
+    case TYPE_VEC2D_VECTOR:           visitor(TypeTag<Vec2dVector>()); break;
+    case TYPE_VEC3F_VECTOR:           visitor(TypeTag<Vec3fVector>()); break;
+    case TYPE_VEC3D_VECTOR:           visitor(TypeTag<Vec3dVector>()); break;
+    case TYPE_VEC4F_VECTOR:           visitor(TypeTag<Vec4fVector>()); break;
+    case TYPE_VEC4D_VECTOR:           visitor(TypeTag<Vec4dVector>()); break;
+    case TYPE_MAT4F_VECTOR:           visitor(TypeTag<Mat4fVector>()); break;
+    case TYPE_MAT4D_VECTOR:           visitor(TypeTag<Mat4dVector>()); break;
+    case TYPE_SCENE_OBJECT_VECTOR:    visitor(TypeTag<SceneObjectVector>()); break;
+    case TYPE_SCENE_OBJECT_INDEXABLE: visitor(TypeTag<SceneObjectIndexable>()); break;
+    default:
+        throw except::TypeError(util::buildString("Unknown attribute type ",
+                static_cast<int>(type), " in SceneClass cache."));
+    }
+}
+
+// Default values. SceneObject defaults can only ever be null or empty (there
+// are no objects to point at during declare()), so nothing is stored for them.
+
+template <typename T>
+void
+enqValue(ValueContainerEnq& enq, const T& value)
+{
+    enq.enq<T>(value);
+}
+
+template <typename T>
+void
+enqValue(ValueContainerEnq& enq, const std::vector<T>& value)
+{
+    enq.enqVector(value);
+}
+
+void enqValue(ValueContainerEnq& enq, const String& value)       { enq.enqString(value); }
+void enqValue(ValueContainerEnq& enq, const BoolVector& value)   { enq.enqBoolVector(value); }
+void enqValue(ValueContainerEnq& enq, const StringVector& value) { enq.enqStringVector(value); }
+void enqValue(ValueContainerEnq&, SceneObject* const&)           {}
+void enqValue(ValueContainerEnq&, const SceneObjectVector&)      {}
+void enqValue(ValueContainerEnq&, const SceneObjectIndexable&)   {}
+
+template <typename T>
+void
+deqValue(ValueContainerDeq& deq, T& value)
+{
+    deq.deq<T>(value);
+}
+
+template <typename T>
+void
+deqValue(ValueContainerDeq& deq, std::vector<T>& value)
+{
+    deq.deqVector(value);
+}
+
+void deqValue(ValueContainerDeq& deq, String& value)       { deq.deqString(value); }
+void deqValue(ValueContainerDeq& deq, BoolVector& value)   { deq.deqBoolVector(value); }
+void deqValue(ValueContainerDeq& deq, StringVector& value) { deq.deqStringVector(value); }
+void deqValue(ValueContainerDeq&, SceneObject*& value)     { value = nullptr; }
+void deqValue(ValueContainerDeq&, SceneObjectVector&)      {}
+void deqValue(ValueContainerDeq&, SceneObjectIndexable&)   {}
+
+std::string
+encodeDeclarations(const SceneClass& sceneClass, SceneObjectInterface declaredInterface,
+                   const std::vector<std::string>& groupNames,
+                   const std::vector<std::pair<std::size_t, const Attribute*>>& groupMembers)
+{
+    std::string bytes;
+    ValueContainerEnq enq(&bytes);
+
+    enqValue(enq, static_cast<Int>(declaredInterface));
+
+    std::unordered_map<const Attribute*, std::size_t> indices;
+    const std::size_t attributeCount =
+        std::distance(sceneClass.beginAttributes(), sceneClass.endAttributes());
+    enq.enqVLSizeT(attributeCount);
+    for (auto iter = sceneClass.beginAttributes(); iter != sceneClass.endAttributes(); ++iter) {
+        const Attribute* attribute = *iter;
+        indices.emplace(attribute, indices.size());
+
+        enq.enqString(attribute->getName());
+        enq.enqStringVector(attribute->getAliases());
+        enq.enqVLUInt(static_cast<unsigned int>(attribute->getType()));
+        enq.enqVLInt(static_cast<int>(attribute->getFlags()));
+        enq.enqVLInt(static_cast<int>(attribute->getObjectType()));
+        visitAttributeType(attribute->getType(), [&](auto tag) {
+            typedef typename decltype(tag)::type T;
+            enqValue(enq, attribute->getDefaultValue<T>());
+        });
+
+        enq.enqVLSizeT(std::distance(attribute->beginMetadata(), attribute->endMetadata()));
+        for (auto item = attribute->beginMetadata(); item != attribute->endMetadata(); ++item) {
+            enq.enqString(item->first);
+            enq.enqString(item->second);
+        }
+
+        enq.enqVLSizeT(std::distance(attribute->beginEnumValues(), attribute->endEnumValues()));
+        for (auto item = attribute->beginEnumValues(); item != attribute->endEnumValues(); ++item) {
+            enq.enqVLInt(item->first);
+            enq.enqString(item->second);
+        }
+    }
+
+    enq.enqStringVector(groupNames);
+    enq.enqVLSizeT(groupMembers.size());
+    for (const auto& member : groupMembers) {
+        enq.enqVLSizeT(member.first);
+        enq.enqVLSizeT(indices.at(member.second));
+    }
+
+    enq.finalize();
+    return bytes;
+}
+
+} // namespace
+
+SceneClassCache::SceneClassCache() :
+    mModified(false)
+{
+}
+
+bool
+SceneClassCache::fileStamp(const std::string& filePath, int64_t& modifiedTime,
+                           uint64_t& fileSize)
+{
+    std::error_code error;
+    const auto time = std::filesystem::last_write_time(filePath, error);
+    if (error) {
+        return false;
+    }
+    const auto size = std::filesystem::file_size(filePath, error);
+    if (error) {
+        return false;
+    }
+    modifiedTime = static_cast<int64_t>(time.time_since_epoch().count());
+    fileSize = static_cast<uint64_t>(size);
+    return true;
+}
+
+const std::string&
+SceneClassCache::libraryStamp()
+{
+    // The built-in base classes (Geometry, Light, etc.) are declared by this
+    // library, so DSO declarations depend on its build as much as on the DSO
+    // itself. Identify the build by the file this code was loaded from.
+    static const std::string stamp = []() {
+        Dl_info info;
+        int64_t modifiedTime;
+        uint64_t fileSize;
+        if (!dladdr(reinterpret_cast<const void*>(&SceneClassCache::libraryStamp), &info) ||
+                !info.dli_fname ||
+                !fileStamp(info.dli_fname, modifiedTime, fileSize)) {
+            return std::string();
+        }
+        return util::buildString(info.dli_fname, ':', modifiedTime, ':', fileSize);
+    }();
+    return stamp;
+}
+
+bool
+SceneClassCache::load(const std::string& filePath)
+{
+    mEntries.clear();
+    mModified = false;
+
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+
+    try {
+        ValueContainerDeq deq(bytes.data(), bytes.size());
+        if (deq.deqVLUInt() != sFormatVersion) {
+            return false;
+        }
+        // A cache written by another build of this library may describe
+        // base class attributes which no longer exist.
+        if (deq.deqString() != libraryStamp()) {
+            return false;
+        }
+
+        const std::size_t entryCount = deq.deqVLSizeT();
+        for (std::size_t i = 0; i < entryCount; ++i) {
+            std::string dsoFilePath = deq.deqString();
+            Entry entry;
+            deq.deq<int64_t>(entry.mModifiedTime);
+            deq.deq<uint64_t>(entry.mFileSize);
+            deq.deqString(entry.mDeclarations);
+            mEntries.emplace(std::move(dsoFilePath), std::move(entry));
+        }
+    } catch (const std::exception&) {
+        // A damaged cache is no worse than a missing one.
+        mEntries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void
+SceneClassCache::save(const std::string& filePath) const
+{
+    std::string bytes;
+    ValueContainerEnq enq(&bytes);
+    enq.enqVLUInt(sFormatVersion);
+    enq.enqString(libraryStamp());
+    enq.enqVLSizeT(mEntries.size());
+    for (const auto& item : mEntries) {
+        enq.enqString(item.first);
+        enq.enq<int64_t>(item.second.mModifiedTime);
+        enq.enq<uint64_t>(item.second.mFileSize);
+        enq.enqString(item.second.mDeclarations);
+    }
+    enq.finalize();
+
+    // Write to a temporary file and rename it into place, so that concurrent
+    // readers never see a partially written cache.
+    const std::string tmpPath = filePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+        if (!out) {
+            throw except::IoError(util::buildString("Failed to write SceneClass cache '",
+                    tmpPath, "'."));
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+        throw except::IoError(util::buildString("Failed to write SceneClass cache '",
+                filePath, "'."));
+    }
+}
+
+bool
+SceneClassCache::restore(const std::string& dsoFilePath, SceneClass& sceneClass) const
+{
+    auto iter = mEntries.find(dsoFilePath);
+    if (iter == mEntries.end()) {
+        return false;
+    }
+
+    int64_t modifiedTime;
+    uint64_t fileSize;
+    if (!fileStamp(dsoFilePath, modifiedTime, fileSize) ||
+            modifiedTime != iter->second.mModifiedTime ||
+            fileSize != iter->second.mFileSize) {
+        return false;
+    }
+
+    try {
+        const std::string& bytes = iter->second.mDeclarations;
+        ValueContainerDeq deq(bytes.data(), bytes.size());
+
+        Int declaredInterface;
+        deqValue(deq, declaredInterface);
+        sceneClass.mDeclaredInterface = static_cast<SceneObjectInterface>(declaredInterface);
+
+        // Declaring the attributes in their original order reproduces the
+        // original indices and storage offsets.
+        const std::size_t attributeCount = deq.deqVLSizeT();
+        for (std::size_t i = 0; i < attributeCount; ++i) {
+            const std::string name = deq.deqString();
+            StringVector aliases;
+            deq.deqStringVector(aliases);
+            const AttributeType type = static_cast<AttributeType>(deq.deqVLUInt());
+            const AttributeFlags flags = static_cast<AttributeFlags>(deq.deqVLInt());
+            const SceneObjectInterface objectType = static_cast<SceneObjectInterface>(deq.deqVLInt());
+            visitAttributeType(type, [&](auto tag) {
+                typedef typename decltype(tag)::type T;
+                T defaultValue;
+                deqValue(deq, defaultValue);
+                sceneClass.declareAttribute<T>(name, defaultValue, flags, objectType, aliases);
+            });
+
+            Attribute* attribute = sceneClass.mAttributes.back();
+            const std::size_t metadataCount = deq.deqVLSizeT();
+            for (std::size_t m = 0; m < metadataCount; ++m) {
+                const std::string key = deq.deqString();
+                attribute->setMetadata(key, deq.deqString());
+            }
+
+            const std::size_t enumCount = deq.deqVLSizeT();
+            for (std::size_t e = 0; e < enumCount; ++e) {
+                const Int value = deq.deqVLInt();
+                attribute->setEnumValue(value, deq.deqString());
+            }
+        }
+
+        deq.deqStringVector(sceneClass.mGroupNames);
+        const std::size_t memberCount = deq.deqVLSizeT();
+        for (std::size_t i = 0; i < memberCount; ++i) {
+            const std::size_t groupIndex = deq.deqVLSizeT();
+            const std::size_t attributeIndex = deq.deqVLSizeT();
+            sceneClass.mGroupMap.emplace(groupIndex, sceneClass.mAttributes.at(attributeIndex));
+        }
+    } catch (const std::exception&) {
+        // Treat an entry we can't decode as missing.
+        return false;
+    }
+
+    return true;
+}
+
+void
+SceneClassCache::store(const std::string& dsoFilePath, const SceneClass& sceneClass)
+{
+    Entry entry;
+    if (!fileStamp(dsoFilePath, entry.mModifiedTime, entry.mFileSize)) {
+        return;
+    }
+
+    std::vector<std::pair<std::size_t, const Attribute*>> groupMembers(
+        sceneClass.mGroupMap.begin(), sceneClass.mGroupMap.end());
+    entry.mDeclarations = encodeDeclarations(sceneClass, sceneClass.mDeclaredInterface,
+                                             sceneClass.mGroupNames, groupMembers);
+
+    mEntries[dsoFilePath] = std::move(entry);
+    mModified = true;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,137 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+class SceneClass;
+
+/**
+ * A SceneClassCache is a persistent record of the attribute declarations of
+ * DSO SceneClasses, so that SceneContext::loadAllSceneClasses() can restore
+ * every SceneClass on the DSO path without dlopen()'ing each library just to
+ * run its declare() function.
+ *
+ * Entries are keyed by the full path to the DSO (or proxy DSO) along with its
+ * modification time and size on disk. If either changes, the entry is treated
+ * as missing and the DSO is loaded and declared normally. What is stored is
+ * everything declare() can record on the SceneClass: the declared interface,
+ * each attribute's name, aliases, type, flags, object type and default value,
+ * its metadata and enum values, and the attribute groups. Class data pointers
+ * (declareDataPtr()) point into the DSO and are not cached.
+ *
+ * A SceneClass restored from the cache has no ObjectFactory. The DSO is
+ * opened and declared for real the first time an object of the class is
+ * created (see SceneClass::createObject()).
+ *
+ * The cache file is written with a ValueContainerEnq and stamped with a format
+ * version and with the path, modification time and size of the scene_rdl2
+ * library which wrote it, since the built-in base classes' declarations come
+ * from that library rather than from the DSO. Unreadable or stale files, or
+ * files written by another build of the library, are ignored rather than
+ * reported, since the cache only ever saves time. Should an entry still turn
+ * out not to match its DSO, the SceneClass is re-declared from the DSO when
+ * its first object is created and the entry is rewritten.
+ *
+ * Thread Safety:
+ *  - None. The SceneContext uses a SceneClassCache from a single thread while
+ *      loading SceneClasses.
+ */
+class SceneClassCache
+{
+public:
+    /// Creates an empty cache.
+    SceneClassCache();
+
+    /**
+     * Reads the cache file at the given path, replacing any entries already
+     * loaded. A missing, truncated, or incompatible file leaves the cache
+     * empty.
+     *
+     * @param   filePath    Path to the cache file.
+     * @return  True if the file was read successfully.
+     */
+    bool load(const std::string& filePath);
+
+    /**
+     * Writes all entries to the cache file at the given path, replacing it.
+     *
+     * @param   filePath    Path to the cache file.
+     * @throw   except::IoError     If the file could not be written.
+     */
+    void save(const std::string& filePath) const;
+
+    /**
+     * Looks up the entry for the given DSO and, if it is still current,
+     * declares the cached attributes on the given (empty) SceneClass. The
+     * SceneClass is not marked complete. If this returns false after
+     * finding an entry (e.g. the entry could not be decoded), the SceneClass
+     * may be partially declared and should be discarded.
+     *
+     * @param   dsoFilePath     Full path to the DSO the class comes from.
+     * @param   sceneClass      The SceneClass to fill in.
+     * @return  True if the SceneClass was restored from the cache.
+     */
+    bool restore(const std::string& dsoFilePath, SceneClass& sceneClass) const;
+
+    /**
+     * Records the declarations of a complete SceneClass which was loaded from
+     * the given DSO, replacing any previous entry for that DSO.
+     *
+     * @param   dsoFilePath     Full path to the DSO the class was loaded from.
+     * @param   sceneClass      The declared SceneClass.
+     */
+    void store(const std::string& dsoFilePath, const SceneClass& sceneClass);
+
+    /// Returns true if entries were stored since the cache was loaded.
+    finline bool isModified() const;
+
+    /// Returns the number of entries in the cache.
+    finline std::size_t size() const;
+
+private:
+    struct Entry
+    {
+        int64_t mModifiedTime;
+        uint64_t mFileSize;
+        std::string mDeclarations; // encoded with a ValueContainerEnq
+    };
+
+    // Reads the modification time and size of a file. Returns false if the
+    // file can't be stat()'d.
+    static bool fileStamp(const std::string& filePath, int64_t& modifiedTime,
+                          uint64_t& fileSize);
+
+    // Identifies the build of the library this code is running from. Empty
+    // if the library file can't be found.
+    static const std::string& libraryStamp();
+
+    std::unordered_map<std::string, Entry> mEntries;
+    bool mModified;
+};
+
+bool
+SceneClassCache::isModified() const
+{
+    return mModified;
+}
+
+std::size_t
+SceneClassCache::size() const
+{
+    return mEntries.size();
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -5,6 +5,7 @@
 #include "SceneContext.h"
 
 #include "Camera.h"
+#include "DisplayFilter.h"
 #include "Dso.h"
 #include "DsoFinder.h"
 #include "Geometry.h"
@@ -20,6 +21,8 @@
 #include "ObjectFactory.h"
 #include "RenderOutput.h"
 #include "SceneClass.h"
+#include "SceneClassCache.h"
+#include "SceneContextSnapshot.h"
 #include "SceneObject.h"
 #include "SceneVariables.h"
 #include "TraceSet.h"
@@ -27,11 +30,11 @@
 
 #include <scene_rdl2/common/platform/Platform.h>
 #include <scene_rdl2/common/except/exceptions.h>
+#include <scene_rdl2/render/util/GetEnv.h>
 #include <scene_rdl2/render/util/Strings.h>
 #include <scene_rdl2/render/logging/logging.h>
 
 #include <tbb/concurrent_hash_map.h>
-#include <tbb/parallel_for_each.h>
 
 #include <algorithm>
 #include <cstddef>
@@ -40,6 +43,8 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include <dirent.h>
@@ -84,14 +89,23 @@ SceneContext::createBuiltInSceneClass(const std::string& className)
         sc->declare();
         sc->setComplete();
         writer->second = sc;
+        mSceneClassGeneration.fetch_add(1, std::memory_order_release);
     }
 }
 
 SceneContext::SceneContext() :
     mProxyModeEnabled(false),
+    mFrozenClassIndex(nullptr),
+    mFrozenObjectIndex(nullptr),
+    mSceneClassGeneration(0),
+    mSceneObjectGeneration(0),
+    mFrozenClassGeneration(0),
+    mFrozenObjectGeneration(0),
     mSceneVariables(nullptr),
+    mDirtyObjects(nullptr),
     mRender2World(nullptr),
-    mDsoPath(DsoFinder::find())
+    mDsoPath(DsoFinder::find()),
+    mSceneClassCachePath(util::getenv<std::string>("RDL2_SCENE_CLASS_CACHE"))
 {
     // Create SceneClasses for builtin types. If you add any new built in
     // types, you must add an explicit instantiation of this function template
@@ -147,6 +161,13 @@ SceneContext::~SceneContext()
 const SceneClass*
 SceneContext::getSceneClass(const std::string& name) const
 {
+    const auto* classIndex = mFrozenClassIndex.load(std::memory_order_acquire);
+    if (classIndex) {
+        if (const SceneClass* sc = classIndex->find(name)) {
+            return sc;
+        }
+    }
+
     SceneClassMap::const_accessor reader;
     if (!mSceneClasses.find(reader, name)) {
         std::stringstream errMsg;
@@ -160,6 +181,13 @@ SceneContext::getSceneClass(const std::string& name) const
 const SceneObject*
 SceneContext::getSceneObject(const std::string& name) const
 {
+    const auto* objectIndex = mFrozenObjectIndex.load(std::memory_order_acquire);
+    if (objectIndex) {
+        if (const SceneObject* obj = objectIndex->find(name)) {
+            return obj;
+        }
+    }
+
     SceneObjectMap::const_accessor reader;
     if (!mSceneObjects.find(reader, name)) {
         std::stringstream errMsg;
@@ -173,6 +201,13 @@ SceneContext::getSceneObject(const std::string& name) const
 SceneObject*
 SceneContext::getSceneObject(const std::string& name)
 {
+    const auto* objectIndex = mFrozenObjectIndex.load(std::memory_order_acquire);
+    if (objectIndex) {
+        if (SceneObject* obj = objectIndex->find(name)) {
+            return obj;
+        }
+    }
+
     SceneObjectMap::const_accessor reader;
     if (!mSceneObjects.find(reader, name)) {
         std::stringstream errMsg;
@@ -293,6 +328,13 @@ SceneContext::createSceneClass(const std::string& className)
     // First, do a quick check for existence. If the class already exists,
     // multiple readers can do this simultaneously.
 
+    const auto* classIndex = mFrozenClassIndex.load(std::memory_order_acquire);
+    if (classIndex) {
+        if (SceneClass* sc = classIndex->find(className)) {
+            return sc;
+        }
+    }
+
     { // Begin reader lock scope.
         SceneClassMap::const_accessor reader;
         
@@ -356,6 +398,7 @@ SceneContext::createSceneClass(const std::string& className)
         // it should be safe to go ahead with the insert.
         MNRY_ASSERT(sc, "SceneClass should never be invalid prior to insertion.");
         writer->second = sc.release();
+        mSceneClassGeneration.fetch_add(1, std::memory_order_release);
     }
 
     // Regardless of whether we created the SceneClass just now because it was
@@ -382,6 +425,14 @@ SceneContext::createSceneObject(const std::string& className,
     // Do a quick check for existence. If the class already exists, multiple
     // readers can do this simultaneously.
 
+    const auto* objectIndex = mFrozenObjectIndex.load(std::memory_order_acquire);
+    if (objectIndex) {
+        if (SceneObject* obj = objectIndex->find(objectName)) {
+            verifyMatchingSceneClass(className, obj);
+            return obj;
+        }
+    }
+
     { // Begin reader lock scope.
         SceneObjectMap::const_accessor reader;
   
@@ -437,6 +488,7 @@ SceneContext::createSceneObject(const std::string& className,
         // it should be safe to go ahead with the insert.
         MNRY_ASSERT(obj, "SceneObject should never be invalid prior to insertion.");
         writer->second = obj;
+        mSceneObjectGeneration.fetch_add(1, std::memory_order_release);
 
         // The containers that are below are not thread safe versions and are not protected
         // by the mSceneObjects write lock since tbb locks per bucket and not per container.
@@ -447,6 +499,11 @@ SceneContext::createSceneObject(const std::string& className,
         // The api exposes the containers and iterators but they should never be used even for reading
         // if other thread is performing modifications to them by calling this function.
 
+        {
+            std::lock_guard lock(mCreateSceneObjectMutex);
+            sc->mSceneObjects.push_back(obj);
+        }
+
         // Do any type-specific setup.
         if (obj->isA<Geometry>()) {
             std::lock_guard lock(mCreateSceneObjectMutex);
@@ -460,7 +517,13 @@ SceneContext::createSceneObject(const std::string& className,
         } else if (obj->isA<RenderOutput>()) {
             std::lock_guard lock(mCreateSceneObjectMutex);
             mRenderOutputs.push_back(obj->asA<RenderOutput>());
-        } 
+        } else if (obj->isA<DisplayFilter>()) {
+            std::lock_guard lock(mCreateSceneObjectMutex);
+            mDisplayFilters.push_back(obj->asA<DisplayFilter>());
+        }
+
+        // New objects are dirty.
+        obj->addToDirtyList();
 
         // Call any on-creation callbacks
         for (auto cb : mCreateCallbacks) {
@@ -534,48 +597,12 @@ SceneContext::applyUpdates(Layer * const layer)
     }
 
     // need to update display filters
-    for (auto& kv : mSceneObjects) {
-        SceneObject* so = kv.second;
-        if(so->isA<DisplayFilter>()) {
-            so->updatePrep(mSceneObjectUpdateGraph, 0);
-        }
+    for (DisplayFilter* displayFilter : mDisplayFilters) {
+        displayFilter->updatePrep(mSceneObjectUpdateGraph, 0);
     }
 
-    // Update all leaves
-    int s = mSceneObjectUpdateGraph.size();
-    if (s == 0){
-        Logger::info("There is no leaf scene object need to be updated");
-    } else if (s == 1) {
-        Logger::info("Updating 1 leaf scene object...");
-    } else {
-        Logger::info("Updating ", s, " leaf scene objects...");
-    } 
-
-    tbb::parallel_for_each(mSceneObjectUpdateGraph.cbegin(), mSceneObjectUpdateGraph.cend(),
-            [&] (SceneObject* const obj)
-    {
-        obj->debug("Updating");
-        obj->update();
-    });
-
-    // Update the objects from bottom up
-    for (int i = mSceneObjectUpdateGraph.getMaxDepth()-1; i >= 0; --i) {
-        int s = mSceneObjectUpdateGraph.size(i);
-        if (s == 0){
-            Logger::info("There is no scene object need to be updated at level ", i);
-        } else if (s == 1) {
-            Logger::info("Updating 1 scene object at level ", i, "...");
-        } else {
-            Logger::info("Updating ", s, " scene objects at level ", i, "...");
-        }
-
-        tbb::parallel_for_each(mSceneObjectUpdateGraph.cbegin(i), mSceneObjectUpdateGraph.cend(i),
-                [&] (SceneObject* const obj)
-        {
-            obj->debug("Updating");
-            obj->update();
-        });
-    }
+    // Update all objects, each as soon as the objects it depends on are done.
+    mSceneObjectUpdateGraph.updateAll();
 
     // Changes in a shader's requested primitive attributes require updating
     // the geometry.
@@ -713,15 +740,81 @@ SceneContext::getUpdatedOrDeformedGeometrySets(Layer * const layer,
 void
 SceneContext::commitAllChanges()
 {
-    std::for_each(mSceneObjects.begin(), mSceneObjects.end(),
-    [](const SceneObjectMapItem& item) {
-        item.second->commitChanges();
-    });
+    // Only objects which were dirtied since the last commit can have anything
+    // to commit.
+    SceneObject* obj = mDirtyObjects.exchange(nullptr, std::memory_order_acquire);
+    while (obj) {
+        SceneObject* next = obj->mNextDirty;
+        obj->mNextDirty = nullptr;
+        obj->mDirtyListed = false;
+        obj->commitChanges();
+        obj = next;
+    }
+
+    freezeNameIndices();
+}
+
+std::unique_ptr<SceneContextSnapshot>
+SceneContext::takeSnapshot(bool dirtyOnly)
+{
+    return std::unique_ptr<SceneContextSnapshot>(new SceneContextSnapshot(*this, dirtyOnly));
+}
+
+void
+SceneContext::addDirtyObject(SceneObject* obj) const
+{
+    SceneObject* head = mDirtyObjects.load(std::memory_order_relaxed);
+    do {
+        obj->mNextDirty = head;
+    } while (!mDirtyObjects.compare_exchange_weak(head, obj, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+}
+
+void
+SceneContext::freezeNameIndices()
+{
+    // Every insertion bumps the generation of its map, so an index built at
+    // the current generation is up to date. The generation is sampled before
+    // walking the map: anything inserted during the walk leaves the index
+    // behind and it is picked up by the next commit.
+    const std::uint64_t classGeneration =
+        mSceneClassGeneration.load(std::memory_order_acquire);
+    if (mClassIndices.empty() || mFrozenClassGeneration != classGeneration) {
+        auto classIndex = std::make_unique<FrozenNameIndex<SceneClass>>(mSceneClasses.size());
+        for (const auto& item : mSceneClasses) {
+            if (item.second) classIndex->insert(item.first, item.second);
+        }
+        // Readers may still be using the previous index, which stays in
+        // mClassIndices until the SceneContext is destroyed.
+        mFrozenClassIndex.store(classIndex.get(), std::memory_order_release);
+        mClassIndices.push_back(std::move(classIndex));
+        mFrozenClassGeneration = classGeneration;
+    }
+
+    const std::uint64_t objectGeneration =
+        mSceneObjectGeneration.load(std::memory_order_acquire);
+    if (mObjectIndices.empty() || mFrozenObjectGeneration != objectGeneration) {
+        auto objectIndex = std::make_unique<FrozenNameIndex<SceneObject>>(mSceneObjects.size());
+        for (const auto& item : mSceneObjects) {
+            if (item.second) objectIndex->insert(item.first, item.second);
+        }
+        mFrozenObjectIndex.store(objectIndex.get(), std::memory_order_release);
+        mObjectIndices.push_back(std::move(objectIndex));
+        mFrozenObjectGeneration = objectGeneration;
+    }
 }
 
 void
 SceneContext::loadAllSceneClasses()
 {
+    // With a cache, unchanged DSOs don't need to be opened at all.
+    const bool useCache = !mSceneClassCachePath.empty();
+    SceneClassCache cache;
+    if (useCache) {
+        cache.load(mSceneClassCachePath);
+    }
+    const std::string extension = (mProxyModeEnabled) ? ".so.proxy" : ".so";
+
     std::string remaining(getDsoPath());
     while (!remaining.empty()) {
         // Grab the next path entry.
@@ -730,19 +823,40 @@ SceneContext::loadAllSceneClasses()
         std::filesystem::path p(directory);
         if (std::filesystem::exists(p)) {
             for (auto const& dirEntry : std::filesystem::directory_iterator(p)) {
-                // If the file is a valid DSO, then create a SceneClass from it.
-                if (Dso::isValidDso(dirEntry.path().string(), mProxyModeEnabled)) {
-                    // Class name is the file name without ".so" (or
-                    // ".so.proxy" in proxy mode).
-                    std::string className;
-                    if (mProxyModeEnabled) {
-                        className = dirEntry.path().stem().stem().string();
-                    } else {
-                        className = dirEntry.path().stem().string();
+                const std::string filePath = dirEntry.path().string();
+
+                // Class name is the file name without ".so" (or
+                // ".so.proxy" in proxy mode).
+                std::string className;
+                if (mProxyModeEnabled) {
+                    className = dirEntry.path().stem().stem().string();
+                } else {
+                    className = dirEntry.path().stem().string();
+                }
+
+                if (useCache && filePath.size() > extension.size() &&
+                        filePath.compare(filePath.size() - extension.size(),
+                                         extension.size(), extension) == 0) {
+                    // A class found earlier in the DSO path wins, just as
+                    // it would in createSceneClass().
+                    if (sceneClassExists(className) ||
+                            restoreCachedSceneClass(cache, className, filePath)) {
+                        continue;
                     }
+                }
 
+                // If the file is a valid DSO, then create a SceneClass from it.
+                if (Dso::isValidDso(filePath, mProxyModeEnabled)) {
                     try {
-                        createSceneClass(className);
+                        const SceneClass* sc = createSceneClass(className);
+
+                        // Only cache the class under this file if this is
+                        // where it was actually loaded from.
+                        std::error_code error;
+                        if (useCache &&
+                                std::filesystem::equivalent(sc->getSourcePath(), filePath, error)) {
+                            cache.store(filePath, *sc);
+                        }
                     } catch (...) {
                         // Swallow exceptions here. If something was wrong with
                         // the declare() function, just move on to the next
@@ -759,6 +873,34 @@ SceneContext::loadAllSceneClasses()
             remaining = "";
         }
     }
+
+    if (useCache && cache.isModified()) {
+        try {
+            cache.save(mSceneClassCachePath);
+        } catch (const except::IoError& e) {
+            // The cache only saves time on the next load.
+            Logger::warn(e.what());
+        }
+    }
+}
+
+bool
+SceneContext::restoreCachedSceneClass(const SceneClassCache& cache, const std::string& className,
+                                      const std::string& dsoFilePath)
+{
+    std::unique_ptr<SceneClass> sc(new SceneClass(this, className, nullptr));
+    if (!cache.restore(dsoFilePath, *sc)) {
+        return false;
+    }
+    sc->deferObjectFactory(dsoFilePath, mProxyModeEnabled);
+    sc->setComplete();
+
+    SceneClassMap::accessor writer;
+    if (mSceneClasses.insert(writer, className)) {
+        writer->second = sc.release();
+        mSceneClassGeneration.fetch_add(1, std::memory_order_release);
+    }
+    return true;
 }
 
 void
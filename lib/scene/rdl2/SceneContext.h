@@ -5,6 +5,7 @@
 #pragma once
 
 #include "Camera.h"
+#include "FrozenNameIndex.h"
 #include "SceneObject.h"
 #include "SceneContext.h"
 #include "SceneVariables.h"
@@ -14,12 +15,19 @@
 #include <scene_rdl2/common/platform/Platform.h>
 #include <tbb/concurrent_hash_map.h>
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
 
+class SceneClassCache;
+class SceneContextSnapshot;
+
 /**
  * The SceneContext represents all the data for a specific scene in RDL. This
  * includes all the objects in the scene (SceneObjects) as well as their types
@@ -47,6 +55,13 @@ namespace rdl2 {
  *      we're inserting the SceneClass or SceneObject into the hash table.
  *      Once the insertion is finished, the lock is released and you can continue
  *      updating the object without holding the lock.
+ *  - commitAllChanges() also freezes a snapshot of both maps into read-only
+ *      name indices. Lookups by name (including the existence check in
+ *      createSceneObject()) consult these first without taking any map lock,
+ *      and only fall back to the hash maps for names created since. The
+ *      indices are published through std::shared_ptr with atomic load/store,
+ *      so lookups may run concurrently with commitAllChanges(): a lookup
+ *      keeps the index it started with alive until it returns.
  *  - SceneClasses and SceneObjects do not synchronize access to themselves,
  *      so writing to these objects must only happen in a single thread. They
  *      are completely self contained, though, so you are free to write to
@@ -96,6 +111,11 @@ public:
     /// Retrieves whether or not the SceneContext is currently in proxy mode.
     finline bool getProxyModeEnabled() const;
 
+    /// Retrieves the path of the SceneClass cache used by loadAllSceneClasses(),
+    /// or an empty string if caching is disabled. Defaults to the value of the
+    /// RDL2_SCENE_CLASS_CACHE environment variable.
+    finline const std::string& getSceneClassCachePath() const;
+
     /// Retrieves the SceneVariables object.
     finline const SceneVariables& getSceneVariables() const;
 
@@ -187,6 +207,15 @@ public:
      */
     finline void setProxyModeEnabled(bool enabled);
 
+    /**
+     * Sets the path of the SceneClass cache file used by loadAllSceneClasses().
+     * An empty path disables caching.
+     *
+     * @param   cachePath   Path to the cache file, which is created if it
+     *                      doesn't exist yet.
+     */
+    finline void setSceneClassCachePath(const std::string& cachePath);
+
     /// Retrieves a mutable reference to the SceneVariables object.
     finline SceneVariables& getSceneVariables();
 
@@ -295,15 +324,43 @@ public:
      * Clears all flags on all attributes of all objects that are tracking
      * what has changed. This effectively puts the SceneContext in its "base"
      * state, where nothing has changed.
+     *
+     * Only objects created or dirtied since the last call are visited, so
+     * the cost scales with the size of the change rather than the scene.
+     *
+     * If SceneClasses or SceneObjects were created since the last call, the
+     * lock free name indices used by lookups are rebuilt as well.
      */
     void commitAllChanges();
 
+    /**
+     * Takes a copy-on-write snapshot of the SceneObjects, which can be read
+     * (e.g. encoded with a BinaryWriter) in another thread while the live
+     * objects carry on being edited. The snapshot keeps each object's set
+     * and update masks and dirty flag, so changes can be committed right
+     * after taking it and the snapshot still delta encodes what changed.
+     * See SceneContextSnapshot.
+     *
+     * No objects may be written to while the snapshot is taken.
+     *
+     * @param   dirtyOnly   Only include the objects which are dirty, which
+     *                      are all a delta encoding BinaryWriter would write.
+     * @return  The snapshot, which must be destroyed before this SceneContext.
+     */
+    std::unique_ptr<SceneContextSnapshot> takeSnapshot(bool dirtyOnly = false);
+
     /**
      * Searches every directory in the DSO path looking for ".so" files and
      * attempts to load them as RDL DSOs. Files that are not successfully
      * opened as RDL DSOs are ignored. This can be used to fill up the SceneClass
      * map with all the available SceneClasses, and then iterate over them
      * exploring their attributes and attribute metadata.
+     *
+     * If a SceneClass cache path is set, DSOs which are unchanged since they
+     * were last cached have their SceneClass restored from the cache without
+     * being opened. Their DSO is only dlopen()'d when the first object of the
+     * class is created. Newly loaded DSOs are added to the cache, which is
+     * then written back out. Failing to write the cache is not an error.
      */
     void loadAllSceneClasses();
 
@@ -347,6 +404,11 @@ private:
     template <typename T>
     void createBuiltInSceneClass(const std::string& className);
 
+    // Creates the named SceneClass from its cached declarations if the cache
+    // has a current entry for the given DSO. Returns false if it doesn't.
+    bool restoreCachedSceneClass(const SceneClassCache& cache, const std::string& className,
+                                 const std::string& dsoFilePath);
+
     // Computes the fast time rescaling coefficients for use by interpolated get().
     // No interpolated gets should be happening on other threads while these are updated.
     void computeTimeRescalingCoeffs(float shutterOpen, float shutterClose, const std::vector<float> &motionSteps);
@@ -368,6 +430,32 @@ private:
     // pointers it contains and is responsible for destroying them.
     SceneObjectMap mSceneObjects;
 
+    // Read-only snapshots of mSceneClasses and mSceneObjects, rebuilt by
+    // commitAllChanges(). Nothing is ever removed from the maps, so entries
+    // never go stale; names created after the snapshot are simply missing.
+    // Published with release and read with acquire ordering, so a lookup is
+    // a single atomic load.
+    std::atomic<const FrozenNameIndex<SceneClass>*> mFrozenClassIndex;
+    std::atomic<const FrozenNameIndex<SceneObject>*> mFrozenObjectIndex;
+
+    // Own every index ever published, current and superseded. A reader may
+    // still be using a superseded one, so they are only freed with the
+    // SceneContext. Only touched by freezeNameIndices().
+    std::vector<std::unique_ptr<const FrozenNameIndex<SceneClass>>> mClassIndices;
+    std::vector<std::unique_ptr<const FrozenNameIndex<SceneObject>>> mObjectIndices;
+
+    // Bumped on every insertion into mSceneClasses / mSceneObjects.
+    std::atomic<std::uint64_t> mSceneClassGeneration;
+    std::atomic<std::uint64_t> mSceneObjectGeneration;
+
+    // The map generations the frozen indices were built at. Only touched by
+    // freezeNameIndices().
+    std::uint64_t mFrozenClassGeneration;
+    std::uint64_t mFrozenObjectGeneration;
+
+    // Rebuilds the frozen name indices if their map generation has moved on.
+    void freezeNameIndices();
+
     // Quick access to the SceneVariables singleton object. This is just an
     // observational pointer. The owner of the SceneVariables object is the
     // SceneObject map.
@@ -375,6 +463,16 @@ private:
 
     GeometryVector mGeometries;
     GeometrySetVector mGeometrySets;
+    std::vector<DisplayFilter*> mDisplayFilters;
+
+    // Intrusive lock free stack of the SceneObjects dirtied since the last
+    // commitAllChanges(), linked through SceneObject::mNextDirty. Objects
+    // push themselves (possibly from several threads at once) the first
+    // time they are dirtied, and commitAllChanges() drains it.
+    mutable std::atomic<SceneObject*> mDirtyObjects;
+
+    // Pushes a SceneObject onto mDirtyObjects. Called by the SceneObject.
+    void addDirtyObject(SceneObject* obj) const;
 
     // We also need a mutex to protect them, since the two SceneObjects could
     // be updated concurrently in different threads. HOWEVER, this does NOT
@@ -418,6 +516,7 @@ private:
 
     RenderOutputVector mRenderOutputs;
     std::string mDsoPath;
+    std::string mSceneClassCachePath;
 
     // DAG of scene objects to update. It is a member variable of SceneContext so that we can call
     // updatePrep on multiple scene objects, or on the same scene object multiple times, without
@@ -449,6 +548,18 @@ SceneContext::setProxyModeEnabled(bool enabled)
     mProxyModeEnabled = enabled;
 }
 
+const std::string&
+SceneContext::getSceneClassCachePath() const
+{
+    return mSceneClassCachePath;
+}
+
+void
+SceneContext::setSceneClassCachePath(const std::string& cachePath)
+{
+    mSceneClassCachePath = cachePath;
+}
+
 const SceneVariables&
 SceneContext::getSceneVariables() const
 {
@@ -464,6 +575,11 @@ SceneContext::getSceneVariables()
 bool
 SceneContext::sceneClassExists(const std::string& name) const
 {
+    const auto* classIndex = mFrozenClassIndex.load(std::memory_order_acquire);
+    if (classIndex && classIndex->find(name)) {
+        return true;
+    }
+
     SceneClassMap::const_accessor reader;
     return mSceneClasses.find(reader, name);
 }
@@ -483,6 +599,11 @@ SceneContext::endSceneClass() const
 bool
 SceneContext::sceneObjectExists(const std::string& name) const
 {
+    const auto* objectIndex = mFrozenObjectIndex.load(std::memory_order_acquire);
+    if (objectIndex && objectIndex->find(name)) {
+        return true;
+    }
+
     SceneObjectMap::const_accessor reader;
     return mSceneObjects.find(reader, name);
 }
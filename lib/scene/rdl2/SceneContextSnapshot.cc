@@ -0,0 +1,36 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#include "SceneContextSnapshot.h"
+
+#include "SceneContext.h"
+#include "SceneObject.h"
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+SceneContextSnapshot::SceneContextSnapshot(const SceneContext& context, bool dirtyOnly) :
+    mContext(context),
+    mDirtyOnly(dirtyOnly)
+{
+    for (SceneContext::SceneObjectConstIterator iter = context.beginSceneObject();
+            iter != context.endSceneObject(); ++iter) {
+        SceneObject* obj = iter->second;
+        if (dirtyOnly && !obj->mDirty) {
+            continue;
+        }
+        mSceneObjects.push_back(new SceneObject(*obj, SceneObject::SnapshotTag()));
+    }
+}
+
+SceneContextSnapshot::~SceneContextSnapshot()
+{
+    for (const SceneObject* obj : mSceneObjects) {
+        delete obj;
+    }
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
@@ -0,0 +1,114 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+
+#pragma once
+
+// Include this before any other includes!
+#include <scene_rdl2/common/platform/Platform.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace rdl2 {
+
+class SceneContext;
+class SceneObject;
+
+/**
+ * A SceneContextSnapshot is a frozen, read-only view of the SceneObjects of a
+ * SceneContext, taken with SceneContext::takeSnapshot(). It lets one thread
+ * read (typically encode with a BinaryWriter) the scene as it was when the
+ * snapshot was taken, while another thread carries on editing the live
+ * objects.
+ *
+ * Taking a snapshot doesn't copy any attribute values. Each object in the
+ * snapshot shares the attribute storage of its live object, and the live
+ * object only copies its storage the first time it is written to afterwards
+ * (copy-on-write). Objects which aren't edited while the snapshot is alive
+ * are never copied. The set and update masks, dirty flag and bindings are
+ * small and are copied when the snapshot is taken.
+ *
+ * Snapshots are meant for pipelining edits and delta encoding:
+ *
+ *      std::unique_ptr<SceneContextSnapshot> snapshot = context.takeSnapshot(true);
+ *      context.commitAllChanges();
+ *      // Encode the snapshot in one thread...
+ *      BinaryWriter writer(*snapshot);
+ *      writer.setDeltaEncoding(true);
+ *      writer.toBytes(manifest, payload);
+ *      // ...while the next batch of edits is applied in another.
+ *
+ * The objects in a snapshot are plain SceneObjects which keep the name,
+ * SceneClass and type of the objects they were copied from, but not their
+ * derived C++ type, so they must not be downcast with asA(). SceneObject
+ * attribute values and bindings still point at the live objects.
+ *
+ * Thread Safety:
+ *  - takeSnapshot() must not run while any objects are being written to.
+ *  - Once taken, a snapshot can be read from any number of threads while the
+ *      live objects are written to, created, and committed.
+ *  - A snapshot must be destroyed before its SceneContext.
+ */
+class SceneContextSnapshot
+{
+public:
+    ~SceneContextSnapshot();
+
+    /// Retrieves the SceneContext the snapshot was taken from.
+    finline const SceneContext& getSceneContext() const;
+
+    /// Returns the frozen SceneObjects, in SceneContext iteration order.
+    finline const std::vector<const SceneObject*>& getSceneObjects() const;
+
+    /// Returns the number of SceneObjects in the snapshot.
+    finline std::size_t size() const;
+
+    /// Returns true if the snapshot only holds the objects which were dirty.
+    finline bool isDirtyOnly() const;
+
+private:
+    // Non-copyable.
+    SceneContextSnapshot(const SceneContextSnapshot&);
+    const SceneContextSnapshot& operator=(const SceneContextSnapshot&);
+
+    // Only SceneContext::takeSnapshot() creates snapshots.
+    SceneContextSnapshot(const SceneContext& context, bool dirtyOnly);
+
+    const SceneContext& mContext;
+    bool mDirtyOnly;
+
+    // The frozen copies, which the snapshot owns.
+    std::vector<const SceneObject*> mSceneObjects;
+
+    friend class SceneContext;
+};
+
+const SceneContext&
+SceneContextSnapshot::getSceneContext() const
+{
+    return mContext;
+}
+
+const std::vector<const SceneObject*>&
+SceneContextSnapshot::getSceneObjects() const
+{
+    return mSceneObjects;
+}
+
+std::size_t
+SceneContextSnapshot::size() const
+{
+    return mSceneObjects.size();
+}
+
+bool
+SceneContextSnapshot::isDirtyOnly() const
+{
+    return mDirtyOnly;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
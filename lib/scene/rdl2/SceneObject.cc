@@ -5,6 +5,7 @@
 #include "SceneObject.h"
 
 #include "Attribute.h"
+#include "LazyAttributeTable.h"
 #include "SceneClass.h"
 #include "SceneContext.h"
 #include "Types.h"
@@ -80,10 +81,14 @@ SceneObject::SceneObject(const SceneClass& sceneClass, const std::string& name)
     mBindingUpdateMask(sceneClass.mAttributes.size()),
     mUpdateActive(false),
     mDirty(true),
+    mDirtyListed(false),
+    mNextDirty(nullptr),
+    mChangeCount(0),
     mUpdatePrepApplied(false),
     mAttributeTreeChanged(false),
     mBindingTreeChanged(false),
-    mUpdateRequested(false)
+    mUpdateRequested(false),
+    mStorageRefCount(nullptr)
 {
     mAttributeStorage = mSceneClass.createStorage();
     mAttributeUpdateMask.set(); // all attributes just got set to defaults
@@ -97,12 +102,136 @@ SceneObject::SceneObject(const SceneClass& sceneClass, const std::string& name)
     }
 }
 
+SceneObject::SceneObject(SceneObject& source, SnapshotTag) :
+    mAttributeStorage(source.mAttributeStorage),
+    mBindings(nullptr),
+    mSceneClass(source.mSceneClass),
+    mName(source.mName),
+    mType(source.mType),
+    mAttributeSetMask(source.mAttributeSetMask),
+    mBindingSetMask(source.mBindingSetMask),
+    mAttributeUpdateMask(source.mAttributeUpdateMask),
+    mBindingUpdateMask(source.mBindingUpdateMask),
+    mUpdateActive(false),
+    mDirty(source.mDirty),
+    mDirtyListed(false),
+    mNextDirty(nullptr),
+    mChangeCount(source.mChangeCount),
+    mUpdatePrepApplied(false),
+    mAttributeTreeChanged(false),
+    mBindingTreeChanged(false),
+    mUpdateRequested(false),
+    mStorageRefCount(nullptr)
+{
+    // Deferred values point into the storage, so they have to land before it
+    // is shared. Later setLazy() calls on the source unshare it first.
+    if (source.mLazyAttributes) {
+        source.mLazyAttributes->materializeAll();
+    }
+
+    if (!source.mStorageRefCount) {
+        source.mStorageRefCount = new std::atomic<uint32_t>(1);
+    }
+    mStorageRefCount = source.mStorageRefCount;
+    mStorageRefCount->fetch_add(1, std::memory_order_relaxed);
+
+    const std::size_t numAttributes = mSceneClass.mAttributes.size();
+    mBindings = new SceneObject*[numAttributes];
+    for (std::size_t i = 0; i < numAttributes; i++) {
+        mBindings[i] = source.mBindings[i];
+    }
+}
+
 SceneObject::~SceneObject()
 {
-    mSceneClass.destroyStorage(mAttributeStorage);
+    if (mStorageRefCount) {
+        releaseSharedStorage();
+    } else {
+        mSceneClass.destroyStorage(mAttributeStorage);
+    }
     delete[] mBindings; 
 }
 
+void
+SceneObject::unshareStorage()
+{
+    // Once every snapshot has let go, the storage is ours alone again. New
+    // references are only taken by the thread writing to this object, so
+    // the count can't go back up behind our back.
+    if (mStorageRefCount->load(std::memory_order_acquire) == 1) {
+        delete mStorageRefCount;
+        mStorageRefCount = nullptr;
+        return;
+    }
+
+    void* storage = mSceneClass.copyStorage(mAttributeStorage);
+    releaseSharedStorage();
+    mAttributeStorage = storage;
+}
+
+void
+SceneObject::releaseSharedStorage()
+{
+    if (mStorageRefCount->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        mSceneClass.destroyStorage(mAttributeStorage);
+        delete mStorageRefCount;
+    }
+    mStorageRefCount = nullptr;
+}
+
+void
+SceneObject::addToDirtyList()
+{
+    // Objects created outside of a SceneContext have nowhere to go, and
+    // nothing would commit them anyway.
+    const SceneContext* context = mSceneClass.getSceneContext();
+    if (context) {
+        mDirtyListed = true;
+        context->addDirtyObject(this);
+    }
+}
+
+void
+SceneObject::getDependencies(std::vector<SceneObject*>& dependencies) const
+{
+    const std::size_t n = mSceneClass.mAttributes.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        const Attribute* const attribute = mSceneClass.mAttributes[i];
+        switch (attribute->getType()) {
+        case TYPE_SCENE_OBJECT:
+            {
+                SceneObject* const object = get(AttributeKey<SceneObject*>(*attribute));
+                if (object) {
+                    dependencies.push_back(object);
+                }
+            }
+            break;
+
+        case TYPE_SCENE_OBJECT_VECTOR:
+            for (SceneObject* const object : get(AttributeKey<SceneObjectVector>(*attribute))) {
+                if (object) {
+                    dependencies.push_back(object);
+                }
+            }
+            break;
+
+        case TYPE_SCENE_OBJECT_INDEXABLE:
+            for (SceneObject* const object : get(AttributeKey<SceneObjectIndexable>(*attribute))) {
+                if (object) {
+                    dependencies.push_back(object);
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+        if (attribute->isBindable() && mBindings[i]) {
+            dependencies.push_back(mBindings[i]);
+        }
+    }
+}
+
 SceneObjectInterface
 SceneObject::declare(SceneClass& /*sceneClass*/)
 {
@@ -154,6 +283,8 @@ T
 SceneObject::get(AttributeKey<T> key, float t) const
 {
     // If the attribute isn't blurrable, it's constant at all timesteps.
+    materializeLazyAttribute(key.mIndex);
+
     if (!key.isBlurrable()) {
         return SceneClass::getValue(mAttributeStorage, key, TIMESTEP_BEGIN);
     }
@@ -181,6 +312,9 @@ SceneObject::set(AttributeKey<T> key, const T& value)
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     int timestep = TIMESTEP_BEGIN;
     bool changed = false;
     do {
@@ -191,7 +325,7 @@ SceneObject::set(AttributeKey<T> key, const T& value)
     if (changed) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -207,6 +341,9 @@ SceneObject::setSequenceContainer(AttributeKey<Container> key, const Container&
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     // Type check each value in the vector against the attribute's object type.
     for (typename Container::const_iterator iter = value.begin();
          iter != value.end(); ++iter) {
@@ -230,7 +367,7 @@ SceneObject::setSequenceContainer(AttributeKey<Container> key, const Container&
     if (changed) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -259,6 +396,9 @@ SceneObject::set(AttributeKey<SceneObject*> key, SceneObject* value)
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     // Type check the value against the attribute's object type.
     if (value && !value->isA(key.mObjectType)) {
         std::stringstream errMsg;
@@ -279,7 +419,7 @@ SceneObject::set(AttributeKey<SceneObject*> key, SceneObject* value)
     if (changed) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -295,6 +435,9 @@ SceneObject::set(AttributeKey<T> key, const T& value, AttributeTimestep timestep
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     // If the attribute isn't blurrable, it's constant at all timesteps.
     if (!key.isBlurrable()) {
         timestep = TIMESTEP_BEGIN;
@@ -303,7 +446,7 @@ SceneObject::set(AttributeKey<T> key, const T& value, AttributeTimestep timestep
     if (SceneClass::setValue(mAttributeStorage, key, timestep, value)) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -319,6 +462,9 @@ SceneObject::setSequenceContainer(AttributeKey<Container> key, const Container&
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     // Type check each value in the vector against the attribute's object type.
     for (typename Container::const_iterator iter = value.begin();
          iter != value.end(); ++iter) {
@@ -340,7 +486,7 @@ SceneObject::setSequenceContainer(AttributeKey<Container> key, const Container&
     if (SceneClass::setValue(mAttributeStorage, key, timestep, value)) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -369,6 +515,9 @@ SceneObject::set(AttributeKey<SceneObject*> key, SceneObject* value, AttributeTi
         throw except::RuntimeError(errMsg.str());
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
     // Type check the value against the attribute's object type.
     if (value && !value->isA(key.mObjectType)) {
         std::stringstream errMsg;
@@ -387,7 +536,7 @@ SceneObject::set(AttributeKey<SceneObject*> key, SceneObject* value, AttributeTi
     if (SceneClass::setValue(mAttributeStorage, key, timestep, value)) {
         mAttributeSetMask.set(key.mIndex, true);
         mAttributeUpdateMask.set(key.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
@@ -581,7 +730,7 @@ SceneObject::setBinding(uint32_t index, bool bindable,
     mBindings[index] = sceneObject;
     mBindingSetMask.set(index, true);
     mBindingUpdateMask.set(index, true);
-    mDirty = true;
+    setDirty();
 }
 
 template <typename T>
@@ -615,6 +764,10 @@ SceneObject::copyValues(const Attribute& attr, const SceneObject& source)
                 "' can only be copied into between beginUpdate() and endUpdate() calls."));
     }
 
+    prepareStorageWrite();
+    materializeLazyAttribute(attr.mIndex);
+    source.materializeLazyAttribute(attr.mIndex);
+
     int timestep = TIMESTEP_BEGIN;
     bool changed = false;
     do {
@@ -627,10 +780,54 @@ SceneObject::copyValues(const Attribute& attr, const SceneObject& source)
     if (changed) {
         mAttributeSetMask.set(attr.mIndex, true);
         mAttributeUpdateMask.set(attr.mIndex, true);
-        mDirty = true;
+        setDirty();
     }
 }
 
+void
+SceneObject::materializeLazyAttribute(uint32_t index) const
+{
+    if (mLazyAttributes) {
+        mLazyAttributes->materialize(index);
+    }
+}
+
+template <typename T>
+void
+SceneObject::setLazy(AttributeKey<T> key, const void* data, std::size_t count,
+                     AttributeTimestep timestep, const std::shared_ptr<const void>& owner)
+{
+    if (!mUpdateActive) {
+        std::stringstream errMsg;
+        errMsg << "Attribute '" << mSceneClass.getAttribute(key)->getName() <<
+            "' of SceneObject '" << mName << "' can only be set between"
+            " beginUpdate() and endUpdate() calls.";
+        throw except::RuntimeError(errMsg.str());
+    }
+
+    // If the attribute isn't blurrable, it's constant at all timesteps.
+    if (!key.isBlurrable()) {
+        timestep = TIMESTEP_BEGIN;
+    }
+
+    // An earlier deferred value for the same attribute must not land on top
+    // of this one later, and this one must not land in a snapshot's storage.
+    prepareStorageWrite();
+    materializeLazyAttribute(key.mIndex);
+
+    if (!mLazyAttributes) {
+        mLazyAttributes.reset(new LazyAttributeTable);
+    }
+    mLazyAttributes->add(key.mIndex, &SceneClass::getValue(mAttributeStorage, key, timestep),
+                         data, count, &LazyAttributeTable::decodeVector<T>, owner);
+
+    // We can't tell whether the value differs without decoding it, so assume
+    // it does.
+    mAttributeSetMask.set(key.mIndex, true);
+    mAttributeUpdateMask.set(key.mIndex, true);
+    setDirty();
+}
+
 void
 SceneObject::copyAll(const SceneObject& source)
 {
@@ -880,6 +1077,33 @@ template void SceneObject::resetToDefault(AttributeKey<Mat4dVector>);
 template void SceneObject::resetToDefault(AttributeKey<SceneObjectVector>);
 template void SceneObject::resetToDefault(AttributeKey<SceneObjectIndexable>);
 
+// Explicit instantiations of setLazy() for vector types the BinaryReader can
+// defer.
+template void SceneObject::setLazy(AttributeKey<FloatVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<DoubleVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<RgbVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<RgbaVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec2fVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec2dVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec3fVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec3dVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec4fVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Vec4dVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Mat4fVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+template void SceneObject::setLazy(AttributeKey<Mat4dVector>, const void*, std::size_t,
+                                    AttributeTimestep, const std::shared_ptr<const void>&);
+
 template bool SceneObject::isDefault(AttributeKey<Bool>) const;
 template bool SceneObject::isDefault(AttributeKey<Int>) const;
 template bool SceneObject::isDefault(AttributeKey<int64_t>) const;
@@ -18,6 +18,7 @@
 #include <boost/dynamic_bitset.hpp>
 
 
+#include <atomic>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -42,6 +43,9 @@ using logging::Logger;
 
 namespace rdl2 {
 
+class LazyAttributeTable;
+class SceneContextSnapshot;
+
 // Forward declarations necessary for unit tests.
 namespace unittest {
     class TestSceneObject;
@@ -961,6 +965,16 @@ private:
     SceneObject(const SceneObject&);
     const SceneObject& operator=(const SceneObject&);
 
+    // Selects the snapshot constructor below.
+    struct SnapshotTag {};
+
+    // Creates a read-only copy of the given object for a SceneContextSnapshot.
+    // The copy shares the source's attribute storage (see mStorageRefCount)
+    // and copies its name, type, masks, dirty flag and bindings. It is a plain
+    // SceneObject whatever the source's derived type is, so it must not be
+    // downcast with asA().
+    SceneObject(SceneObject& source, SnapshotTag);
+
     // Utility function for testing types when we must fall back on the runtime
     // type. Not exposed publicly because you really shouldn't need it.
     finline bool isA(SceneObjectInterface type) const;
@@ -1035,6 +1049,28 @@ private:
     // This is used by the SceneObject writers to decide what objects to 
     // serialize, not by updatePrep().
     bool mDirty;
+
+    // Whether this object is on its SceneContext's list of objects dirtied
+    // since the last commitAllChanges(), and the next object on that list.
+    // This lets commitAllChanges() visit only the objects that changed.
+    bool mDirtyListed;
+    SceneObject* mNextDirty;
+
+    // Incremented every time the object is marked dirty. Derived objects which
+    // keep data derived from their attributes (see Layer) compare it against a
+    // saved count to notice changes made through set().
+    uint32_t mChangeCount;
+
+    // Marks the object dirty and puts it on the SceneContext's dirty list.
+    finline void setDirty();
+
+    // Adds this object to the SceneContext's dirty list.
+    void addToDirtyList();
+
+    // Appends the non-null SceneObjects referenced by this object's
+    // SceneObject attributes and bindings, which is what updatePrep() walks.
+    // May contain duplicates.
+    void getDependencies(std::vector<SceneObject*>& dependencies) const;
     
     // Tracks whether updatePrep() has been called on this object since the
     // last resetUpdate() call. Keeps the updatePrep() call tree from going
@@ -1054,6 +1090,40 @@ private:
     //  updated.  (E.g. a displacement assignment in a layer.)
     bool mUpdateRequested;
 
+    // Attribute values read from RDL binary which haven't been copied into
+    // attribute storage yet. Null unless the BinaryReader deferred some.
+    std::unique_ptr<LazyAttributeTable> mLazyAttributes;
+
+    // Copies any deferred values of the attribute with the given index into
+    // attribute storage.
+    void materializeLazyAttribute(uint32_t index) const;
+
+    // Records that the value of an attribute at the given timestep is still
+    // encoded as count raw elements at data, which owner keeps alive. The
+    // value is treated as set and is copied into attribute storage when the
+    // attribute is first accessed.
+    template <typename T>
+    void setLazy(AttributeKey<T> key, const void* data, std::size_t count,
+                 AttributeTimestep timestep, const std::shared_ptr<const void>& owner);
+
+    // Reference count of the attribute storage while it is shared with the
+    // copies held by SceneContextSnapshots. Null while the object owns its
+    // storage outright, which is the usual case. The last owner to let go
+    // destroys the storage.
+    std::atomic<uint32_t>* mStorageRefCount;
+
+    // Makes sure no snapshot shares the attribute storage before it is
+    // written to. Every path which writes to the storage calls this first.
+    finline void prepareStorageWrite();
+
+    // Gives this object storage of its own, copying it if a snapshot still
+    // holds the shared storage.
+    void unshareStorage();
+
+    // Drops this object's reference to shared storage, destroying the storage
+    // if it was the last one.
+    void releaseSharedStorage();
+
     // Classes requiring access for serialization.
     friend class AsciiWriter;
     friend class BinaryWriter;
@@ -1069,6 +1139,15 @@ private:
     friend class Metadata;
     friend class TraceSet;
 
+    // Maintains the dirty list.
+    friend class SceneContext;
+
+    // Creates the read-only copies of objects.
+    friend class SceneContextSnapshot;
+
+    // Schedules updates by dependency.
+    friend class UpdateHelper;
+
     // Classes requiring access for testing.
     friend class unittest::TestSceneObject;
 };
@@ -1102,6 +1181,7 @@ template <typename T>
 const T&
 SceneObject::get(AttributeKey<T> key) const
 {
+    if (mLazyAttributes) materializeLazyAttribute(key.mIndex);
     return SceneClass::getValue(mAttributeStorage, key, TIMESTEP_BEGIN);
 }
 
@@ -1109,6 +1189,8 @@ template <typename T>
 const T&
 SceneObject::get(AttributeKey<T> key, AttributeTimestep timestep) const
 {
+    if (mLazyAttributes) materializeLazyAttribute(key.mIndex);
+
     // If the attribute isn't blurrable, it's constant at all timesteps.
     if (!key.isBlurrable()) {
         timestep = TIMESTEP_BEGIN;
@@ -1141,6 +1223,8 @@ template <typename T>
 T&
 SceneObject::getMutable(AttributeKey<T> key)
 {
+    prepareStorageWrite();
+    if (mLazyAttributes) materializeLazyAttribute(key.mIndex);
     return SceneClass::getValue(mAttributeStorage, key, TIMESTEP_BEGIN);
 }
 
@@ -1148,6 +1232,9 @@ template <typename T>
 T&
 SceneObject::getMutable(AttributeKey<T> key, AttributeTimestep timestep)
 {
+    prepareStorageWrite();
+    if (mLazyAttributes) materializeLazyAttribute(key.mIndex);
+
     // If the attribute isn't blurrable, it's constant at all timesteps.
     if (!key.isBlurrable()) {
         timestep = TIMESTEP_BEGIN;
@@ -1227,6 +1314,24 @@ SceneObject::hasBindingChanged(const Attribute* attribute) const
     return mBindingUpdateMask.test(attribute->mIndex);
 }
 
+void
+SceneObject::prepareStorageWrite()
+{
+    if (mStorageRefCount) {
+        unshareStorage();
+    }
+}
+
+void
+SceneObject::setDirty()
+{
+    mDirty = true;
+    ++mChangeCount;
+    if (!mDirtyListed) {
+        addToDirtyList();
+    }
+}
+
 void
 SceneObject::commitChanges()
 {
@@ -1241,7 +1346,7 @@ SceneObject::markAttributeChanged(const Attribute* attribute)
 {
         mAttributeSetMask.set(attribute->mIndex, true);
         mAttributeUpdateMask.set(attribute->mIndex, true);
-        mDirty = true;
+        setDirty();
 }
 
 namespace {
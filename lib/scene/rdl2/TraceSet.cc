@@ -78,7 +78,7 @@ TraceSet::assign(Geometry* geometry, const String& partName)
     mAttributeUpdateMask.set(sPartsKey.mIndex, true);
     mAttributeSetMask.set(sGeometriesKey.mIndex, true);
     mAttributeSetMask.set(sPartsKey.mIndex, true);
-    mDirty = true;
+    setDirty();
 
     return geometries.size() - 1;
 }
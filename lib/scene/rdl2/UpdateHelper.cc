@@ -0,0 +1,195 @@
+// Copyright 2023-2024 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+// SceneObject.h includes UpdateHelper.h and needs it complete, so it has to
+// come first.
+#include "SceneObject.h"
+#include "UpdateHelper.h"
+
+#include <scene_rdl2/render/logging/logging.h>
+
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace scene_rdl2 {
+
+using logging::Logger;
+
+namespace rdl2 {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct UpdateNode
+{
+    SceneObject* mObject;
+    int mDepth;
+    std::atomic<int> mPending;          // dependencies not updated yet
+    std::vector<std::size_t> mDependents;
+    std::size_t mFinished;              // position in the order updates finished in
+    Clock::time_point mStart;
+    Clock::time_point mEnd;
+};
+
+double
+milliseconds(Clock::duration d)
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // namespace
+
+UpdateHelper::Timings
+UpdateHelper::updateAll() const
+{
+    // Number the objects: leaves first, then the levels from the deepest up,
+    // which is also the order the levels were updated in before.
+    const std::size_t count = mDepthMap.size();
+    std::unique_ptr<UpdateNode[]> nodes(new UpdateNode[count]);
+    std::unordered_map<SceneObject*, std::size_t> indices;
+    indices.reserve(count);
+    std::size_t n = 0;
+    for (SceneObject* obj : mDagLeaves) {
+        nodes[n].mObject = obj;
+        nodes[n].mDepth = -1;
+        indices[obj] = n++;
+    }
+    for (int depth = static_cast<int>(mDagLevels.size()) - 1; depth >= 0; --depth) {
+        for (SceneObject* obj : mDagLevels[depth]) {
+            nodes[n].mObject = obj;
+            nodes[n].mDepth = depth;
+            indices[obj] = n++;
+        }
+    }
+    MNRY_ASSERT(n == count);
+
+    // Connect every object to the objects it depends on which need updating
+    // too. Dependencies outside of the graph didn't change, and neither did
+    // anything they depend on, so there is nothing to wait for there.
+    std::vector<SceneObject*> dependencies;
+    for (std::size_t i = 0; i < count; ++i) {
+        nodes[i].mPending = 0;
+        dependencies.clear();
+        nodes[i].mObject->getDependencies(dependencies);
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+        for (SceneObject* dependency : dependencies) {
+            auto it = indices.find(dependency);
+            if (it != indices.end() && it->second != i) {
+                nodes[it->second].mDependents.push_back(i);
+                ++nodes[i].mPending;
+            }
+        }
+    }
+
+    // Each finished update releases its dependents, and the last dependency
+    // of an object to finish schedules it.
+    const Clock::time_point start = Clock::now();
+    std::atomic<std::size_t> finished(0);
+    tbb::task_group tasks;
+    std::function<void(std::size_t)> run = [&](std::size_t i) {
+        UpdateNode& node = nodes[i];
+        node.mStart = Clock::now();
+        node.mObject->debug("Updating");
+        node.mObject->update();
+        node.mEnd = Clock::now();
+        node.mFinished = finished++;
+        for (std::size_t dependent : node.mDependents) {
+            if (--nodes[dependent].mPending == 0) {
+                tasks.run([&run, dependent] { run(dependent); });
+            }
+        }
+    };
+    for (std::size_t i = 0; i < count; ++i) {
+        if (nodes[i].mPending == 0) {
+            tasks.run([&run, i] { run(i); });
+        }
+    }
+    tasks.wait();
+
+    // Objects caught in a dependency cycle never become ready. The scene
+    // graph should never have one, but if it does, update them the way the
+    // levels used to rather than silently skipping them.
+    if (finished < count) {
+        Logger::warn("Cyclic SceneObject dependencies, updating ", count - finished,
+                     " scene objects in level order");
+        for (std::size_t i = 0; i < count; ++i) {
+            UpdateNode& node = nodes[i];
+            if (node.mPending > 0) {
+                node.mStart = Clock::now();
+                node.mObject->debug("Updating");
+                node.mObject->update();
+                node.mEnd = Clock::now();
+                node.mFinished = finished++;
+            }
+        }
+    }
+    const Clock::time_point end = Clock::now();
+
+    // Gather the timings. Every object finished after all of its
+    // dependencies, so one pass in that order finds the longest chain ending
+    // at every object.
+    Timings timings;
+    timings.mWall = milliseconds(end - start);
+    timings.mCriticalPath = 0.0;
+    timings.mCriticalPathLength = 0;
+
+    std::vector<std::size_t> finishOrder(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        finishOrder[nodes[i].mFinished] = i;
+    }
+    std::vector<double> chain(count, 0.0);
+    std::vector<std::size_t> chainLength(count, 0);
+    for (std::size_t i : finishOrder) {
+        const UpdateNode& node = nodes[i];
+        const double duration = milliseconds(node.mEnd - node.mStart);
+        chain[i] += duration;
+        chainLength[i] += 1;
+        if (chain[i] > timings.mCriticalPath) {
+            timings.mCriticalPath = chain[i];
+            timings.mCriticalPathLength = chainLength[i];
+        }
+        for (std::size_t dependent : node.mDependents) {
+            if (chain[i] > chain[dependent]) {
+                chain[dependent] = chain[i];
+                chainLength[dependent] = chainLength[i];
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const UpdateNode& node = nodes[i];
+        const double duration = milliseconds(node.mEnd - node.mStart);
+        if (timings.mLevels.empty() || timings.mLevels.back().mDepth != node.mDepth) {
+            timings.mLevels.push_back(LevelTimings{node.mDepth, 0, 0.0, 0.0});
+        }
+        LevelTimings& level = timings.mLevels.back();
+        ++level.mCount;
+        level.mTotal += duration;
+        level.mLongest = std::max(level.mLongest, duration);
+    }
+
+    for (const LevelTimings& level : timings.mLevels) {
+        if (level.mDepth < 0) {
+            Logger::info("Updated ", level.mCount, " leaf scene objects in ", level.mTotal,
+                         " ms total, longest ", level.mLongest, " ms");
+        } else {
+            Logger::info("Updated ", level.mCount, " scene objects at level ", level.mDepth,
+                         " in ", level.mTotal, " ms total, longest ", level.mLongest, " ms");
+        }
+    }
+    Logger::info("Updated ", count, " scene objects in ", timings.mWall, " ms, critical path ",
+                 timings.mCriticalPath, " ms through ", timings.mCriticalPathLength, " objects");
+
+    return timings;
+}
+
+} // namespace rdl2
+} // namespace scene_rdl2
+
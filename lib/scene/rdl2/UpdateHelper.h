@@ -7,6 +7,7 @@
 
 #include <scene_rdl2/common/platform/Platform.h>
 
+#include <cstddef>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
@@ -28,13 +29,14 @@ namespace rdl2 {
  *
  *    Check updatePrep() function in SceneObject.h for more details
  *
- * 2. Call update() on all objects which need update level by level from
- *    the deepest level to shallow ones. For the objects which have the same
- *    depth, update() will be called in parallel.
+ * 2. Call update() on all objects which need update, see updateAll(). Each
+ *    object is updated as soon as the objects it depends on (its SceneObject
+ *    attributes and bindings which are also in the graph) have been, so
+ *    independent branches of the DAG never wait on each other. The levels
+ *    are still used to report timings.
  *
  * 3. Leaves in DAG are the nodes which do not have any dependencies. Leaves
- *    are treated seperately here. All leaves can be updated in parallel before
- *    other nodes in DAG.
+ *    are treated seperately here. All leaves can be updated right away.
  *
  * Definition of depth of a level
  * -2 : not found, hasn't been recorded
@@ -87,9 +89,31 @@ public:
     typedef typename ObjectSet::const_iterator const_iterator;
     typedef typename DagLeaves::const_iterator const_leaves_iterator;
 
+    // Timings of the last updateAll() call, in milliseconds.
+    struct LevelTimings
+    {
+        int mDepth;             // -1 for the leaves
+        std::size_t mCount;     // number of objects updated
+        double mTotal;          // sum of the update() times
+        double mLongest;        // longest single update()
+    };
+
+    struct Timings
+    {
+        std::vector<LevelTimings> mLevels;  // leaves first, then deepest to shallowest
+        double mWall;                       // start of the first to end of the last update()
+        double mCriticalPath;               // longest chain of dependent update() calls
+        std::size_t mCriticalPathLength;    // number of objects on that chain
+    };
+
     UpdateHelper(){};
     ~UpdateHelper(){};
 
+    // Calls update() on every object in the graph, in parallel, once all of
+    // the objects it depends on have been updated. Logs and returns timings
+    // per level and for the critical path.
+    Timings updateAll() const;
+
     // insert an object to mDagLevels. if this object has already been inserted
     // before, we compare the current depth and the depth recorded before. if
     // the current depth is deeper, we update depth.
@@ -146,6 +146,18 @@ public:
         }
     }
 
+    // Steps over a vector encoded by enqVector() without copying it. Returns the
+    // address of the (possibly unaligned) element data and sets size to the
+    // number of elements.
+    template <typename T> const void *
+    skipVector(size_t &size)
+    {
+        unsigned long ul;
+        updateCurrPtr(ValueContainerUtil::variableLengthDecoding(mCurrPtr, ul));
+        size = static_cast<size_t>(ul);
+        return skipByteData(sizeof(typename T::value_type) * size);
+    }
+
     inline void deqBoolVector(BoolVector &vec);
     inline void deqIntVector(IntVector &vec)       { deqVector<IntVector>(vec); }
     inline void deqUIntVector(UIntVector &vec)     { deqVector<UIntVector>(vec); }
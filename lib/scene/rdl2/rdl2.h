@@ -32,6 +32,8 @@
  *      or file.
  *  - BinaryReader: Can deserialize an RDL SceneContext from a binary byte
  *      stream or file.
+ *  - BinaryStreamReader: Can deserialize framed RDL binary incrementally, as
+ *      the bytes arrive.
  *  - Asset, Camera, Geometry, Light, Map, Material, etc.: Derived classes of
  *      SceneObject that declare specific attributes or provide useful methods
  *      that the renderer can call.
@@ -89,8 +91,11 @@
 #include "AsciiReader.h"
 #include "AsciiWriter.h"
 #include "Attribute.h"
+#include "AttributeBatch.h"
+#include "AttributeColumn.h"
 #include "AttributeKey.h"
 #include "BinaryReader.h"
+#include "BinaryStreamReader.h"
 #include "BinaryWriter.h"
 #include "Camera.h"
 #include "CommonAttributes.h"
@@ -117,6 +122,7 @@
 #include "RootShader.h"
 #include "SceneClass.h"
 #include "SceneContext.h"
+#include "SceneContextSnapshot.h"
 #include "SceneObject.h"
 #include "SceneVariables.h"
 #include "Shader.h"
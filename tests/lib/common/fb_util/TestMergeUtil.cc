@@ -0,0 +1,166 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "TestMergeUtil.h"
+
+#include <scene_rdl2/common/fb_util/MergeUtil.h>
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// If comment out following directive, all unitTest do timing test.
+// Each unittest needs almost 128x longer execution cost.
+//#define TIMING_TEST
+
+namespace scene_rdl2 {
+namespace fb_util {
+namespace unittest {
+
+static constexpr int sTilePix = 64; // 8x8 pixels, we can not change tile resolution
+
+void
+TestMergeUtil::testAccumulateNumSample()
+{
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloatNumSample", 1,
+                                 MergeUtil::accumulateTileFloatNumSample_SISD,
+                                 MergeUtil::accumulateTileFloatNumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat2NumSample", 2,
+                                 MergeUtil::accumulateTileFloat2NumSample_SISD,
+                                 MergeUtil::accumulateTileFloat2NumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat3NumSample", 3,
+                                 MergeUtil::accumulateTileFloat3NumSample_SISD,
+                                 MergeUtil::accumulateTileFloat3NumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat4NumSample", 4,
+                                 MergeUtil::accumulateTileFloat4NumSample_SISD,
+                                 MergeUtil::accumulateTileFloat4NumSample_SIMD));
+}
+
+void
+TestMergeUtil::testAccumulateClosestFilter()
+{
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat2ClosestFilter", 2,
+                                 MergeUtil::accumulateTileFloat2ClosestFilter_SISD,
+                                 MergeUtil::accumulateTileFloat2ClosestFilter_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat3ClosestFilter", 3,
+                                 MergeUtil::accumulateTileFloat3ClosestFilter_SISD,
+                                 MergeUtil::accumulateTileFloat3ClosestFilter_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("accumulateTileFloat4ClosestFilter", 4,
+                                 MergeUtil::accumulateTileFloat4ClosestFilter_SISD,
+                                 MergeUtil::accumulateTileFloat4ClosestFilter_SIMD));
+}
+
+void
+TestMergeUtil::testCopyNumSample()
+{
+    CPPUNIT_ASSERT(testMergeTile("copyTileFloatNumSample", 1,
+                                 MergeUtil::copyTileFloatNumSample_SISD,
+                                 MergeUtil::copyTileFloatNumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("copyTileFloat2NumSample", 2,
+                                 MergeUtil::copyTileFloat2NumSample_SISD,
+                                 MergeUtil::copyTileFloat2NumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("copyTileFloat3NumSample", 3,
+                                 MergeUtil::copyTileFloat3NumSample_SISD,
+                                 MergeUtil::copyTileFloat3NumSample_SIMD));
+    CPPUNIT_ASSERT(testMergeTile("copyTileFloat4NumSample", 4,
+                                 MergeUtil::copyTileFloat4NumSample_SISD,
+                                 MergeUtil::copyTileFloat4NumSample_SIMD));
+}
+
+//------------------------------------------------------------------------------------------
+
+bool
+TestMergeUtil::testMergeTile(const std::string& testName,
+                             const int pixDim,
+                             const MergeTileFunc& mergeTileFuncSISD,
+                             const MergeTileFunc& mergeTileFuncSIMD) const
+{
+    const int tileTotal = 240 * 135; // = 1920 x 1080
+    const int pixTotal = tileTotal * sTilePix;
+
+    std::mt19937 rng(pixDim);
+    std::uniform_real_distribution<float> valDist(0.0f, 1.0f);
+    std::uniform_int_distribution<uint32_t> numDist(0, 64);
+    std::uniform_int_distribution<uint64_t> maskDist;
+
+    // 25% of the pixels have zero numSample and 20% of the tiles are fully active,
+    // 20% are empty and the rest are partially active.
+    auto setupNum = [&](std::vector<uint32_t>& buff) {
+        for (uint32_t& n : buff) n = (numDist(rng) < 16) ? 0 : numDist(rng);
+    };
+    std::vector<float> orgDstV(pixTotal * pixDim);
+    std::vector<float> srcV(pixTotal * pixDim);
+    for (float& v : orgDstV) v = valDist(rng);
+    for (float& v : srcV) v = valDist(rng);
+    std::vector<uint32_t> orgDstN(pixTotal);
+    std::vector<uint32_t> srcN(pixTotal);
+    setupNum(orgDstN);
+    setupNum(srcN);
+    std::vector<uint64_t> srcTileMask(tileTotal);
+    for (int tileId = 0; tileId < tileTotal; ++tileId) {
+        switch (tileId % 5) {
+        case 0 : srcTileMask[tileId] = ~static_cast<uint64_t>(0x0); break;
+        case 1 : srcTileMask[tileId] = static_cast<uint64_t>(0x0); break;
+        default : srcTileMask[tileId] = maskDist(rng); break;
+        }
+    }
+
+    std::vector<float> dstVSISD, dstVSIMD;
+    std::vector<uint32_t> dstNSISD, dstNSIMD;
+    const float timeSISD = runMergeTile(tileTotal, pixDim, mergeTileFuncSISD, srcTileMask,
+                                        orgDstV, orgDstN, srcV, srcN, dstVSISD, dstNSISD);
+    const float timeSIMD = runMergeTile(tileTotal, pixDim, mergeTileFuncSIMD, srcTileMask,
+                                        orgDstV, orgDstN, srcV, srcN, dstVSIMD, dstNSIMD);
+
+    // ISPC might use FMA for the weighted average, so values are compared with a small tolerance.
+    bool result = (dstNSISD == dstNSIMD);
+    for (size_t i = 0; result && i < dstVSISD.size(); ++i) {
+        if (std::fabs(dstVSISD[i] - dstVSIMD[i]) > 1.0e-6f * std::fabs(dstVSISD[i]) + 1.0e-7f) {
+            result = false;
+        }
+    }
+
+    std::cerr << ">> TestMergeUtil " << testName
+              << " SISD:" << timeSISD * 1000.0f << "ms"
+              << " SIMD:" << timeSIMD * 1000.0f << "ms (" << timeSISD / timeSIMD << "x)"
+              << " => " << (result ? "OK" : "NG") << '\n';
+    return result;
+}
+
+float
+TestMergeUtil::runMergeTile(const int tileTotal,
+                            const int pixDim,
+                            const MergeTileFunc& mergeTileFunc,
+                            const std::vector<uint64_t>& srcTileMask,
+                            const std::vector<float>& orgDstV,
+                            const std::vector<uint32_t>& orgDstN,
+                            const std::vector<float>& srcV,
+                            const std::vector<uint32_t>& srcN,
+                            std::vector<float>& dstV,
+                            std::vector<uint32_t>& dstN) const
+{
+#ifdef TIMING_TEST
+    int timingTestLoopMax = 128; // for performance test
+#else // else TIMING_TEST
+    int timingTestLoopMax = 1;
+#endif // end else TIMING_TEST
+
+    rec_time::RecTime recTime;
+    float time = 0.0f;
+    for (int i = 0; i < timingTestLoopMax; ++i) {
+        dstV = orgDstV;
+        dstN = orgDstN;
+        recTime.start();
+        for (int tileId = 0; tileId < tileTotal; ++tileId) {
+            const int pixOffset = tileId * sTilePix;
+            mergeTileFunc(&dstV[pixOffset * pixDim], &dstN[pixOffset], srcTileMask[tileId],
+                          &srcV[pixOffset * pixDim], &srcN[pixOffset]);
+        }
+        time += recTime.end();
+    }
+    return time / static_cast<float>(timingTestLoopMax);
+}
+
+} // namespace unittest
+} // namespace fb_util
+} // namespace scene_rdl2
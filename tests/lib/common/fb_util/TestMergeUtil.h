@@ -0,0 +1,61 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace fb_util {
+namespace unittest {
+
+class TestMergeUtil : public CppUnit::TestFixture
+//
+// Verifies that the SIMD (ISPC) versions of the fb_util::MergeUtil tile functions produce the
+// same result as the SISD (C++) versions, and reports the timing of both.
+//
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testAccumulateNumSample();
+    void testAccumulateClosestFilter();
+    void testCopyNumSample();
+
+    CPPUNIT_TEST_SUITE(TestMergeUtil);
+    CPPUNIT_TEST(testAccumulateNumSample);
+    CPPUNIT_TEST(testAccumulateClosestFilter);
+    CPPUNIT_TEST(testCopyNumSample);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    using MergeTileFunc =
+        std::function<void(float* dstV, uint32_t* dstN, const uint64_t srcTileMask,
+                           const float* srcV, const uint32_t* srcN)>;
+
+    bool testMergeTile(const std::string& testName,
+                       const int pixDim,
+                       const MergeTileFunc& mergeTileFuncSISD,
+                       const MergeTileFunc& mergeTileFuncSIMD) const;
+    float runMergeTile(const int tileTotal,
+                       const int pixDim,
+                       const MergeTileFunc& mergeTileFunc,
+                       const std::vector<uint64_t>& srcTileMask,
+                       const std::vector<float>& orgDstV,
+                       const std::vector<uint32_t>& orgDstN,
+                       const std::vector<float>& srcV,
+                       const std::vector<uint32_t>& srcN,
+                       std::vector<float>& dstV,
+                       std::vector<uint32_t>& dstN) const; // return sec
+};
+
+} // namespace unittest
+} // namespace fb_util
+} // namespace scene_rdl2
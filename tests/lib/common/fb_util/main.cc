@@ -1,6 +1,7 @@
 // Copyright 2023-2024 DreamWorks Animation LLC
 // SPDX-License-Identifier: Apache-2.0
 
+#include "TestMergeUtil.h"
 #include "TestPixelBuffer.h"
 #include "TestRunningStats.h"
 #include "TestSnapshotUtil.h"
@@ -14,6 +15,7 @@ main(int argc, char* argv[])
 {
     using namespace scene_rdl2::fb_util::unittest;
 
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestMergeUtil);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestPixelBuffer);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestRunningStats);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestSnapshotUtil);
@@ -0,0 +1,164 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "TestContentHash.h"
+#include "TimeOutput.h"
+
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+void
+TestContentHash::testFastHash()
+{
+    TIME_START;
+
+    const std::string data = randomDataGen(5000);
+
+    // Every size crosses the short input, stripe, block and last stripe boundaries.
+    std::set<FastHash::Hash> hashSet;
+    for (size_t size = 0; size <= 3000; ++size) {
+        const FastHash::Hash hash = FastHash::hash(data.data(), size);
+        CPPUNIT_ASSERT("deterministic" && hash == FastHash::hash(data.substr(0, size)));
+        hashSet.insert(hash);
+    }
+    CPPUNIT_ASSERT("size" && hashSet.size() == 3001);
+
+    // zero data only differs by size
+    const std::string zero(2048, 0x0);
+    hashSet.clear();
+    for (size_t size = 0; size <= zero.size(); ++size) {
+        hashSet.insert(FastHash::hash(zero.data(), size));
+    }
+    CPPUNIT_ASSERT("zero" && hashSet.size() == zero.size() + 1);
+
+    // single bit flip
+    for (size_t size : {1, 63, 64, 65, 1024, 1025, 5000}) {
+        std::string work = data.substr(0, size);
+        const FastHash::Hash hash = FastHash::hash(work);
+        for (size_t bitId = 0; bitId < size * 8; bitId += 3) {
+            work[bitId / 8] ^= static_cast<char>(1 << (bitId % 8));
+            CPPUNIT_ASSERT("bitFlip" && hash != FastHash::hash(work));
+            work[bitId / 8] ^= static_cast<char>(1 << (bitId % 8));
+        }
+    }
+
+    TIME_END;
+}
+
+void
+TestContentHash::testSlot()
+{
+    TIME_START;
+
+    for (size_t size : {0, 20, 1000, 123456}) {
+        const std::string data = randomDataGen(size);
+        CPPUNIT_ASSERT("SHA1" && runSlot(ContentHash::Mode::SHA1, data));
+        CPPUNIT_ASSERT("FAST128" && runSlot(ContentHash::Mode::FAST128, data));
+    }
+
+    // SHA1 slot of which the last 4 bytes are overwritten by the FAST128 tag is detected as FAST128,
+    // and verify() fails by both FAST128 and SHA1 tests.
+    const std::string data = randomDataGen(1000);
+    ContentHash::Slot slot = ContentHash::calc(ContentHash::Mode::SHA1, data.data(), data.size());
+    const ContentHash::Slot fastSlot = ContentHash::calc(ContentHash::Mode::FAST128, "", 0);
+    std::copy(fastSlot.begin() + FastHash::HASH_SIZE, fastSlot.end(), slot.begin() + FastHash::HASH_SIZE);
+    CPPUNIT_ASSERT("tag" && ContentHash::getMode(slot.data()) == ContentHash::Mode::FAST128);
+    CPPUNIT_ASSERT("broken" && !ContentHash::verify(slot.data(), data.data(), data.size()));
+
+    TIME_END;
+}
+
+void
+TestContentHash::testThroughput()
+{
+    TIME_START;
+
+    CPPUNIT_ASSERT("64KB" && runThroughput("64KB", 64 * 1024));
+    CPPUNIT_ASSERT("HD RGBA" && runThroughput("1920x1080 RGBA", 1920 * 1080 * 16));
+
+    TIME_END;
+}
+
+bool
+TestContentHash::runSlot(const ContentHash::Mode mode, const std::string& data) const
+{
+    const ContentHash::Slot slot = ContentHash::calc(mode, data.data(), data.size());
+    if (ContentHash::getMode(slot.data()) != mode) return false;
+    if (!ContentHash::verify(slot.data(), data.data(), data.size())) return false;
+    if (data.empty()) return true;
+
+    std::string broken = data;
+    broken[broken.size() / 2] ^= 0x10;
+    return !ContentHash::verify(slot.data(), broken.data(), broken.size());
+}
+
+bool
+TestContentHash::runThroughput(const std::string& title, const size_t dataSize) const
+//
+// Compares FastHash with the current SHA1 hash computation (Sha1Gen) which is used by the image
+// synchronization feedback logic.
+//
+{
+    const std::string data = randomDataGen(dataSize);
+    const int loop = std::max(1, static_cast<int>((size_t)(256 * 1024 * 1024) / dataSize));
+
+    rec_time::RecTime recTime;
+
+    Sha1Gen::Hash sha1Hash;
+    recTime.start();
+    try {
+        Sha1Gen sha1;
+        for (int i = 0; i < loop; ++i) {
+            if (!sha1.init() || !sha1.updateStr(data)) return false;
+            sha1Hash = sha1.finalize();
+        }
+    }
+    catch (std::string error) {
+        std::cerr << "ERROR " << __FILE__ << " line:" << __LINE__ << " func:" << __func__
+                  << " failed. error:" << error << '\n';
+        return false;
+    }
+    const float sha1Sec = recTime.end() / static_cast<float>(loop);
+
+    FastHash::Hash fastHash;
+    recTime.start();
+    for (int i = 0; i < loop; ++i) {
+        fastHash = FastHash::hash(data);
+    }
+    const float fastSec = recTime.end() / static_cast<float>(loop);
+
+    auto gbPerSec = [&](const float sec) { return static_cast<float>(dataSize) / sec / 1.0e9f; };
+    std::cerr << "  " << std::setw(14) << title << " size:" << std::setw(9) << dataSize
+              << std::fixed << std::setprecision(2)
+              << " Sha1Gen:" << std::setw(6) << gbPerSec(sha1Sec) << " GB/s"
+              << " FastHash:" << std::setw(6) << gbPerSec(fastSec) << " GB/s"
+              << " (x" << sha1Sec / fastSec << ")\n";
+
+    return (sha1Hash == Sha1Util::hash(data) && fastHash == FastHash::hash(data));
+}
+
+std::string
+TestContentHash::randomDataGen(size_t size) const
+{
+    std::mt19937 mt(static_cast<unsigned>(size));
+    std::uniform_int_distribution<> rand255(0, 255);
+
+    std::string data;
+    data.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        data.push_back(static_cast<unsigned char>(rand255(mt)));
+    }
+    return data;
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,45 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <scene_rdl2/common/grid_util/ContentHash.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestContentHash : public CppUnit::TestFixture
+//
+// Verifies FastHash and the ContentHash slot and reports the throughput of FastHash compared with
+// the SHA1 hash by Sha1Gen.
+//
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testFastHash();
+    void testSlot();
+    void testThroughput();
+
+    CPPUNIT_TEST_SUITE(TestContentHash);
+    CPPUNIT_TEST(testFastHash);
+    CPPUNIT_TEST(testSlot);
+    CPPUNIT_TEST(testThroughput);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    bool runSlot(const ContentHash::Mode mode, const std::string& data) const;
+    bool runThroughput(const std::string& title, const size_t dataSize) const;
+
+    std::string randomDataGen(size_t size) const;
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,207 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "TestFbMerge.h"
+#include "TimeOutput.h"
+
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+static const std::string sHeatMapName = "heatMap";
+static const std::string sAovName = "aovFloat3";
+
+void
+TestFbMerge::testAccumulateAllFbs()
+{
+    TIME_START;
+
+    // Throughput is reported as merged source pixels per second. Raise the machine counts and
+    // the resolution (i.e. 64 machines at 1920x1080) for profiling the merge computation.
+    const std::vector<int> numMachinesTbl = {1, 4, 16};
+
+    CPPUNIT_ASSERT("320x240" && runTest(320, 240, numMachinesTbl));
+    CPPUNIT_ASSERT("643x361" && runTest(643, 361, numMachinesTbl)); // not tile aligned
+
+    TIME_END;
+}
+
+bool
+TestFbMerge::runTest(const unsigned width, const unsigned height, const std::vector<int>& numMachinesTbl)
+{
+    const math::Viewport viewport(0, 0, width - 1, height - 1);
+    const int maxMachines = *std::max_element(numMachinesTbl.begin(), numMachinesTbl.end());
+
+    std::mt19937 rng(width * height);
+    std::vector<Fb> srcFbs(maxMachines);
+    for (int machineId = 0; machineId < maxMachines; ++machineId) {
+        setupSrcFb(srcFbs[machineId], viewport, rng);
+    }
+    std::vector<char> received(maxMachines, 1);
+
+    Fb dstFb;
+    dstFb.init(viewport);
+    Fb refFb;
+    refFb.init(viewport);
+
+    bool result = true;
+    for (int numMachines : numMachinesTbl) {
+        const float sec = benchAccumulateAllFbs(dstFb, numMachines, received, srcFbs);
+
+        refFb.reset();
+        mergeOneByOne(refFb, numMachines, srcFbs);
+        const bool flag = compareFb(dstFb, refFb);
+        if (!flag) result = false;
+
+        const float srcPix = static_cast<float>(numMachines) * width * height;
+        std::cerr << ">> TestFbMerge accumulateAllFbs"
+                  << " res:" << width << 'x' << height
+                  << " machines:" << std::setw(2) << numMachines
+                  << " time:" << std::fixed << std::setprecision(6) << sec << " sec"
+                  << " throughput:" << std::setprecision(2) << (srcPix / sec * 0.000001f) << " Mpix/sec"
+                  << " => " << (flag ? "OK" : "NG") << '\n';
+        std::cerr.unsetf(std::ios::floatfield);
+    }
+    return result;
+}
+
+void
+TestFbMerge::setupSrcFb(Fb& srcFb, const math::Viewport& viewport, std::mt19937& rng) const
+//
+// Sets up a source Fb with random beauty, heatMap and one FLOAT3 AOV. Only part of the pixels
+// of each tile is active, like a source which has not yet sent every pixel.
+//
+{
+    srcFb.init(viewport);
+    fillRandomActivePixels(srcFb.getActivePixels(), rng);
+    fillRandom(reinterpret_cast<float*>(srcFb.getRenderBufferTiled().getData()),
+               srcFb.getRenderBufferTiled().getArea() * 4, rng);
+    fillRandomNumSample(srcFb.getNumSampleBufferTiled().getData(),
+                        srcFb.getNumSampleBufferTiled().getArea(), rng);
+
+    srcFb.setupHeatMap(nullptr, sHeatMapName);
+    fillRandomActivePixels(srcFb.getActivePixelsHeatMap(), rng);
+    fillRandom(srcFb.getHeatMapSecBufferTiled().getData(), srcFb.getHeatMapSecBufferTiled().getArea(), rng);
+    fillRandomNumSample(srcFb.getHeatMapNumSampleBufferTiled().getData(),
+                        srcFb.getHeatMapNumSampleBufferTiled().getArea(), rng);
+
+    Fb::FbAovShPtr fbAov = srcFb.getAov(sAovName);
+    fbAov->setup(nullptr, fb_util::VariablePixelBuffer::FLOAT3, viewport.width(), viewport.height(), true);
+    fillRandomActivePixels(fbAov->getActivePixels(), rng);
+    fb_util::Float3Buffer& buff = fbAov->getBufferTiled().getFloat3Buffer();
+    fillRandom(reinterpret_cast<float*>(buff.getData()), buff.getArea() * 3, rng);
+    fillRandomNumSample(fbAov->getNumSampleBufferTiled().getData(),
+                        fbAov->getNumSampleBufferTiled().getArea(), rng);
+}
+
+void
+TestFbMerge::fillRandom(float* data, const size_t total, std::mt19937& rng) const
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    for (size_t i = 0; i < total; ++i) data[i] = dist(rng);
+}
+
+void
+TestFbMerge::fillRandomNumSample(unsigned* data, const size_t total, std::mt19937& rng) const
+{
+    std::uniform_int_distribution<unsigned> dist(1, 64);
+    for (size_t i = 0; i < total; ++i) data[i] = dist(rng);
+}
+
+void
+TestFbMerge::fillRandomActivePixels(fb_util::ActivePixels& activePixels, std::mt19937& rng) const
+{
+    std::uniform_int_distribution<uint64_t> dist;
+    for (unsigned tileId = 0; tileId < activePixels.getNumTiles(); ++tileId) {
+        activePixels.setTileMask(tileId, dist(rng));
+    }
+}
+
+void
+TestFbMerge::mergeOneByOne(Fb& dstFb, const int numMachines, const std::vector<Fb>& srcFbs) const
+{
+    for (int machineId = 0; machineId < numMachines; ++machineId) {
+        dstFb.accumulateRenderBuffer(nullptr, srcFbs[machineId]);
+        dstFb.accumulateHeatMap(nullptr, srcFbs[machineId]);
+        dstFb.accumulateRenderOutput(nullptr, srcFbs[machineId]);
+    }
+}
+
+float
+TestFbMerge::benchAccumulateAllFbs(Fb& dstFb,
+                                   const int numMachines,
+                                   const std::vector<char>& received,
+                                   const std::vector<Fb>& srcFbs) const
+{
+    constexpr int loopMax = 4;
+
+    float total = 0.0f;
+    for (int i = 0; i < loopMax; ++i) {
+        dstFb.reset();
+
+        rec_time::RecTime recTime;
+        recTime.start();
+        dstFb.accumulateAllFbs(numMachines, received, srcFbs);
+        total += recTime.end();
+    }
+    return total / static_cast<float>(loopMax);
+}
+
+bool
+TestFbMerge::compareFb(Fb& a, Fb& b) const
+{
+    if (!compareActivePixels(a.getActivePixels(), b.getActivePixels()) ||
+        !compareBuffer(a.getRenderBufferTiled(), b.getRenderBufferTiled()) ||
+        !compareBuffer(a.getNumSampleBufferTiled(), b.getNumSampleBufferTiled())) {
+        std::cerr << "beauty mismatch\n";
+        return false;
+    }
+
+    if (!a.getHeatMapStatus() || !b.getHeatMapStatus() ||
+        !compareActivePixels(a.getActivePixelsHeatMap(), b.getActivePixelsHeatMap()) ||
+        !compareBuffer(a.getHeatMapSecBufferTiled(), b.getHeatMapSecBufferTiled()) ||
+        !compareBuffer(a.getHeatMapNumSampleBufferTiled(), b.getHeatMapNumSampleBufferTiled())) {
+        std::cerr << "heatMap mismatch\n";
+        return false;
+    }
+
+    Fb::FbAovShPtr aovA, aovB;
+    if (!a.getAov2(sAovName, aovA) || !b.getAov2(sAovName, aovB) ||
+        !aovA->getStatus() || !aovB->getStatus() ||
+        !compareActivePixels(aovA->getActivePixels(), aovB->getActivePixels()) ||
+        !compareBuffer(aovA->getBufferTiled().getFloat3Buffer(), aovB->getBufferTiled().getFloat3Buffer()) ||
+        !compareBuffer(aovA->getNumSampleBufferTiled(), aovB->getNumSampleBufferTiled())) {
+        std::cerr << "aov mismatch\n";
+        return false;
+    }
+    return true;
+}
+
+bool
+TestFbMerge::compareActivePixels(const fb_util::ActivePixels& a, const fb_util::ActivePixels& b) const
+{
+    if (a.getNumTiles() != b.getNumTiles()) return false;
+    for (unsigned tileId = 0; tileId < a.getNumTiles(); ++tileId) {
+        if (a.getTileMask(tileId) != b.getTileMask(tileId)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool
+TestFbMerge::compareBuffer(const fb_util::PixelBuffer<T>& a, const fb_util::PixelBuffer<T>& b) const
+{
+    // Both sides fold the sources in the same order, so the results have to be bit identical.
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+    return std::memcmp(a.getData(), b.getData(), a.getArea() * sizeof(T)) == 0;
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,55 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <scene_rdl2/common/grid_util/Fb.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <random>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestFbMerge : public CppUnit::TestFixture
+//
+// Verifies Fb::accumulateAllFbs() against merging the sources one by one, and reports the
+// merge throughput for several machine counts and resolutions.
+//
+{
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    void testAccumulateAllFbs();
+
+    CPPUNIT_TEST_SUITE(TestFbMerge);
+    CPPUNIT_TEST(testAccumulateAllFbs);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    bool runTest(const unsigned width, const unsigned height, const std::vector<int>& numMachinesTbl);
+
+    void setupSrcFb(Fb& srcFb, const math::Viewport& viewport, std::mt19937& rng) const;
+    void fillRandom(float* data, const size_t total, std::mt19937& rng) const;
+    void fillRandomNumSample(unsigned* data, const size_t total, std::mt19937& rng) const;
+    void fillRandomActivePixels(fb_util::ActivePixels& activePixels, std::mt19937& rng) const;
+
+    void mergeOneByOne(Fb& dstFb, const int numMachines, const std::vector<Fb>& srcFbs) const;
+    float benchAccumulateAllFbs(Fb& dstFb,
+                                const int numMachines,
+                                const std::vector<char>& received,
+                                const std::vector<Fb>& srcFbs) const; // return average sec
+
+    bool compareFb(Fb& a, Fb& b) const;
+    bool compareActivePixels(const fb_util::ActivePixels& a, const fb_util::ActivePixels& b) const;
+    template <typename T>
+    bool compareBuffer(const fb_util::PixelBuffer<T>& a, const fb_util::PixelBuffer<T>& b) const;
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
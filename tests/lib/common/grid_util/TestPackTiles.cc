@@ -0,0 +1,431 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#include "TestPackTiles.h"
+#include "TimeOutput.h"
+
+#include <scene_rdl2/common/grid_util/EntropyCodec.h>
+#include <scene_rdl2/common/rec_time/RecTime.h>
+
+#include <atomic>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+void
+TestPackTiles::testBeautyVer3()
+{
+    TIME_START;
+
+    constexpr EnqFormatVer ver = EnqFormatVer::VER3;
+    CPPUNIT_ASSERT("empty" && runBeauty(ver, PrecisionMode::F32, 320, 240, 0.0f));
+    CPPUNIT_ASSERT("320x240" && runBeauty(ver, PrecisionMode::F32, 320, 240, 1.0f)); // single chunk
+    CPPUNIT_ASSERT("643x361" && runBeauty(ver, PrecisionMode::F32, 643, 361, 0.5f)); // not tile aligned
+    CPPUNIT_ASSERT("1920x1080 sparse" && runBeauty(ver, PrecisionMode::F32, 1920, 1080, 0.1f));
+    CPPUNIT_ASSERT("1920x1080" && runBeauty(ver, PrecisionMode::F32, 1920, 1080, 1.0f));
+
+    TIME_END;
+}
+
+void
+TestPackTiles::testHeatMapVer3()
+{
+    TIME_START;
+
+    CPPUNIT_ASSERT("643x361" && runHeatMap(EnqFormatVer::VER3, 643, 361, 0.5f));
+    CPPUNIT_ASSERT("1920x1080" && runHeatMap(EnqFormatVer::VER3, 1920, 1080, 1.0f));
+
+    TIME_END;
+}
+
+void
+TestPackTiles::testEntropyCodec()
+{
+    TIME_START;
+
+    std::mt19937 rng(123);
+    std::uniform_int_distribution<int> byteDist(0, 255);
+
+    std::string random(100000, 0x0);
+    for (char& c : random) c = static_cast<char>(byteDist(rng));
+
+    std::string record; // 17 byte pixel record like RGBA float + numSample
+    for (unsigned pixId = 0; pixId < 20000; ++pixId) {
+        const float v[4] = {pixId * 0.001f, pixId * 0.002f, 0.5f, 1.0f};
+        record.append(reinterpret_cast<const char*>(v), sizeof(v));
+        record.push_back(static_cast<char>(pixId % 4 + 1));
+    }
+
+    std::string skewed(50000, 0x0); // only a few symbols
+    for (char& c : skewed) c = static_cast<char>((byteDist(rng) < 250) ? 0 : byteDist(rng) % 3);
+
+    CPPUNIT_ASSERT("empty" && runEntropyCodec("empty", std::string()));
+    CPPUNIT_ASSERT("small" && runEntropyCodec("small", random.substr(0, 100)));
+    CPPUNIT_ASSERT("random" && runEntropyCodec("random", random));
+    CPPUNIT_ASSERT("record" && runEntropyCodec("record", record));
+    CPPUNIT_ASSERT("skewed" && runEntropyCodec("skewed", skewed));
+    CPPUNIT_ASSERT("constant" && runEntropyCodec("constant", std::string(10000, 'a')));
+
+    // broken data has to be detected instead of crashing
+    std::string encoded, decoded;
+    EntropyCodec::encode(record.data(), record.size(), encoded);
+    CPPUNIT_ASSERT("truncated" &&
+                   !EntropyCodec::decode(encoded.data(), encoded.size() / 2, record.size(), decoded));
+    CPPUNIT_ASSERT("maxDecodeSize" &&
+                   !EntropyCodec::decode(encoded.data(), encoded.size(), record.size() - 1, decoded));
+
+    TIME_END;
+}
+
+void
+TestPackTiles::testBeautyVer4()
+{
+    TIME_START;
+
+    constexpr EnqFormatVer ver = EnqFormatVer::VER4;
+    CPPUNIT_ASSERT("empty" && runBeauty(ver, PrecisionMode::F32, 320, 240, 0.0f));
+    CPPUNIT_ASSERT("643x361 F32" && runBeauty(ver, PrecisionMode::F32, 643, 361, 0.5f));
+    CPPUNIT_ASSERT("643x361 H16" && runBeauty(ver, PrecisionMode::H16, 643, 361, 0.5f));
+    CPPUNIT_ASSERT("643x361 UC8" && runBeauty(ver, PrecisionMode::UC8, 643, 361, 0.5f));
+    CPPUNIT_ASSERT("1920x1080 F32" && runBeauty(ver, PrecisionMode::F32, 1920, 1080, 1.0f));
+    CPPUNIT_ASSERT("1920x1080 H16" && runBeauty(ver, PrecisionMode::H16, 1920, 1080, 1.0f));
+
+    TIME_END;
+}
+
+void
+TestPackTiles::testHeatMapVer4()
+{
+    TIME_START;
+
+    CPPUNIT_ASSERT("643x361" && runHeatMap(EnqFormatVer::VER4, 643, 361, 0.5f));
+    CPPUNIT_ASSERT("1920x1080" && runHeatMap(EnqFormatVer::VER4, 1920, 1080, 1.0f));
+
+    TIME_END;
+}
+
+void
+TestPackTiles::testHashMode()
+{
+    TIME_START;
+
+    {
+        std::string data;
+        PackTiles::encodeRenderOutputReference(FbReferenceType::BEAUTY, data, true); // withSha1Hash
+        const unsigned char* hash = reinterpret_cast<const unsigned char*>(data.data());
+        CPPUNIT_ASSERT("default" && PackTiles::decodeHashMode(hash) == HashMode::SHA1);
+    }
+    CPPUNIT_ASSERT("SHA1" && runHashMode(HashMode::SHA1));
+    CPPUNIT_ASSERT("FAST128" && runHashMode(HashMode::FAST128));
+
+    // runBeauty() runs verifyDecodeHash() for all encoded data
+    CPPUNIT_ASSERT("643x361 FAST128" &&
+                   runBeauty(EnqFormatVer::VER4, PrecisionMode::F32, 643, 361, 0.5f, HashMode::FAST128));
+
+    // The mode belongs to each encode call, so senders using different modes can run concurrently.
+    std::vector<std::thread> threads;
+    std::atomic<bool> concurrentFlag {true};
+    for (unsigned i = 0; i < 4; ++i) {
+        threads.emplace_back([&, i]() {
+            const HashMode hashMode = (i % 2) ? HashMode::FAST128 : HashMode::SHA1;
+            for (unsigned j = 0; j < 100; ++j) {
+                std::string data;
+                PackTiles::encodeRenderOutputReference(FbReferenceType::BEAUTY, data,
+                                                       true, // withSha1Hash
+                                                       EnqFormatVer::VER2, hashMode);
+                const unsigned char* hash = reinterpret_cast<const unsigned char*>(data.data());
+                if (PackTiles::decodeHashMode(hash) != hashMode) concurrentFlag = false;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    CPPUNIT_ASSERT("concurrent" && concurrentFlag);
+
+    TIME_END;
+}
+
+bool
+TestPackTiles::runBeauty(const EnqFormatVer enqFormatVer,
+                         const PrecisionMode precisionMode,
+                         const unsigned width, const unsigned height, const float activeFraction,
+                         const HashMode hashMode)
+{
+    std::mt19937 rng(width * height);
+
+    ActivePixels activePixels;
+    activePixels.init(width, height);
+    fillRandomActivePixels(activePixels, activeFraction, rng);
+
+    const unsigned alignedWidth = activePixels.getAlignedWidth();
+    const unsigned alignedHeight = activePixels.getAlignedHeight();
+    RenderBuffer renderBufferTiled;
+    FloatBuffer weightBufferTiled;
+    renderBufferTiled.init(alignedWidth, alignedHeight);
+    weightBufferTiled.init(alignedWidth, alignedHeight);
+    std::uniform_int_distribution<int> weightDist(1, 4);
+    for (size_t i = 0; i < weightBufferTiled.getArea(); ++i) {
+        weightBufferTiled.getData()[i] = static_cast<float>(weightDist(rng));
+    }
+    fillGradation(reinterpret_cast<float*>(renderBufferTiled.getData()), 4, activePixels, rng);
+    for (size_t i = 0; i < renderBufferTiled.getArea(); ++i) {
+        renderBufferTiled.getData()[i] *= weightBufferTiled.getData()[i]; // non normalized color
+    }
+
+    ActivePixels activePixels2, activePixelsB;
+    RenderBuffer renderBufferTiled2, renderBufferTiledB;
+    NumSampleBuffer numSampleBufferTiled2, numSampleBufferTiledB;
+    size_t size2 = 0, sizeB = 0;
+
+    rec_time::RecTime recTime;
+    recTime.start();
+    bool flag = encodeDecodeBeauty(EnqFormatVer::VER2, precisionMode,
+                                   activePixels, renderBufferTiled, weightBufferTiled,
+                                   activePixels2, renderBufferTiled2, numSampleBufferTiled2, size2,
+                                   hashMode);
+    const float sec2 = recTime.end();
+
+    recTime.start();
+    flag = encodeDecodeBeauty(enqFormatVer, precisionMode,
+                              activePixels, renderBufferTiled, weightBufferTiled,
+                              activePixelsB, renderBufferTiledB, numSampleBufferTiledB, sizeB,
+                              hashMode) && flag;
+    const float secB = recTime.end();
+
+    flag = (flag &&
+            compareActivePixels(activePixels, activePixelsB) &&
+            compareActivePixels(activePixels2, activePixelsB) &&
+            compareBuffer(renderBufferTiled2, renderBufferTiledB) &&
+            compareBuffer(numSampleBufferTiled2, numSampleBufferTiledB));
+
+    showResult("beauty " + PackTiles::showPrecisionMode(precisionMode),
+               enqFormatVer, width, height, size2, sec2, sizeB, secB, flag);
+    return flag;
+}
+
+bool
+TestPackTiles::runHeatMap(const EnqFormatVer enqFormatVer,
+                          const unsigned width, const unsigned height, const float activeFraction)
+{
+    std::mt19937 rng(width + height);
+
+    ActivePixels activePixels;
+    activePixels.init(width, height);
+    fillRandomActivePixels(activePixels, activeFraction, rng);
+
+    FloatBuffer heatMapSecBufferTiled;
+    heatMapSecBufferTiled.init(activePixels.getAlignedWidth(), activePixels.getAlignedHeight());
+    fillGradation(heatMapSecBufferTiled.getData(), 1, activePixels, rng);
+
+    auto encodeDecode = [&](const EnqFormatVer enqFormatVer,
+                            ActivePixels& outActivePixels,
+                            FloatBuffer& outSecBufferTiled,
+                            size_t& dataSize) -> bool {
+        std::string data;
+        dataSize = PackTiles::encodeHeatMap(activePixels, heatMapSecBufferTiled, data, true, enqFormatVer);
+        bool activeDecodeAction = false;
+        return (PackTiles::verifyDecodeHash(data.data(), data.size()) &&
+                PackTiles::decodeHeatMap(data.data(), data.size(),
+                                         outActivePixels, outSecBufferTiled, activeDecodeAction));
+    };
+
+    ActivePixels activePixels2, activePixelsB;
+    FloatBuffer secBufferTiled2, secBufferTiledB;
+    size_t size2 = 0, sizeB = 0;
+
+    rec_time::RecTime recTime;
+    recTime.start();
+    bool flag = encodeDecode(EnqFormatVer::VER2, activePixels2, secBufferTiled2, size2);
+    const float sec2 = recTime.end();
+
+    recTime.start();
+    flag = encodeDecode(enqFormatVer, activePixelsB, secBufferTiledB, sizeB) && flag;
+    const float secB = recTime.end();
+
+    flag = (flag &&
+            compareActivePixels(activePixels, activePixelsB) &&
+            compareActivePixels(activePixels2, activePixelsB) &&
+            compareBuffer(secBufferTiled2, secBufferTiledB));
+
+    showResult("heatMap", enqFormatVer, width, height, size2, sec2, sizeB, secB, flag);
+    return flag;
+}
+
+bool
+TestPackTiles::runEntropyCodec(const std::string& title, const std::string& data) const
+{
+    std::string encoded, decoded;
+    EntropyCodec::encode(data.data(), data.size(), encoded);
+    const bool flag = (EntropyCodec::decode(encoded.data(), encoded.size(), data.size(), decoded) &&
+                       decoded == data);
+
+    const EntropyCodec::Mode mode = static_cast<EntropyCodec::Mode>(encoded[0]);
+    std::cerr << ">> TestPackTiles entropyCodec " << title
+              << " mode:" << EntropyCodec::showMode(mode)
+              << " stride:" << EntropyCodec::selectStride(data.data(), data.size())
+              << " size:" << data.size() << " -> " << encoded.size()
+              << " => " << (flag ? "OK" : "NG") << '\n';
+    return flag;
+}
+
+bool
+TestPackTiles::runHashMode(const HashMode hashMode) const
+{
+    std::string data;
+    PackTiles::encodeRenderOutputReference(FbReferenceType::BEAUTY, data,
+                                           true, // withSha1Hash
+                                           EnqFormatVer::VER2, hashMode);
+
+    // The receiver does not know the sender's hash mode and picks it up from the data.
+    const unsigned char* hash = reinterpret_cast<const unsigned char*>(data.data());
+    bool flag = (PackTiles::decodeHashMode(hash) == hashMode &&
+                 PackTiles::verifyDecodeHash(data.data(), data.size()));
+
+    data.back() ^= 0x1; // broken data
+    flag = flag && !PackTiles::verifyDecodeHash(data.data(), data.size());
+
+    std::cerr << "  hashMode:" << std::setw(7) << ContentHash::showMode(hashMode)
+              << ' ' << PackTiles::showHash("", hash)
+              << " => " << (flag ? "OK" : "NG") << '\n';
+    return flag;
+}
+
+bool
+TestPackTiles::encodeDecodeBeauty(const EnqFormatVer enqFormatVer,
+                                  const PrecisionMode precisionMode,
+                                  const ActivePixels& activePixels,
+                                  const RenderBuffer& renderBufferTiled,
+                                  const FloatBuffer& weightBufferTiled,
+                                  ActivePixels& outActivePixels,
+                                  RenderBuffer& outRenderBufferTiled,
+                                  NumSampleBuffer& outNumSampleBufferTiled,
+                                  size_t& dataSize,
+                                  const HashMode hashMode) const
+{
+    std::string data;
+    dataSize = PackTiles::encode(false, // renderBufferOdd
+                                 activePixels,
+                                 renderBufferTiled,
+                                 weightBufferTiled,
+                                 data,
+                                 precisionMode,
+                                 CoarsePassPrecision::F32,
+                                 FinePassPrecision::F32,
+                                 false, // noNumSampleMode
+                                 true,  // withSha1Hash
+                                 enqFormatVer,
+                                 hashMode);
+    if (!PackTiles::verifyDecodeHash(data.data(), data.size())) {
+        std::cerr << "verifyDecodeHash() failed\n";
+        return false;
+    }
+
+    CoarsePassPrecision coarsePassPrecision;
+    FinePassPrecision finePassPrecision;
+    bool activeDecodeAction = false;
+    if (!PackTiles::decode(false, // renderBufferOdd
+                           data.data(),
+                           data.size(),
+                           true, // storeNumSampleData
+                           outActivePixels,
+                           outRenderBufferTiled,
+                           outNumSampleBufferTiled,
+                           coarsePassPrecision,
+                           finePassPrecision,
+                           activeDecodeAction)) {
+        std::cerr << "decode() failed\n";
+        return false;
+    }
+    return true;
+}
+
+void
+TestPackTiles::fillRandomActivePixels(ActivePixels& activePixels,
+                                      const float activeFraction,
+                                      std::mt19937& rng) const
+{
+    std::uniform_real_distribution<float> tileDist(0.0f, 1.0f);
+    std::uniform_int_distribution<uint64_t> maskDist;
+    for (unsigned tileId = 0; tileId < activePixels.getNumTiles(); ++tileId) {
+        const uint64_t mask = (tileDist(rng) < activeFraction) ? maskDist(rng) : 0x0;
+        activePixels.setTileMask(tileId, mask);
+    }
+}
+
+void
+TestPackTiles::fillRandom(float* data, const size_t total, const float min, const float max,
+                          std::mt19937& rng) const
+{
+    std::uniform_real_distribution<float> dist(min, max);
+    for (size_t i = 0; i < total; ++i) data[i] = dist(rng);
+}
+
+void
+TestPackTiles::fillGradation(float* data, const unsigned numChan, const ActivePixels& activePixels,
+                             std::mt19937& rng) const
+//
+// Fills smooth gradation + small noise like a rendered image. data is tile aligned layout.
+//
+{
+    std::uniform_real_distribution<float> noiseDist(-0.01f, 0.01f);
+    const float scaleX = 1.0f / static_cast<float>(activePixels.getAlignedWidth());
+    const float scaleY = 1.0f / static_cast<float>(activePixels.getAlignedHeight());
+    for (unsigned tileId = 0; tileId < activePixels.getNumTiles(); ++tileId) {
+        const unsigned tileX = tileId % activePixels.getNumTilesX();
+        const unsigned tileY = tileId / activePixels.getNumTilesX();
+        for (unsigned offset = 0; offset < 64; ++offset) {
+            const float x = static_cast<float>(tileX * 8 + (offset & 0x7)) * scaleX;
+            const float y = static_cast<float>(tileY * 8 + (offset >> 3)) * scaleY;
+            float* pix = data + (static_cast<size_t>(tileId) * 64 + offset) * numChan;
+            for (unsigned chan = 0; chan < numChan; ++chan) {
+                pix[chan] = 0.25f * (chan + 1) * x + 0.5f * y + noiseDist(rng);
+            }
+        }
+    }
+}
+
+bool
+TestPackTiles::compareActivePixels(const ActivePixels& a, const ActivePixels& b) const
+{
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+    for (unsigned tileId = 0; tileId < a.getNumTiles(); ++tileId) {
+        if (a.getTileMask(tileId) != b.getTileMask(tileId)) return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool
+TestPackTiles::compareBuffer(const fb_util::PixelBuffer<T>& a, const fb_util::PixelBuffer<T>& b) const
+{
+    // All versions run exactly the same per pixel codec and VER4 entropy coding is lossless,
+    // so the results have to be bit identical.
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+    return std::memcmp(a.getData(), b.getData(), a.getArea() * sizeof(T)) == 0;
+}
+
+void
+TestPackTiles::showResult(const std::string& title,
+                          const EnqFormatVer enqFormatVer,
+                          const unsigned width, const unsigned height,
+                          const size_t sizeVer2, const float secVer2,
+                          const size_t size, const float sec,
+                          const bool flag) const
+{
+    std::cerr << ">> TestPackTiles " << title
+              << " res:" << width << 'x' << height
+              << " VER2(size:" << sizeVer2
+              << " time:" << std::fixed << std::setprecision(6) << secVer2 << " sec)"
+              << " VER" << static_cast<unsigned>(enqFormatVer) << "(size:" << size
+              << " time:" << sec << " sec)"
+              << " => " << (flag ? "OK" : "NG") << '\n';
+    std::cerr.unsetf(std::ios::floatfield);
+}
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
@@ -0,0 +1,96 @@
+// Copyright 2025 DreamWorks Animation LLC
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <scene_rdl2/common/grid_util/PackTiles.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <random>
+#include <string>
+
+namespace scene_rdl2 {
+namespace grid_util {
+namespace unittest {
+
+class TestPackTiles : public CppUnit::TestFixture
+//
+// Verifies that the chunked multi-threaded VER3 format and the entropy coded VER4 format decode
+// to exactly the same result as VER2, and reports the data size and encode/decode time of them.
+// Also verifies that the hash mode is recorded in the data and the receiver can verify it.
+//
+{
+public:
+    using ActivePixels = fb_util::ActivePixels;
+    using EnqFormatVer = PackTiles::EnqFormatVer;
+    using HashMode = PackTiles::HashMode;
+    using FloatBuffer = fb_util::FloatBuffer;
+    using NumSampleBuffer = PackTiles::NumSampleBuffer;
+    using PrecisionMode = PackTiles::PrecisionMode;
+    using RenderBuffer = fb_util::RenderBuffer;
+
+    void setUp() {}
+    void tearDown() {}
+
+    void testBeautyVer3();
+    void testHeatMapVer3();
+    void testEntropyCodec();
+    void testBeautyVer4();
+    void testHeatMapVer4();
+    void testHashMode();
+
+    CPPUNIT_TEST_SUITE(TestPackTiles);
+    CPPUNIT_TEST(testBeautyVer3);
+    CPPUNIT_TEST(testHeatMapVer3);
+    CPPUNIT_TEST(testEntropyCodec);
+    CPPUNIT_TEST(testBeautyVer4);
+    CPPUNIT_TEST(testHeatMapVer4);
+    CPPUNIT_TEST(testHashMode);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    // compares enqFormatVer result with VER2 result
+    bool runBeauty(const EnqFormatVer enqFormatVer,
+                   const PrecisionMode precisionMode,
+                   const unsigned width, const unsigned height, const float activeFraction,
+                   const HashMode hashMode = HashMode::SHA1);
+    bool runHeatMap(const EnqFormatVer enqFormatVer,
+                    const unsigned width, const unsigned height, const float activeFraction);
+    bool runEntropyCodec(const std::string& title, const std::string& data) const;
+    bool runHashMode(const HashMode hashMode) const;
+
+    bool encodeDecodeBeauty(const EnqFormatVer enqFormatVer,
+                            const PrecisionMode precisionMode,
+                            const ActivePixels& activePixels,
+                            const RenderBuffer& renderBufferTiled,
+                            const FloatBuffer& weightBufferTiled,
+                            ActivePixels& outActivePixels,
+                            RenderBuffer& outRenderBufferTiled,
+                            NumSampleBuffer& outNumSampleBufferTiled,
+                            size_t& dataSize,
+                            const HashMode hashMode) const;
+
+    void fillRandomActivePixels(ActivePixels& activePixels,
+                                const float activeFraction,
+                                std::mt19937& rng) const;
+    void fillRandom(float* data, const size_t total, const float min, const float max,
+                    std::mt19937& rng) const;
+    void fillGradation(float* data, const unsigned numChan, const ActivePixels& activePixels,
+                       std::mt19937& rng) const;
+
+    bool compareActivePixels(const ActivePixels& a, const ActivePixels& b) const;
+    template <typename T>
+    bool compareBuffer(const fb_util::PixelBuffer<T>& a, const fb_util::PixelBuffer<T>& b) const;
+
+    void showResult(const std::string& title,
+                    const EnqFormatVer enqFormatVer,
+                    const unsigned width, const unsigned height,
+                    const size_t sizeVer2, const float secVer2,
+                    const size_t size, const float sec,
+                    const bool flag) const;
+};
+
+} // namespace unittest
+} // namespace grid_util
+} // namespace scene_rdl2
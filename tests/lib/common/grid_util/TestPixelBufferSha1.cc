@@ -79,6 +79,27 @@ TestPixelBufferSha1::testDualRegion()
     TIME_END;
 }
 
+void
+TestPixelBufferSha1::testFast128()
+{
+    TIME_START;
+
+#   ifdef SINGLE_THREAD
+    constexpr int testTotal = 8;
+#   else // else SINGLE_THREAD
+    constexpr int testTotal = 64;
+#   endif // end else SINGLE_THREAD
+
+    mHashMode = ContentHash::Mode::FAST128;
+
+    singleRegionTestMain<fb_util::ByteColor>(testTotal);
+    singleRegionTestMain<fb_util::RenderColor>(testTotal);
+    dualRegionTestMain<fb_util::ByteColor>(testTotal);
+    dualRegionTestMain<fb_util::RenderColor>(testTotal);
+
+    TIME_END;
+}
+
 //------------------------------------------------------------------------------------------
 
 template <typename T>
@@ -129,6 +150,7 @@ TestPixelBufferSha1::singleRegionTestRun(const TestRunParam& currParam,
 #       endif // end DEBUG_MSG
 
         PixelBufferSha1Hash fbHash;
+        fbHash.setHashMode(mHashMode);
         fbHash.calcHash(nullptr, buff);
 
         const unsigned tileIdEnd = mTileTotal - 1;
@@ -155,6 +177,7 @@ TestPixelBufferSha1::singleRegionTestRun(const TestRunParam& currParam,
         // std::cerr << "TestFbSha1.cc " << PixelBufferSha1Hash::showPartialMergeTilesTbl(tileTbl) << '\n';
 
         PixelBufferSha1Hash fbHash;
+        fbHash.setHashMode(mHashMode);
         fbHash.calcHash(&tileTbl, buff);
 
         PixelBufferSha1Hash::Hash verifyHash;
@@ -213,6 +236,7 @@ TestPixelBufferSha1::dualRegionTestRun(const TestRunParam& currParam,
     // std::cerr << "TestFbSha1.cc " << PixelBufferSha1Hash::showPartialMergeTilesTbl(tileTbl) << '\n';
 
     PixelBufferSha1Hash fbHash;
+    fbHash.setHashMode(mHashMode);
     fbHash.calcHash(&tileTbl, buff);
 
     PixelBufferSha1Hash::Hash verifyHashA, verifyHashB;
@@ -397,7 +421,7 @@ TestPixelBufferSha1::showVerifyInfo(const std::string& title,
     ostr << "verifyInfo (" << title << ") {\n";
     if (verifyActive) {
         ostr << "  verifyActive:ON\n"
-             << str_util::addIndent(Sha1Util::show(verifyHash)) << '\n'
+             << str_util::addIndent(ContentHash::show(verifyHash.data())) << '\n'
              << "  tileIdStart:" << tileIdStart << '\n'
              << "  tileIdEnd:" << tileIdEnd << '\n';
     } else {
@@ -31,10 +31,12 @@ public:
 
     void testSingleRegion();
     void testDualRegion();
+    void testFast128();
 
     CPPUNIT_TEST_SUITE(TestPixelBufferSha1);
     CPPUNIT_TEST(testSingleRegion);
     CPPUNIT_TEST(testDualRegion);
+    CPPUNIT_TEST(testFast128);
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -128,6 +130,8 @@ protected:
     constexpr static unsigned mTileTotalX {mTileAlignedWidth / 8};
     constexpr static unsigned mTileTotalY {mTileAlignedHeight / 8};
     constexpr static unsigned mTileTotal {mTileTotalX * mTileTotalY};
+
+    ContentHash::Mode mHashMode {ContentHash::Mode::SHA1};
     
     unsigned mSeed {std::random_device{}()};
 
@@ -4,8 +4,11 @@
 #include "TestAffinityMapTable.h"
 #include "TestArg.h"
 #include "TestBinPacketDictionary.h"
+#include "TestContentHash.h"
 #include "TestCpuSocketUtil.h"
+#include "TestFbMerge.h"
 #include "TestFbUtils.h"
+#include "TestPackTiles.h"
 #include "TestParser.h"
 #include "TestPixelBufferSha1.h"
 #include "TestSha1.h"
@@ -25,8 +28,11 @@ main(int ac, char** av)
     CPPUNIT_TEST_SUITE_REGISTRATION(TestAffinityMapTable);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestArg);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestBinPacketDictionary);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestContentHash);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestCpuSocketUtil);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestFbMerge);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestFbUtils);
+    CPPUNIT_TEST_SUITE_REGISTRATION(TestPackTiles);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestParser);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestPixelBufferSha1);
     CPPUNIT_TEST_SUITE_REGISTRATION(TestSha1);
@@ -9,11 +9,18 @@ using namespace scene_rdl2;
 RDL2_DSO_ATTR_DECLARE
 
     rdl2::AttributeKey<rdl2::Float> attrFakeness;
+    rdl2::AttributeKey<rdl2::Vec3fVector> attrVertexList0;
+    rdl2::AttributeKey<rdl2::Vec3fVector> attrVertexList1;
 
 RDL2_DSO_ATTR_DEFINE(rdl2::Geometry)
 
     attrFakeness =
         sceneClass.declareAttribute<rdl2::Float>("fakeness", 11);
 
-RDL2_DSO_ATTR_END
+    // Vertex positions at the two motion keys.
+    attrVertexList0 =
+        sceneClass.declareAttribute<rdl2::Vec3fVector>("vertex_list_0", rdl2::Vec3fVector());
+    attrVertexList1 =
+        sceneClass.declareAttribute<rdl2::Vec3fVector>("vertex_list_1", rdl2::Vec3fVector());
 
+RDL2_DSO_ATTR_END
@@ -16,6 +16,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <string>
+#include <vector>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -572,6 +573,95 @@ void TestAscii::testAttributeAlias()
     CPPUNIT_ASSERT(iv[2] == 3);
 }
 
+void
+TestAscii::testParallelFiles()
+{
+    // Each file sets up one object, and all of them reference (and so may
+    // create) the objects of the other files.
+    const int fileCount = 8;
+    std::vector<std::string> filenames;
+    for (int i = 0; i < fileCount; ++i) {
+        const std::string name = "/seq/shot/object" + std::to_string(i);
+        const std::string next = "/seq/shot/object" + std::to_string((i + 1) % fileCount);
+        filenames.push_back("parallel" + std::to_string(i) + ".rdla");
+        std::ofstream out(filenames.back());
+        out << "ExtensiveObject(\"" << name << "\") {\n"
+            << "    [\"int\"] = " << i << ",\n"
+            << "    [\"scene object\"] = ExtensiveObject(\"" << next << "\"),\n"
+            << "    [\"string\"] = bind(ExtensiveObject(\"" << next << "\"), \"file " << i << "\"),\n"
+            << "}\n";
+    }
+
+    SceneContext context;
+    const SceneClass* sc = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sc->getAttributeKey<Int>("int");
+    AttributeKey<SceneObject*> sceneObjectKey = sc->getAttributeKey<SceneObject*>("scene_object");
+    AttributeKey<String> stringKey = sc->getAttributeKey<String>("string");
+
+    AsciiReader::fromFiles(context, filenames);
+
+    for (int i = 0; i < fileCount; ++i) {
+        const SceneObject* obj = context.getSceneObject("/seq/shot/object" + std::to_string(i));
+        const SceneObject* next = context.getSceneObject("/seq/shot/object" + std::to_string((i + 1) % fileCount));
+        CPPUNIT_ASSERT_EQUAL(Int(i), obj->get(intKey));
+        CPPUNIT_ASSERT(obj->get(sceneObjectKey) == next);
+        CPPUNIT_ASSERT(obj->getBinding(stringKey) == next);
+        CPPUNIT_ASSERT_EQUAL(String("file " + std::to_string(i)), obj->get(stringKey));
+    }
+
+    // A broken file fails the whole load.
+    {
+        std::ofstream out(filenames.back());
+        out << "this is not rdla\n";
+    }
+    SceneContext badContext;
+    CPPUNIT_ASSERT_THROW(AsciiReader::fromFiles(badContext, filenames), except::RuntimeError);
+}
+
+void
+TestAscii::testParallelFilesBadAttribute()
+{
+    // Every file keeps updating one shared object, so the readers contend
+    // for its lock, and one of them sets an attribute which doesn't exist
+    // while holding it.
+    const int fileCount = 8;
+    const int badFile = 3;
+    std::vector<std::string> filenames;
+    for (int i = 0; i < fileCount; ++i) {
+        filenames.push_back("parallel_bad" + std::to_string(i) + ".rdla");
+        std::ofstream out(filenames.back());
+        out << "for j = 1, 50 do\n"
+            << "    ExtensiveObject(\"/seq/shot/shared\")[\"float\"] = j\n";
+        if (i == badFile) {
+            out << "    if j == 25 then\n"
+                << "        ExtensiveObject(\"/seq/shot/shared\")[\"not an attribute\"] = j\n"
+                << "    end\n";
+        }
+        out << "end\n"
+            << "ExtensiveObject(\"/seq/shot/object" << i << "\") { [\"int\"] = " << i << " }\n";
+    }
+
+    // As an error, the load fails rather than hanging on the lock.
+    {
+        SceneContext context;
+        CPPUNIT_ASSERT_THROW(AsciiReader::fromFiles(context, filenames, true), except::RuntimeError);
+    }
+
+    // As a warning, the other updates of the shared object still go through.
+    SceneContext context;
+    const SceneClass* sc = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sc->getAttributeKey<Int>("int");
+    AttributeKey<Float> floatKey = sc->getAttributeKey<Float>("float");
+
+    AsciiReader::fromFiles(context, filenames, false);
+
+    CPPUNIT_ASSERT_EQUAL(Float(50), context.getSceneObject("/seq/shot/shared")->get(floatKey));
+    for (int i = 0; i < fileCount; ++i) {
+        const SceneObject* obj = context.getSceneObject("/seq/shot/object" + std::to_string(i));
+        CPPUNIT_ASSERT_EQUAL(Int(i), obj->get(intKey));
+    }
+}
+
 void
 TestAscii::testDenormals()
 {
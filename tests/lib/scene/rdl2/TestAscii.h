@@ -36,6 +36,13 @@ public:
     /// Test that attribute aliases work
     void testAttributeAlias();
 
+    /// Test loading several files in parallel into one context.
+    void testParallelFiles();
+
+    /// Test that a bad attribute in one of several files loaded in parallel
+    /// fails the load (or warns) without leaving objects locked.
+    void testParallelFilesBadAttribute();
+
 #ifdef _TEST_ASCII_DO_TEST_MEMORY
     /// Test to ensure that no memory leaks for the AsciiReader/Writer
     void testMemory();
@@ -49,6 +56,8 @@ public:
     CPPUNIT_TEST(testDeltaEncoding);
     CPPUNIT_TEST(testNullReferences);
     CPPUNIT_TEST(testAttributeAlias);
+    CPPUNIT_TEST(testParallelFiles);
+    CPPUNIT_TEST(testParallelFilesBadAttribute);
 #ifdef _TEST_ASCII_DO_TEST_MEMORY
     CPPUNIT_TEST(testMemory);
 #endif
@@ -6,15 +6,23 @@
 
 #include <scene_rdl2/scene/rdl2/AttributeKey.h>
 #include <scene_rdl2/scene/rdl2/BinaryReader.h>
+#include <scene_rdl2/scene/rdl2/BinaryStreamReader.h>
 #include <scene_rdl2/scene/rdl2/BinaryWriter.h>
+#include <scene_rdl2/scene/rdl2/RecordCompression.h>
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
 #include <scene_rdl2/scene/rdl2/SceneContext.h>
 #include <scene_rdl2/scene/rdl2/SceneObject.h>
+#include <scene_rdl2/scene/rdl2/ValueContainerEnq.h>
 
 #include <scene_rdl2/common/except/exceptions.h>
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
 
 namespace scene_rdl2 {
@@ -624,6 +632,662 @@ TestBinary::testNullReferences()
     CPPUNIT_ASSERT(pizza->getBinding(stringKey) == nullptr);
 }
 
+void
+TestBinary::testMemoryMappedFile()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Float> floatKey = sceneClass->getAttributeKey<Float>("float");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<Vec3fVector> vec3fVecKey = sceneClass->getAttributeKey<Vec3fVector>("vec3f_vector");
+
+    FloatVector floatVec(10000);
+    Vec3fVector vec3fVec(10000);
+    for (size_t i = 0; i < floatVec.size(); ++i) {
+        floatVec[i] = static_cast<float>(i) * 0.5f;
+        vec3fVec[i] = Vec3f(static_cast<float>(i), 1.0f, -static_cast<float>(i));
+    }
+
+    SceneObject* pizza = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza");
+    pizza->beginUpdate();
+    pizza->set(floatKey, 3.0f, TIMESTEP_BEGIN);
+    pizza->set(floatKey, 4.0f, TIMESTEP_END);
+    pizza->set(floatVecKey, floatVec);
+    pizza->set(vec3fVecKey, vec3fVec);
+    pizza->endUpdate();
+
+    BinaryWriter writer(context);
+    writer.toFile("mapped.rdlb");
+
+    // Read once through the memory mapped path and once through the stream.
+    SceneContext mappedContext;
+    BinaryReader mappedReader(mappedContext);
+    mappedReader.setMemoryMappedFile(true);
+    mappedReader.fromFile("mapped.rdlb");
+
+    SceneContext streamContext;
+    BinaryReader streamReader(streamContext);
+    streamReader.setMemoryMappedFile(false);
+    streamReader.fromFile("mapped.rdlb");
+
+    const SceneObject* mappedPizza = mappedContext.getSceneObject("/seq/shot/pizza");
+    const SceneObject* streamPizza = streamContext.getSceneObject("/seq/shot/pizza");
+    CPPUNIT_ASSERT(mappedPizza->get(floatKey, TIMESTEP_BEGIN) == 3.0f);
+    CPPUNIT_ASSERT(mappedPizza->get(floatKey, TIMESTEP_END) == 4.0f);
+    CPPUNIT_ASSERT(mappedPizza->get(floatVecKey) == floatVec);
+    CPPUNIT_ASSERT(mappedPizza->get(vec3fVecKey) == vec3fVec);
+    CPPUNIT_ASSERT(mappedPizza->get(floatVecKey) == streamPizza->get(floatVecKey));
+    CPPUNIT_ASSERT(mappedPizza->get(vec3fVecKey) == streamPizza->get(vec3fVecKey));
+
+    // A file cut off in the middle of the payload must not be decoded.
+    {
+        std::ifstream in("mapped.rdlb", std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out("mapped_truncated.rdlb", std::ios::binary);
+        out.write(bytes.data(), bytes.size() / 2);
+    }
+    SceneContext truncatedContext;
+    BinaryReader truncatedReader(truncatedContext);
+    CPPUNIT_ASSERT_THROW(truncatedReader.fromFile("mapped_truncated.rdlb"), except::IoError);
+}
+
+void
+TestBinary::testParallelDecoding()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sceneClass->getAttributeKey<Int>("int");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<SceneObject*> sceneObjectKey = sceneClass->getAttributeKey<SceneObject*>("scene object");
+
+    const int numObjects = 1000;
+    for (int i = 0; i < numObjects; ++i) {
+        context.createSceneObject("ExtensiveObject", "/seq/shot/object" + std::to_string(i));
+    }
+    for (int i = 0; i < numObjects; ++i) {
+        SceneObject* obj = context.getSceneObject("/seq/shot/object" + std::to_string(i));
+        SceneObject* next = context.getSceneObject("/seq/shot/object" + std::to_string((i + 1) % numObjects));
+        obj->beginUpdate();
+        obj->set(intKey, i, TIMESTEP_BEGIN);
+        obj->set(floatVecKey, FloatVector(i % 17, static_cast<float>(i)));
+        obj->set(sceneObjectKey, next);
+        obj->endUpdate();
+    }
+
+    std::string manifest, payload;
+    BinaryWriter writer(context);
+    writer.toBytes(manifest, payload);
+
+    SceneContext readContext;
+    BinaryReader reader(readContext);
+    reader.setParallelDecoding(true);
+    reader.fromBytes(manifest, payload);
+
+    for (int i = 0; i < numObjects; ++i) {
+        const SceneObject* obj = readContext.getSceneObject("/seq/shot/object" + std::to_string(i));
+        const SceneObject* next = readContext.getSceneObject("/seq/shot/object" + std::to_string((i + 1) % numObjects));
+        CPPUNIT_ASSERT(obj->get(intKey, TIMESTEP_BEGIN) == i);
+        CPPUNIT_ASSERT(obj->get(floatVecKey) == FloatVector(i % 17, static_cast<float>(i)));
+        CPPUNIT_ASSERT(obj->get(sceneObjectKey) == next);
+    }
+}
+
+void
+TestBinary::testParallelEncoding()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sceneClass->getAttributeKey<Int>("int");
+    AttributeKey<Vec3fVector> vec3fVecKey = sceneClass->getAttributeKey<Vec3fVector>("vec3f_vector");
+
+    const int numObjects = 500;
+    for (int i = 0; i < numObjects; ++i) {
+        SceneObject* obj = context.createSceneObject("ExtensiveObject", "/seq/shot/object" + std::to_string(i));
+        obj->beginUpdate();
+        obj->set(intKey, i, TIMESTEP_BEGIN);
+        obj->set(vec3fVecKey, Vec3fVector(i % 31, Vec3f(static_cast<float>(i))));
+        obj->endUpdate();
+    }
+
+    auto encode = [&](bool parallel, bool delta, std::string& manifest, std::string& payload) {
+        BinaryWriter writer(context);
+        writer.setDeltaEncoding(delta);
+        writer.setParallelEncoding(parallel);
+        writer.toBytes(manifest, payload);
+    };
+
+    std::string serialManifest, serialPayload, parallelManifest, parallelPayload;
+    encode(false, false, serialManifest, serialPayload);
+    encode(true, false, parallelManifest, parallelPayload);
+    CPPUNIT_ASSERT(serialManifest == parallelManifest);
+    CPPUNIT_ASSERT(serialPayload == parallelPayload);
+
+    // Only the touched objects should end up in a delta update.
+    context.commitAllChanges();
+    for (int i = 0; i < numObjects; i += 7) {
+        SceneObject* obj = context.getSceneObject("/seq/shot/object" + std::to_string(i));
+        obj->beginUpdate();
+        obj->set(intKey, -i, TIMESTEP_BEGIN);
+        obj->endUpdate();
+    }
+
+    std::string serialDeltaManifest, serialDeltaPayload, parallelDeltaManifest, parallelDeltaPayload;
+    encode(false, true, serialDeltaManifest, serialDeltaPayload);
+    encode(true, true, parallelDeltaManifest, parallelDeltaPayload);
+    CPPUNIT_ASSERT(serialDeltaManifest == parallelDeltaManifest);
+    CPPUNIT_ASSERT(serialDeltaPayload == parallelDeltaPayload);
+
+    SceneContext readContext;
+    BinaryReader reader(readContext);
+    reader.fromBytes(parallelManifest, parallelPayload);
+    reader.fromBytes(parallelDeltaManifest, parallelDeltaPayload);
+    for (int i = 0; i < numObjects; ++i) {
+        const SceneObject* obj = readContext.getSceneObject("/seq/shot/object" + std::to_string(i));
+        CPPUNIT_ASSERT(obj->get(intKey, TIMESTEP_BEGIN) == ((i % 7 == 0) ? -i : i));
+    }
+}
+
+void
+TestBinary::testStreamReader()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sceneClass->getAttributeKey<Int>("int");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+
+    const int numObjects = 20;
+    for (int i = 0; i < numObjects; ++i) {
+        SceneObject* obj = context.createSceneObject("ExtensiveObject", "/seq/shot/object" + std::to_string(i));
+        obj->beginUpdate();
+        obj->set(intKey, i, TIMESTEP_BEGIN);
+        obj->set(floatVecKey, FloatVector(i * 10, 0.25f));
+        obj->endUpdate();
+    }
+
+    // Two frames back to back, as they would arrive on a socket.
+    std::ostringstream out;
+    BinaryWriter writer(context);
+    writer.toStream(out);
+    const std::string frame = out.str();
+    const std::string stream = frame + frame;
+
+    SceneContext readContext;
+    BinaryStreamReader reader(readContext);
+
+    // Push small pieces so headers, the manifest and records get split.
+    const std::size_t pieceSize = 7;
+    std::size_t offset = 0;
+    while (!reader.isComplete()) {
+        const std::size_t length = std::min(pieceSize, stream.size() - offset);
+        offset += reader.push(stream.data() + offset, length);
+        if (reader.hasManifest()) {
+            CPPUNIT_ASSERT(reader.getRecordCount() == static_cast<std::size_t>(numObjects) + 1);
+        }
+    }
+    CPPUNIT_ASSERT(offset == frame.size());
+    CPPUNIT_ASSERT(reader.getRecordsApplied() == reader.getRecordCount());
+
+    for (int i = 0; i < numObjects; ++i) {
+        const SceneObject* obj = readContext.getSceneObject("/seq/shot/object" + std::to_string(i));
+        CPPUNIT_ASSERT(obj->get(intKey, TIMESTEP_BEGIN) == i);
+        CPPUNIT_ASSERT(obj->get(floatVecKey) == FloatVector(i * 10, 0.25f));
+    }
+
+    // The rest of the stream is a second frame, pushed in one go.
+    reader.reset();
+    CPPUNIT_ASSERT(reader.push(stream.substr(offset)) == frame.size());
+    CPPUNIT_ASSERT(reader.isComplete());
+}
+
+void
+TestBinary::testCompression()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sceneClass->getAttributeKey<Int>("int");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<Vec3fVector> vec3fVecKey = sceneClass->getAttributeKey<Vec3fVector>("vec3f_vector");
+
+    const int numObjects = 50;
+    for (int i = 0; i < numObjects; ++i) {
+        FloatVector floatVec(1000 + i);
+        Vec3fVector vec3fVec(1000 + i);
+        for (size_t j = 0; j < floatVec.size(); ++j) {
+            floatVec[j] = static_cast<float>(j % 64) * 0.125f;
+            vec3fVec[j] = Vec3f(1.0f, static_cast<float>(i), static_cast<float>(j / 16));
+        }
+        SceneObject* obj = context.createSceneObject("ExtensiveObject", "/seq/shot/object" + std::to_string(i));
+        obj->beginUpdate();
+        obj->set(intKey, i, TIMESTEP_BEGIN);
+        obj->set(floatVecKey, floatVec);
+        obj->set(vec3fVecKey, vec3fVec);
+        obj->endUpdate();
+    }
+
+    std::string rawManifest, rawPayload;
+    BinaryWriter rawWriter(context);
+    rawWriter.toBytes(rawManifest, rawPayload);
+
+    std::string manifest, payload;
+    BinaryWriter writer(context);
+    writer.setCompression(true);
+    writer.toBytes(manifest, payload);
+    CPPUNIT_ASSERT(payload.size() < rawPayload.size());
+
+    std::ostringstream out;
+    BinaryWriter streamWriter(context);
+    streamWriter.setCompression(true);
+    streamWriter.toStream(out);
+    const std::string frame = out.str();
+
+    auto verify = [&](const SceneContext& readContext) {
+        for (int i = 0; i < numObjects; ++i) {
+            const SceneObject* orig = context.getSceneObject("/seq/shot/object" + std::to_string(i));
+            const SceneObject* obj = readContext.getSceneObject("/seq/shot/object" + std::to_string(i));
+            CPPUNIT_ASSERT(obj->get(intKey, TIMESTEP_BEGIN) == i);
+            CPPUNIT_ASSERT(obj->get(floatVecKey) == orig->get(floatVecKey));
+            CPPUNIT_ASSERT(obj->get(vec3fVecKey) == orig->get(vec3fVecKey));
+        }
+    };
+
+    SceneContext serialContext;
+    BinaryReader serialReader(serialContext);
+    serialReader.fromBytes(manifest, payload);
+    verify(serialContext);
+
+    SceneContext parallelContext;
+    BinaryReader parallelReader(parallelContext);
+    parallelReader.setParallelDecoding(true);
+    parallelReader.fromBytes(manifest, payload);
+    verify(parallelContext);
+
+    SceneContext streamContext;
+    BinaryStreamReader streamReader(streamContext);
+    for (std::size_t offset = 0; offset < frame.size(); offset += 1000) {
+        streamReader.push(frame.data() + offset, std::min<std::size_t>(1000, frame.size() - offset));
+    }
+    CPPUNIT_ASSERT(streamReader.isComplete());
+    verify(streamContext);
+
+    // A corrupt raw size in a record header is rejected before anything is
+    // allocated for it.
+    const std::string raw(4096, '\0');
+    std::string record;
+    CPPUNIT_ASSERT(RecordCompression::compress(raw.data(), raw.size(), record));
+    std::string decoded;
+    RecordCompression::decompress(record.data(), record.size(), decoded);
+    CPPUNIT_ASSERT(decoded == raw);
+    for (uint64_t rawSize : {uint64_t(1) << 62, uint64_t(raw.size()) * 1000}) {
+        std::string corrupt = record;
+        std::memcpy(&corrupt[0], &rawSize, sizeof(uint64_t));
+        std::string out;
+        CPPUNIT_ASSERT_THROW(RecordCompression::decompress(corrupt.data(), corrupt.size(), out),
+                             except::FormatError);
+        CPPUNIT_ASSERT(out.empty());
+    }
+}
+
+void
+TestBinary::testLazyAttributes()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("ExtensiveObject");
+    AttributeKey<Int> intKey = sceneClass->getAttributeKey<Int>("int");
+    AttributeKey<FloatVector> floatVecKey = sceneClass->getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<Vec3fVector> vec3fVecKey = sceneClass->getAttributeKey<Vec3fVector>("vec3f_vector");
+
+    // One object with values well over the lazy threshold, one under it.
+    FloatVector bigFloatVec(5000);
+    Vec3fVector bigVec3fVec(5000);
+    for (size_t i = 0; i < bigFloatVec.size(); ++i) {
+        bigFloatVec[i] = static_cast<float>(i % 100) * 0.25f;
+        bigVec3fVec[i] = Vec3f(static_cast<float>(i), 2.0f, -1.0f);
+    }
+    FloatVector smallFloatVec = {1.0f, 2.0f, 3.0f};
+
+    SceneObject* big = context.createSceneObject("ExtensiveObject", "/seq/shot/big");
+    big->beginUpdate();
+    big->set(intKey, 7, TIMESTEP_BEGIN);
+    big->set(floatVecKey, bigFloatVec);
+    big->set(vec3fVecKey, bigVec3fVec);
+    big->endUpdate();
+
+    SceneObject* small = context.createSceneObject("ExtensiveObject", "/seq/shot/small");
+    small->beginUpdate();
+    small->set(floatVecKey, smallFloatVec);
+    small->endUpdate();
+
+    std::string manifest, payload;
+    BinaryWriter writer(context);
+    writer.toBytes(manifest, payload);
+    writer.toFile("lazy.rdlb");
+
+    std::string compressedManifest, compressedPayload;
+    BinaryWriter compressedWriter(context);
+    compressedWriter.setCompression(true);
+    compressedWriter.toBytes(compressedManifest, compressedPayload);
+
+    auto verify = [&](const SceneContext& readContext) {
+        const SceneObject* readBig = readContext.getSceneObject("/seq/shot/big");
+        const SceneObject* readSmall = readContext.getSceneObject("/seq/shot/small");
+        CPPUNIT_ASSERT(readBig->isAttributeSet(sceneClass->getAttribute("float_vector")));
+        CPPUNIT_ASSERT(readBig->get(intKey, TIMESTEP_BEGIN) == 7);
+        CPPUNIT_ASSERT(readBig->get(floatVecKey) == bigFloatVec);
+        CPPUNIT_ASSERT(readBig->get(vec3fVecKey, TIMESTEP_END) == bigVec3fVec);
+        CPPUNIT_ASSERT(readSmall->get(floatVecKey) == smallFloatVec);
+    };
+
+    SceneContext fileContext;
+    {
+        BinaryReader reader(fileContext);
+        reader.setLazyAttributes(true);
+        reader.fromFile("lazy.rdlb");
+    }
+    verify(fileContext);
+
+    // The caller's payload can go away right after reading.
+    SceneContext bytesContext;
+    {
+        std::string payloadCopy = payload;
+        BinaryReader reader(bytesContext);
+        reader.setLazyAttributes(true);
+        reader.fromBytes(manifest, payloadCopy);
+    }
+    verify(bytesContext);
+
+    SceneContext compressedContext;
+    {
+        BinaryReader reader(compressedContext);
+        reader.setLazyAttributes(true);
+        reader.setParallelDecoding(true);
+        reader.fromBytes(compressedManifest, compressedPayload);
+    }
+    verify(compressedContext);
+
+    // Overwrite a value which was never accessed, then read it back.
+    SceneContext setContext;
+    BinaryReader setReader(setContext);
+    setReader.setLazyAttributes(true);
+    setReader.fromBytes(manifest, payload);
+    SceneObject* setBig = setContext.getSceneObject("/seq/shot/big");
+    setBig->beginUpdate();
+    setBig->set(floatVecKey, smallFloatVec);
+    setBig->endUpdate();
+    CPPUNIT_ASSERT(setBig->get(floatVecKey) == smallFloatVec);
+    CPPUNIT_ASSERT(setBig->get(vec3fVecKey) == bigVec3fVec);
+}
+
+void
+TestBinary::testUnknownVectorAttribute()
+{
+    // A FakeTeapot record with a vector attribute the class doesn't have and
+    // one of the wrong type, both large enough to be read lazily, followed by
+    // a good one.
+    const Vec3fVector vertices(1000, Vec3f(1.0f, 2.0f, 3.0f));
+    const FloatVector floats(1000, 0.5f);
+    std::string payload;
+    ValueContainerEnq record(&payload);
+    record.enqString("FakeTeapot");
+    record.enqString("/seq/shot/teapot");
+    auto enqAttribute = [&](AttributeType type, const std::string& name) {
+        record.enqAttributeType(type);
+        record.enqBool(false);
+        record.enqString(name);
+        record.enqUChar(0);
+        record.enqUChar(static_cast<unsigned char>(TIMESTEP_BEGIN));
+    };
+    enqAttribute(TYPE_VEC3F_VECTOR, "no_such_vector");
+    record.enqVec3fVector(vertices);
+    enqAttribute(TYPE_FLOAT_VECTOR, "vertex_list_0");
+    record.enqFloatVector(floats);
+    enqAttribute(TYPE_VEC3F_VECTOR, "vertex_list_1");
+    record.enqVec3fVector(vertices);
+    record.enqAttributeType(TYPE_UNKNOWN); // end of attributes
+    record.enqBool(false);                 // end of bindings
+    const std::size_t recordSize = record.finalize();
+
+    std::string manifest;
+    ValueContainerEnq records(&manifest);
+    records.enqVLSizeT(1);
+    records.enqVLUInt(static_cast<unsigned int>(BinaryWriter::SCENE_OBJECT_2));
+    records.enqVLSizeT(recordSize);
+    records.finalize();
+
+    // The bad values are skipped with a warning and the rest still decodes.
+    for (bool lazy : {false, true}) {
+        SceneContext context;
+        BinaryReader reader(context);
+        reader.setLazyAttributes(lazy);
+        reader.fromBytes(manifest, payload);
+        const SceneObject* teapot = context.getSceneObject("/seq/shot/teapot");
+        const SceneClass& sceneClass = teapot->getSceneClass();
+        CPPUNIT_ASSERT(teapot->get(sceneClass.getAttributeKey<Vec3fVector>("vertex_list_0")).empty());
+        CPPUNIT_ASSERT(teapot->get(sceneClass.getAttributeKey<Vec3fVector>("vertex_list_1")) == vertices);
+    }
+
+    SceneContext context;
+    BinaryReader reader(context);
+    reader.setWarningsAsErrors(true);
+    CPPUNIT_ASSERT_THROW(reader.fromBytes(manifest, payload), except::KeyError);
+}
+
+void
+TestBinary::testVectorDeltaEncoding()
+{
+    SceneContext context;
+    const SceneClass* sceneClass = context.createSceneClass("FakeTeapot");
+    AttributeKey<Vec3fVector> key0 = sceneClass->getAttributeKey<Vec3fVector>("vertex_list_0");
+    AttributeKey<Vec3fVector> key1 = sceneClass->getAttributeKey<Vec3fVector>("vertex_list_1");
+
+    // One teapot barely moves between the motion keys, the other moves
+    // everywhere, and the third has keys of different lengths.
+    Vec3fVector vertices(1000);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = Vec3f(static_cast<float>(i), 1.0f, 0.0f);
+    }
+    Vec3fVector fewMoved = vertices;
+    for (size_t i = 0; i < fewMoved.size(); i += 100) {
+        fewMoved[i].y += 0.5f;
+    }
+    fewMoved.back().z = -0.0f;
+    Vec3fVector allMoved = vertices;
+    for (Vec3f& v : allMoved) {
+        v.x += 0.25f;
+    }
+    Vec3fVector shorter(vertices.begin(), vertices.begin() + 500);
+
+    SceneObject* still = context.createSceneObject("FakeTeapot", "/seq/shot/still");
+    SceneObject* moving = context.createSceneObject("FakeTeapot", "/seq/shot/moving");
+    SceneObject* growing = context.createSceneObject("FakeTeapot", "/seq/shot/growing");
+    for (SceneObject* obj : {still, moving, growing}) {
+        SceneObject::UpdateGuard guard(obj);
+        obj->set(key0, obj == growing ? shorter : vertices);
+        obj->set(key1, obj == still ? fewMoved : (obj == moving ? allMoved : vertices));
+    }
+
+    auto verify = [&](const SceneContext& readContext) {
+        for (const char* name : {"/seq/shot/still", "/seq/shot/moving", "/seq/shot/growing"}) {
+            const SceneObject* orig = context.getSceneObject(name);
+            const SceneObject* obj = readContext.getSceneObject(name);
+            CPPUNIT_ASSERT(obj->get(key0) == orig->get(key0));
+            CPPUNIT_ASSERT(obj->get(key1) == orig->get(key1));
+        }
+        // Elements are compared bitwise, so a zero which only changed sign
+        // still comes back.
+        const Vec3fVector& readBack = readContext.getSceneObject("/seq/shot/still")->get(key1);
+        CPPUNIT_ASSERT(std::signbit(readBack.back().z));
+    };
+
+    std::string rawManifest, rawPayload;
+    BinaryWriter rawWriter(context);
+    rawWriter.toBytes(rawManifest, rawPayload);
+
+    for (bool transient : {false, true}) {
+        std::string manifest, payload;
+        BinaryWriter writer(context);
+        writer.setTransientEncoding(transient);
+        writer.setVectorDeltaEncoding(true);
+        writer.toBytes(manifest, payload);
+        if (!transient) {
+            // Only the still teapot's second key can be made smaller.
+            CPPUNIT_ASSERT(payload.size() + vertices.size() * sizeof(Vec3f) / 2 < rawPayload.size());
+        }
+
+        SceneContext readContext;
+        BinaryReader reader(readContext);
+        reader.fromBytes(manifest, payload);
+        verify(readContext);
+
+        SceneContext lazyContext;
+        BinaryReader lazyReader(lazyContext);
+        lazyReader.setLazyAttributes(true);
+        lazyReader.fromBytes(manifest, payload);
+        verify(lazyContext);
+    }
+}
+
+void
+TestBinary::testMalformedVectorDelta()
+{
+    SceneContext classContext;
+    const SceneClass* sceneClass = classContext.createSceneClass("FakeTeapot");
+    int vertexList0Id = -1, vertexList1Id = -1;
+    int attributeId = 0;
+    for (auto iter = sceneClass->beginAttributes(); iter != sceneClass->endAttributes(); ++iter, ++attributeId) {
+        if ((*iter)->getName() == "vertex_list_0") vertexList0Id = attributeId;
+        if ((*iter)->getName() == "vertex_list_1") vertexList1Id = attributeId;
+    }
+
+    // How the delta of the second vertex list of a FakeTeapot is written.
+    struct Delta
+    {
+        bool transient;
+        std::string referenceName;
+        int referenceId;
+        std::size_t size;
+        std::size_t count;
+        std::size_t written;
+        std::size_t firstGap;
+    };
+
+    // Writes a frame holding one FakeTeapot whose second vertex list is the
+    // given delta against the first, followed by a float attribute.
+    auto writeFrame = [&](const Delta& delta, std::string& manifest, std::string& payload) {
+        const Vec3fVector base(100, Vec3f(1.0f, 2.0f, 3.0f));
+        ValueContainerEnq record(&payload);
+        record.enqString("FakeTeapot");
+        record.enqString("/seq/shot/teapot");
+        record.enqAttributeType(TYPE_VEC3F_VECTOR);
+        record.enqBool(false);
+        record.enqString("vertex_list_0");
+        record.enqUChar(0);
+        record.enqUChar(static_cast<unsigned char>(TIMESTEP_BEGIN));
+        record.enqVec3fVector(base);
+        record.enqAttributeType(TYPE_VEC3F_VECTOR);
+        record.enqBool(delta.transient);
+        if (delta.transient) {
+            record.enqInt(vertexList1Id);
+        } else {
+            record.enqString("vertex_list_1");
+        }
+        record.enqUChar(0);
+        record.enqUChar(static_cast<unsigned char>(TIMESTEP_BEGIN | 0x80)); // delta flag
+        if (delta.transient) {
+            record.enqInt(delta.referenceId);
+        } else {
+            record.enqString(delta.referenceName);
+        }
+        record.enqVLSizeT(delta.size);
+        record.enqVLSizeT(delta.count);
+        for (std::size_t i = 0; i < delta.written; ++i) {
+            record.enqVLSizeT(i == 0 ? delta.firstGap : 1);
+            record.enq<Vec3f>(Vec3f(4.0f, 5.0f, 6.0f));
+        }
+        if (delta.written == delta.count) {
+            record.enqAttributeType(TYPE_FLOAT);
+            record.enqBool(false);
+            record.enqString("fakeness");
+            record.enqUChar(0);
+            record.enqUChar(static_cast<unsigned char>(TIMESTEP_BEGIN));
+            record.enqFloat(7.0f);
+            record.enqAttributeType(TYPE_UNKNOWN); // end of attributes
+            record.enqBool(false);                 // end of bindings
+        }
+        const std::size_t recordSize = record.finalize();
+
+        ValueContainerEnq records(&manifest);
+        records.enqVLSizeT(1);
+        records.enqVLUInt(static_cast<unsigned int>(BinaryWriter::SCENE_OBJECT_2));
+        records.enqVLSizeT(recordSize);
+        records.finalize();
+    };
+
+    auto read = [&](const Delta& delta, bool warningsAsErrors, SceneContext& context) {
+        std::string manifest, payload;
+        writeFrame(delta, manifest, payload);
+        BinaryReader reader(context);
+        reader.setWarningsAsErrors(warningsAsErrors);
+        reader.fromBytes(manifest, payload);
+    };
+    auto getVertexList1 = [](const SceneContext& context) -> const Vec3fVector& {
+        const SceneObject* teapot = context.getSceneObject("/seq/shot/teapot");
+        return teapot->get(teapot->getSceneClass().getAttributeKey<Vec3fVector>("vertex_list_1"));
+    };
+    auto getFakeness = [](const SceneContext& context) {
+        const SceneObject* teapot = context.getSceneObject("/seq/shot/teapot");
+        return teapot->get(teapot->getSceneClass().getAttributeKey<Float>("fakeness"));
+    };
+
+    // Well formed deltas read back, by name and by index.
+    for (bool transient : {false, true}) {
+        SceneContext context;
+        read({transient, "vertex_list_0", vertexList0Id, 100, 3, 3, 1}, true, context);
+        const Vec3fVector& vec = getVertexList1(context);
+        CPPUNIT_ASSERT(vec.size() == 100);
+        CPPUNIT_ASSERT(vec[0] == Vec3f(1.0f, 2.0f, 3.0f));
+        CPPUNIT_ASSERT(vec[3] == Vec3f(4.0f, 5.0f, 6.0f));
+        CPPUNIT_ASSERT(getFakeness(context) == 7.0f);
+    }
+
+    // A reference which doesn't exist, has another type or another length is
+    // rejected. When warnings aren't errors the delta is skipped and the rest
+    // of the record still decodes.
+    const std::vector<std::pair<Delta, bool>> rejected = {
+        {{false, "no_such_vector", 0, 100, 3, 3, 1}, true},     // KeyError
+        {{true, "", 100000, 100, 3, 3, 1}, true},               // KeyError
+        {{true, "", -1, 100, 3, 3, 1}, true},                   // KeyError
+        {{false, "fakeness", 0, 100, 3, 3, 1}, false},          // TypeError
+        {{false, "vertex_list_0", 0, 50, 3, 3, 1}, false}       // TypeError
+    };
+    for (const auto& entry : rejected) {
+        SceneContext context;
+        if (entry.second) {
+            CPPUNIT_ASSERT_THROW(read(entry.first, true, context), except::KeyError);
+        } else {
+            CPPUNIT_ASSERT_THROW(read(entry.first, true, context), except::TypeError);
+        }
+        SceneContext warnContext;
+        read(entry.first, false, warnContext);
+        CPPUNIT_ASSERT(getVertexList1(warnContext).empty());
+        CPPUNIT_ASSERT(getFakeness(warnContext) == 7.0f);
+    }
+
+    // A delta cut off before all its elements, or with an element past the
+    // end of the vector, is corrupt and is never decoded, even when warnings
+    // aren't errors.
+    const std::vector<Delta> corrupt = {
+        {false, "vertex_list_0", 0, 100, 50, 3, 1},
+        {false, "vertex_list_0", 0, 100, 3, 3, 98},
+        {false, "vertex_list_0", 0, 100, 3, 3, 100000}
+    };
+    for (const Delta& delta : corrupt) {
+        for (bool warningsAsErrors : {true, false}) {
+            SceneContext context;
+            CPPUNIT_ASSERT_THROW(read(delta, warningsAsErrors, context), except::FormatError);
+        }
+    }
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
@@ -32,11 +32,56 @@ public:
     /// and bindings.
     void testNullReferences();
 
+    /// Test that memory mapped and stream based file reading decode the same
+    /// data, and that truncated files are rejected.
+    void testMemoryMappedFile();
+
+    /// Test that parallel record decoding produces the same objects as serial
+    /// decoding, including references between objects.
+    void testParallelDecoding();
+
+    /// Test that parallel record encoding produces exactly the same bytes as
+    /// serial encoding, for both full and delta updates.
+    void testParallelEncoding();
+
+    /// Test incremental decoding of a frame pushed in small pieces.
+    void testStreamReader();
+
+    /// Test that compressed records roundtrip through the serial, parallel
+    /// and incremental readers, and actually make the payload smaller.
+    void testCompression();
+
+    /// Test that large vector attributes read lazily (from a file, from bytes
+    /// and from compressed records) come back intact on first access, and
+    /// that setting them before they were ever read still works.
+    void testLazyAttributes();
+
+    /// Test that a vector value of an unknown or mistyped attribute is
+    /// skipped in warning mode and the rest of the record still decodes.
+    void testUnknownVectorAttribute();
+
+    /// Test that vectors written as sparse deltas against an earlier vector
+    /// of the same type roundtrip, and make the payload smaller.
+    void testVectorDeltaEncoding();
+
+    /// Test that a vector delta against a missing or mismatched reference,
+    /// or a corrupt one, is rejected without losing track of the record.
+    void testMalformedVectorDelta();
+
     CPPUNIT_TEST_SUITE(TestBinary);
     CPPUNIT_TEST(testRoundtrip);
     CPPUNIT_TEST(testTransientEncoding);
     CPPUNIT_TEST(testDeltaEncoding);
     CPPUNIT_TEST(testNullReferences);
+    CPPUNIT_TEST(testMemoryMappedFile);
+    CPPUNIT_TEST(testParallelDecoding);
+    CPPUNIT_TEST(testParallelEncoding);
+    CPPUNIT_TEST(testStreamReader);
+    CPPUNIT_TEST(testCompression);
+    CPPUNIT_TEST(testLazyAttributes);
+    CPPUNIT_TEST(testUnknownVectorAttribute);
+    CPPUNIT_TEST(testVectorDeltaEncoding);
+    CPPUNIT_TEST(testMalformedVectorDelta);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -17,8 +17,13 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <sstream>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -511,6 +516,189 @@ TestLayer::testContextLookup()
 
 
 
+void
+TestLayer::testAssignmentIds()
+{
+    Geometry* teapot = mContext->createSceneObject("FakeTeapot", "/seq/shot/teapot")->asA<Geometry>();
+    Geometry* teapot2 = mContext->createSceneObject("FakeTeapot", "/seq/shot/teapot2")->asA<Geometry>();
+    Material* material1 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material1")->asA<Material>();
+    Material* material2 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material2")->asA<Material>();
+    LightSet* rig = mContext->createSceneObject("LightSet", "/seq/shot/rig")->asA<LightSet>();
+
+    Layer* layer = mContext->createSceneObject("Layer", "/seq/shot/layer")->asA<Layer>();
+
+    auto sortedIds = [](const Layer::AssignmentIdVector& ids) {
+        Layer::AssignmentIdVector sorted(ids);
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    };
+    const Layer::AssignmentIdVector none;
+
+    layer->beginUpdate();
+    CPPUNIT_ASSERT(layer->assign(teapot, "lid", material1, rig) == 0);
+    CPPUNIT_ASSERT(layer->assign(teapot, "body", material1, rig) == 1);
+    CPPUNIT_ASSERT(layer->assign(teapot2, "spout", material2, nullptr) == 2);
+    layer->endUpdate();
+
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material1)) == Layer::AssignmentIdVector({0, 1}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material2)) == Layer::AssignmentIdVector({2}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(rig)) == Layer::AssignmentIdVector({0, 1}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(teapot)) == Layer::AssignmentIdVector({0, 1}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(teapot2)) == Layer::AssignmentIdVector({2}));
+
+    // Reassignments move assignments between objects.
+    layer->beginUpdate();
+    CPPUNIT_ASSERT(layer->assign(teapot, "lid", material2, nullptr) == 0);
+    layer->endUpdate();
+
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material1)) == Layer::AssignmentIdVector({1}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material2)) == Layer::AssignmentIdVector({0, 2}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(rig)) == Layer::AssignmentIdVector({1}));
+
+    layer->beginUpdate();
+    CPPUNIT_ASSERT(layer->assign(teapot, "body", material2, nullptr) == 1);
+    layer->endUpdate();
+
+    CPPUNIT_ASSERT(layer->getAssignmentIds(material1) == none);
+    CPPUNIT_ASSERT(layer->getAssignmentIds(rig) == none);
+
+    Layer::MaterialSet materials;
+    layer->getAllMaterials(materials);
+    CPPUNIT_ASSERT(materials == Layer::MaterialSet({material2}));
+
+    Layer::LightSetSet lightSets;
+    layer->getAllLightSets(lightSets);
+    CPPUNIT_ASSERT(lightSets.empty());
+
+    // Changing the assignment attributes directly is picked up too.
+    layer->beginUpdate();
+    layer->set("surface_shaders", SceneObjectVector({material1, material1, material2}));
+    layer->endUpdate();
+
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material1)) == Layer::AssignmentIdVector({0, 1}));
+    CPPUNIT_ASSERT(sortedIds(layer->getAssignmentIds(material2)) == Layer::AssignmentIdVector({2}));
+
+    // Clearing the layer empties the indices.
+    layer->beginUpdate();
+    layer->clear();
+    CPPUNIT_ASSERT(layer->assign(teapot2, "", material1, rig) == 0);
+    layer->endUpdate();
+
+    CPPUNIT_ASSERT(layer->getAssignmentIds(material1) == Layer::AssignmentIdVector({0}));
+    CPPUNIT_ASSERT(layer->getAssignmentIds(material2) == none);
+    CPPUNIT_ASSERT(layer->getAssignmentIds(teapot) == none);
+    CPPUNIT_ASSERT(layer->getAssignmentIds(teapot2) == Layer::AssignmentIdVector({0}));
+}
+
+void
+TestLayer::testDistinctAssignments()
+{
+    Geometry* teapot = mContext->createSceneObject("FakeTeapot", "/seq/shot/teapot")->asA<Geometry>();
+    Material* material1 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material1")->asA<Material>();
+    Material* material2 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material2")->asA<Material>();
+    Displacement* displacement = mContext->createSceneObject("FakeDisplacement", "/seq/shot/displacement")->asA<Displacement>();
+    LightSet* rig = mContext->createSceneObject("LightSet", "/seq/shot/rig")->asA<LightSet>();
+
+    Layer* layer = mContext->createSceneObject("Layer", "/seq/shot/layer")->asA<Layer>();
+
+    // Many parts sharing a couple of combinations.
+    const int32_t partCount = 100;
+    layer->beginUpdate();
+    for (int32_t i = 0; i < partCount; ++i) {
+        Material* material = (i % 2) ? material2 : material1;
+        CPPUNIT_ASSERT(layer->assign(teapot, "part" + std::to_string(i), material, rig,
+                                     displacement, nullptr) == i);
+    }
+    layer->endUpdate();
+    CPPUNIT_ASSERT(layer->getDistinctAssignmentCount() == 2);
+
+    for (int32_t i = 0; i < partCount; ++i) {
+        CPPUNIT_ASSERT(layer->lookupMaterial(i) == ((i % 2) ? material2 : material1));
+        CPPUNIT_ASSERT(layer->lookupLightSet(i) == rig);
+        CPPUNIT_ASSERT(layer->lookupDisplacement(i) == displacement);
+        CPPUNIT_ASSERT(layer->lookupVolumeShader(i) == nullptr);
+    }
+    CPPUNIT_ASSERT_THROW(layer->lookupMaterial(partCount), except::IndexError);
+
+    // A new combination adds an entry, and an entry nothing uses goes away.
+    layer->beginUpdate();
+    layer->assign(teapot, "part0", material1, nullptr);
+    layer->endUpdate();
+    CPPUNIT_ASSERT(layer->getDistinctAssignmentCount() == 3);
+    CPPUNIT_ASSERT(layer->lookup(0) == Layer::MaterialLightSetPair(material1, nullptr));
+    CPPUNIT_ASSERT(layer->lookupDisplacement(0) == nullptr);
+
+    layer->beginUpdate();
+    for (int32_t i = 0; i < partCount; i += 2) {
+        layer->assign(teapot, "part" + std::to_string(i), material2, rig, displacement, nullptr);
+    }
+    layer->endUpdate();
+    CPPUNIT_ASSERT(layer->getDistinctAssignmentCount() == 1);
+    for (int32_t i = 0; i < partCount; ++i) {
+        CPPUNIT_ASSERT(layer->lookupMaterial(i) == material2);
+    }
+
+    // Lookups see direct changes to the attributes.
+    SceneObjectVector surfaceShaders(partCount, material1);
+    layer->beginUpdate();
+    layer->set("surface_shaders", surfaceShaders);
+    layer->endUpdate();
+    CPPUNIT_ASSERT(layer->lookupMaterial(1) == material1);
+    CPPUNIT_ASSERT(layer->getDistinctAssignmentCount() == 1);
+    CPPUNIT_ASSERT(layer->lookupMaterial(1) == material1);
+}
+
+void
+TestLayer::testConcurrentIndexRebuild()
+{
+    Geometry* teapot = mContext->createSceneObject("FakeTeapot", "/seq/shot/teapot")->asA<Geometry>();
+    Material* material1 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material1")->asA<Material>();
+    Material* material2 = mContext->createSceneObject("FakeMaterial", "/seq/shot/material2")->asA<Material>();
+    LightSet* rig = mContext->createSceneObject("LightSet", "/seq/shot/rig")->asA<LightSet>();
+
+    Layer* layer = mContext->createSceneObject("Layer", "/seq/shot/layer")->asA<Layer>();
+
+    const int32_t partCount = 1000;
+    layer->beginUpdate();
+    for (int32_t i = 0; i < partCount; ++i) {
+        layer->assign(teapot, "part" + std::to_string(i), material1, rig);
+    }
+    layer->endUpdate();
+
+    for (int round = 0; round < 4; ++round) {
+        // A direct set leaves the indices out of date, so the first const
+        // query of each thread races to rebuild them.
+        SceneObjectVector surfaceShaders(partCount, material1);
+        for (int32_t i = round % 2; i < partCount; i += 2) {
+            surfaceShaders[i] = material2;
+        }
+        layer->beginUpdate();
+        layer->set("surface_shaders", surfaceShaders);
+        layer->endUpdate();
+
+        const Layer* constLayer = layer;
+        std::atomic<int> mismatches(0);
+        tbb::parallel_for(0, 64, [&](int task) {
+            if (task % 2) {
+                Layer::GeometrySet geometries;
+                constLayer->getAllGeometries(geometries);
+                if (geometries != Layer::GeometrySet({teapot}) ||
+                        constLayer->getAssignmentIds(material2).size() != std::size_t(partCount / 2) ||
+                        constLayer->getDistinctAssignmentCount() != 2) {
+                    ++mismatches;
+                }
+            } else {
+                for (int32_t i = 0; i < partCount; ++i) {
+                    if (constLayer->lookupMaterial(i) != surfaceShaders[i]) {
+                        ++mismatches;
+                    }
+                }
+            }
+        });
+        CPPUNIT_ASSERT_EQUAL(0, mismatches.load());
+    }
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
@@ -38,6 +38,18 @@ public:
 
     void testSerialize();
 
+    /// Test that the reverse assignment indices follow reassignments, clears,
+    /// and direct changes to the Layer's attributes.
+    void testAssignmentIds();
+
+    /// Test that assignments with the same objects share a lookup table entry,
+    /// and that lookups stay correct as the table changes.
+    void testDistinctAssignments();
+
+    /// Test that const queries and lookups from many threads agree while the
+    /// reverse indices are rebuilt after a direct change to the attributes.
+    void testConcurrentIndexRebuild();
+
     CPPUNIT_TEST_SUITE(TestLayer);
     CPPUNIT_TEST(testAssignAndLookup);
     CPPUNIT_TEST(testDefaultAssignments);
@@ -45,6 +57,9 @@ public:
     CPPUNIT_TEST(testIterators);
     CPPUNIT_TEST(testContextLookup);
     CPPUNIT_TEST(testSerialize);
+    CPPUNIT_TEST(testAssignmentIds);
+    CPPUNIT_TEST(testDistinctAssignments);
+    CPPUNIT_TEST(testConcurrentIndexRebuild);
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -5,9 +5,13 @@
 #include "TestSceneClass.h"
 
 #include <scene_rdl2/scene/rdl2/Attribute.h>
+#include <scene_rdl2/scene/rdl2/AttributeColumn.h>
 #include <scene_rdl2/scene/rdl2/AttributeKey.h>
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
+#include <scene_rdl2/scene/rdl2/SceneContext.h>
+#include <scene_rdl2/scene/rdl2/SceneObject.h>
 #include <scene_rdl2/scene/rdl2/Types.h>
+#include <scene_rdl2/scene/rdl2/UpdateHelper.h>
 
 #include <scene_rdl2/common/except/exceptions.h>
 
@@ -2556,6 +2560,67 @@ TestSceneClass::testAttributeStorage()
     }
 }
 
+void
+TestSceneClass::testAttributeColumn()
+{
+    SceneContext context;
+    SceneObject* pizza = context.createSceneObject("ExampleObject", "/seq/shot/pizza");
+    SceneObject* cookie = context.createSceneObject("ExampleObject", "/seq/shot/cookie");
+    SceneObject* pie = context.createSceneObject("ExampleObject", "/seq/shot/pie");
+    const SceneClass& sc = pizza->getSceneClass();
+    AttributeKey<Int> awesomeness = sc.getAttributeKey<Int>("awesomeness");
+
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), sc.getSceneObjects().size());
+    CPPUNIT_ASSERT(sc.getSceneObjects()[1] == cookie);
+
+    // Clears the update masks the way a render update cycle does.
+    auto finishUpdate = [&]() {
+        UpdateHelper helper;
+        for (SceneObject* obj : sc.getSceneObjects()) {
+            obj->updatePrep(helper, 0);
+        }
+        for (SceneObject* obj : sc.getSceneObjects()) {
+            obj->resetUpdate();
+        }
+    };
+
+    pie->beginUpdate();
+    pie->set(awesomeness, Int(3));
+    pie->endUpdate();
+
+    AttributeColumn<Int> column(sc, awesomeness);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), column.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(0), column.getDirtyBegin());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), column.getDirtyEnd());
+    CPPUNIT_ASSERT_EQUAL(Int(11), column[0]);
+    CPPUNIT_ASSERT_EQUAL(Int(11), column.data()[1]);
+    CPPUNIT_ASSERT_EQUAL(Int(3), column[2]);
+    CPPUNIT_ASSERT(column.getSceneObject(2) == pie);
+    finishUpdate();
+
+    // Nothing changed.
+    CPPUNIT_ASSERT(!column.update());
+    CPPUNIT_ASSERT_EQUAL(column.getDirtyBegin(), column.getDirtyEnd());
+
+    // Only the changed row is rewritten.
+    cookie->beginUpdate();
+    cookie->set(awesomeness, Int(42));
+    cookie->endUpdate();
+    CPPUNIT_ASSERT(column.update());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), column.getDirtyBegin());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), column.getDirtyEnd());
+    CPPUNIT_ASSERT_EQUAL(Int(42), column[1]);
+    finishUpdate();
+
+    // New objects are appended.
+    context.createSceneObject("ExampleObject", "/seq/shot/cake");
+    CPPUNIT_ASSERT(column.update());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), column.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), column.getDirtyBegin());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(4), column.getDirtyEnd());
+    CPPUNIT_ASSERT_EQUAL(Int(11), column[3]);
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
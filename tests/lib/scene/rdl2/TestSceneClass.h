@@ -62,6 +62,9 @@ public:
     /// and set values in it.
     void testAttributeStorage();
 
+    /// Test that an AttributeColumn tracks objects and changed values.
+    void testAttributeColumn();
+
     CPPUNIT_TEST_SUITE(TestSceneClass);
     CPPUNIT_TEST(testGetName);
     CPPUNIT_TEST(testDeclareSimple);
@@ -77,6 +80,7 @@ public:
     CPPUNIT_TEST(testMemoryLayout);
     CPPUNIT_TEST(testCreateDestroyObject);
     CPPUNIT_TEST(testAttributeStorage);
+    CPPUNIT_TEST(testAttributeColumn);
     CPPUNIT_TEST_SUITE_END();
 
 private:
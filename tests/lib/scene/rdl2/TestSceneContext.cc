@@ -4,17 +4,32 @@
 
 #include "TestSceneContext.h"
 
+#include <scene_rdl2/scene/rdl2/Attribute.h>
 #include <scene_rdl2/scene/rdl2/AttributeKey.h>
+#include <scene_rdl2/scene/rdl2/BinaryWriter.h>
 #include <scene_rdl2/scene/rdl2/SceneContext.h>
+#include <scene_rdl2/scene/rdl2/SceneContextSnapshot.h>
 #include <scene_rdl2/scene/rdl2/SceneClass.h>
+#include <scene_rdl2/scene/rdl2/SceneClassCache.h>
 #include <scene_rdl2/scene/rdl2/SceneObject.h>
 #include <scene_rdl2/scene/rdl2/SceneVariables.h>
 #include <scene_rdl2/scene/rdl2/Types.h>
+#include <scene_rdl2/scene/rdl2/UpdateHelper.h>
 
 #include <scene_rdl2/common/except/exceptions.h>
 #include <scene_rdl2/common/math/Color.h>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -416,6 +431,366 @@ TestSceneContext::testCreateObjectFailure()
     CPPUNIT_ASSERT_EQUAL(numBefore, numAfter);
 }
 
+void
+TestSceneContext::testFrozenNameIndex()
+{
+    SceneContext context;
+    SceneObject* pizza = context.createSceneObject("ExampleObject", "/seq/shot/pizza");
+    context.commitAllChanges();
+
+    // Served from the frozen index.
+    const SceneContext& constContext = context;
+    CPPUNIT_ASSERT(context.getSceneObject("/seq/shot/pizza") == pizza);
+    CPPUNIT_ASSERT(constContext.getSceneObject("/seq/shot/pizza") == pizza);
+    CPPUNIT_ASSERT(context.createSceneObject("ExampleObject", "/seq/shot/pizza") == pizza);
+    CPPUNIT_ASSERT(context.sceneObjectExists("/seq/shot/pizza"));
+    CPPUNIT_ASSERT(context.sceneClassExists("ExampleObject"));
+    CPPUNIT_ASSERT(context.getSceneClass("ExampleObject") == &pizza->getSceneClass());
+    CPPUNIT_ASSERT(!context.sceneObjectExists("/seq/shot/not_a_pizza"));
+    CPPUNIT_ASSERT_THROW(context.getSceneObject("/seq/shot/not_a_pizza"), except::KeyError);
+
+    // The class mismatch check still applies to frozen objects.
+    CPPUNIT_ASSERT_THROW(context.createSceneObject("GeometrySet", "/seq/shot/pizza"), except::TypeError);
+
+    // Created after the index was built, so found through the hash map.
+    SceneObject* cookie = context.createSceneObject("ExampleObject", "/seq/shot/cookie");
+    CPPUNIT_ASSERT(context.getSceneObject("/seq/shot/cookie") == cookie);
+    CPPUNIT_ASSERT(context.sceneObjectExists("/seq/shot/cookie"));
+
+    // And in the index after the next commit.
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(context.getSceneObject("/seq/shot/cookie") == cookie);
+    CPPUNIT_ASSERT(context.getSceneObject("/seq/shot/pizza") == pizza);
+}
+
+void
+TestSceneContext::testFrozenNameIndexConcurrentCommit()
+{
+    SceneContext context;
+    SceneObject* pizza = context.createSceneObject("ExampleObject", "/seq/shot/pizza");
+    context.commitAllChanges();
+
+    // Readers hammer the frozen index while every commit below replaces it.
+    std::atomic<bool> done(false);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            const SceneContext& constContext = context;
+            while (!done.load(std::memory_order_acquire)) {
+                if (constContext.getSceneObject("/seq/shot/pizza") != pizza ||
+                    !constContext.sceneClassExists("ExampleObject")) {
+                    ++mismatches;
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        context.createSceneObject("ExampleObject", "/seq/shot/cookie" + std::to_string(i));
+        context.commitAllChanges();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    CPPUNIT_ASSERT_EQUAL(0, mismatches.load());
+    for (int i = 0; i < 200; ++i) {
+        CPPUNIT_ASSERT(context.sceneObjectExists("/seq/shot/cookie" + std::to_string(i)));
+    }
+}
+
+void
+TestSceneContext::testDirtyList()
+{
+    SceneContext context;
+    SceneObject* pizza = context.createSceneObject("ExampleObject", "/seq/shot/pizza");
+    SceneObject* cookie = context.createSceneObject("ExampleObject", "/seq/shot/cookie");
+    AttributeKey<Int> awesomeness = pizza->getSceneClass().getAttributeKey<Int>("awesomeness");
+
+    // New objects start out dirty.
+    CPPUNIT_ASSERT(pizza->isDirty());
+    CPPUNIT_ASSERT(cookie->isDirty());
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(!pizza->isDirty());
+    CPPUNIT_ASSERT(!cookie->isDirty());
+
+    // Setting a value to what it already is doesn't dirty the object.
+    pizza->beginUpdate();
+    pizza->set(awesomeness, 11);
+    pizza->endUpdate();
+    CPPUNIT_ASSERT(!pizza->isDirty());
+
+    pizza->beginUpdate();
+    pizza->set(awesomeness, 12);
+    pizza->endUpdate();
+    CPPUNIT_ASSERT(pizza->isDirty());
+    CPPUNIT_ASSERT(!cookie->isDirty());
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(!pizza->isDirty());
+
+    // Committing an object by hand doesn't confuse the next commit.
+    cookie->beginUpdate();
+    cookie->set(awesomeness, 1);
+    cookie->endUpdate();
+    cookie->commitChanges();
+    cookie->beginUpdate();
+    cookie->set(awesomeness, 2);
+    cookie->endUpdate();
+    CPPUNIT_ASSERT(cookie->isDirty());
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(!cookie->isDirty());
+    context.commitAllChanges();
+    CPPUNIT_ASSERT(!cookie->isDirty());
+}
+
+void
+TestSceneContext::testUpdateGraph()
+{
+    // A binds B and D, B binds C. C and D are leaves.
+    SceneContext context;
+    SceneObject* a = context.createSceneObject("UpdateTracker", "/seq/shot/a");
+    SceneObject* b = context.createSceneObject("UpdateTracker", "/seq/shot/b");
+    SceneObject* c = context.createSceneObject("UpdateTracker", "/seq/shot/c");
+    SceneObject* d = context.createSceneObject("UpdateTracker", "/seq/shot/d");
+    const SceneClass& sc = a->getSceneClass();
+    AttributeKey<Float> pizzaKey = sc.getAttributeKey<Float>("pizza");
+    AttributeKey<Int> cookieKey = sc.getAttributeKey<Int>("cookie");
+
+    a->beginUpdate();
+    a->setBinding(pizzaKey, b);
+    a->endUpdate();
+    b->beginUpdate();
+    b->setBinding(pizzaKey, c);
+    b->endUpdate();
+    d->beginUpdate();
+    d->set(cookieKey, 1);
+    d->endUpdate();
+
+    UpdateHelper graph;
+    a->updatePrep(graph, 0);
+    d->updatePrep(graph, 0);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), graph.size());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), graph.getMaxDepth());
+
+    const UpdateHelper::Timings timings = graph.updateAll();
+
+    // Leaves, then level 1 (B), then level 0 (A).
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), timings.mLevels.size());
+    CPPUNIT_ASSERT_EQUAL(-1, timings.mLevels[0].mDepth);
+    CPPUNIT_ASSERT_EQUAL(std::size_t(2), timings.mLevels[0].mCount);
+    CPPUNIT_ASSERT_EQUAL(1, timings.mLevels[1].mDepth);
+    CPPUNIT_ASSERT_EQUAL(0, timings.mLevels[2].mDepth);
+
+    // C -> B -> A is the longest chain.
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), timings.mCriticalPathLength);
+    CPPUNIT_ASSERT(timings.mCriticalPath <= timings.mWall);
+}
+
+void
+TestSceneContext::testSceneClassCache()
+{
+    const std::string cachePath("scene_class_cache.bin");
+    std::remove(cachePath.c_str());
+
+    // The first load declares every DSO and writes the cache.
+    {
+        SceneContext context;
+        context.setProxyModeEnabled(true);
+        context.setSceneClassCachePath(cachePath);
+        context.loadAllSceneClasses();
+    }
+    CPPUNIT_ASSERT(std::filesystem::exists(cachePath));
+
+    SceneContext reference;
+    reference.setProxyModeEnabled(true);
+    const SceneClass* expected = reference.createSceneClass("ExtensiveObject");
+
+    // The second load restores them from the cache.
+    SceneContext context;
+    context.setProxyModeEnabled(true);
+    context.setSceneClassCachePath(cachePath);
+    context.loadAllSceneClasses();
+    const SceneClass* cached = context.getSceneClass("ExtensiveObject");
+
+    CPPUNIT_ASSERT(std::filesystem::equivalent(expected->getSourcePath(), cached->getSourcePath()));
+    CPPUNIT_ASSERT_EQUAL(expected->getDeclaredInterface(), cached->getDeclaredInterface());
+    CPPUNIT_ASSERT_EQUAL(std::distance(expected->beginAttributes(), expected->endAttributes()),
+                         std::distance(cached->beginAttributes(), cached->endAttributes()));
+    for (auto e = expected->beginAttributes(), c = cached->beginAttributes();
+            e != expected->endAttributes(); ++e, ++c) {
+        CPPUNIT_ASSERT_EQUAL((*e)->getName(), (*c)->getName());
+        CPPUNIT_ASSERT_EQUAL((*e)->getType(), (*c)->getType());
+        CPPUNIT_ASSERT_EQUAL((*e)->getFlags(), (*c)->getFlags());
+        CPPUNIT_ASSERT_EQUAL((*e)->getObjectType(), (*c)->getObjectType());
+        CPPUNIT_ASSERT((*e)->getAliases() == (*c)->getAliases());
+        CPPUNIT_ASSERT(std::equal((*e)->beginMetadata(), (*e)->endMetadata(),
+                                  (*c)->beginMetadata(), (*c)->endMetadata()));
+        CPPUNIT_ASSERT(std::equal((*e)->beginEnumValues(), (*e)->endEnumValues(),
+                                  (*c)->beginEnumValues(), (*c)->endEnumValues()));
+    }
+    CPPUNIT_ASSERT(std::equal(expected->beginGroups(), expected->endGroups(),
+                              cached->beginGroups(), cached->endGroups()));
+
+    const Attribute* stringVector = cached->getAttribute("string_vector");
+    CPPUNIT_ASSERT(stringVector->getDefaultValue<StringVector>() ==
+                   expected->getAttribute("string_vector")->getDefaultValue<StringVector>());
+
+    // Creating an object opens the DSO for real.
+    SceneObject* obj = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza");
+    CPPUNIT_ASSERT_EQUAL(Int(42), obj->get(cached->getAttributeKey<Int>("int")));
+
+    std::remove(cachePath.c_str());
+}
+
+void
+TestSceneContext::testSceneClassCacheStale()
+{
+    const std::string cachePath("scene_class_cache_stale.bin");
+    std::remove(cachePath.c_str());
+
+    {
+        SceneContext context;
+        context.setProxyModeEnabled(true);
+        context.setSceneClassCachePath(cachePath);
+        context.loadAllSceneClasses();
+    }
+
+    SceneContext reference;
+    reference.setProxyModeEnabled(true);
+    const SceneClass* expected = reference.createSceneClass("ExtensiveObject");
+    const auto attributeCount = std::distance(expected->beginAttributes(),
+                                              expected->endAttributes());
+
+    // Overwrite the ExtensiveObject entry with ExampleObject's declarations,
+    // as if the entry had been written against different base classes.
+    {
+        SceneContext context;
+        context.setProxyModeEnabled(true);
+        context.setSceneClassCachePath(cachePath);
+        context.loadAllSceneClasses();
+        const std::string dsoPath = context.getSceneClass("ExtensiveObject")->getSourcePath();
+
+        SceneContext other;
+        other.setProxyModeEnabled(true);
+        const SceneClass* wrong = other.createSceneClass("ExampleObject");
+
+        SceneClassCache cache;
+        CPPUNIT_ASSERT(cache.load(cachePath));
+        cache.store(dsoPath, *wrong);
+        cache.save(cachePath);
+    }
+
+    {
+        SceneContext context;
+        context.setProxyModeEnabled(true);
+        context.setSceneClassCachePath(cachePath);
+        context.loadAllSceneClasses();
+        const SceneClass* cached = context.getSceneClass("ExtensiveObject");
+        CPPUNIT_ASSERT(std::distance(cached->beginAttributes(), cached->endAttributes()) !=
+                       attributeCount);
+
+        // Creating an object notices the mismatch and re-declares the class.
+        SceneObject* obj = nullptr;
+        CPPUNIT_ASSERT_NO_THROW(obj = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza"));
+        CPPUNIT_ASSERT_EQUAL(attributeCount,
+                             std::distance(cached->beginAttributes(), cached->endAttributes()));
+        CPPUNIT_ASSERT_EQUAL(Int(42), obj->get(cached->getAttributeKey<Int>("int")));
+    }
+
+    // The rewritten entry restores the DSO's declarations.
+    SceneContext context;
+    context.setProxyModeEnabled(true);
+    context.setSceneClassCachePath(cachePath);
+    context.loadAllSceneClasses();
+    const SceneClass* cached = context.getSceneClass("ExtensiveObject");
+    CPPUNIT_ASSERT_EQUAL(attributeCount,
+                         std::distance(cached->beginAttributes(), cached->endAttributes()));
+    for (auto e = expected->beginAttributes(), c = cached->beginAttributes();
+            e != expected->endAttributes(); ++e, ++c) {
+        CPPUNIT_ASSERT_EQUAL((*e)->getName(), (*c)->getName());
+        CPPUNIT_ASSERT_EQUAL((*e)->getType(), (*c)->getType());
+    }
+
+    std::remove(cachePath.c_str());
+}
+
+void
+TestSceneContext::testSnapshot()
+{
+    SceneContext context;
+    SceneObject* pizza = context.createSceneObject("ExtensiveObject", "/seq/shot/pizza");
+    SceneObject* cookie = context.createSceneObject("ExtensiveObject", "/seq/shot/cookie");
+    const SceneClass& sc = pizza->getSceneClass();
+    AttributeKey<String> stringKey = sc.getAttributeKey<String>("string");
+    AttributeKey<FloatVector> floatVectorKey = sc.getAttributeKey<FloatVector>("float_vector");
+    AttributeKey<Int> intKey = sc.getAttributeKey<Int>("int");
+
+    {
+        SceneObject::UpdateGuard guard(pizza);
+        pizza->set(stringKey, String("pepperoni"));
+        pizza->set(floatVectorKey, FloatVector{1.0f, 2.0f, 3.0f});
+    }
+    context.commitAllChanges();
+    {
+        SceneObject::UpdateGuard guard(pizza);
+        pizza->set(intKey, 7);
+    }
+
+    std::string manifest, payload;
+    BinaryWriter liveWriter(context);
+    liveWriter.setDeltaEncoding(true);
+    liveWriter.toBytes(manifest, payload);
+
+    // Only pizza is dirty.
+    std::unique_ptr<SceneContextSnapshot> snapshot = context.takeSnapshot(true);
+    CPPUNIT_ASSERT(snapshot->isDirtyOnly());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), snapshot->size());
+    const SceneObject* frozen = snapshot->getSceneObjects()[0];
+    CPPUNIT_ASSERT_EQUAL(pizza->getName(), frozen->getName());
+    CPPUNIT_ASSERT(frozen->isDirty());
+    CPPUNIT_ASSERT(frozen->hasChanged(intKey));
+
+    // Committing and editing the live objects leaves the snapshot alone.
+    context.commitAllChanges();
+    {
+        SceneObject::UpdateGuard guard(pizza);
+        pizza->set(stringKey, String("anchovies"));
+        pizza->set(floatVectorKey, FloatVector{4.0f});
+        pizza->set(intKey, 8);
+    }
+    CPPUNIT_ASSERT_EQUAL(String("anchovies"), pizza->get(stringKey));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(1), pizza->get(floatVectorKey).size());
+    CPPUNIT_ASSERT_EQUAL(String("pepperoni"), frozen->get(stringKey));
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), frozen->get(floatVectorKey).size());
+    CPPUNIT_ASSERT_EQUAL(7, frozen->get(intKey));
+    CPPUNIT_ASSERT(frozen->isDirty());
+    CPPUNIT_ASSERT(!cookie->isDirty());
+
+    // The snapshot encodes what the context encoded when it was taken.
+    std::string snapshotManifest, snapshotPayload;
+    BinaryWriter snapshotWriter(*snapshot);
+    snapshotWriter.setDeltaEncoding(true);
+    snapshotWriter.toBytes(snapshotManifest, snapshotPayload);
+    CPPUNIT_ASSERT(manifest == snapshotManifest);
+    CPPUNIT_ASSERT(payload == snapshotPayload);
+
+    // A full snapshot holds every object, and dropping it hands the storage
+    // back to the live objects untouched.
+    std::unique_ptr<SceneContextSnapshot> full = context.takeSnapshot();
+    CPPUNIT_ASSERT(!full->isDirtyOnly());
+    CPPUNIT_ASSERT_EQUAL(std::size_t(3), full->size()); // plus SceneVariables
+    snapshot.reset();
+    full.reset();
+    {
+        SceneObject::UpdateGuard guard(cookie);
+        cookie->set(stringKey, String("chocolate"));
+    }
+    CPPUNIT_ASSERT_EQUAL(String("chocolate"), cookie->get(stringKey));
+    CPPUNIT_ASSERT_EQUAL(String("anchovies"), pizza->get(stringKey));
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
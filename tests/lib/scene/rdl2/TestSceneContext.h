@@ -65,6 +65,32 @@ public:
     /// creation fails.
     void testCreateObjectFailure();
 
+    /// Test that lookups served by the name index frozen in
+    /// commitAllChanges() agree with the hash maps, including for objects
+    /// and classes created after the index was built.
+    void testFrozenNameIndex();
+
+    /// Test that lookups may run while commitAllChanges() replaces the
+    /// frozen name index.
+    void testFrozenNameIndexConcurrentCommit();
+
+    /// Test that commitAllChanges() commits exactly the dirtied objects.
+    void testDirtyList();
+
+    /// Test that update scheduling follows dependencies and reports timings.
+    void testUpdateGraph();
+
+    /// Test restoring SceneClasses from the SceneClass cache.
+    void testSceneClassCache();
+
+    /// Test that a SceneClass restored from a cache entry which no longer
+    /// matches its DSO is re-declared from the DSO, and the entry rewritten.
+    void testSceneClassCacheStale();
+
+    /// Test that snapshots keep the values they were taken with while the
+    /// live objects are edited, and encode like the context did.
+    void testSnapshot();
+
     CPPUNIT_TEST_SUITE(TestSceneContext);
     CPPUNIT_TEST(testDsoPath);
     CPPUNIT_TEST(testCreateSceneClass);
@@ -80,6 +106,13 @@ public:
     CPPUNIT_TEST(testSceneVariables);
     CPPUNIT_TEST(testCreateClassFailure);
     CPPUNIT_TEST(testCreateObjectFailure);
+    CPPUNIT_TEST(testFrozenNameIndex);
+    CPPUNIT_TEST(testFrozenNameIndexConcurrentCommit);
+    CPPUNIT_TEST(testDirtyList);
+    CPPUNIT_TEST(testUpdateGraph);
+    CPPUNIT_TEST(testSceneClassCache);
+    CPPUNIT_TEST(testSceneClassCacheStale);
+    CPPUNIT_TEST(testSnapshot);
     CPPUNIT_TEST_SUITE_END();
 };
 
@@ -10,7 +10,12 @@
 #include <scene_rdl2/scene/rdl2/SceneObject.h>
 #include <scene_rdl2/scene/rdl2/Types.h>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace scene_rdl2 {
 namespace rdl2 {
@@ -617,6 +622,164 @@ TestSceneObject::testExtension()
     mDsoClass->destroyObject(obj);
 }
 
+void
+TestSceneObject::testStorageArena()
+{
+    const std::size_t numObjects = 8;
+    std::vector<SceneObject*> objs;
+    for (std::size_t i = 0; i < numObjects; ++i) {
+        objs.push_back(mDsoClass->createObject("/seq/shot/pizza" + std::to_string(i)));
+    }
+
+    // All of these fit in the first slab, so their storage is evenly spaced.
+    const uintptr_t first = reinterpret_cast<uintptr_t>(objs[0]->mAttributeStorage);
+    const uintptr_t stride = reinterpret_cast<uintptr_t>(objs[1]->mAttributeStorage) - first;
+    CPPUNIT_ASSERT(stride >= mDsoClass->mAttributeStorageSize);
+    CPPUNIT_ASSERT(stride % AttributeStorageArena::sAlignment == 0);
+    for (std::size_t i = 0; i < numObjects; ++i) {
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(objs[i]->mAttributeStorage);
+        CPPUNIT_ASSERT(addr % AttributeStorageArena::sAlignment == 0);
+        CPPUNIT_ASSERT(addr == first + i * stride);
+    }
+    CPPUNIT_ASSERT(mDsoClass->mStorageArena.getSlabCount() == 1);
+
+    // Freed storage is reused, and comes back initialized to defaults.
+    objs[3]->beginUpdate();
+    objs[3]->set(mIntKey, Int(42));
+    objs[3]->set(mFloatVectorKey, mFloatVec2);
+    objs[3]->endUpdate();
+    void* freed = objs[3]->mAttributeStorage;
+    mDsoClass->destroyObject(objs[3]);
+    objs[3] = mDsoClass->createObject("/seq/shot/pizza3");
+    CPPUNIT_ASSERT(objs[3]->mAttributeStorage == freed);
+    CPPUNIT_ASSERT(objs[3]->get(mIntKey) == Int(100));
+    CPPUNIT_ASSERT(objs[3]->get(mFloatVectorKey) == mFloatVec);
+
+    for (SceneObject* obj : objs) {
+        mDsoClass->destroyObject(obj);
+    }
+}
+
+void
+TestSceneObject::testStorageArenaParallel()
+{
+    const std::size_t numObjects = 4096;
+    std::vector<SceneObject*> objs(numObjects);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        tbb::parallel_for(std::size_t(0), numObjects, [&](std::size_t i) {
+            objs[i] = mDsoClass->createObject("/seq/shot/pizza" + std::to_string(i));
+        });
+
+        std::vector<uintptr_t> addrs;
+        for (const SceneObject* obj : objs) {
+            const uintptr_t addr = reinterpret_cast<uintptr_t>(obj->mAttributeStorage);
+            CPPUNIT_ASSERT(addr % AttributeStorageArena::sAlignment == 0);
+            CPPUNIT_ASSERT(obj->get(mIntKey) == Int(100));
+            addrs.push_back(addr);
+        }
+
+        // No two objects share storage.
+        std::sort(addrs.begin(), addrs.end());
+        for (std::size_t i = 1; i < numObjects; ++i) {
+            CPPUNIT_ASSERT(addrs[i] - addrs[i - 1] >= mDsoClass->mAttributeStorageSize);
+        }
+
+        // Destroy in the reverse order, mostly from threads other than the
+        // ones which allocated, so the second pass reuses blocks through
+        // other threads' free lists.
+        tbb::parallel_for(std::size_t(0), numObjects, [&](std::size_t i) {
+            mDsoClass->destroyObject(objs[numObjects - 1 - i]);
+        });
+    }
+}
+
+void
+TestSceneObject::testStorageArenaCrossThread()
+{
+    const std::size_t numObjects = 64;
+    std::vector<SceneObject*> objs(numObjects);
+    std::size_t slabCount = 0;
+
+    for (int pass = 0; pass < 100; ++pass) {
+        for (std::size_t i = 0; i < numObjects; ++i) {
+            objs[i] = mDsoClass->createObject("/seq/shot/pizza" + std::to_string(i));
+            CPPUNIT_ASSERT(objs[i]->get(mIntKey) == Int(100));
+        }
+        if (pass == 0) {
+            slabCount = mDsoClass->mStorageArena.getSlabCount();
+        }
+
+        std::thread destroyer([&]() {
+            for (SceneObject* obj : objs) {
+                mDsoClass->destroyObject(obj);
+            }
+        });
+        destroyer.join();
+    }
+
+    // Every pass after the first is served entirely from freed blocks.
+    CPPUNIT_ASSERT(mDsoClass->mStorageArena.getSlabCount() == slabCount);
+}
+
+void
+TestSceneObject::testAttributeBatch()
+{
+    const std::size_t numObjects = 64;
+    SceneObjectVector objs;
+    std::vector<Float> floats;
+    for (std::size_t i = 0; i < numObjects; ++i) {
+        objs.push_back(mDsoClass->createObject("/seq/shot/pizza" + std::to_string(i)));
+        floats.push_back(Float(i));
+    }
+
+    for (bool parallel : { false, true }) {
+        const Int intValue = parallel ? Int(8) : Int(7);
+
+        AttributeBatch batch;
+        batch.set(objs, mFloatKey, floats);
+        batch.set(objs[1], mIntKey, intValue, TIMESTEP_END);
+        batch.set(objs[2], mStringKey, String("first"));
+        batch.set(objs[2], mStringKey, String("second"));
+        batch.set(objs[3], mSceneObjectKey, objs[4]);
+        batch.set(objs[5], mBoolVectorKey, mBoolVec2);
+        CPPUNIT_ASSERT(batch.size() == numObjects + 5);
+
+        batch.apply(parallel);
+        CPPUNIT_ASSERT(batch.empty());
+
+        for (std::size_t i = 0; i < numObjects; ++i) {
+            CPPUNIT_ASSERT(objs[i]->get(mFloatKey, TIMESTEP_BEGIN) == Float(i));
+            CPPUNIT_ASSERT(objs[i]->get(mFloatKey, TIMESTEP_END) == Float(i));
+            CPPUNIT_ASSERT(!objs[i]->mUpdateActive);
+        }
+        CPPUNIT_ASSERT(objs[1]->get(mIntKey, TIMESTEP_BEGIN) == Int(100));
+        CPPUNIT_ASSERT(objs[1]->get(mIntKey, TIMESTEP_END) == intValue);
+        CPPUNIT_ASSERT(objs[1]->mAttributeSetMask.test(mIntKey.mIndex));
+        CPPUNIT_ASSERT(objs[2]->get(mStringKey) == String("second"));
+        CPPUNIT_ASSERT(objs[3]->get(mSceneObjectKey) == objs[4]);
+        CPPUNIT_ASSERT(objs[5]->get(mBoolVectorKey) == mBoolVec2);
+
+        // Values that don't change leave the object clean.
+        for (SceneObject* obj : objs) {
+            obj->commitChanges();
+        }
+        batch.set(objs, mFloatKey, floats);
+        batch.apply(parallel);
+        CPPUNIT_ASSERT(!objs[0]->mAttributeSetMask.test(mFloatKey.mIndex));
+        CPPUNIT_ASSERT(!objs[0]->isDirty());
+    }
+
+    // Mismatched vectors are rejected up front.
+    AttributeBatch batch;
+    CPPUNIT_ASSERT_THROW(batch.set(objs, mFloatKey, std::vector<Float>(1)), except::ValueError);
+    CPPUNIT_ASSERT(batch.empty());
+
+    for (SceneObject* obj : objs) {
+        mDsoClass->destroyObject(obj);
+    }
+}
+
 } // namespace unittest
 } // namespace rdl2
 } // namespace scene_rdl2
@@ -60,6 +60,22 @@ public:
     /// Mostly a compilation test.
     void testExtension();
 
+    /// Test that attribute storage comes from the SceneClass's arena: cache
+    /// line aligned, packed together, and reused after an object is destroyed.
+    void testStorageArena();
+
+    /// Test that objects can be created and destroyed from many threads at
+    /// once, each getting its own aligned, default initialized storage.
+    void testStorageArenaParallel();
+
+    /// Test that blocks freed on a thread which never allocates are reused by
+    /// the thread which does, rather than the arena growing without bound.
+    void testStorageArenaCrossThread();
+
+    /// Test that an AttributeBatch applies queued changes to many objects,
+    /// serially and in parallel, with the same effect as individual sets.
+    void testAttributeBatch();
+
     CPPUNIT_TEST_SUITE(TestSceneObject);
     CPPUNIT_TEST(testGetClass);
     CPPUNIT_TEST(testGetName);
@@ -72,6 +88,10 @@ public:
     CPPUNIT_TEST(testAttributeSetMask);
     CPPUNIT_TEST(testBindings);
     CPPUNIT_TEST(testExtension);
+    CPPUNIT_TEST(testStorageArena);
+    CPPUNIT_TEST(testStorageArenaParallel);
+    CPPUNIT_TEST(testStorageArenaCrossThread);
+    CPPUNIT_TEST(testAttributeBatch);
     CPPUNIT_TEST_SUITE_END();
 
 private: